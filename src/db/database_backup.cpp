@@ -0,0 +1,343 @@
+#include "database_backup.hpp"
+#include "database_connection.hpp"
+#include "../utils/logger.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+
+double DatabaseBackup::Progress::percent() const
+{
+    if (state == State::Done)
+    {
+        return 100.0;
+    }
+    if (files_total == 0)
+    {
+        return 0.0;
+    }
+    // 已完成的文件按整份计，当前文件按已复制页数折算
+    double current = pages_total > 0 ? static_cast<double>(pages_copied) / pages_total : 0.0;
+    return (files_done + current) * 100.0 / files_total;
+}
+
+nlohmann::json DatabaseBackup::Progress::toJson() const
+{
+    nlohmann::json json = {
+        {"state", stateName(state)},
+        {"destination", destination},
+        {"files_total", files_total},
+        {"files_done", files_done},
+        {"pages_total", pages_total},
+        {"pages_copied", pages_copied},
+        {"percent", percent()},
+        {"steps", steps},
+        {"started_at", started_at},
+        {"finished_at", finished_at}};
+    if (!error.empty())
+    {
+        json["error"] = error;
+    }
+    return json;
+}
+
+DatabaseBackup::DatabaseBackup(std::vector<DatabaseConnection *> sources) : sources_(std::move(sources)) {}
+
+DatabaseBackup::~DatabaseBackup()
+{
+    stopping_ = true;
+    timer_.stop();
+    // 中途停止时放弃未完成的文件
+    closeCurrent();
+}
+
+void DatabaseBackup::setOptions(const Options &options)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+}
+
+DatabaseBackup::Options DatabaseBackup::getOptions() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+bool DatabaseBackup::start(const std::string &destination)
+{
+    if (sources_.empty() || destination.empty())
+    {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (progress_.state == State::Running)
+        {
+            return false;
+        }
+        progress_ = Progress();
+        progress_.state = State::Running;
+        progress_.destination = destination;
+        progress_.files_total = sources_.size();
+        progress_.started_at = std::time(nullptr);
+        index_ = 0;
+    }
+
+    timer_.addOnceTask(std::chrono::milliseconds(0), [this]()
+                       { step(); });
+    timer_.start();
+    LOG_INFO << "Database backup started: " << destination << ", files: " << sources_.size();
+    return true;
+}
+
+std::string DatabaseBackup::defaultDestination() const
+{
+    if (sources_.empty())
+    {
+        return "";
+    }
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    char suffix[32];
+    std::strftime(suffix, sizeof(suffix), ".backup-%Y%m%d-%H%M%S", &local);
+    return sources_.front()->getPath() + suffix;
+}
+
+DatabaseBackup::Progress DatabaseBackup::getProgress() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return progress_;
+}
+
+bool DatabaseBackup::isRunning() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return progress_.state == State::Running;
+}
+
+const char *DatabaseBackup::stateName(State state)
+{
+    switch (state)
+    {
+    case State::Running:
+        return "running";
+    case State::Done:
+        return "done";
+    case State::Failed:
+        return "failed";
+    default:
+        return "idle";
+    }
+}
+
+void DatabaseBackup::step()
+{
+    if (stopping_)
+    {
+        return;
+    }
+    if (!backup_ && !openNext())
+    {
+        return;
+    }
+
+    Options options = getOptions();
+    DatabaseConnection *source = sources_[index_];
+    int rc, remaining, pagecount;
+    {
+        // 只在复制这几页时持有连接锁
+        std::lock_guard<DatabaseConnection::Mutex> lock(source->getMutex());
+        rc = sqlite3_backup_step(backup_, std::max(1, options.pages_per_step));
+        remaining = sqlite3_backup_remaining(backup_);
+        pagecount = sqlite3_backup_pagecount(backup_);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++progress_.steps;
+        progress_.pages_total = pagecount;
+        progress_.pages_copied = pagecount - remaining;
+    }
+
+    if (rc == SQLITE_DONE)
+    {
+        if (!finishCurrent())
+        {
+            return;
+        }
+        ++index_;
+        bool done = index_ == sources_.size();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            progress_.files_done = index_;
+            if (done)
+            {
+                progress_.state = State::Done;
+                progress_.finished_at = std::time(nullptr);
+            }
+        }
+        if (done)
+        {
+            LOG_INFO << "Database backup finished: " << destinationFor(0);
+            pruneOldBackups();
+            return;
+        }
+    }
+    else if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED)
+    {
+        // BUSY/LOCKED 时下一步重试，其余错误终止备份
+        fail(std::string("backup step failed: ") + sqlite3_errstr(rc));
+        return;
+    }
+
+    timer_.addOnceTask(options.step_interval, [this]()
+                       { step(); });
+}
+
+bool DatabaseBackup::openNext()
+{
+    std::string path = destinationFor(index_) + ".tmp";
+    std::remove(path.c_str()); // 上次中断留下的临时文件
+    if (sqlite3_open(path.c_str(), &dest_) != SQLITE_OK)
+    {
+        fail("cannot open " + path + ": " + sqlite3_errmsg(dest_));
+        return false;
+    }
+
+    DatabaseConnection *source = sources_[index_];
+    {
+        std::lock_guard<DatabaseConnection::Mutex> lock(source->getMutex());
+        backup_ = sqlite3_backup_init(dest_, "main", source->getDb(), "main");
+    }
+    if (!backup_)
+    {
+        fail("cannot start backup of " + source->getPath() + ": " + sqlite3_errmsg(dest_));
+        return false;
+    }
+    LOG_DEBUG << "Backing up " << source->getPath() << " to " << path;
+    return true;
+}
+
+bool DatabaseBackup::finishCurrent()
+{
+    int rc;
+    {
+        std::lock_guard<DatabaseConnection::Mutex> lock(sources_[index_]->getMutex());
+        rc = sqlite3_backup_finish(backup_);
+    }
+    backup_ = nullptr;
+    if (rc != SQLITE_OK)
+    {
+        fail(std::string("backup finish failed: ") + sqlite3_errstr(rc));
+        return false;
+    }
+    if (sqlite3_close(dest_) != SQLITE_OK)
+    {
+        fail("cannot close backup file: " + std::string(sqlite3_errmsg(dest_)));
+        return false;
+    }
+    dest_ = nullptr;
+
+    std::string path = destinationFor(index_);
+    if (std::rename((path + ".tmp").c_str(), path.c_str()) != 0)
+    {
+        fail("cannot rename backup file to " + path);
+        return false;
+    }
+    return true;
+}
+
+void DatabaseBackup::closeCurrent()
+{
+    if (backup_)
+    {
+        std::lock_guard<DatabaseConnection::Mutex> lock(sources_[index_]->getMutex());
+        sqlite3_backup_finish(backup_);
+        backup_ = nullptr;
+    }
+    if (dest_)
+    {
+        sqlite3_close(dest_);
+        dest_ = nullptr;
+        std::remove((destinationFor(index_) + ".tmp").c_str());
+    }
+}
+
+void DatabaseBackup::fail(const std::string &error)
+{
+    closeCurrent();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        progress_.state = State::Failed;
+        progress_.error = error;
+        progress_.finished_at = std::time(nullptr);
+    }
+    LOG_ERROR << "Database backup failed: " << error;
+}
+
+std::string DatabaseBackup::destinationFor(size_t index) const
+{
+    std::string destination;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        destination = progress_.destination;
+    }
+    // 与分片库的命名一致：chat.db -> chat.db.shard0, chat.db.shard1 ...
+    return index == 0 ? destination : destination + ".shard" + std::to_string(index - 1);
+}
+
+void DatabaseBackup::pruneOldBackups()
+{
+    size_t keep = getOptions().keep_backups;
+    if (keep == 0)
+    {
+        return;
+    }
+    // 只认 defaultDestination 生成的文件名：<元数据库文件名>.backup-YYYYMMDD-HHMMSS，
+    // 时间戳定长，按文件名排序即按时间排序
+    namespace fs = std::filesystem;
+    fs::path meta(sources_.front()->getPath());
+    fs::path dir = meta.has_parent_path() ? meta.parent_path() : fs::path(".");
+    const std::string prefix = meta.filename().string() + ".backup-";
+    const size_t stamp_length = 15; // YYYYMMDD-HHMMSS
+
+    std::vector<std::string> backups;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+    {
+        std::string name = it->path().filename().string();
+        if (name.size() != prefix.size() + stamp_length || name.compare(0, prefix.size(), prefix) != 0)
+        {
+            continue;
+        }
+        std::string stamp = name.substr(prefix.size());
+        bool valid = std::all_of(stamp.begin(), stamp.end(), [](char c)
+                                 { return c == '-' || (c >= '0' && c <= '9'); });
+        if (valid && stamp[8] == '-')
+        {
+            backups.push_back(name);
+        }
+    }
+    if (ec)
+    {
+        LOG_WARN << "Failed to list backups in " << dir.string() << ": " << ec.message();
+        return;
+    }
+    if (backups.size() <= keep)
+    {
+        return;
+    }
+
+    std::sort(backups.begin(), backups.end());
+    backups.resize(backups.size() - keep);
+    for (const auto &name : backups)
+    {
+        fs::path path = dir / name;
+        fs::remove(path, ec);
+        for (size_t i = 1; i < sources_.size(); ++i)
+        {
+            fs::remove(path.string() + ".shard" + std::to_string(i - 1), ec);
+        }
+        LOG_INFO << "Removed old database backup: " << path.string();
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include <nlohmann/json.hpp>
+#include "../utils/timer.hpp"
+
+class DatabaseConnection;
+
+// 在线热备份
+// 基于 sqlite3_backup_* 把元数据库和各消息分片逐个复制到备份文件。每一步只在持有连接锁时复制
+// pages_per_step 页，两步之间释放锁并等待 step_interval，前台读写可以穿插执行；
+// 备份期间经同一连接写入的页面由 SQLite 同步到备份中，不需要从头重来。
+// 备份先写入 <目标>.tmp，单个文件完成后再改名，半成品不会被当成完整备份
+class DatabaseBackup
+{
+public:
+    struct Options
+    {
+        int pages_per_step = 256;                                             // 每步复制的页数
+        std::chrono::milliseconds step_interval = std::chrono::milliseconds(5); // 两步之间让出数据库的时间
+        size_t keep_backups = 3;                                              // 保留的默认路径备份份数，0 表示不清理
+    };
+
+    enum class State
+    {
+        Idle,
+        Running,
+        Done,
+        Failed
+    };
+
+    struct Progress
+    {
+        State state = State::Idle;
+        std::string destination;  // 元数据库的备份路径，分片备份为 <destination>.shardN
+        size_t files_total = 0;   // 需要备份的数据库文件数
+        size_t files_done = 0;    // 已完成的文件数
+        int64_t pages_total = 0;  // 当前文件的总页数
+        int64_t pages_copied = 0; // 当前文件已复制的页数
+        int64_t steps = 0;        // 已执行的步数
+        int64_t started_at = 0;   // 开始时间（秒）
+        int64_t finished_at = 0;  // 结束时间（秒），未结束时为 0
+        std::string error;        // 失败原因
+
+        double percent() const;
+        nlohmann::json toJson() const;
+    };
+
+    // sources: 需要备份的连接，第一个为元数据库，其余依次为消息分片
+    explicit DatabaseBackup(std::vector<DatabaseConnection *> sources);
+    ~DatabaseBackup();
+
+    DatabaseBackup(const DatabaseBackup &) = delete;
+    DatabaseBackup &operator=(const DatabaseBackup &) = delete;
+
+    void setOptions(const Options &options);
+    Options getOptions() const;
+
+    // 开始备份到 destination，已有备份在进行或没有可备份的连接时返回 false
+    bool start(const std::string &destination);
+    // 默认备份路径：元数据库路径加上时间戳，如 chat.db.backup-20250720-153000。
+    // 备份成功后只保留最新的 keep_backups 份默认路径备份，更早的连同分片文件一起删除
+    std::string defaultDestination() const;
+    Progress getProgress() const;
+    bool isRunning() const;
+
+    static const char *stateName(State state);
+
+private:
+    void step();
+    bool openNext();         // 为下一个源连接打开备份文件和备份句柄，调用前 backup_ 为空
+    bool finishCurrent();    // 结束当前文件的备份并把临时文件改名
+    void closeCurrent();     // 放弃当前文件的备份并删除临时文件
+    void fail(const std::string &error);
+    std::string destinationFor(size_t index) const;
+    void pruneOldBackups(); // 删除超出 keep_backups 的旧备份
+
+    std::vector<DatabaseConnection *> sources_;
+
+    mutable std::mutex mutex_; // 保护 options_ 和 progress_
+    Options options_;
+    Progress progress_;
+
+    // 以下成员只在定时器线程中访问（析构时定时器已停止）
+    size_t index_ = 0;                   // 正在备份的源连接
+    sqlite3 *dest_ = nullptr;            // 备份文件连接
+    sqlite3_backup *backup_ = nullptr;   // 备份句柄
+
+    std::atomic<bool> stopping_{false};
+    utils::Timer timer_;
+};
@@ -1,17 +1,21 @@
 #include "database_connection.hpp"
 #include <chrono>
 
-DatabaseConnection::DatabaseConnection(const std::string &db_path) : db_path_(db_path), db_(nullptr)
+DatabaseConnection::DatabaseConnection(const std::string &db_path, Schema schema)
+    : db_(nullptr), db_path_(db_path), mutex_(stats_), schema_(schema)
 {
     {
         //进入临界区，加锁
-        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::lock_guard<Mutex> lock(mutex_);
         if (sqlite3_open(db_path.c_str(), &db_) != SQLITE_OK)//尝试打开数据库
         {
             LOG_ERROR << "Can't open database: " << sqlite3_errmsg(db_);
             return;
         }
         LOG_INFO << "Opened database successfully";
+
+        // 记录每条语句的耗时和返回行数
+        sqlite3_trace_v2(db_, SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW, &QueryStats::traceCallback, &stats_);
         
         // 启用外键约束
         if (!enableForeignKeys())
@@ -22,6 +26,15 @@ DatabaseConnection::DatabaseConnection(const std::string &db_path) : db_path_(db
             return;
         }
         LOG_INFO << "Foreign key constraints enabled";
+
+        // 必须在建表之前设置，只对新建的空库生效；已有的库需要执行一次 VACUUM 才能切换，否则增量回收不会释放空间
+        executeQuery("PRAGMA auto_vacuum = INCREMENTAL;");
+
+        // 消息分片库写入频繁，使用WAL模式减少写入时的锁等待
+        if (schema_ == Schema::MessagesOnly && db_path != ":memory:")
+        {
+            wal_ = executeQuery("PRAGMA journal_mode = WAL;");
+        }
     }
     
     //如果连接成功则初始化表
@@ -40,7 +53,12 @@ DatabaseConnection::DatabaseConnection(const std::string &db_path) : db_path_(db
 
 DatabaseConnection::~DatabaseConnection()
 {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::lock_guard<Mutex> lock(mutex_);
+    for (auto &entry : statement_cache_)
+    {
+        sqlite3_finalize(entry.second);
+    }
+    statement_cache_.clear();
     if (db_)
     {
         LOG_INFO << "Closing database connection";
@@ -50,7 +68,7 @@ DatabaseConnection::~DatabaseConnection()
 
 bool DatabaseConnection::executeQuery(const std::string &query)
 {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::lock_guard<Mutex> lock(mutex_);
     char *err_msg = nullptr;
     int rc = sqlite3_exec(db_, query.c_str(), nullptr, nullptr, &err_msg);
     if (rc != SQLITE_OK)
@@ -62,6 +80,90 @@ bool DatabaseConnection::executeQuery(const std::string &query)
     return true;
 }
 
+sqlite3_stmt *DatabaseConnection::getCachedStatement(const char *sql)
+{
+    auto it = statement_cache_.find(sql);
+    if (it != statement_cache_.end())
+    {
+        sqlite3_reset(it->second);
+        sqlite3_clear_bindings(it->second);
+        return it->second;
+    }
+
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_);
+        return nullptr;
+    }
+    statement_cache_.emplace(sql, stmt);
+    return stmt;
+}
+
+bool DatabaseConnection::runMaintenance(int vacuum_pages)
+{
+    if (!db_) return false;
+
+    std::lock_guard<Mutex> lock(mutex_);
+    // 每次只回收有限的空闲页，避免长时间占用写锁
+    bool success = executeQuery("PRAGMA incremental_vacuum(" + std::to_string(vacuum_pages) + ");");
+
+    if (wal_)
+    {
+        // PASSIVE 不等待读写，只把已提交的WAL内容写回主库，防止WAL文件无限增长
+        int log_frames = 0;
+        int checkpointed = 0;
+        if (sqlite3_wal_checkpoint_v2(db_, nullptr, SQLITE_CHECKPOINT_PASSIVE, &log_frames, &checkpointed) != SQLITE_OK)
+        {
+            LOG_WARN << "WAL checkpoint failed for " << db_path_ << ": " << sqlite3_errmsg(db_);
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool DatabaseConnection::beginTransaction()
+{
+    // IMMEDIATE 在开始时就获取写锁，避免事务中途因锁升级失败
+    return executeQuery("BEGIN IMMEDIATE;");
+}
+
+bool DatabaseConnection::commitTransaction()
+{
+    return executeQuery("COMMIT;");
+}
+
+void DatabaseConnection::rollbackTransaction()
+{
+    executeQuery("ROLLBACK;");
+}
+
+bool DatabaseConnection::beginReadTransaction()
+{
+    if (!sqlite3_get_autocommit(db_))
+    {
+        return false;
+    }
+    // DEFERRED 在第一次读时才获取读锁，不影响写入；语句走缓存，省去每次解析
+    sqlite3_stmt *stmt = getCachedStatement("BEGIN DEFERRED;");
+    bool success = stmt && sqlite3_step(stmt) == SQLITE_DONE;
+    if (stmt)
+    {
+        sqlite3_reset(stmt);
+    }
+    return success;
+}
+
+void DatabaseConnection::endReadTransaction()
+{
+    sqlite3_stmt *stmt = getCachedStatement("COMMIT;");
+    if (stmt)
+    {
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+}
+
 bool DatabaseConnection::enableForeignKeys()
 {
     const char* enable_fk_query = "PRAGMA foreign_keys = ON;";
@@ -70,18 +172,157 @@ bool DatabaseConnection::enableForeignKeys()
 
 bool DatabaseConnection::initializeTables()
 {
+    if (schema_ == Schema::MessagesOnly)
+    {
+        return createShardMessagesTable() && createSearchIndex();
+    }
+
+    // 按版本依次迁移已有的库，迁移期间还没有创建计数触发器
+    if (tableExists("users"))
+    {
+        int64_t version = queryInt("PRAGMA user_version;");
+        if (version < 2 && !migrateToIntegerKeys())
+        {
+            return false;
+        }
+        if (version < 3 && !migrateToRoomCounters())
+        {
+            return false;
+        }
+    }
+
     return createUsersTable() &&
            createRoomsTable() &&
            createRoomMembersTable() &&
            createMessagesTable() &&
-           createIndexes();
+           createRoomRetentionTable() &&
+           createStorageSettingsTable() &&
+           createIndexes() &&
+           createCounterTriggers() &&
+           createSearchIndex() &&
+           executeQuery("PRAGMA user_version = " + std::to_string(kSchemaVersion) + ";");
+}
+
+bool DatabaseConnection::migrateToRoomCounters()
+{
+    LOG_INFO << "Migrating " << db_path_ << " to materialized room counters";
+    std::lock_guard<Mutex> lock(mutex_);
+
+    // 从版本 1 迁移来的库已经按新结构建了 rooms 表，只需要回填
+    bool has_columns = queryInt("SELECT COUNT(*) FROM pragma_table_info('rooms') WHERE name = 'member_count';") > 0;
+
+    // 一次性聚合回填，之后由触发器增量维护
+    bool success =
+        beginTransaction() &&
+        (has_columns ||
+         executeQuery("ALTER TABLE rooms ADD COLUMN member_count INTEGER NOT NULL DEFAULT 0;"
+                      "ALTER TABLE rooms ADD COLUMN message_count INTEGER NOT NULL DEFAULT 0;"
+                      "ALTER TABLE rooms ADD COLUMN last_activity INTEGER NOT NULL DEFAULT 0;")) &&
+        executeQuery("UPDATE rooms SET "
+                     "member_count = (SELECT COUNT(*) FROM room_members WHERE room_pk = rooms.pk),"
+                     "message_count = (SELECT COUNT(*) FROM messages WHERE room_pk = rooms.pk),"
+                     "last_activity = COALESCE((SELECT MAX(timestamp) FROM messages WHERE room_pk = rooms.pk), 0);") &&
+        executeQuery("PRAGMA user_version = 3;") &&
+        commitTransaction();
+
+    if (!success)
+    {
+        LOG_ERROR << "Failed to migrate " << db_path_ << " to room counters, rolling back";
+        rollbackTransaction();
+    }
+    return success;
+}
+
+int64_t DatabaseConnection::queryInt(const std::string &query)
+{
+    std::lock_guard<Mutex> lock(mutex_);
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db_, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_);
+        return 0;
+    }
+
+    int64_t value = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        value = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+bool DatabaseConnection::tableExists(const std::string &table)
+{
+    return queryInt("SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = '" + table + "';") > 0;
+}
+
+bool DatabaseConnection::migrateToIntegerKeys()
+{
+    LOG_INFO << "Migrating " << db_path_ << " to integer keys";
+    std::lock_guard<Mutex> lock(mutex_);
+
+    // 保留策略表是后加的，更早的库中可能没有
+    bool has_retention = tableExists("room_retention");
+
+    // 外键开关在事务中无效，迁移期间关闭，避免删除旧表时逐行检查引用
+    executeQuery("PRAGMA foreign_keys = OFF;");
+
+    // 旧表改名后按新结构重建，通过字符串ID关联出整数主键再复制数据。
+    // 消息ID原样保留，已下发给客户端的ID和分页游标迁移后仍然有效
+    bool success =
+        executeQuery("BEGIN IMMEDIATE;") &&
+        executeQuery("ALTER TABLE users RENAME TO users_v1;"
+                     "ALTER TABLE rooms RENAME TO rooms_v1;"
+                     "ALTER TABLE room_members RENAME TO room_members_v1;"
+                     "ALTER TABLE messages RENAME TO messages_v1;") &&
+        (!has_retention || executeQuery("ALTER TABLE room_retention RENAME TO room_retention_v1;")) &&
+        createUsersTable() &&
+        createRoomsTable() &&
+        createRoomMembersTable() &&
+        createMessagesTable() &&
+        createRoomRetentionTable() &&
+        executeQuery("INSERT INTO users (id, username, password_hash, created_at) "
+                     "SELECT id, username, password_hash, created_at FROM users_v1 ORDER BY rowid;"
+                     "INSERT INTO rooms (id, name, description, creator_pk, created_at) "
+                     "SELECT r.id, r.name, r.description, u.pk, r.created_at "
+                     "FROM rooms_v1 r JOIN users u ON u.id = r.creator_id ORDER BY r.rowid;"
+                     "INSERT INTO room_members (room_pk, user_pk, joined_at) "
+                     "SELECT r.pk, u.pk, rm.joined_at FROM room_members_v1 rm "
+                     "JOIN rooms r ON r.id = rm.room_id JOIN users u ON u.id = rm.user_id;"
+                     "INSERT INTO messages (id, room_pk, user_pk, content, timestamp) "
+                     "SELECT m.id, r.pk, u.pk, m.content, m.timestamp FROM messages_v1 m "
+                     "JOIN rooms r ON r.id = m.room_id JOIN users u ON u.id = m.user_id ORDER BY m.id;"
+                     // 自增序号随旧表改名，转回新表，已删除的消息ID不会被重新分配
+                     "DELETE FROM sqlite_sequence WHERE name = 'messages';"
+                     "UPDATE sqlite_sequence SET name = 'messages' WHERE name = 'messages_v1';") &&
+        (!has_retention ||
+         executeQuery("INSERT INTO room_retention (room_pk, max_age_seconds, max_messages) "
+                      "SELECT r.pk, rr.max_age_seconds, rr.max_messages FROM room_retention_v1 rr "
+                      "JOIN rooms r ON r.id = rr.room_id;"
+                      "DROP TABLE room_retention_v1;")) &&
+        executeQuery("DROP TABLE messages_v1;"
+                     "DROP TABLE room_members_v1;"
+                     "DROP TABLE rooms_v1;"
+                     "DROP TABLE users_v1;") &&
+        executeQuery("PRAGMA user_version = 2;") &&
+        executeQuery("COMMIT;");
+
+    if (!success)
+    {
+        LOG_ERROR << "Failed to migrate " << db_path_ << " to integer keys, rolling back";
+        executeQuery("ROLLBACK;");
+    }
+    enableForeignKeys();
+    return success;
 }
 
 bool DatabaseConnection::createUsersTable()
 {
     const char *create_users_table =
         "CREATE TABLE IF NOT EXISTS users ("
-        "id TEXT PRIMARY KEY,"
+        "pk INTEGER PRIMARY KEY,"
+        "id TEXT UNIQUE NOT NULL,"
         "username TEXT UNIQUE NOT NULL,"
         "password_hash TEXT NOT NULL,"
         "created_at INTEGER NOT NULL);";
@@ -93,12 +334,16 @@ bool DatabaseConnection::createRoomsTable()
 {
     const char *create_rooms_table =
         "CREATE TABLE IF NOT EXISTS rooms ("
-        "id TEXT PRIMARY KEY,"
+        "pk INTEGER PRIMARY KEY,"
+        "id TEXT UNIQUE NOT NULL,"
         "name TEXT UNIQUE NOT NULL,"
         "description TEXT DEFAULT '',"
-        "creator_id TEXT NOT NULL,"
+        "creator_pk INTEGER NOT NULL,"
         "created_at INTEGER NOT NULL,"
-        "FOREIGN KEY(creator_id) REFERENCES users(id) ON DELETE CASCADE);";
+        "member_count INTEGER NOT NULL DEFAULT 0,"
+        "message_count INTEGER NOT NULL DEFAULT 0,"
+        "last_activity INTEGER NOT NULL DEFAULT 0,"
+        "FOREIGN KEY(creator_pk) REFERENCES users(pk) ON DELETE CASCADE);";
     
     return executeQuery(create_rooms_table);
 }
@@ -107,12 +352,12 @@ bool DatabaseConnection::createRoomMembersTable()
 {
     const char *create_room_members_table =
         "CREATE TABLE IF NOT EXISTS room_members ("
-        "room_id TEXT NOT NULL,"
-        "user_id TEXT NOT NULL,"
+        "room_pk INTEGER NOT NULL,"
+        "user_pk INTEGER NOT NULL,"
         "joined_at INTEGER NOT NULL,"
-        "PRIMARY KEY(room_id, user_id),"
-        "FOREIGN KEY(room_id) REFERENCES rooms(id) ON DELETE CASCADE,"
-        "FOREIGN KEY(user_id) REFERENCES users(id) ON DELETE CASCADE);";
+        "PRIMARY KEY(room_pk, user_pk),"
+        "FOREIGN KEY(room_pk) REFERENCES rooms(pk) ON DELETE CASCADE,"
+        "FOREIGN KEY(user_pk) REFERENCES users(pk) ON DELETE CASCADE) WITHOUT ROWID;";
     
     return executeQuery(create_room_members_table);
 }
@@ -122,20 +367,113 @@ bool DatabaseConnection::createMessagesTable()
     const char *create_messages_table =
         "CREATE TABLE IF NOT EXISTS messages ("
         "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "room_id TEXT NOT NULL,"
-        "user_id TEXT NOT NULL,"
+        "room_pk INTEGER NOT NULL,"
+        "user_pk INTEGER NOT NULL,"
         "content TEXT NOT NULL,"
         "timestamp INTEGER NOT NULL,"
-        "FOREIGN KEY(room_id) REFERENCES rooms(id) ON DELETE CASCADE,"
-        "FOREIGN KEY(user_id) REFERENCES users(id) ON DELETE CASCADE);";
+        "FOREIGN KEY(room_pk) REFERENCES rooms(pk) ON DELETE CASCADE,"
+        "FOREIGN KEY(user_pk) REFERENCES users(pk) ON DELETE CASCADE);";
     
     return executeQuery(create_messages_table);
 }
 
+bool DatabaseConnection::createRoomRetentionTable()
+{
+    // 房间单独设置的消息保留策略，0 表示不按该条件清理
+    const char *create_room_retention_table =
+        "CREATE TABLE IF NOT EXISTS room_retention ("
+        "room_pk INTEGER PRIMARY KEY,"
+        "max_age_seconds INTEGER NOT NULL DEFAULT 0,"
+        "max_messages INTEGER NOT NULL DEFAULT 0,"
+        "FOREIGN KEY(room_pk) REFERENCES rooms(pk) ON DELETE CASCADE);";
+
+    return executeQuery(create_room_retention_table);
+}
+
+bool DatabaseConnection::createStorageSettingsTable()
+{
+    // 影响数据存放位置的启动参数（如消息分片数），首次启动时记录，之后启动时校验
+    const char *create_storage_settings_table =
+        "CREATE TABLE IF NOT EXISTS storage_settings ("
+        "name TEXT PRIMARY KEY,"
+        "value TEXT NOT NULL);";
+
+    return executeQuery(create_storage_settings_table);
+}
+
 bool DatabaseConnection::createIndexes()
 {
     const char *create_username_index = "CREATE INDEX IF NOT EXISTS idx_users_username ON users(username);";
     const char *create_room_name_index = "CREATE INDEX IF NOT EXISTS idx_rooms_name ON rooms(name);";
+    // 按房间分页查询和按时间清理消息
+    const char *create_message_room_index = "CREATE INDEX IF NOT EXISTS idx_messages_room ON messages(room_pk, id);";
+    const char *create_message_time_index = "CREATE INDEX IF NOT EXISTS idx_messages_room_time ON messages(room_pk, timestamp);";
+    // 成员表主键按房间排列，查询用户加入的房间需要反向索引
+    const char *create_member_user_index = "CREATE INDEX IF NOT EXISTS idx_room_members_user ON room_members(user_pk);";
     
-    return executeQuery(create_username_index) && executeQuery(create_room_name_index);
+    return executeQuery(create_username_index) && executeQuery(create_room_name_index) &&
+           executeQuery(create_message_room_index) && executeQuery(create_message_time_index) &&
+           executeQuery(create_member_user_index);
+}
+
+bool DatabaseConnection::createCounterTriggers()
+{
+    // 房间计数随成员和消息的增删在同一个语句事务中更新，房间列表不需要聚合查询。
+    // INSERT OR IGNORE 忽略的行不会触发；删除房间时级联删除触发的更新找不到房间行，不产生影响
+    const char *create_member_triggers =
+        "CREATE TRIGGER IF NOT EXISTS room_members_count_insert AFTER INSERT ON room_members BEGIN "
+        "UPDATE rooms SET member_count = member_count + 1 WHERE pk = new.room_pk; "
+        "END;"
+        "CREATE TRIGGER IF NOT EXISTS room_members_count_delete AFTER DELETE ON room_members BEGIN "
+        "UPDATE rooms SET member_count = member_count - 1 WHERE pk = old.room_pk; "
+        "END;";
+    const char *create_message_triggers =
+        "CREATE TRIGGER IF NOT EXISTS messages_count_insert AFTER INSERT ON messages BEGIN "
+        "UPDATE rooms SET message_count = message_count + 1, last_activity = MAX(last_activity, new.timestamp) "
+        "WHERE pk = new.room_pk; "
+        "END;"
+        "CREATE TRIGGER IF NOT EXISTS messages_count_delete AFTER DELETE ON messages BEGIN "
+        "UPDATE rooms SET message_count = message_count - 1 WHERE pk = old.room_pk; "
+        "END;";
+
+    return executeQuery(create_member_triggers) && executeQuery(create_message_triggers);
+}
+
+bool DatabaseConnection::createShardMessagesTable()
+{
+    // 分片库中没有用户表和房间表，无法声明外键，由 DatabaseManager 写入前校验
+    const char *create_messages_table =
+        "CREATE TABLE IF NOT EXISTS messages ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "room_id TEXT NOT NULL,"
+        "user_id TEXT NOT NULL,"
+        "content TEXT NOT NULL,"
+        "timestamp INTEGER NOT NULL);";
+    const char *create_room_index = "CREATE INDEX IF NOT EXISTS idx_messages_room ON messages(room_id, id);";
+    const char *create_time_index = "CREATE INDEX IF NOT EXISTS idx_messages_room_time ON messages(room_id, timestamp);";
+
+    return executeQuery(create_messages_table) && executeQuery(create_room_index) && executeQuery(create_time_index);
+}
+
+bool DatabaseConnection::createSearchIndex()
+{
+    // 消息内容的全文索引，外部内容表，不重复保存消息文本。
+    // trigram 分词按任意子串匹配，中文等没有空格分词的文本也能检索
+    const char *create_fts_table =
+        "CREATE VIRTUAL TABLE IF NOT EXISTS messages_fts USING fts5("
+        "content, content='messages', content_rowid='id', tokenize='trigram');";
+    // 已经加入索引的最大消息ID，新消息由后台任务分批加入，不在写入路径上维护
+    const char *create_state_table =
+        "CREATE TABLE IF NOT EXISTS messages_fts_state ("
+        "id INTEGER PRIMARY KEY CHECK (id = 0),"
+        "last_indexed_id INTEGER NOT NULL);"
+        "INSERT OR IGNORE INTO messages_fts_state (id, last_indexed_id) VALUES (0, 0);";
+    // 删除（包括级联删除和清理）很少发生，用触发器同步移除已经进入索引的消息
+    const char *create_delete_trigger =
+        "CREATE TRIGGER IF NOT EXISTS messages_fts_delete AFTER DELETE ON messages "
+        "WHEN old.id <= (SELECT last_indexed_id FROM messages_fts_state) BEGIN "
+        "INSERT INTO messages_fts (messages_fts, rowid, content) VALUES ('delete', old.id, old.content); "
+        "END;";
+
+    return executeQuery(create_fts_table) && executeQuery(create_state_table) && executeQuery(create_delete_trigger);
 }
@@ -3,34 +3,80 @@
 #include <string>
 #include <sqlite3.h>
 #include <mutex>
+#include <unordered_map>
+#include "query_stats.hpp"
 #include "../utils/logger.hpp"
 
 // 数据库连接管理基类
 class DatabaseConnection
 {
 public:
-    explicit DatabaseConnection(const std::string &db_path);
+    // 数据库文件包含的表结构
+    enum class Schema
+    {
+        Full,        // 完整的元数据库：用户、房间、成员、消息
+        MessagesOnly // 消息分片库：只有消息表，引用关系由元数据库校验
+    };
+
+    // 元数据库的表结构版本，记录在 PRAGMA user_version 中
+    // 1: 字符串ID作为主键和外键；2: 整数主键，字符串ID只在对外接口中使用；
+    // 3: rooms 表上维护成员数、消息数和最后活跃时间
+    static constexpr int kSchemaVersion = 3;
+
+    explicit DatabaseConnection(const std::string &db_path, Schema schema = Schema::Full);
     virtual ~DatabaseConnection();//后面需要通过基类指针来删除一个派生类，所以需要将基类的析构函数声明为虚函数
 
     bool isConnected() const { return db_ != nullptr; }
     sqlite3* getDb() const { return db_; }
 
-    // 互斥锁访问接口
-    std::recursive_mutex& getMutex() { return mutex_; }
+    // 互斥锁访问接口，锁会记录调用方的等待时间
+    using Mutex = InstrumentedMutex;
+    Mutex& getMutex() { return mutex_; }
+
+    // SQL 执行统计
+    QueryStats& getQueryStats() { return stats_; }
+    const std::string& getPath() const { return db_path_; }
+
+    // 获取缓存的预编译语句，调用方需持有互斥锁，使用后不要 finalize
+    sqlite3_stmt *getCachedStatement(const char *sql);
+
+    // 后台维护：增量回收最多 vacuum_pages 个空闲页，WAL 模式下执行一次被动检查点
+    bool runMaintenance(int vacuum_pages);
+
+    // 显式事务，调用方需在整个事务期间持有互斥锁
+    bool beginTransaction();
+    bool commitTransaction();
+    void rollbackTransaction();
+    // 只读事务：WAL 模式下事务内的多次查询读到同一个快照。已经在事务中时返回 false，不嵌套
+    bool beginReadTransaction();
+    void endReadTransaction();
 
 protected:
     bool executeQuery(const std::string &query);
     bool initializeTables();
     bool enableForeignKeys();
+    int64_t queryInt(const std::string &query);
+    bool tableExists(const std::string &table);
 
     sqlite3 *db_;                // 指向sqlite3 结构体的指针
     std::string db_path_;        // 数据库路径
-    mutable std::recursive_mutex mutex_; // 递归互斥锁
+    QueryStats stats_;           // SQL 执行统计，需在 mutex_ 之前构造
+    mutable Mutex mutex_;        // 递归互斥锁
+    Schema schema_;              // 表结构类型
+    bool wal_ = false;           // 是否为 WAL 模式
+    std::unordered_map<std::string, sqlite3_stmt *> statement_cache_; // 预编译语句缓存
 
 private:
     bool createUsersTable();
     bool createRoomsTable();
     bool createRoomMembersTable();
     bool createMessagesTable();
+    bool createRoomRetentionTable();
+    bool createStorageSettingsTable();
     bool createIndexes();
+    bool createShardMessagesTable();
+    bool createSearchIndex();
+    bool createCounterTriggers();
+    bool migrateToIntegerKeys();
+    bool migrateToRoomCounters();
 };
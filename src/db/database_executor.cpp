@@ -0,0 +1,159 @@
+#include "database_executor.hpp"
+#include "../utils/logger.hpp"
+
+DatabaseExecutor::DatabaseExecutor(size_t num_threads, size_t max_queue_size)
+    : lanes_(kLaneCount), max_queue_size_(max_queue_size), stop_(false), rejected_count_(0)
+{
+    for (size_t i = 0; i < num_threads; ++i)
+    {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+DatabaseExecutor::~DatabaseExecutor()
+{
+    stop();
+}
+
+bool DatabaseExecutor::trySubmit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (!acceptLocked())
+        {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+    return true;
+}
+
+bool DatabaseExecutor::trySubmit(const std::string &key, std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (!acceptLocked())
+        {
+            return false;
+        }
+        size_t index = std::hash<std::string>()(key) % lanes_.size();
+        Lane &lane = lanes_[index];
+        if (lane.busy)
+        {
+            // 通道中已有任务，等它执行完再接着调度
+            lane.pending.push_back(std::move(task));
+            ++lane_pending_;
+            return true;
+        }
+        lane.busy = true;
+        tasks_.push_back(laneTask(index, std::move(task)));
+    }
+    condition_.notify_one();
+    return true;
+}
+
+bool DatabaseExecutor::acceptLocked()
+{
+    if (stop_)
+    {
+        return false;
+    }
+    if (tasks_.size() + lane_pending_ >= max_queue_size_)
+    {
+        // 队列已满，拒绝任务，由调用方返回明确的过载错误
+        uint64_t rejected = ++rejected_count_;
+        if ((rejected & (rejected - 1)) == 0) // 按2的幂次记录，避免过载时日志刷屏
+        {
+            LOG_WARN << "DatabaseExecutor queue full (" << max_queue_size_ << "), rejected " << rejected << " tasks so far";
+        }
+        return false;
+    }
+    return true;
+}
+
+std::function<void()> DatabaseExecutor::laneTask(size_t lane, std::function<void()> task)
+{
+    return [this, lane, task = std::move(task)]()
+    {
+        try
+        {
+            task();
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR << "DatabaseExecutor task exception: " << e.what();
+        }
+
+        // 执行完后把通道里的下一个任务放到共享队列末尾，其他通道的任务不会被饿死；
+        // 停止过程中也照常调度，已接受的任务都会执行
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            Lane &current = lanes_[lane];
+            if (current.pending.empty())
+            {
+                current.busy = false;
+                return;
+            }
+            tasks_.push_back(laneTask(lane, std::move(current.pending.front())));
+            current.pending.pop_front();
+            --lane_pending_;
+        }
+        condition_.notify_one();
+    };
+}
+
+void DatabaseExecutor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (stop_ && workers_.empty())
+        {
+            return;
+        }
+        stop_ = true;
+    }
+    condition_.notify_all();
+    for (std::thread &worker : workers_)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+size_t DatabaseExecutor::pendingCount() const
+{
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    return tasks_.size() + lane_pending_;
+}
+
+void DatabaseExecutor::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            // 停止后仍然把已入队的任务执行完，保证已接受的写操作不会丢失
+            if (stop_ && tasks_.empty())
+            {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR << "DatabaseExecutor task exception: " << e.what();
+        }
+    }
+}
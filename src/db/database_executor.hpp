@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <optional>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <string>
+
+// 专用的数据库执行器
+// 数据库操作投递到独立的工作线程执行，调用线程（HTTP工作线程、WebSocket事件循环）不必等待磁盘IO。
+// 队列有上限，队列满时提交直接失败，由调用方把过载显式反馈给客户端，而不是无限排队拉长延迟。
+// 带 key 提交的任务按 key 哈希到串行通道：同一通道的任务按提交顺序逐个执行，不同通道在多个工作线程上并行
+class DatabaseExecutor
+{
+public:
+    explicit DatabaseExecutor(size_t num_threads = 1, size_t max_queue_size = 1024);
+    ~DatabaseExecutor();
+
+    DatabaseExecutor(const DatabaseExecutor &) = delete;
+    DatabaseExecutor &operator=(const DatabaseExecutor &) = delete;
+
+    // 提交一个任务，队列已满或执行器已停止时返回 false
+    bool trySubmit(std::function<void()> task);
+    // 提交一个需要与同 key 任务保持顺序的任务（如同一房间的消息），排队中的通道任务同样计入队列上限
+    bool trySubmit(const std::string &key, std::function<void()> task);
+
+    // 提交一个有返回值的任务，通过 future 获取结果；被拒绝时返回 std::nullopt
+    template <class F>
+    auto submit(F &&op) -> std::optional<std::future<std::invoke_result_t<F>>>
+    {
+        using return_type = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<return_type()>>(std::forward<F>(op));
+        std::future<return_type> result = task->get_future();
+        if (!trySubmit([task]() { (*task)(); }))
+        {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    // 停止执行器，已入队的任务会被执行完
+    void stop();
+
+    size_t pendingCount() const;                          // 当前排队的任务数
+    size_t maxQueueSize() const { return max_queue_size_; }
+    uint64_t rejectedCount() const { return rejected_count_.load(); } // 因队列满被拒绝的任务数
+
+private:
+    static constexpr size_t kLaneCount = 64;
+
+    // 串行通道：同一时刻最多有一个任务在共享队列中或正在执行，其余在 pending 中等待
+    struct Lane
+    {
+        bool busy = false;
+        std::deque<std::function<void()>> pending;
+    };
+
+    void workerLoop();
+    bool acceptLocked(); // 持有队列锁时检查能否接受新任务
+    std::function<void()> laneTask(size_t lane, std::function<void()> task);
+
+    std::vector<std::thread> workers_;        // 工作线程
+    std::deque<std::function<void()>> tasks_; // 任务队列
+    std::vector<Lane> lanes_;                 // 串行通道，受 queue_mutex_ 保护
+    size_t lane_pending_ = 0;                 // 各通道 pending 中的任务总数
+    size_t max_queue_size_;                   // 队列上限
+    mutable std::mutex queue_mutex_;          // 队列锁
+    std::condition_variable condition_;
+    bool stop_;
+    std::atomic<uint64_t> rejected_count_;
+};
@@ -1,19 +1,260 @@
 #include "database_manager.hpp"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
 
-DatabaseManager::DatabaseManager(const std::string &db_path):db_conn_(std::make_unique<DatabaseConnection>(db_path))
+namespace
 {
-    if (db_conn_->isConnected())
+// 分片库文件路径：chat.db -> chat.db.shard0, chat.db.shard1 ...
+std::string shardPath(const std::string &db_path, size_t index)
+{
+    if (db_path == ":memory:")
+    {
+        return db_path;
+    }
+    return db_path + ".shard" + std::to_string(index);
+}
+
+// FNV-1a 哈希，结果与平台和标准库实现无关，保证重启后房间仍映射到同一个分片
+uint64_t stableHash(const std::string &key)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// 不区分 ASCII 大小写的子串查找
+bool containsIgnoreCase(const std::string &text, const std::string &term)
+{
+    auto it = std::search(text.begin(), text.end(), term.begin(), term.end(), [](char a, char b)
+                          { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); });
+    return it != text.end();
+}
+
+// 读事务守卫：构造时开始只读事务，析构时结束，查询中抛出异常时也不会把事务留在连接上
+class ReadTransaction
+{
+public:
+    explicit ReadTransaction(DatabaseConnection *conn)
+        : conn_(conn && conn->beginReadTransaction() ? conn : nullptr) {}
+    ~ReadTransaction()
+    {
+        if (conn_)
+        {
+            conn_->endReadTransaction();
+        }
+    }
+
+    ReadTransaction(const ReadTransaction &) = delete;
+    ReadTransaction &operator=(const ReadTransaction &) = delete;
+
+private:
+    DatabaseConnection *conn_;
+};
+} // namespace
+
+DatabaseManager::DatabaseManager(const std::string &db_path, size_t message_shards)
+    : DatabaseManager(db_path, DatabaseOptions{message_shards}) {}
+
+DatabaseManager::DatabaseManager(const std::string &db_path, const DatabaseOptions &options)
+    : executor_(options.executor_threads)
+{
+    openStorage(db_path, options);
+    // 房间策略保存在元数据库中，内存引擎没有元数据库
+    retention_ = std::make_unique<MessageRetention>(*this, db_conn_ && db_conn_->isConnected() ? db_conn_.get() : nullptr);
+    search_indexer_ = std::make_unique<SearchIndexer>(*this);
+
+    // 备份顺序与文件命名对应：元数据库在前，随后是各消息分片
+    std::vector<DatabaseConnection *> backup_sources;
+    if (db_conn_ && db_conn_->isConnected())
+    {
+        backup_sources.push_back(db_conn_.get());
+        for (const auto &conn : shard_conns_)
+        {
+            backup_sources.push_back(conn.get());
+        }
+    }
+    backup_ = std::make_unique<DatabaseBackup>(std::move(backup_sources));
+}
+
+void DatabaseManager::openStorage(const std::string &db_path, const DatabaseOptions &options)
+{
+    if (db_path == kMemoryEnginePath)
+    {
+        if (options.message_shards > 1 || options.message_engine != MessageEngine::Sqlite)
+        {
+            LOG_WARN << "In-memory storage engine ignores message_shards and message_engine";
+        }
+        openMemoryEngine();
+        return;
+    }
+
+    db_conn_ = std::make_unique<DatabaseConnection>(db_path);
+    if (!db_conn_->isConnected())
+    {
+        return;
+    }
+
+    // 创建各个仓库
+    user_repo_ = std::make_unique<SqliteUserRepository>(db_conn_.get());
+    room_repo_ = std::make_unique<SqliteRoomRepository>(db_conn_.get());
+
+    if (options.message_engine == MessageEngine::Log)
+    {
+        if (db_path == ":memory:")
+        {
+            LOG_WARN << "Message log engine needs a database file path, falling back to SQLite message storage";
+        }
+        else
+        {
+            if (options.message_shards > 1)
+            {
+                LOG_WARN << "Message log engine keeps one log per room, message_shards is ignored";
+            }
+            openMessageLog(db_path + ".msglog", options);
+            return;
+        }
+    }
+
+    if (!checkMessageShardCount(db_path, std::max<size_t>(1, options.message_shards)))
+    {
+        return;
+    }
+    if (options.message_shards <= 1)
+    {
+        // 不分片：消息与元数据在同一个库中
+        message_repos_.push_back(std::make_unique<SqliteMessageRepository>(db_conn_.get()));
+        return;
+    }
+    openMessageShards(db_path, options.message_shards);
+}
+
+void DatabaseManager::openMemoryEngine()
+{
+    user_repo_ = std::make_unique<MemoryUserRepository>();
+    room_repo_ = std::make_unique<MemoryRoomRepository>(user_repo_.get());
+    message_repos_.push_back(std::make_unique<MemoryMessageRepository>(user_repo_.get()));
+    // 内存消息存储同样没有外键，由本类校验引用并在删除房间时清理
+    external_messages_ = true;
+    LOG_WARN << "Using in-memory storage engine, all data will be lost on exit";
+}
+
+void DatabaseManager::openMessageShards(const std::string &db_path, size_t message_shards)
+{
+    for (size_t i = 0; i < message_shards; ++i)
+    {
+        auto conn = std::make_unique<DatabaseConnection>(shardPath(db_path, i), DatabaseConnection::Schema::MessagesOnly);
+        if (!conn->isConnected())
+        {
+            LOG_ERROR << "Failed to open message shard " << i << ": " << shardPath(db_path, i);
+            message_repos_.clear();
+            shard_conns_.clear();
+            return;
+        }
+        message_repos_.push_back(std::make_unique<SqliteMessageRepository>(conn.get(), user_repo_.get(),
+                                                                           static_cast<int>(i), static_cast<int>(message_shards)));
+        shard_conns_.push_back(std::move(conn));
+    }
+    external_messages_ = true;
+    LOG_INFO << "Message storage sharded across " << message_shards << " databases";
+    warnUnmigratedMessages();
+}
+
+void DatabaseManager::openMessageLog(const std::string &dir, const DatabaseOptions &options)
+{
+    LogMessageRepository::Options log_options;
+    log_options.sync_interval = options.log_sync_interval;
+    auto repo = std::make_unique<LogMessageRepository>(dir, user_repo_.get(), log_options);
+    if (!repo->isOpen())
     {
-        // 创建各个仓库
-        user_repo_ = std::make_unique<UserRepository>(db_conn_.get());
-        room_repo_ = std::make_unique<RoomRepository>(db_conn_.get());
-        message_repo_ = std::make_unique<MessageRepository>(db_conn_.get());
+        LOG_ERROR << "Failed to open message log: " << dir;
+        return;
     }
+    message_repos_.push_back(std::move(repo));
+    external_messages_ = true;
+    LOG_INFO << "Message storage uses append-only log at " << dir;
+    warnUnmigratedMessages();
+}
+
+void DatabaseManager::warnUnmigratedMessages()
+{
+    // 元数据库中已有的消息在独立的消息存储中不可见，提示需要迁移
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db_conn_->getDb(), "SELECT EXISTS(SELECT 1 FROM messages);", -1, &stmt, nullptr) == SQLITE_OK)
+    {
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) == 1)
+        {
+            LOG_WARN << "Database " << db_conn_->getPath() << " still contains messages that are not served by the configured message storage";
+        }
+        sqlite3_finalize(stmt);
+    }
+}
+
+bool DatabaseManager::checkMessageShardCount(const std::string &db_path, size_t message_shards)
+{
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    sqlite3 *db = db_conn_->getDb();
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT value FROM storage_settings WHERE name = 'message_shards';", -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to read storage settings: " << sqlite3_errmsg(db);
+        return false;
+    }
+    std::optional<std::string> stored;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        stored = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+
+    std::string configured = std::to_string(message_shards);
+    if (stored)
+    {
+        if (*stored != configured)
+        {
+            LOG_ERROR << "Database " << db_path << " was created with " << *stored << " message shards but "
+                      << configured << " are configured; restart with --message-shards " << *stored << " or migrate the messages first";
+            return false;
+        }
+        return true;
+    }
+
+    if (sqlite3_prepare_v2(db, "INSERT INTO storage_settings (name, value) VALUES ('message_shards', ?);", -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to record storage settings: " << sqlite3_errmsg(db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, configured.c_str(), -1, SQLITE_TRANSIENT);
+    bool recorded = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    if (!recorded)
+    {
+        LOG_ERROR << "Failed to record storage settings: " << sqlite3_errmsg(db);
+    }
+    return recorded;
 }
 
 bool DatabaseManager::isConnected() const
 {
-    return db_conn_ && db_conn_->isConnected();
+    // 内存引擎没有数据库连接
+    return (!db_conn_ || db_conn_->isConnected()) && user_repo_ && !message_repos_.empty();
+}
+
+MessageRepository *DatabaseManager::messageRepoFor(const std::string &room_id) const
+{
+    if (message_repos_.empty()) return nullptr;
+    if (message_repos_.size() == 1) return message_repos_.front().get();
+    return message_repos_[stableHash(room_id) % message_repos_.size()].get();
+}
+
+MessageRepository *DatabaseManager::messageRepoForId(int64_t message_id) const
+{
+    if (message_repos_.empty() || message_id < 0) return nullptr;
+    return message_repos_[message_id % message_repos_.size()].get();
 }
 
 // 用户操作代理
@@ -37,6 +278,14 @@ std::vector<User> DatabaseManager::getAllUsers()
     return user_repo_ ? user_repo_->getAllUsers() : std::vector<User>();
 }
 
+void DatabaseManager::visitUsers(const std::string &after, size_t limit, const UserRowVisitor &visitor) const
+{
+    if (user_repo_)
+    {
+        user_repo_->visitUsers(after, limit, visitor);
+    }
+}
+
 
 std::optional<User> DatabaseManager::getUserByUsername(const std::string &username) const
 {
@@ -48,6 +297,11 @@ std::optional<User> DatabaseManager::getUserById(const std::string &user_id) con
     return user_repo_ ? user_repo_->getUserById(user_id) : std::nullopt;
 }
 
+std::unordered_map<std::string, std::string> DatabaseManager::getUsernames(const std::vector<std::string> &user_ids) const
+{
+    return user_repo_ ? user_repo_->getUsernames(user_ids) : std::unordered_map<std::string, std::string>();
+}
+
 std::string DatabaseManager::generateUserId()
 {
     return user_repo_ ? user_repo_->generateUserId() : "";
@@ -61,7 +315,18 @@ std::optional<Room> DatabaseManager::createRoom(const std::string &name, const s
 
 bool DatabaseManager::deleteRoom(const std::string &room_id)
 {
-    return room_repo_ ? room_repo_->deleteRoom(room_id) : false;
+    if (!room_repo_ || !room_repo_->deleteRoom(room_id))
+    {
+        return false;
+    }
+    // 独立消息存储中的消息不会随房间级联删除，需要手动清理
+    if (external_messages_)
+    {
+        messageRepoFor(room_id)->deleteRoomMessages(room_id);
+    }
+    message_cache_.evictRoom(room_id);
+    retention_->forgetRoom(room_id);
+    return true;
 }
 
 bool DatabaseManager::roomExists(const std::string &room_id)
@@ -105,6 +370,14 @@ std::vector<nlohmann::json> DatabaseManager::getRoomMembers(const std::string &r
     return room_repo_ ? room_repo_->getRoomMembers(room_id) : std::vector<nlohmann::json>();
 }
 
+void DatabaseManager::visitRoomMembers(const std::string &room_id, const MemberRowVisitor &visitor) const
+{
+    if (room_repo_)
+    {
+        room_repo_->visitRoomMembers(room_id, visitor);
+    }
+}
+
 std::vector<Room> DatabaseManager::getUserJoinedRooms(const std::string &user_id) const
 {
     return room_repo_ ? room_repo_->getUserJoinedRooms(user_id) : std::vector<Room>();
@@ -120,25 +393,308 @@ bool DatabaseManager::removeRoomMember(const std::string &room_id, const std::st
     return room_repo_ ? room_repo_->removeRoomMember(room_id, user_id) : false;
 }
 
+bool DatabaseManager::isRoomMember(const std::string &room_id, const std::string &user_id) const
+{
+    return room_repo_ ? room_repo_->isRoomMember(room_id, user_id) : false;
+}
+
+size_t DatabaseManager::getRoomMemberCount(const std::string &room_id) const
+{
+    return room_repo_ ? room_repo_->getRoomMemberCount(room_id) : 0;
+}
+
+MembershipStatus DatabaseManager::checkMembership(const std::string &room_id, const std::string &user_id) const
+{
+    return room_repo_ ? room_repo_->checkMembership(room_id, user_id) : MembershipStatus::RoomNotFound;
+}
+
+JoinResult DatabaseManager::joinRoom(const std::string &room_id, const std::string &user_id)
+{
+    return room_repo_ ? room_repo_->joinRoom(room_id, user_id) : JoinResult::Failed;
+}
+
+MembershipStatus DatabaseManager::getMessagePageIfMember(const std::string &room_id, const std::string &user_id, int limit,
+                                                         int64_t before_id, std::vector<std::string> &message_jsons)
+{
+    MessageRepository *repo = messageRepoFor(room_id);
+    if (!room_repo_ || !repo)
+    {
+        return MembershipStatus::RoomNotFound;
+    }
+
+    // 消息也在元数据库中时只加这一次锁，仓库内部的加锁是同一线程的重入；
+    // 分片库和日志引擎的消息在另一个连接上，成员校验和读取消息各自加锁
+    std::unique_lock<DatabaseConnection::Mutex> lock;
+    DatabaseConnection *shared_conn = db_conn_ && !external_messages_ ? db_conn_.get() : nullptr;
+    if (shared_conn)
+    {
+        lock = std::unique_lock<DatabaseConnection::Mutex>(shared_conn->getMutex());
+    }
+    ReadTransaction transaction(shared_conn);
+
+    MembershipStatus status = room_repo_->checkMembership(room_id, user_id);
+    if (status != MembershipStatus::Member)
+    {
+        return status;
+    }
+
+    if (before_id > 0)
+    {
+        // 更早的分页直接回源数据库
+        for (const auto &message : repo->getRecentMessages(room_id, limit, before_id))
+        {
+            message_jsons.push_back(message.toJson().dump());
+        }
+    }
+    else if (!message_cache_.getRecent(room_id, limit, message_jsons))
+    {
+        // 缓存未命中，按缓存容量从数据库加载最近的消息并填充缓存
+        int warm_count = std::max(limit, static_cast<int>(message_cache_.capacity()));
+        auto messages = repo->getRecentMessages(room_id, warm_count, 0);
+        message_cache_.warm(room_id, messages, messages.size() < static_cast<size_t>(warm_count));
+
+        size_t start = messages.size() > static_cast<size_t>(limit) ? messages.size() - limit : 0;
+        for (size_t i = start; i < messages.size(); ++i)
+        {
+            message_jsons.push_back(messages[i].toJson().dump());
+        }
+    }
+    return status;
+}
+
+bool DatabaseManager::getMessagesAfter(const std::string &room_id, int64_t after_id, int limit, std::vector<std::string> &message_jsons)
+{
+    MessageRepository *repo = messageRepoFor(room_id);
+    if (!repo || limit <= 0)
+    {
+        return true;
+    }
+
+    bool truncated = false;
+    if (message_cache_.getAfter(room_id, after_id, limit, message_jsons, truncated))
+    {
+        return !truncated;
+    }
+
+    // 多取一条用于判断缺口是否超过 limit
+    int warm_count = std::max(limit + 1, static_cast<int>(message_cache_.capacity()));
+    auto messages = repo->getRecentMessages(room_id, warm_count, 0);
+    message_cache_.warm(room_id, messages, messages.size() < static_cast<size_t>(warm_count));
+
+    auto first = std::upper_bound(messages.begin(), messages.end(), after_id,
+                                  [](int64_t id, const Message &message) { return id < message.getId(); });
+    size_t newer = static_cast<size_t>(messages.end() - first);
+    size_t count = std::min(newer, static_cast<size_t>(limit));
+    message_jsons.clear();
+    for (auto it = messages.end() - count; it != messages.end(); ++it)
+    {
+        message_jsons.push_back(it->toJson().dump());
+    }
+    return newer <= static_cast<size_t>(limit);
+}
+
 // 消息操作代理
 bool DatabaseManager::saveMessage(const std::string &room_id, const std::string &user_id,
-                                   const std::string &content, int64_t timestamp)
+                                   const std::string &content, int64_t timestamp,
+                                   int64_t *message_id)
 {
-    return message_repo_ ? message_repo_->saveMessage(room_id, user_id, content, timestamp) : false;
+    MessageRepository *repo = messageRepoFor(room_id);
+    if (!repo)
+    {
+        return false;
+    }
+    // 独立消息存储没有外键约束，写入前在元数据库中校验房间和用户
+    if (external_messages_ && !(room_repo_->roomExists(room_id) && user_repo_->userExists(user_id)))
+    {
+        return false;
+    }
+    if (!repo->saveMessage(room_id, user_id, content, timestamp, message_id))
+    {
+        return false;
+    }
+    // 元数据库里的消息由触发器维护房间计数，独立消息存储需要在这里补上
+    if (external_messages_)
+    {
+        room_repo_->recordMessageActivity(room_id, 1, timestamp);
+    }
+    return true;
 }
 
 std::vector<Message> DatabaseManager::getMessages(const std::string &room_id, int limit,
                                                   int64_t before_timestamp)
 {
-    return message_repo_ ? message_repo_->getMessages(room_id, limit, before_timestamp) : std::vector<Message>();
+    MessageRepository *repo = messageRepoFor(room_id);
+    return repo ? repo->getMessages(room_id, limit, before_timestamp) : std::vector<Message>();
+}
+
+std::vector<Message> DatabaseManager::getRecentMessages(const std::string &room_id, int limit,
+                                                        int64_t before_id)
+{
+    MessageRepository *repo = messageRepoFor(room_id);
+    return repo ? repo->getRecentMessages(room_id, limit, before_id) : std::vector<Message>();
 }
 
 std::optional<Message> DatabaseManager::getMessageById(int64_t message_id)
 {
-    return message_repo_ ? message_repo_->getMessageById(message_id) : std::nullopt;
+    MessageRepository *repo = messageRepoForId(message_id);
+    return repo ? repo->getMessageById(message_id) : std::nullopt;
 }
 
 std::vector<Room> DatabaseManager::getAllRooms()
 {
     return room_repo_ ? room_repo_->getAllRooms() : std::vector<Room>();
 }
+
+void DatabaseManager::visitRooms(const std::string &after, size_t limit, const RoomRowVisitor &visitor) const
+{
+    if (room_repo_)
+    {
+        room_repo_->visitRooms(after, limit, visitor);
+    }
+}
+
+// 消息保留
+size_t DatabaseManager::purgeRoomMessages(const std::string &room_id, int64_t before_timestamp,
+                                          size_t keep_latest, size_t batch_size)
+{
+    MessageRepository *repo = messageRepoFor(room_id);
+    if (!repo)
+    {
+        return 0;
+    }
+    size_t deleted = repo->purgeMessages(room_id, before_timestamp, keep_latest, batch_size);
+    if (deleted > 0)
+    {
+        // 热缓存中可能还有被清理的消息
+        message_cache_.evictRoom(room_id);
+        if (external_messages_)
+        {
+            room_repo_->recordMessageActivity(room_id, -static_cast<int64_t>(deleted), 0);
+        }
+    }
+    return deleted;
+}
+
+std::vector<Message> DatabaseManager::searchMessages(const std::string &room_id, const std::string &query,
+                                                    int limit, int offset, bool *partial)
+{
+    if (partial)
+    {
+        *partial = false;
+    }
+    MessageRepository *repo = messageRepoFor(room_id);
+    if (!repo || limit <= 0)
+    {
+        return {};
+    }
+
+    // 索引由 SearchIndexer 在后台维护，尚未索引的新消息由存储自己按内容匹配
+    if (auto results = repo->searchMessages(room_id, query, limit, offset))
+    {
+        return *results;
+    }
+
+    // 存储没有全文索引（日志引擎、内存引擎），从最新的消息开始逐页扫描
+    std::vector<std::string> terms;
+    std::istringstream iss(query);
+    for (std::string term; iss >> term;)
+    {
+        terms.push_back(term);
+    }
+    std::vector<Message> results;
+    if (terms.empty())
+    {
+        return results;
+    }
+
+    // 匹配很少的词会一直扫描到房间最早的消息，限制单次搜索扫描的页数
+    const int page_size = 500;
+    const int max_pages = 20;
+    int skipped = 0;
+    int64_t before_id = 0;
+    for (int pages = 0; results.size() < static_cast<size_t>(limit); ++pages)
+    {
+        if (pages == max_pages)
+        {
+            if (partial)
+            {
+                *partial = true; // 更早的消息没有搜索
+            }
+            break;
+        }
+        auto page = repo->getRecentMessages(room_id, page_size, before_id);
+        for (auto it = page.rbegin(); it != page.rend() && results.size() < static_cast<size_t>(limit); ++it)
+        {
+            bool matched = std::all_of(terms.begin(), terms.end(), [&it](const std::string &term)
+                                       { return containsIgnoreCase(it->getContent(), term); });
+            if (matched && skipped++ >= offset)
+            {
+                results.push_back(*it);
+            }
+        }
+        if (page.size() < static_cast<size_t>(page_size))
+        {
+            break;
+        }
+        before_id = page.front().getId();
+    }
+    return results;
+}
+
+void DatabaseManager::runStorageMaintenance(int vacuum_pages)
+{
+    if (db_conn_)
+    {
+        db_conn_->runMaintenance(vacuum_pages);
+    }
+    for (const auto &conn : shard_conns_)
+    {
+        conn->runMaintenance(vacuum_pages);
+    }
+}
+
+// SQL 执行统计
+nlohmann::json DatabaseManager::getQueryStats() const
+{
+    nlohmann::json connections = nlohmann::json::array();
+    auto append = [&connections](DatabaseConnection &conn)
+    {
+        nlohmann::json entry = conn.getQueryStats().toJson();
+        entry["database"] = conn.getPath();
+        connections.push_back(std::move(entry));
+    };
+
+    if (db_conn_)
+    {
+        append(*db_conn_);
+    }
+    for (const auto &conn : shard_conns_)
+    {
+        append(*conn);
+    }
+    return connections;
+}
+
+void DatabaseManager::resetQueryStats()
+{
+    if (db_conn_)
+    {
+        db_conn_->getQueryStats().reset();
+    }
+    for (const auto &conn : shard_conns_)
+    {
+        conn->getQueryStats().reset();
+    }
+}
+
+void DatabaseManager::setSlowQueryThreshold(std::chrono::milliseconds threshold)
+{
+    if (db_conn_)
+    {
+        db_conn_->getQueryStats().setSlowQueryThreshold(threshold);
+    }
+    for (const auto &conn : shard_conns_)
+    {
+        conn->getQueryStats().setSlowQueryThreshold(threshold);
+    }
+}
@@ -2,19 +2,55 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <chrono>
 #include "database_connection.hpp"
 #include "user_repository.hpp"
 #include "room_repository.hpp"
 #include "message_repository.hpp"
+#include "sqlite_user_repository.hpp"
+#include "sqlite_room_repository.hpp"
+#include "sqlite_message_repository.hpp"
+#include "log_message_repository.hpp"
+#include "memory_user_repository.hpp"
+#include "memory_room_repository.hpp"
+#include "memory_message_repository.hpp"
+#include "message_cache.hpp"
+#include "database_executor.hpp"
+#include "message_retention.hpp"
+#include "search_indexer.hpp"
+#include "database_backup.hpp"
 #include "../model/user.hpp"
 #include "../model/room.hpp"
 #include "../model/message.hpp"
 
+// 消息存储引擎
+enum class MessageEngine
+{
+    Sqlite, // 消息保存在SQLite中（可按房间分片）
+    Log     // 追加写的分段日志
+};
+
+// 数据库启动选项
+struct DatabaseOptions
+{
+    size_t message_shards = 1;                            // SQLite 消息分片数
+    MessageEngine message_engine = MessageEngine::Sqlite; // 消息存储引擎
+    std::chrono::milliseconds log_sync_interval{100};     // 日志引擎批量刷盘间隔
+    size_t executor_threads = 4;                          // 异步执行器线程数，同一房间的任务仍按提交顺序执行
+};
+
 // 重构后的数据库管理类 - 作为各个仓库的组合
 class DatabaseManager
 {
 public:
-    explicit DatabaseManager(const std::string &db_path);
+    // 以此作为 db_path 时使用纯内存存储（用户、房间、成员、消息都不落盘），用于压测网络层和测试
+    static constexpr const char *kMemoryEnginePath = ":memory-engine:";
+
+    // message_shards > 1 时消息按房间哈希分散存放到多个独立的SQLite文件中，
+    // 每个分片有自己的连接和写锁；用户、房间、成员等元数据仍在 db_path 中
+    explicit DatabaseManager(const std::string &db_path, size_t message_shards = 1);
+    DatabaseManager(const std::string &db_path, const DatabaseOptions &options);
     ~DatabaseManager() = default;
 
     // 检查数据库连接状态
@@ -25,8 +61,10 @@ public:
     bool validateUser(const std::string &username, const std::string &password_hash);
     bool userExists(const std::string &user_id);
     std::vector<User> getAllUsers();
+    void visitUsers(const std::string &after, size_t limit, const UserRowVisitor &visitor) const;// 逐行回调，不构造对象
     std::optional<User> getUserById(const std::string &user_id) const;
     std::optional<User> getUserByUsername(const std::string &username) const;
+    std::unordered_map<std::string, std::string> getUsernames(const std::vector<std::string> &user_ids) const;// 批量查询用户名
     std::string generateUserId();
 
     // 房间操作代理
@@ -35,6 +73,7 @@ public:
     bool roomExists(const std::string &room_id);
     std::vector<std::string> getRooms();
     std::vector<Room> getAllRooms();
+    void visitRooms(const std::string &after, size_t limit, const RoomRowVisitor &visitor) const;// 逐行回调，不构造对象
     std::optional<Room> getRoomById(const std::string &room_id) const;
     std::optional<std::string> getRoomIdByName(const std::string &room_name) const;
     std::string generateRoomId();
@@ -43,25 +82,95 @@ public:
 
     // 房间成员操作代理
     std::vector<nlohmann::json> getRoomMembers(const std::string &room_id) const;
+    void visitRoomMembers(const std::string &room_id, const MemberRowVisitor &visitor) const;
     std::vector<Room> getUserJoinedRooms(const std::string &user_id) const;
     bool addRoomMember(const std::string &room_id, const std::string &user_id);
     bool removeRoomMember(const std::string &room_id, const std::string &user_id);
+    bool isRoomMember(const std::string &room_id, const std::string &user_id) const;
+    size_t getRoomMemberCount(const std::string &room_id) const;
+
+    // 组合操作：服务层一次调用完成校验和读写，不在多次调用之间反复加锁
+    MembershipStatus checkMembership(const std::string &room_id, const std::string &user_id) const;
+    JoinResult joinRoom(const std::string &room_id, const std::string &user_id);
+    // 用户是房间成员时取一页消息（预先序列化的 JSON，按时间正序），返回成员校验结果；
+    // before_id 为 0 时取最新一页，优先走热消息缓存，未命中时回源数据库并填充缓存。
+    // 消息与元数据在同一个库中时，校验和读取在一次加锁、一个读事务内完成
+    MembershipStatus getMessagePageIfMember(const std::string &room_id, const std::string &user_id, int limit,
+                                            int64_t before_id, std::vector<std::string> &message_jsons);
+
+    // 断线重连时补发房间中ID大于 after_id 的消息（预先序列化的 JSON，按时间正序），最多返回最新的 limit 条。
+    // 消息ID在房间内严格递增，即房间的消息序号。优先走热消息缓存，未命中时回源数据库并填充缓存，
+    // 重连风暴中同一房间之后的补发都能命中缓存。缺口超过 limit 条时返回 false，更早的部分需按 before_id 分页获取
+    bool getMessagesAfter(const std::string &room_id, int64_t after_id, int limit, std::vector<std::string> &message_jsons);
 
     // 消息操作代理
     bool saveMessage(const std::string &room_id, const std::string &user_id,
-                     const std::string &content, int64_t timestamp);
+                     const std::string &content, int64_t timestamp,
+                     int64_t *message_id = nullptr);
     std::vector<Message> getMessages(const std::string &room_id, int limit = 50,
                                      int64_t before_timestamp = 0);
+    std::vector<Message> getRecentMessages(const std::string &room_id, int limit = 50,
+                                           int64_t before_id = 0);
     std::optional<Message> getMessageById(int64_t message_id);
 
     // 获取各个仓库的直接访问（如果需要更复杂的操作）
     UserRepository* getUserRepository() { return user_repo_.get(); }
     RoomRepository* getRoomRepository() { return room_repo_.get(); }
-    MessageRepository* getMessageRepository() { return message_repo_.get(); }
+    MessageRepository* getMessageRepository() { return message_repos_.empty() ? nullptr : message_repos_.front().get(); }
+    MessageRepository* getMessageRepository(const std::string &room_id) { return messageRepoFor(room_id); }// 房间所在分片的消息仓库
+    size_t getMessageShardCount() const { return message_repos_.size(); }
+    MessageRepository* getMessageShard(size_t index) { return message_repos_[index].get(); }
+
+    // 热消息缓存
+    MessageCache& getMessageCache() { return message_cache_; }
+
+    // 消息保留：后台按策略分批清理旧消息
+    MessageRetention& getRetention() { return *retention_; }
+    // 清理一批房间消息，参数与 MessageRepository::purgeMessages 相同，返回删除的条数
+    size_t purgeRoomMessages(const std::string &room_id, int64_t before_timestamp,
+                             size_t keep_latest, size_t batch_size);
+    // 对所有SQLite连接执行增量回收和WAL检查点
+    void runStorageMaintenance(int vacuum_pages);
+
+    // 全文搜索：后台任务分批维护索引
+    SearchIndexer& getSearchIndexer() { return *search_indexer_; }
+    // 在房间内搜索包含 query 中所有词的消息，按相关度排序（没有全文索引的存储按时间倒序），跳过 offset 条后最多返回 limit 条。
+    // 没有全文索引的存储只扫描最新的 10000 条消息，没有扫描到房间最早的消息时 partial 置为 true
+    std::vector<Message> searchMessages(const std::string &room_id, const std::string &query, int limit, int offset = 0,
+                                        bool *partial = nullptr);
+
+    // 在线热备份：元数据库和各消息分片逐步复制到备份文件，不阻塞前台写入；内存引擎没有可备份的连接
+    DatabaseBackup& getBackup() { return *backup_; }
+
+    // SQL 执行统计：每个数据库连接（元数据库和各消息分片）各自一份
+    nlohmann::json getQueryStats() const;
+    void resetQueryStats();
+    void setSlowQueryThreshold(std::chrono::milliseconds threshold);
+
+    // 异步数据库执行器，用于不希望阻塞调用线程的数据库操作
+    DatabaseExecutor& getExecutor() { return executor_; }
 
 private:
-    std::unique_ptr<DatabaseConnection> db_conn_;// 数据库连接
+    void openStorage(const std::string &db_path, const DatabaseOptions &options);
+    void openMemoryEngine();
+    void openMessageShards(const std::string &db_path, size_t message_shards);
+    void openMessageLog(const std::string &dir, const DatabaseOptions &options);
+    void warnUnmigratedMessages();
+    // 消息分片数决定房间和消息ID到分片的映射，首次启动时记录在元数据库中；
+    // 之后以不同的分片数启动会让已有消息不可见、新消息写到别的文件，返回 false 拒绝启动
+    bool checkMessageShardCount(const std::string &db_path, size_t message_shards);
+    MessageRepository *messageRepoFor(const std::string &room_id) const;// 按房间ID选择消息分片
+    MessageRepository *messageRepoForId(int64_t message_id) const;// 按消息ID选择消息分片
+
+    std::unique_ptr<DatabaseConnection> db_conn_;// 数据库连接，内存引擎时为空
+    std::vector<std::unique_ptr<DatabaseConnection>> shard_conns_;// 消息分片库连接，未分片时为空
     std::unique_ptr<UserRepository> user_repo_;// 用户仓库
     std::unique_ptr<RoomRepository> room_repo_;// 房间仓库
-    std::unique_ptr<MessageRepository> message_repo_;// 消息仓库
+    std::vector<std::unique_ptr<MessageRepository>> message_repos_;// 消息仓库，每个分片一个
+    bool external_messages_ = false;// 消息不在元数据库中（分片或日志引擎），需要手动校验引用和清理
+    MessageCache message_cache_;// 活跃房间的最近消息缓存
+    std::unique_ptr<MessageRetention> retention_;// 后台消息清理，先于仓库析构以停止定时任务
+    std::unique_ptr<SearchIndexer> search_indexer_;// 后台全文索引，先于仓库析构以停止定时任务
+    std::unique_ptr<DatabaseBackup> backup_;// 在线热备份，先于连接析构以停止定时任务
+    DatabaseExecutor executor_;// 异步数据库执行器，最后声明以保证最先析构，排队中的任务仍能访问仓库
 };
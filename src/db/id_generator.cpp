@@ -0,0 +1,22 @@
+#include "id_generator.hpp"
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+std::string IdGenerator::next(const char *prefix)
+{
+    // random_device 可能是一次系统调用，只在线程第一次生成ID时读取
+    thread_local std::mt19937 gen(std::random_device{}());
+    static const char digits[] = "0123456789abcdef";
+
+    uint32_t value = gen();
+    size_t prefix_len = std::strlen(prefix);
+    std::string id(prefix_len + 8, '0');
+    std::memcpy(id.data(), prefix, prefix_len);
+    for (size_t i = id.size(); i > prefix_len; --i)
+    {
+        id[i - 1] = digits[value & 0xf];
+        value >>= 4;
+    }
+    return id;
+}
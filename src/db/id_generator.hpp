@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+// 对外暴露的字符串ID生成器
+// 每个线程持有一个只播种一次的随机数引擎，生成 "前缀 + 8位十六进制" 形式的ID，
+// 不再为每次调用读取 random_device，也不经过 stringstream 格式化
+class IdGenerator
+{
+public:
+    // 生成形如 prefix + "1a2b3c4d" 的ID
+    static std::string next(const char *prefix);
+};
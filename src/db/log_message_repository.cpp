@@ -0,0 +1,761 @@
+#include "log_message_repository.hpp"
+#include "user_repository.hpp"
+#include "../utils/logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+// 记录格式：[u32 负载长度][u32 校验和][u32 序号][i64 时间戳][u16 用户ID长度][用户ID][消息内容]
+constexpr size_t kHeaderSize = 8;
+constexpr size_t kFixedPayloadSize = 4 + 8 + 2;
+
+uint32_t checksum(const char *data, size_t size)
+{
+    // FNV-1a，用于启动时识别写了一半的记录
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+template <typename T>
+void appendRaw(std::string &buffer, T value)
+{
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+T readRaw(const char *data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+std::string segmentFileName(uint32_t first_seq)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%010u.log", first_seq);
+    return name;
+}
+
+bool writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+} // namespace
+
+LogMessageRepository::LogMessageRepository(const std::string &dir, const UserRepository *user_repo)
+    : LogMessageRepository(dir, user_repo, Options{}) {}
+
+LogMessageRepository::LogMessageRepository(const std::string &dir, const UserRepository *user_repo, Options options)
+    : dir_(dir), user_repo_(user_repo), options_(options)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec)
+    {
+        LOG_ERROR << "Failed to create message log directory " << dir_ << ": " << ec.message();
+        return;
+    }
+
+    if (!loadManifest())
+    {
+        return;
+    }
+    LOG_INFO << "Message log opened at " << dir_ << " with " << rooms_.size() << " rooms";
+
+    if (options_.sync_interval.count() > 0)
+    {
+        sync_timer_.addPeriodicTask(options_.sync_interval, options_.sync_interval, [this]()
+                                    { sync(); });
+        sync_timer_.start();
+    }
+}
+
+LogMessageRepository::~LogMessageRepository()
+{
+    sync_timer_.stop();
+    sync();
+
+    std::lock_guard<std::mutex> lock(rooms_mutex_);
+    for (auto &[room_id, room] : rooms_)
+    {
+        std::lock_guard<std::mutex> room_lock(room->mutex);
+        if (room->write_fd >= 0)
+        {
+            ::close(room->write_fd);
+            room->write_fd = -1;
+        }
+        for (auto &segment : room->segments)
+        {
+            unmapSegment(segment);
+        }
+    }
+    if (manifest_fd_ >= 0)
+    {
+        ::close(manifest_fd_);
+        manifest_fd_ = -1;
+    }
+}
+
+bool LogMessageRepository::saveMessage(const std::string &room_id, const std::string &user_id,
+                                       const std::string &content, int64_t timestamp,
+                                       int64_t *message_id)
+{
+    if (!isOpen() || user_id.size() > UINT16_MAX) return false;
+
+    auto room = findOrCreateRoom(room_id);
+    if (!room) return false;
+
+    std::lock_guard<std::mutex> lock(room->mutex);
+    if (room->next_seq == UINT32_MAX)
+    {
+        LOG_ERROR << "Message log of room " << room_id << " is full";
+        return false;
+    }
+
+    // 当前段写满后滚动到新段
+    if (room->segments.empty() || room->segments.back().size >= options_.segment_bytes)
+    {
+        if (!openSegment(*room, room->next_seq))
+        {
+            return false;
+        }
+    }
+
+    uint32_t seq = room->next_seq;
+    std::string buffer;
+    buffer.reserve(kHeaderSize + kFixedPayloadSize + user_id.size() + content.size());
+    appendRaw<uint32_t>(buffer, static_cast<uint32_t>(kFixedPayloadSize + user_id.size() + content.size()));
+    appendRaw<uint32_t>(buffer, 0); // 校验和占位
+    appendRaw<uint32_t>(buffer, seq);
+    appendRaw<int64_t>(buffer, timestamp);
+    appendRaw<uint16_t>(buffer, static_cast<uint16_t>(user_id.size()));
+    buffer.append(user_id);
+    buffer.append(content);
+    uint32_t sum = checksum(buffer.data() + kHeaderSize, buffer.size() - kHeaderSize);
+    std::memcpy(&buffer[4], &sum, sizeof(sum));
+
+    Segment &segment = room->segments.back();
+    if (!writeAll(room->write_fd, buffer.data(), buffer.size()))
+    {
+        LOG_ERROR << "Failed to append to message log " << segment.path << ": " << std::strerror(errno);
+        // 丢弃可能写了一半的记录，保持段文件完整
+        if (::ftruncate(room->write_fd, static_cast<off_t>(segment.size)) != 0)
+        {
+            LOG_ERROR << "Failed to truncate message log " << segment.path << ": " << std::strerror(errno);
+        }
+        return false;
+    }
+
+    if (segment.count % options_.index_interval == 0)
+    {
+        segment.index.emplace_back(seq, segment.size);
+    }
+    segment.size += buffer.size();
+    segment.count++;
+    segment.max_timestamp = std::max(segment.max_timestamp, timestamp);
+    room->next_seq++;
+
+    if (options_.sync_interval.count() == 0)
+    {
+        ::fdatasync(room->write_fd);
+    }
+    else
+    {
+        room->dirty = true;
+    }
+
+    if (message_id)
+    {
+        *message_id = makeId(room->room_no, seq);
+    }
+    return true;
+}
+
+std::vector<Message> LogMessageRepository::getMessages(const std::string &room_id, int limit,
+                                                       int64_t before_timestamp)
+{
+    auto room = findRoom(room_id);
+    if (!room) return {};
+
+    std::vector<Record> records;
+    {
+        std::lock_guard<std::mutex> lock(room->mutex);
+        readRange(*room, 1, room->next_seq, records);
+    }
+
+    // 与 SQLite 实现保持一致：timestamp >= before_timestamp，按时间戳正序
+    if (before_timestamp > 0)
+    {
+        records.erase(std::remove_if(records.begin(), records.end(), [before_timestamp](const Record &record)
+                                     { return record.timestamp < before_timestamp; }),
+                      records.end());
+    }
+    std::stable_sort(records.begin(), records.end(), [](const Record &a, const Record &b)
+                     { return a.timestamp < b.timestamp; });
+    if (limit > 0 && records.size() > static_cast<size_t>(limit))
+    {
+        records.resize(limit);
+    }
+    return toMessages(*room, records);
+}
+
+std::vector<Message> LogMessageRepository::getRecentMessages(const std::string &room_id, int limit,
+                                                             int64_t before_id)
+{
+    auto room = findRoom(room_id);
+    if (!room) return {};
+
+    std::vector<Record> records;
+    {
+        std::lock_guard<std::mutex> lock(room->mutex);
+        uint32_t end_seq = room->next_seq;
+        if (before_id > 0)
+        {
+            uint32_t before_room = static_cast<uint32_t>(before_id >> 32);
+            if (before_room < room->room_no)
+            {
+                return {};
+            }
+            if (before_room == room->room_no)
+            {
+                end_seq = std::min(end_seq, static_cast<uint32_t>(before_id & 0xffffffff));
+            }
+        }
+        // 房间内序号连续，最近 limit 条就是 [end_seq - limit, end_seq)
+        uint32_t start_seq = (limit > 0 && end_seq > static_cast<uint32_t>(limit)) ? end_seq - limit : 1;
+        readRange(*room, start_seq, end_seq, records);
+    }
+    return toMessages(*room, records);
+}
+
+std::optional<Message> LogMessageRepository::getMessageById(int64_t message_id)
+{
+    if (message_id <= 0) return std::nullopt;
+    auto room = findRoom(static_cast<uint32_t>(message_id >> 32));
+    if (!room) return std::nullopt;
+
+    uint32_t seq = static_cast<uint32_t>(message_id & 0xffffffff);
+    std::vector<Record> records;
+    {
+        std::lock_guard<std::mutex> lock(room->mutex);
+        readRange(*room, seq, seq + 1, records);
+    }
+    if (records.empty()) return std::nullopt;
+    return toMessages(*room, records).front();
+}
+
+bool LogMessageRepository::deleteRoomMessages(const std::string &room_id)
+{
+    std::shared_ptr<RoomLog> room;
+    {
+        std::lock_guard<std::mutex> lock(rooms_mutex_);
+        auto it = rooms_.find(room_id);
+        if (it == rooms_.end())
+        {
+            return true; // 房间没有消息
+        }
+        room = it->second;
+        if (!appendManifest("-" + std::to_string(room->room_no)))
+        {
+            return false;
+        }
+        rooms_by_no_.erase(room->room_no);
+        rooms_.erase(it);
+    }
+
+    std::lock_guard<std::mutex> room_lock(room->mutex);
+    if (room->write_fd >= 0)
+    {
+        ::close(room->write_fd);
+        room->write_fd = -1;
+    }
+    for (auto &segment : room->segments)
+    {
+        unmapSegment(segment);
+    }
+    room->segments.clear();
+
+    std::error_code ec;
+    std::filesystem::remove_all(room->dir, ec);
+    if (ec)
+    {
+        LOG_WARN << "Failed to remove message log directory " << room->dir << ": " << ec.message();
+    }
+    return true;
+}
+
+size_t LogMessageRepository::purgeMessages(const std::string &room_id, int64_t before_timestamp,
+                                           size_t keep_latest, size_t /*batch_size*/)
+{
+    auto room = findRoom(room_id);
+    if (!room) return 0;
+
+    // 以段为单位清理：每次最多删除最旧的一个段，正在写入的段不删除。
+    // 只有段内所有消息都满足清理条件时才删除，保留的消息可能比策略要求多出不到一个段
+    std::lock_guard<std::mutex> lock(room->mutex);
+    if (room->segments.size() < 2)
+    {
+        return 0;
+    }
+    Segment &oldest = room->segments.front();
+    bool over_count = keep_latest > 0 && oldest.first_seq + oldest.count + keep_latest <= room->next_seq;
+    bool expired = before_timestamp > 0 && oldest.max_timestamp < before_timestamp;
+    if (!over_count && !expired)
+    {
+        return 0;
+    }
+
+    size_t deleted = oldest.count;
+    unmapSegment(oldest);
+    if (::unlink(oldest.path.c_str()) != 0)
+    {
+        LOG_ERROR << "Failed to remove message log " << oldest.path << ": " << std::strerror(errno);
+        return 0;
+    }
+    room->segments.erase(room->segments.begin());
+    return deleted;
+}
+
+void LogMessageRepository::sync()
+{
+    std::vector<std::shared_ptr<RoomLog>> rooms;
+    {
+        std::lock_guard<std::mutex> lock(rooms_mutex_);
+        rooms.reserve(rooms_.size());
+        for (const auto &entry : rooms_)
+        {
+            rooms.push_back(entry.second);
+        }
+    }
+
+    for (auto &room : rooms)
+    {
+        int fd = -1;
+        {
+            std::lock_guard<std::mutex> lock(room->mutex);
+            if (!room->dirty || room->write_fd < 0)
+            {
+                continue;
+            }
+            // 复制描述符后在锁外刷盘，刷盘期间不阻塞该房间的写入
+            fd = ::dup(room->write_fd);
+            room->dirty = false;
+        }
+        if (fd >= 0)
+        {
+            ::fdatasync(fd);
+            ::close(fd);
+        }
+    }
+}
+
+bool LogMessageRepository::loadManifest()
+{
+    std::string manifest_path = dir_ + "/MANIFEST";
+
+    // 清单为追加写的文本：“+编号 房间ID” 表示创建，“-编号” 表示删除；最后一行没有换行符说明写入不完整，忽略
+    std::ifstream in(manifest_path, std::ios::binary);
+    std::unordered_map<uint32_t, std::string> live;
+    if (in)
+    {
+        std::stringstream content;
+        content << in.rdbuf();
+        std::string data = content.str();
+        size_t line_start = 0;
+        size_t line_end;
+        while ((line_end = data.find('\n', line_start)) != std::string::npos)
+        {
+            std::string line = data.substr(line_start, line_end - line_start);
+            line_start = line_end + 1;
+            if (line.size() < 2) continue;
+
+            size_t space = line.find(' ');
+            uint32_t room_no = static_cast<uint32_t>(std::strtoul(line.c_str() + 1, nullptr, 10));
+            if (room_no == 0) continue;
+            next_room_no_ = std::max(next_room_no_, room_no + 1);
+
+            if (line[0] == '+' && space != std::string::npos)
+            {
+                live[room_no] = line.substr(space + 1);
+            }
+            else if (line[0] == '-')
+            {
+                live.erase(room_no);
+            }
+        }
+    }
+
+    for (auto &[room_no, room_id] : live)
+    {
+        auto room = std::make_shared<RoomLog>();
+        room->room_no = room_no;
+        room->room_id = room_id;
+        room->dir = dir_ + "/r" + std::to_string(room_no);
+        if (!openRoom(*room))
+        {
+            return false;
+        }
+        rooms_by_no_[room_no] = room;
+        rooms_[room_id] = std::move(room);
+    }
+
+    manifest_fd_ = ::open(manifest_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (manifest_fd_ < 0)
+    {
+        LOG_ERROR << "Failed to open message log manifest " << manifest_path << ": " << std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool LogMessageRepository::appendManifest(const std::string &line)
+{
+    std::string entry = line + "\n";
+    if (!writeAll(manifest_fd_, entry.data(), entry.size()) || ::fdatasync(manifest_fd_) != 0)
+    {
+        LOG_ERROR << "Failed to write message log manifest: " << std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool LogMessageRepository::openRoom(RoomLog &room)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(room.dir, ec);
+
+    std::vector<uint32_t> first_seqs;
+    for (const auto &entry : std::filesystem::directory_iterator(room.dir, ec))
+    {
+        if (entry.path().extension() == ".log")
+        {
+            first_seqs.push_back(static_cast<uint32_t>(std::strtoul(entry.path().stem().c_str(), nullptr, 10)));
+        }
+    }
+    std::sort(first_seqs.begin(), first_seqs.end());
+
+    for (uint32_t first_seq : first_seqs)
+    {
+        Segment segment;
+        segment.first_seq = first_seq;
+        segment.path = room.dir + "/" + segmentFileName(first_seq);
+        if (!scanSegment(segment))
+        {
+            return false;
+        }
+        room.segments.push_back(std::move(segment));
+    }
+
+    if (!room.segments.empty())
+    {
+        const Segment &last = room.segments.back();
+        room.next_seq = last.first_seq + last.count;
+        room.write_fd = ::open(last.path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+        if (room.write_fd < 0)
+        {
+            LOG_ERROR << "Failed to open message log " << last.path << ": " << std::strerror(errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LogMessageRepository::scanSegment(Segment &segment)
+{
+    struct stat st;
+    if (::stat(segment.path.c_str(), &st) != 0)
+    {
+        LOG_ERROR << "Failed to stat message log " << segment.path << ": " << std::strerror(errno);
+        return false;
+    }
+    segment.size = static_cast<size_t>(st.st_size);
+    const char *data = mapSegment(segment);
+
+    size_t offset = 0;
+    Record record;
+    size_t record_size = 0;
+    while (data && offset < segment.size && parseRecord(data + offset, segment.size - offset, record, record_size))
+    {
+        if (record.seq != segment.first_seq + segment.count)
+        {
+            break; // 序号不连续，视为损坏
+        }
+        if (segment.count % options_.index_interval == 0)
+        {
+            segment.index.emplace_back(record.seq, offset);
+        }
+        segment.count++;
+        segment.max_timestamp = std::max(segment.max_timestamp, record.timestamp);
+        offset += record_size;
+    }
+
+    if (offset < segment.size)
+    {
+        // 崩溃时写了一半的记录，截断到最后一条完整记录
+        LOG_WARN << "Truncating message log " << segment.path << " from " << segment.size << " to " << offset << " bytes";
+        unmapSegment(segment);
+        if (::truncate(segment.path.c_str(), static_cast<off_t>(offset)) != 0)
+        {
+            LOG_ERROR << "Failed to truncate message log " << segment.path << ": " << std::strerror(errno);
+            return false;
+        }
+        segment.size = offset;
+    }
+    return true;
+}
+
+bool LogMessageRepository::openSegment(RoomLog &room, uint32_t first_seq)
+{
+    if (room.write_fd >= 0)
+    {
+        // 已写满的段在关闭前刷盘
+        ::fdatasync(room.write_fd);
+        ::close(room.write_fd);
+        room.write_fd = -1;
+        room.dirty = false;
+    }
+
+    Segment segment;
+    segment.first_seq = first_seq;
+    segment.path = room.dir + "/" + segmentFileName(first_seq);
+    room.write_fd = ::open(segment.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (room.write_fd < 0)
+    {
+        LOG_ERROR << "Failed to create message log " << segment.path << ": " << std::strerror(errno);
+        return false;
+    }
+    room.segments.push_back(std::move(segment));
+    return true;
+}
+
+std::shared_ptr<LogMessageRepository::RoomLog> LogMessageRepository::findRoom(const std::string &room_id)
+{
+    std::lock_guard<std::mutex> lock(rooms_mutex_);
+    auto it = rooms_.find(room_id);
+    return it != rooms_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<LogMessageRepository::RoomLog> LogMessageRepository::findRoom(uint32_t room_no)
+{
+    std::lock_guard<std::mutex> lock(rooms_mutex_);
+    auto it = rooms_by_no_.find(room_no);
+    return it != rooms_by_no_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<LogMessageRepository::RoomLog> LogMessageRepository::findOrCreateRoom(const std::string &room_id)
+{
+    if (room_id.empty() || room_id.find('\n') != std::string::npos)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(rooms_mutex_);
+    auto it = rooms_.find(room_id);
+    if (it != rooms_.end())
+    {
+        return it->second;
+    }
+
+    auto room = std::make_shared<RoomLog>();
+    room->room_no = next_room_no_;
+    room->room_id = room_id;
+    room->dir = dir_ + "/r" + std::to_string(room->room_no);
+
+    std::error_code ec;
+    std::filesystem::create_directories(room->dir, ec);
+    if (ec)
+    {
+        LOG_ERROR << "Failed to create message log directory " << room->dir << ": " << ec.message();
+        return nullptr;
+    }
+    if (!appendManifest("+" + std::to_string(room->room_no) + " " + room_id))
+    {
+        return nullptr;
+    }
+
+    next_room_no_++;
+    rooms_by_no_[room->room_no] = room;
+    rooms_[room_id] = room;
+    return room;
+}
+
+const char *LogMessageRepository::mapSegment(Segment &segment)
+{
+    if (segment.size == 0)
+    {
+        return nullptr;
+    }
+    if (segment.map && segment.map_size >= segment.size)
+    {
+        return segment.map;
+    }
+
+    unmapSegment(segment);
+    int fd = ::open(segment.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_ERROR << "Failed to open message log " << segment.path << ": " << std::strerror(errno);
+        return nullptr;
+    }
+    // 映射长度至少为段大小上限，写入段在写满之前不需要重新映射；只访问文件有效长度以内的数据
+    size_t map_size = std::max(segment.size, options_.segment_bytes);
+    void *map = ::mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+    {
+        LOG_ERROR << "Failed to mmap message log " << segment.path << ": " << std::strerror(errno);
+        return nullptr;
+    }
+    segment.map = static_cast<const char *>(map);
+    segment.map_size = map_size;
+    return segment.map;
+}
+
+void LogMessageRepository::unmapSegment(Segment &segment)
+{
+    if (segment.map)
+    {
+        ::munmap(const_cast<char *>(segment.map), segment.map_size);
+        segment.map = nullptr;
+        segment.map_size = 0;
+    }
+}
+
+bool LogMessageRepository::parseRecord(const char *data, size_t available, Record &record, size_t &record_size)
+{
+    if (available < kHeaderSize + kFixedPayloadSize)
+    {
+        return false;
+    }
+    uint32_t payload_size = readRaw<uint32_t>(data);
+    uint32_t sum = readRaw<uint32_t>(data + 4);
+    if (payload_size < kFixedPayloadSize || available - kHeaderSize < payload_size)
+    {
+        return false;
+    }
+    const char *payload = data + kHeaderSize;
+    if (checksum(payload, payload_size) != sum)
+    {
+        return false;
+    }
+
+    uint16_t user_size = readRaw<uint16_t>(payload + 12);
+    if (kFixedPayloadSize + user_size > payload_size)
+    {
+        return false;
+    }
+    record.seq = readRaw<uint32_t>(payload);
+    record.timestamp = readRaw<int64_t>(payload + 4);
+    record.user_id.assign(payload + kFixedPayloadSize, user_size);
+    record.content.assign(payload + kFixedPayloadSize + user_size, payload_size - kFixedPayloadSize - user_size);
+    record_size = kHeaderSize + payload_size;
+    return true;
+}
+
+void LogMessageRepository::readRange(RoomLog &room, uint32_t start_seq, uint32_t end_seq, std::vector<Record> &out)
+{
+    if (start_seq >= end_seq || room.segments.empty())
+    {
+        return;
+    }
+
+    // 找到包含 start_seq 的段
+    auto segment_it = std::upper_bound(room.segments.begin(), room.segments.end(), start_seq,
+                                       [](uint32_t seq, const Segment &segment)
+                                       { return seq < segment.first_seq; });
+    if (segment_it != room.segments.begin())
+    {
+        --segment_it;
+    }
+
+    for (; segment_it != room.segments.end() && segment_it->first_seq < end_seq; ++segment_it)
+    {
+        Segment &segment = *segment_it;
+        const char *data = mapSegment(segment);
+        if (!data)
+        {
+            continue;
+        }
+
+        // 通过稀疏索引跳到 start_seq 附近，再顺序扫描
+        size_t offset = 0;
+        auto index_it = std::upper_bound(segment.index.begin(), segment.index.end(), start_seq,
+                                         [](uint32_t seq, const std::pair<uint32_t, size_t> &entry)
+                                         { return seq < entry.first; });
+        if (index_it != segment.index.begin())
+        {
+            offset = std::prev(index_it)->second;
+        }
+
+        Record record;
+        size_t record_size = 0;
+        while (offset < segment.size && parseRecord(data + offset, segment.size - offset, record, record_size))
+        {
+            if (record.seq >= end_seq)
+            {
+                return;
+            }
+            if (record.seq >= start_seq)
+            {
+                out.push_back(record);
+            }
+            offset += record_size;
+        }
+    }
+}
+
+std::vector<Message> LogMessageRepository::toMessages(const RoomLog &room, std::vector<Record> &records) const
+{
+    std::vector<Message> messages;
+    messages.reserve(records.size());
+    // 同一批消息的发送者通常只有少数几个，按用户ID缓存查询结果
+    std::unordered_map<std::string, std::string> usernames;
+    for (auto &record : records)
+    {
+        auto it = usernames.find(record.user_id);
+        if (it == usernames.end())
+        {
+            auto user = user_repo_ ? user_repo_->getUserById(record.user_id) : std::nullopt;
+            it = usernames.emplace(record.user_id, user ? user->getUsername() : "").first;
+        }
+        messages.emplace_back(makeId(room.room_no, record.seq), room.room_id, record.user_id,
+                              std::move(record.content), record.timestamp, it->second);
+    }
+    return messages;
+}
+
+std::optional<std::vector<Message>> LogMessageRepository::searchMessages(const std::string &, const std::string &, int, int)
+{
+    return std::nullopt;
+}
+
+size_t LogMessageRepository::indexPendingMessages(size_t)
+{
+    return 0;
+}
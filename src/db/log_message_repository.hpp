@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+#include "message_repository.hpp"
+#include "../utils/timer.hpp"
+
+class UserRepository;
+
+// 追加写的分段日志消息存储
+// 每个房间一个目录，消息按顺序追加到段文件中，段文件写满后滚动到新段；
+// 内存中为每个段维护稀疏索引（每隔 index_interval 条记录一个 序号->偏移），历史分页通过 mmap 读取段文件。
+// 写入只调用 write()，由后台定时器每隔 sync_interval 批量 fdatasync，崩溃时最多丢失最后一个同步周期内的消息。
+//
+// 消息ID = (房间编号 << 32) | 房间内序号，同一房间内单调递增，可以直接由ID定位房间和段
+class LogMessageRepository : public MessageRepository
+{
+public:
+    struct Options
+    {
+        size_t segment_bytes = 16 * 1024 * 1024;                       // 单个段文件的大小上限
+        size_t index_interval = 64;                                    // 稀疏索引间隔（记录数）
+        std::chrono::milliseconds sync_interval = std::chrono::milliseconds(100); // 批量刷盘间隔，0 表示每次写入都刷盘
+    };
+
+    // dir: 日志根目录；user_repo: 用于查询发送者用户名
+    LogMessageRepository(const std::string &dir, const UserRepository *user_repo, Options options);
+    LogMessageRepository(const std::string &dir, const UserRepository *user_repo);
+    ~LogMessageRepository() override;
+
+    LogMessageRepository(const LogMessageRepository &) = delete;
+    LogMessageRepository &operator=(const LogMessageRepository &) = delete;
+
+    bool isOpen() const { return manifest_fd_ >= 0; }
+
+    bool saveMessage(const std::string &room_id, const std::string &user_id,
+                     const std::string &content, int64_t timestamp,
+                     int64_t *message_id) override;
+    std::vector<Message> getMessages(const std::string &room_id, int limit,
+                                     int64_t before_timestamp) override;
+    std::vector<Message> getRecentMessages(const std::string &room_id, int limit,
+                                           int64_t before_id) override;
+    std::optional<Message> getMessageById(int64_t message_id) override;
+    bool deleteRoomMessages(const std::string &room_id) override;
+    size_t purgeMessages(const std::string &room_id, int64_t before_timestamp,
+                         size_t keep_latest, size_t batch_size) override;
+    std::optional<std::vector<Message>> searchMessages(const std::string &room_id, const std::string &query,
+                                                       int limit, int offset) override;// 没有全文索引，返回空
+    size_t indexPendingMessages(size_t batch_size) override;
+
+    void sync(); // 立即把所有未同步的写入刷到磁盘
+
+private:
+    // 段文件中的一条记录
+    struct Record
+    {
+        uint32_t seq;
+        int64_t timestamp;
+        std::string user_id;
+        std::string content;
+    };
+
+    struct Segment
+    {
+        uint32_t first_seq = 0;                             // 段内第一条记录的序号
+        uint32_t count = 0;                                 // 段内记录数
+        std::string path;
+        size_t size = 0;                                    // 有效数据长度
+        int64_t max_timestamp = 0;                          // 段内最大的消息时间戳，用于按时间清理
+        std::vector<std::pair<uint32_t, size_t>> index;     // 稀疏索引：序号 -> 偏移
+        const char *map = nullptr;                          // 只读映射
+        size_t map_size = 0;
+    };
+
+    struct RoomLog
+    {
+        uint32_t room_no = 0;
+        std::string room_id;
+        std::string dir;
+        std::vector<Segment> segments;
+        uint32_t next_seq = 1;
+        int write_fd = -1;                                  // 当前段的追加写描述符
+        bool dirty = false;                                 // 有尚未刷盘的写入
+        std::mutex mutex;
+    };
+
+    bool loadManifest();
+    bool appendManifest(const std::string &line);
+    bool openRoom(RoomLog &room);                                      // 启动时扫描房间的段文件并重建索引
+    bool scanSegment(Segment &segment);                                // 校验段文件，截断末尾不完整的记录
+    bool openSegment(RoomLog &room, uint32_t first_seq);               // 创建新的段并作为写入段
+    std::shared_ptr<RoomLog> findRoom(const std::string &room_id);
+    std::shared_ptr<RoomLog> findOrCreateRoom(const std::string &room_id);
+    std::shared_ptr<RoomLog> findRoom(uint32_t room_no);
+
+    const char *mapSegment(Segment &segment);                          // 保证映射覆盖整个段
+    static void unmapSegment(Segment &segment);
+    static bool parseRecord(const char *data, size_t available, Record &record, size_t &record_size);
+    // 读取 [start_seq, end_seq) 范围内的记录，调用方持有房间锁
+    void readRange(RoomLog &room, uint32_t start_seq, uint32_t end_seq, std::vector<Record> &out);
+    std::vector<Message> toMessages(const RoomLog &room, std::vector<Record> &records) const;
+
+    static int64_t makeId(uint32_t room_no, uint32_t seq) { return (static_cast<int64_t>(room_no) << 32) | seq; }
+
+    std::string dir_;
+    const UserRepository *user_repo_;
+    Options options_;
+
+    std::mutex rooms_mutex_;                                          // 保护房间表和清单文件
+    std::unordered_map<std::string, std::shared_ptr<RoomLog>> rooms_;
+    std::unordered_map<uint32_t, std::shared_ptr<RoomLog>> rooms_by_no_;
+    uint32_t next_room_no_ = 1;
+    int manifest_fd_ = -1;
+
+    utils::Timer sync_timer_;                                         // 批量刷盘定时器
+};
@@ -0,0 +1,210 @@
+#include "memory_message_repository.hpp"
+#include "user_repository.hpp"
+#include <algorithm>
+#include <mutex>
+
+MemoryMessageRepository::MemoryMessageRepository(const UserRepository *user_repo) : user_repo_(user_repo) {}
+
+std::shared_ptr<MemoryMessageRepository::RoomMessages> MemoryMessageRepository::findRoom(const std::string &room_id) const
+{
+    return rooms_.read(room_id, [&](const auto &rooms)
+    {
+        auto it = rooms.find(room_id);
+        return it != rooms.end() ? it->second : nullptr;
+    });
+}
+
+std::shared_ptr<MemoryMessageRepository::RoomMessages> MemoryMessageRepository::findRoom(uint32_t room_no) const
+{
+    std::shared_lock<std::shared_mutex> lock(rooms_by_no_mutex_);
+    auto it = rooms_by_no_.find(room_no);
+    return it != rooms_by_no_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<MemoryMessageRepository::RoomMessages> MemoryMessageRepository::findOrCreateRoom(const std::string &room_id)
+{
+    if (auto room = findRoom(room_id))
+    {
+        return room;
+    }
+    return rooms_.write(room_id, [&](auto &rooms)
+    {
+        auto &room = rooms[room_id];
+        if (!room)
+        {
+            // 房间删除后重新写入会分配新的编号，旧消息ID不会指向新消息
+            room = std::make_shared<RoomMessages>();
+            room->room_no = next_room_no_++;
+            room->room_id = room_id;
+            std::unique_lock<std::shared_mutex> lock(rooms_by_no_mutex_);
+            rooms_by_no_.emplace(room->room_no, room);
+        }
+        return room;
+    });
+}
+
+bool MemoryMessageRepository::saveMessage(const std::string &room_id, const std::string &user_id,
+                                          const std::string &content, int64_t timestamp,
+                                          int64_t *message_id)
+{
+    auto room = findOrCreateRoom(room_id);
+    std::unique_lock<std::shared_mutex> lock(room->mutex);
+    room->records.push_back(Record{timestamp, user_id, content});
+    if (message_id)
+    {
+        *message_id = makeId(room->room_no, room->first_seq + static_cast<uint32_t>(room->records.size() - 1));
+    }
+    return true;
+}
+
+Message MemoryMessageRepository::toMessage(const RoomMessages &room, size_t index,
+                                          std::unordered_map<std::string, std::string> &usernames) const
+{
+    const Record &record = room.records[index];
+    auto name = usernames.find(record.user_id);
+    if (name == usernames.end())
+    {
+        auto user = user_repo_ ? user_repo_->getUserById(record.user_id) : std::nullopt;
+        name = usernames.emplace(record.user_id, user ? user->getUsername() : "").first;
+    }
+    return Message(makeId(room.room_no, room.first_seq + static_cast<uint32_t>(index)), room.room_id, record.user_id,
+                   record.content, record.timestamp, name->second);
+}
+
+std::vector<Message> MemoryMessageRepository::getMessages(const std::string &room_id, int limit,
+                                                          int64_t before_timestamp)
+{
+    auto room = findRoom(room_id);
+    if (!room) return {};
+
+    // 与 SQLite 实现保持一致：timestamp >= before_timestamp，按时间戳正序
+    std::vector<size_t> indexes;
+    std::shared_lock<std::shared_mutex> lock(room->mutex);
+    for (size_t i = 0; i < room->records.size(); ++i)
+    {
+        if (before_timestamp <= 0 || room->records[i].timestamp >= before_timestamp)
+        {
+            indexes.push_back(i);
+        }
+    }
+    std::stable_sort(indexes.begin(), indexes.end(), [&](size_t a, size_t b)
+                     { return room->records[a].timestamp < room->records[b].timestamp; });
+    if (limit > 0 && indexes.size() > static_cast<size_t>(limit))
+    {
+        indexes.resize(limit);
+    }
+
+    std::vector<Message> messages;
+    messages.reserve(indexes.size());
+    std::unordered_map<std::string, std::string> usernames;
+    for (size_t i : indexes)
+    {
+        messages.push_back(toMessage(*room, i, usernames));
+    }
+    return messages;
+}
+
+std::vector<Message> MemoryMessageRepository::getRecentMessages(const std::string &room_id, int limit,
+                                                                int64_t before_id)
+{
+    auto room = findRoom(room_id);
+    if (!room) return {};
+
+    std::shared_lock<std::shared_mutex> lock(room->mutex);
+    size_t end = room->records.size();
+    if (before_id > 0)
+    {
+        uint32_t before_room = static_cast<uint32_t>(before_id >> 32);
+        if (before_room < room->room_no)
+        {
+            return {};
+        }
+        if (before_room == room->room_no)
+        {
+            // 序号 < before_seq 的记录下标为 [0, before_seq - first_seq)
+            uint32_t before_seq = static_cast<uint32_t>(before_id & 0xffffffff);
+            end = std::min(end, before_seq > room->first_seq ? static_cast<size_t>(before_seq - room->first_seq) : 0);
+        }
+    }
+    size_t begin = (limit > 0 && end > static_cast<size_t>(limit)) ? end - limit : 0;
+
+    std::vector<Message> messages;
+    messages.reserve(end - begin);
+    std::unordered_map<std::string, std::string> usernames;
+    for (size_t i = begin; i < end; ++i)
+    {
+        messages.push_back(toMessage(*room, i, usernames));
+    }
+    return messages;
+}
+
+std::optional<Message> MemoryMessageRepository::getMessageById(int64_t message_id)
+{
+    if (message_id <= 0) return std::nullopt;
+    auto room = findRoom(static_cast<uint32_t>(message_id >> 32));
+    if (!room) return std::nullopt;
+
+    uint32_t seq = static_cast<uint32_t>(message_id & 0xffffffff);
+    std::shared_lock<std::shared_mutex> lock(room->mutex);
+    if (seq < room->first_seq || seq - room->first_seq >= room->records.size())
+    {
+        return std::nullopt;
+    }
+    std::unordered_map<std::string, std::string> usernames;
+    return toMessage(*room, seq - room->first_seq, usernames);
+}
+
+bool MemoryMessageRepository::deleteRoomMessages(const std::string &room_id)
+{
+    auto room = rooms_.write(room_id, [&](auto &rooms)
+    {
+        std::shared_ptr<RoomMessages> removed;
+        auto it = rooms.find(room_id);
+        if (it != rooms.end())
+        {
+            removed = std::move(it->second);
+            rooms.erase(it);
+        }
+        return removed;
+    });
+    if (room)
+    {
+        std::unique_lock<std::shared_mutex> lock(rooms_by_no_mutex_);
+        rooms_by_no_.erase(room->room_no);
+    }
+    return true;
+}
+
+size_t MemoryMessageRepository::purgeMessages(const std::string &room_id, int64_t before_timestamp,
+                                              size_t keep_latest, size_t batch_size)
+{
+    auto room = findRoom(room_id);
+    if (!room) return 0;
+
+    // 从最旧的一端删除，遇到第一条需要保留的消息即停止
+    std::unique_lock<std::shared_mutex> lock(room->mutex);
+    size_t deleted = 0;
+    while (deleted < batch_size && !room->records.empty())
+    {
+        bool over_count = keep_latest > 0 && room->records.size() > keep_latest;
+        bool expired = before_timestamp > 0 && room->records.front().timestamp < before_timestamp;
+        if (!over_count && !expired)
+        {
+            break;
+        }
+        room->records.pop_front();
+        room->first_seq++;
+        deleted++;
+    }
+    return deleted;
+}
+
+std::optional<std::vector<Message>> MemoryMessageRepository::searchMessages(const std::string &, const std::string &, int, int)
+{
+    return std::nullopt;
+}
+
+size_t MemoryMessageRepository::indexPendingMessages(size_t)
+{
+    return 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <optional>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include "message_repository.hpp"
+#include "striped_map.hpp"
+
+class UserRepository;
+
+// 纯内存的消息存储，数据不落盘，进程退出即丢失
+// 每个房间一个按写入顺序追加的数组，房间表按房间ID分段加锁，房间内的读写只锁该房间。
+// 消息ID = (房间编号 << 32) | 房间内序号，与日志引擎相同，同一房间内单调递增
+class MemoryMessageRepository : public MessageRepository
+{
+public:
+    // user_repo: 用于查询发送者用户名
+    explicit MemoryMessageRepository(const UserRepository *user_repo);
+
+    bool saveMessage(const std::string &room_id, const std::string &user_id,
+                     const std::string &content, int64_t timestamp,
+                     int64_t *message_id) override;
+    std::vector<Message> getMessages(const std::string &room_id, int limit,
+                                     int64_t before_timestamp) override;
+    std::vector<Message> getRecentMessages(const std::string &room_id, int limit,
+                                           int64_t before_id) override;
+    std::optional<Message> getMessageById(int64_t message_id) override;
+    bool deleteRoomMessages(const std::string &room_id) override;
+    size_t purgeMessages(const std::string &room_id, int64_t before_timestamp,
+                         size_t keep_latest, size_t batch_size) override;
+    std::optional<std::vector<Message>> searchMessages(const std::string &room_id, const std::string &query,
+                                                       int limit, int offset) override;// 没有全文索引，返回空
+    size_t indexPendingMessages(size_t batch_size) override;
+
+private:
+    struct Record
+    {
+        int64_t timestamp;
+        std::string user_id;
+        std::string content;
+    };
+
+    struct RoomMessages
+    {
+        uint32_t room_no = 0;
+        std::string room_id;
+        mutable std::shared_mutex mutex;
+        std::deque<Record> records;  // 第 i 条记录的序号为 first_seq + i
+        uint32_t first_seq = 1;      // 最旧的记录被清理后向后移动
+    };
+
+    std::shared_ptr<RoomMessages> findRoom(const std::string &room_id) const;
+    std::shared_ptr<RoomMessages> findRoom(uint32_t room_no) const;
+    std::shared_ptr<RoomMessages> findOrCreateRoom(const std::string &room_id);
+    // 把下标为 index 的记录转换为消息，调用方持有房间锁；usernames 缓存本次查询已解析的用户名
+    Message toMessage(const RoomMessages &room, size_t index, std::unordered_map<std::string, std::string> &usernames) const;
+
+    static int64_t makeId(uint32_t room_no, uint32_t seq) { return (static_cast<int64_t>(room_no) << 32) | seq; }
+
+    const UserRepository *user_repo_;
+    StripedMap<std::string, std::shared_ptr<RoomMessages>> rooms_;      // 房间ID -> 消息
+    mutable std::shared_mutex rooms_by_no_mutex_;
+    std::unordered_map<uint32_t, std::shared_ptr<RoomMessages>> rooms_by_no_; // 房间编号 -> 消息，用于按消息ID查询
+    std::atomic<uint32_t> next_room_no_{1};
+};
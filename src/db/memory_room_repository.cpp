@@ -0,0 +1,406 @@
+#include "memory_room_repository.hpp"
+#include "user_repository.hpp"
+#include "../utils/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+namespace
+{
+int64_t nowTicks()
+{
+    // 与 SQLite 实现写入的时间戳保持一致
+    return std::chrono::system_clock::now().time_since_epoch().count();
+}
+} // namespace
+
+MemoryRoomRepository::MemoryRoomRepository(const UserRepository *user_repo) : user_repo_(user_repo) {}
+
+bool MemoryRoomRepository::userExists(const std::string &user_id) const
+{
+    return user_repo_ && user_repo_->getUserById(user_id).has_value();
+}
+
+std::optional<Room> MemoryRoomRepository::createRoom(const std::string &name, const std::string &description, const std::string &creator_id)
+{
+    // 与 rooms.creator_id 外键一致：创建者必须存在
+    if (!userExists(creator_id))
+    {
+        LOG_ERROR << "createRoom: creator does not exist: " << creator_id;
+        return std::nullopt;
+    }
+
+    std::unique_lock<std::shared_mutex> names_lock(names_mutex_);
+    if (names_.count(name))
+    {
+        LOG_ERROR << "createRoom: room name already exists: " << name;
+        return std::nullopt;
+    }
+
+    Room room;
+    bool inserted = false;
+    while (!inserted)
+    {
+        room = Room(generateRoomId(), name, description, creator_id, nowTicks());
+        inserted = rooms_.write(room.getId(), [&](auto &rooms)
+        {
+            Entry entry;
+            entry.room = room;
+            entry.seq = next_seq_++;
+            return rooms.emplace(room.getId(), std::move(entry)).second;
+        });
+    }
+    names_.emplace(name, room.getId());
+    return room;
+}
+
+bool MemoryRoomRepository::deleteRoom(const std::string &room_id)
+{
+    std::vector<std::string> members;
+    {
+        std::unique_lock<std::shared_mutex> names_lock(names_mutex_);
+        bool erased = rooms_.write(room_id, [&](auto &rooms)
+        {
+            auto it = rooms.find(room_id);
+            if (it == rooms.end())
+            {
+                return false;
+            }
+            names_.erase(it->second.room.getName());
+            for (const auto &member : it->second.members)
+            {
+                members.push_back(member.first);
+            }
+            rooms.erase(it);
+            return true;
+        });
+        // 与 SQLite 一致：删除不存在的房间不算失败
+        if (!erased)
+        {
+            return true;
+        }
+    }
+
+    // 成员关系随房间级联删除
+    for (const auto &user_id : members)
+    {
+        joined_.write(user_id, [&](auto &joined)
+        {
+            auto it = joined.find(user_id);
+            if (it != joined.end())
+            {
+                it->second.erase(room_id);
+                if (it->second.empty())
+                {
+                    joined.erase(it);
+                }
+            }
+            return true;
+        });
+    }
+    return true;
+}
+
+bool MemoryRoomRepository::roomExists(const std::string &room_id) const
+{
+    return rooms_.read(room_id, [&](const auto &rooms)
+                       { return rooms.count(room_id) > 0; });
+}
+
+bool MemoryRoomRepository::updateRoom(const std::string &room_id, const std::string &name, const std::string &description)
+{
+    std::unique_lock<std::shared_mutex> names_lock(names_mutex_);
+    auto owner = names_.find(name);
+    if (owner != names_.end() && owner->second != room_id)
+    {
+        LOG_ERROR << "updateRoom: room name already exists: " << name;
+        return false;
+    }
+
+    rooms_.write(room_id, [&](auto &rooms)
+    {
+        auto it = rooms.find(room_id);
+        if (it != rooms.end())
+        {
+            names_.erase(it->second.room.getName());
+            names_.emplace(name, room_id);
+            it->second.room.setName(name);
+            it->second.room.setDescription(description);
+        }
+        return true;
+    });
+    return true;
+}
+
+std::vector<std::string> MemoryRoomRepository::getRooms()
+{
+    std::vector<std::string> names;
+    for (const auto &room : getAllRooms())
+    {
+        names.push_back(room.getName());
+    }
+    return names;
+}
+
+std::vector<Room> MemoryRoomRepository::getAllRooms()
+{
+    std::vector<std::pair<uint64_t, Room>> snapshot;
+    rooms_.forEach([&](const std::string &, const Entry &entry)
+                   { snapshot.emplace_back(entry.seq, entry.room); });
+    std::sort(snapshot.begin(), snapshot.end(), [](const auto &a, const auto &b)
+              { return a.first < b.first; });
+
+    std::vector<Room> rooms;
+    rooms.reserve(snapshot.size());
+    for (auto &item : snapshot)
+    {
+        rooms.push_back(std::move(item.second));
+    }
+    return rooms;
+}
+
+std::optional<Room> MemoryRoomRepository::getRoomById(const std::string &room_id) const
+{
+    return rooms_.read(room_id, [&](const auto &rooms) -> std::optional<Room>
+    {
+        auto it = rooms.find(room_id);
+        if (it == rooms.end())
+        {
+            return std::nullopt;
+        }
+        return it->second.room;
+    });
+}
+
+std::optional<std::string> MemoryRoomRepository::getRoomIdByName(const std::string &room_name) const
+{
+    std::shared_lock<std::shared_mutex> names_lock(names_mutex_);
+    auto it = names_.find(room_name);
+    if (it == names_.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+bool MemoryRoomRepository::isRoomCreator(const std::string &room_id, const std::string &user_id)
+{
+    return rooms_.read(room_id, [&](const auto &rooms)
+    {
+        auto it = rooms.find(room_id);
+        return it != rooms.end() && it->second.room.getCreatorId() == user_id;
+    });
+}
+
+std::vector<nlohmann::json> MemoryRoomRepository::getRoomMembers(const std::string &room_id) const
+{
+    std::vector<std::pair<int64_t, std::string>> joined;
+    rooms_.read(room_id, [&](const auto &rooms)
+    {
+        auto it = rooms.find(room_id);
+        if (it != rooms.end())
+        {
+            for (const auto &[user_id, joined_at] : it->second.members)
+            {
+                joined.emplace_back(joined_at, user_id);
+            }
+        }
+        return true;
+    });
+    std::sort(joined.begin(), joined.end());
+
+    // 用户名在释放房间锁之后查询，避免持锁访问用户存储
+    std::vector<nlohmann::json> members;
+    for (const auto &[joined_at, user_id] : joined)
+    {
+        auto user = user_repo_ ? user_repo_->getUserById(user_id) : std::nullopt;
+        if (!user)
+        {
+            continue;
+        }
+        members.push_back({{"id", user_id},
+                           {"username", user->getUsername()},
+                           {"joined_at", joined_at}});
+    }
+    return members;
+}
+
+std::vector<Room> MemoryRoomRepository::getUserJoinedRooms(const std::string &user_id) const
+{
+    auto room_ids = joined_.read(user_id, [&](const auto &joined)
+    {
+        auto it = joined.find(user_id);
+        return it != joined.end() ? it->second : std::unordered_set<std::string>();
+    });
+
+    std::vector<Room> rooms;
+    for (const auto &room_id : room_ids)
+    {
+        if (auto room = getRoomById(room_id))
+        {
+            rooms.push_back(std::move(*room));
+        }
+    }
+    return rooms;
+}
+
+bool MemoryRoomRepository::addRoomMember(const std::string &room_id, const std::string &user_id)
+{
+    return joinRoom(room_id, user_id) == JoinResult::Joined;
+}
+
+JoinResult MemoryRoomRepository::joinRoom(const std::string &room_id, const std::string &user_id)
+{
+    // 与 room_members 的外键一致：用户必须存在
+    bool user_exists = userExists(user_id);
+    JoinResult result = JoinResult::RoomNotFound;
+    rooms_.write(room_id, [&](auto &rooms)
+    {
+        auto it = rooms.find(room_id);
+        if (it == rooms.end())
+        {
+            return false;
+        }
+        if (!user_exists)
+        {
+            result = JoinResult::UserNotFound;
+            return false;
+        }
+        // INSERT OR IGNORE 语义：已是成员时保持原加入时间并返回成功
+        if (it->second.members.emplace(user_id, nowTicks()).second)
+        {
+            it->second.room.setMemberCount(static_cast<int64_t>(it->second.members.size()));
+        }
+        joined_.write(user_id, [&](auto &joined)
+                      { return joined[user_id].insert(room_id).second; });
+        result = JoinResult::Joined;
+        return true;
+    });
+    return result;
+}
+
+bool MemoryRoomRepository::removeRoomMember(const std::string &room_id, const std::string &user_id)
+{
+    rooms_.write(room_id, [&](auto &rooms)
+    {
+        auto it = rooms.find(room_id);
+        if (it == rooms.end() || it->second.members.erase(user_id) == 0)
+        {
+            return false;
+        }
+        it->second.room.setMemberCount(static_cast<int64_t>(it->second.members.size()));
+        joined_.write(user_id, [&](auto &joined)
+        {
+            auto user_it = joined.find(user_id);
+            if (user_it != joined.end())
+            {
+                user_it->second.erase(room_id);
+                if (user_it->second.empty())
+                {
+                    joined.erase(user_it);
+                }
+            }
+            return true;
+        });
+        return true;
+    });
+    // 与 SQLite 的 DELETE 一致：没有匹配的成员关系也返回成功
+    return true;
+}
+
+bool MemoryRoomRepository::isRoomMember(const std::string &room_id, const std::string &user_id) const
+{
+    return rooms_.read(room_id, [&](const auto &rooms)
+    {
+        auto it = rooms.find(room_id);
+        return it != rooms.end() && it->second.members.count(user_id) > 0;
+    });
+}
+
+MembershipStatus MemoryRoomRepository::checkMembership(const std::string &room_id, const std::string &user_id) const
+{
+    return rooms_.read(room_id, [&](const auto &rooms)
+    {
+        auto it = rooms.find(room_id);
+        if (it == rooms.end())
+        {
+            return MembershipStatus::RoomNotFound;
+        }
+        return it->second.members.count(user_id) > 0 ? MembershipStatus::Member : MembershipStatus::NotMember;
+    });
+}
+
+size_t MemoryRoomRepository::getRoomMemberCount(const std::string &room_id) const
+{
+    return rooms_.read(room_id, [&](const auto &rooms) -> size_t
+    {
+        auto it = rooms.find(room_id);
+        return it != rooms.end() ? it->second.members.size() : 0;
+    });
+}
+
+void MemoryRoomRepository::recordMessageActivity(const std::string &room_id, int64_t message_delta, int64_t timestamp)
+{
+    rooms_.write(room_id, [&](auto &rooms)
+    {
+        auto it = rooms.find(room_id);
+        if (it == rooms.end())
+        {
+            return false;
+        }
+        Room &room = it->second.room;
+        room.setMessageCount(std::max<int64_t>(room.getMessageCount() + message_delta, 0));
+        room.setLastActivity(std::max(room.getLastActivity(), timestamp));
+        return true;
+    });
+}
+
+void MemoryRoomRepository::visitRooms(const std::string &after, size_t limit, const RoomRowVisitor &visitor) const
+{
+    // 先取快照再回调，不在持有分段锁时执行外部代码
+    std::vector<std::pair<uint64_t, Room>> snapshot;
+    rooms_.forEach([&](const std::string &, const Entry &entry)
+                   { snapshot.emplace_back(entry.seq, entry.room); });
+    // 与 SQLite 实现一致，从新到旧
+    std::sort(snapshot.begin(), snapshot.end(), [](const auto &a, const auto &b)
+              { return a.first > b.first; });
+
+    auto it = snapshot.begin();
+    if (!after.empty())
+    {
+        it = std::find_if(snapshot.begin(), snapshot.end(), [&after](const auto &item)
+                          { return item.second.getId() == after; });
+        it = it != snapshot.end() ? it + 1 : snapshot.end();
+    }
+
+    for (size_t visited = 0; it != snapshot.end() && (limit == 0 || visited < limit); ++it, ++visited)
+    {
+        const Room &room = it->second;
+        RoomRow row;
+        row.id = room.getId();
+        row.name = room.getName();
+        row.description = room.getDescription();
+        row.creator_id = room.getCreatorId();
+        row.created_at = room.getCreatedAt();
+        row.member_count = room.getMemberCount();
+        row.message_count = room.getMessageCount();
+        row.last_activity = room.getLastActivity();
+        if (!visitor(row))
+        {
+            break;
+        }
+    }
+}
+
+void MemoryRoomRepository::visitRoomMembers(const std::string &room_id, const MemberRowVisitor &visitor) const
+{
+    for (const auto &member : getRoomMembers(room_id))
+    {
+        const auto &user_id = member["id"].get_ref<const std::string &>();
+        const auto &username = member["username"].get_ref<const std::string &>();
+        if (!visitor(MemberRow{user_id, username, member["joined_at"].get<int64_t>()}))
+        {
+            break;
+        }
+    }
+}
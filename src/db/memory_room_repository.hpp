@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <nlohmann/json.hpp>
+#include "room_repository.hpp"
+#include "striped_map.hpp"
+#include "../model/room.hpp"
+
+class UserRepository;
+
+// 纯内存的房间和成员存储，数据不落盘，进程退出即丢失
+// 房间（含成员表）和 用户 -> 已加入房间 的反向索引按键分段加锁；
+// 房间名索引只在创建、改名、删除房间时写入，用一把读写锁保护。
+// 加锁顺序固定为 房间名索引 -> 房间分段 -> 用户分段
+class MemoryRoomRepository : public RoomRepository
+{
+public:
+    // user_repo: 用于校验创建者/成员是否存在以及查询成员用户名
+    explicit MemoryRoomRepository(const UserRepository *user_repo);
+
+    std::optional<Room> createRoom(const std::string &name, const std::string &description, const std::string &creator_id) override;
+    bool deleteRoom(const std::string &room_id) override;
+    bool roomExists(const std::string &room_id) const override;
+    bool updateRoom(const std::string &room_id, const std::string &name, const std::string &description) override;
+
+    std::vector<std::string> getRooms() override;
+    std::vector<Room> getAllRooms() override;// 按创建顺序返回
+    void visitRooms(const std::string &after, size_t limit, const RoomRowVisitor &visitor) const override;
+    std::optional<Room> getRoomById(const std::string &room_id) const override;
+    std::optional<std::string> getRoomIdByName(const std::string &room_name) const override;
+    bool isRoomCreator(const std::string &room_id, const std::string &user_id) override;
+
+    std::vector<nlohmann::json> getRoomMembers(const std::string &room_id) const override;// 按加入时间返回
+    void visitRoomMembers(const std::string &room_id, const MemberRowVisitor &visitor) const override;
+    std::vector<Room> getUserJoinedRooms(const std::string &user_id) const override;
+    bool addRoomMember(const std::string &room_id, const std::string &user_id) override;
+    bool removeRoomMember(const std::string &room_id, const std::string &user_id) override;
+    bool isRoomMember(const std::string &room_id, const std::string &user_id) const override;
+    size_t getRoomMemberCount(const std::string &room_id) const override;
+    MembershipStatus checkMembership(const std::string &room_id, const std::string &user_id) const override;
+    JoinResult joinRoom(const std::string &room_id, const std::string &user_id) override;
+    void recordMessageActivity(const std::string &room_id, int64_t message_delta, int64_t timestamp) override;
+
+private:
+    struct Entry
+    {
+        Room room;
+        uint64_t seq = 0;                                 // 创建顺序
+        std::unordered_map<std::string, int64_t> members; // 成员ID -> 加入时间
+    };
+
+    bool userExists(const std::string &user_id) const;
+
+    const UserRepository *user_repo_;
+    mutable std::shared_mutex names_mutex_;
+    std::unordered_map<std::string, std::string> names_;                  // 房间名 -> 房间ID
+    StripedMap<std::string, Entry> rooms_;                                // 房间ID -> 房间及成员
+    StripedMap<std::string, std::unordered_set<std::string>> joined_;     // 用户ID -> 已加入的房间ID
+    std::atomic<uint64_t> next_seq_{0};
+};
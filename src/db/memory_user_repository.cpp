@@ -0,0 +1,123 @@
+#include "memory_user_repository.hpp"
+#include "../utils/logger.hpp"
+#include <algorithm>
+
+bool MemoryUserRepository::createUser(const std::string &username, const std::string &password_hash)
+{
+    // 先锁用户名分段再锁用户分段，所有路径都按这个顺序加锁
+    bool created = usernames_.write(username, [&](auto &usernames)
+    {
+        if (usernames.count(username))
+        {
+            return false;
+        }
+        std::string user_id;
+        bool inserted = false;
+        while (!inserted)
+        {
+            user_id = generateUserId();
+            inserted = users_.write(user_id, [&](auto &users)
+            {
+                return users.emplace(user_id, Entry{User(user_id, username, password_hash), next_seq_++}).second;
+            });
+        }
+        usernames.emplace(username, user_id);
+        return true;
+    });
+
+    if (!created)
+    {
+        LOG_ERROR << "Failed to create user, username already exists: " << username;
+    }
+    return created;
+}
+
+bool MemoryUserRepository::validateUser(const std::string &username, const std::string &password_hash)
+{
+    auto user = getUserByUsername(username);
+    return user && user->getPassword() == password_hash;
+}
+
+bool MemoryUserRepository::userExists(const std::string &user_id)
+{
+    return users_.read(user_id, [&](const auto &users)
+                       { return users.count(user_id) > 0; });
+}
+
+std::vector<User> MemoryUserRepository::getAllUsers() const
+{
+    std::vector<Entry> snapshot;
+    users_.forEach([&](const std::string &, const Entry &entry)
+                   { snapshot.push_back(entry); });
+    std::sort(snapshot.begin(), snapshot.end(), [](const Entry &a, const Entry &b)
+              { return a.seq < b.seq; });
+
+    std::vector<User> users;
+    users.reserve(snapshot.size());
+    for (auto &entry : snapshot)
+    {
+        users.push_back(std::move(entry.user));
+    }
+    return users;
+}
+
+std::optional<User> MemoryUserRepository::getUserById(const std::string &user_id) const
+{
+    return users_.read(user_id, [&](const auto &users) -> std::optional<User>
+    {
+        auto it = users.find(user_id);
+        if (it == users.end())
+        {
+            return std::nullopt;
+        }
+        return it->second.user;
+    });
+}
+
+std::optional<User> MemoryUserRepository::getUserByUsername(const std::string &username) const
+{
+    auto user_id = usernames_.read(username, [&](const auto &usernames) -> std::optional<std::string>
+    {
+        auto it = usernames.find(username);
+        if (it == usernames.end())
+        {
+            return std::nullopt;
+        }
+        return it->second;
+    });
+    return user_id ? getUserById(*user_id) : std::nullopt;
+}
+
+std::unordered_map<std::string, std::string> MemoryUserRepository::getUsernames(const std::vector<std::string> &user_ids) const
+{
+    std::unordered_map<std::string, std::string> usernames;
+    for (const auto &user_id : user_ids)
+    {
+        if (auto user = getUserById(user_id))
+        {
+            usernames.emplace(user_id, user->getUsername());
+        }
+    }
+    return usernames;
+}
+
+void MemoryUserRepository::visitUsers(const std::string &after, size_t limit, const UserRowVisitor &visitor) const
+{
+    // 先取快照再回调，不在持有分段锁时执行外部代码
+    auto users = getAllUsers();
+    auto it = users.begin();
+    if (!after.empty())
+    {
+        it = std::find_if(users.begin(), users.end(), [&after](const User &user)
+                          { return user.getId() == after; });
+        it = it != users.end() ? it + 1 : users.end();
+    }
+
+    for (size_t visited = 0; it != users.end() && (limit == 0 || visited < limit); ++it, ++visited)
+    {
+        if (!visitor(UserRow{it->getId(), it->getUsername()}))
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <atomic>
+#include <cstdint>
+#include "user_repository.hpp"
+#include "striped_map.hpp"
+#include "../model/user.hpp"
+
+// 纯内存的用户存储，数据不落盘，进程退出即丢失
+// 用户表和用户名索引都按键分段加锁，用于压测网络层时排除 SQLite 的影响
+class MemoryUserRepository : public UserRepository
+{
+public:
+    MemoryUserRepository() = default;
+
+    bool createUser(const std::string &username, const std::string &password_hash) override;
+    bool validateUser(const std::string &username, const std::string &password_hash) override;
+    bool userExists(const std::string &user_id) override;
+
+    std::vector<User> getAllUsers() const override;// 按创建顺序返回
+    void visitUsers(const std::string &after, size_t limit, const UserRowVisitor &visitor) const override;
+    std::optional<User> getUserById(const std::string &user_id) const override;
+    std::optional<User> getUserByUsername(const std::string &username) const override;
+    std::unordered_map<std::string, std::string> getUsernames(const std::vector<std::string> &user_ids) const override;
+
+private:
+    struct Entry
+    {
+        User user;
+        uint64_t seq; // 创建顺序
+    };
+
+    StripedMap<std::string, Entry> users_;           // 用户ID -> 用户
+    StripedMap<std::string, std::string> usernames_; // 用户名 -> 用户ID，保证用户名唯一
+    std::atomic<uint64_t> next_seq_{0};
+};
@@ -0,0 +1,174 @@
+#include "message_cache.hpp"
+#include "../utils/logger.hpp"
+#include <algorithm>
+
+MessageCache::MessageCache(size_t capacity, std::chrono::seconds idle_ttl)
+    : capacity_(capacity), idle_ttl_(idle_ttl) {}
+
+bool MessageCache::getRecent(const std::string &room_id, int limit, std::vector<std::string> &out)
+{
+    if (limit <= 0) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = rings_.find(room_id);
+    if (it == rings_.end())
+    {
+        return false;
+    }
+
+    Ring &ring = it->second;
+    // 缓存里的消息不够，且不确定是否还有更早的消息时，只能回源数据库
+    if (!ring.complete && ring.entries.size() < static_cast<size_t>(limit))
+    {
+        return false;
+    }
+
+    ring.last_access = std::chrono::steady_clock::now();
+    size_t count = std::min(ring.entries.size(), static_cast<size_t>(limit));
+    out.clear();
+    out.reserve(count);
+    for (auto entry_it = ring.entries.end() - count; entry_it != ring.entries.end(); ++entry_it)
+    {
+        out.push_back(entry_it->json);
+    }
+    return true;
+}
+
+bool MessageCache::getAfter(const std::string &room_id, int64_t after_id, int limit, std::vector<std::string> &out, bool &truncated)
+{
+    if (limit <= 0) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = rings_.find(room_id);
+    if (it == rings_.end())
+    {
+        return false;
+    }
+
+    Ring &ring = it->second;
+    auto first = std::upper_bound(ring.entries.begin(), ring.entries.end(), after_id,
+                                  [](int64_t id, const Entry &entry) { return id < entry.id; });
+    size_t newer = static_cast<size_t>(ring.entries.end() - first);
+    // 缓存中有 after_id 或更早的消息，说明缺口完整地落在缓存里
+    bool covered = ring.complete || first != ring.entries.begin();
+    if (!covered && newer <= static_cast<size_t>(limit))
+    {
+        return false;
+    }
+
+    ring.last_access = std::chrono::steady_clock::now();
+    truncated = newer > static_cast<size_t>(limit);
+    size_t count = std::min(newer, static_cast<size_t>(limit));
+    out.clear();
+    out.reserve(count);
+    for (auto entry_it = ring.entries.end() - count; entry_it != ring.entries.end(); ++entry_it)
+    {
+        out.push_back(entry_it->json);
+    }
+    return true;
+}
+
+void MessageCache::warm(const std::string &room_id, const std::vector<Message> &messages, bool complete)
+{
+    Ring ring;
+    ring.complete = complete;
+    ring.last_access = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &message : messages)
+    {
+        insertLocked(ring, message.getId(), message.toJson().dump());
+    }
+
+    // 查询数据库期间可能有新消息已经追加进旧缓存，合并过来避免丢失
+    auto it = rings_.find(room_id);
+    if (it != rings_.end())
+    {
+        for (auto &entry : it->second.entries)
+        {
+            insertLocked(ring, entry.id, std::move(entry.json));
+        }
+    }
+    rings_[room_id] = std::move(ring);
+}
+
+void MessageCache::append(const Message &message)
+{
+    std::string json = message.toJson().dump(); // 在锁外完成序列化
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = rings_.find(message.getRoomId());
+    if (it == rings_.end())
+    {
+        // 还没有缓存的房间建立一个不完整的环，等第一次读取时再从数据库补齐
+        it = rings_.emplace(message.getRoomId(), Ring{}).first;
+    }
+    it->second.last_access = std::chrono::steady_clock::now();
+    insertLocked(it->second, message.getId(), std::move(json));
+}
+
+void MessageCache::evictRoom(const std::string &room_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings_.erase(room_id);
+}
+
+size_t MessageCache::evictIdle()
+{
+    auto now = std::chrono::steady_clock::now();
+    size_t evicted = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = rings_.begin(); it != rings_.end();)
+    {
+        if (now - it->second.last_access >= idle_ttl_)
+        {
+            it = rings_.erase(it);
+            ++evicted;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if (evicted > 0)
+    {
+        LOG_INFO << "MessageCache evicted " << evicted << " idle rooms, " << rings_.size() << " remaining";
+    }
+    return evicted;
+}
+
+size_t MessageCache::roomCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rings_.size();
+}
+
+void MessageCache::insertLocked(Ring &ring, int64_t id, std::string json)
+{
+    // 绝大多数情况下新消息ID最大，直接追加到尾部
+    auto pos = ring.entries.end();
+    while (pos != ring.entries.begin() && (pos - 1)->id >= id)
+    {
+        if ((pos - 1)->id == id)
+        {
+            return; // 已存在，去重
+        }
+        --pos;
+    }
+
+    // 环已满且新消息比最旧的还旧，直接丢弃
+    if (ring.entries.size() >= capacity_ && pos == ring.entries.begin())
+    {
+        ring.complete = false;
+        return;
+    }
+
+    ring.entries.insert(pos, Entry{id, std::move(json)});
+    while (ring.entries.size() > capacity_)
+    {
+        ring.entries.pop_front();
+        ring.complete = false; // 最旧的消息被挤出，缓存不再包含房间全部消息
+    }
+}
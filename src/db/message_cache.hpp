@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include "../model/message.hpp"
+
+// 活跃房间的热消息环形缓存
+// 每个房间保存最近 capacity 条消息（已序列化为JSON字符串），用于直接响应最新的历史消息请求，
+// 更早的分页仍然走 MessageRepository
+class MessageCache
+{
+public:
+    explicit MessageCache(size_t capacity = 200,
+                          std::chrono::seconds idle_ttl = std::chrono::seconds(600));
+
+    // 尝试从缓存中获取房间最近的 limit 条消息（按时间正序），命中返回 true
+    bool getRecent(const std::string &room_id, int limit, std::vector<std::string> &out);
+
+    // 断线重连时补发：获取ID大于 after_id 的消息（按时间正序），最多返回最新的 limit 条，
+    // truncated 表示缺口超过 limit 条。缓存确定覆盖 after_id 之后的全部消息，或其中已超过 limit 条时才命中
+    bool getAfter(const std::string &room_id, int64_t after_id, int limit, std::vector<std::string> &out, bool &truncated);
+
+    // 用数据库中读到的最近消息（按ID正序）填充房间缓存
+    // complete 表示 messages 已经包含了该房间的全部消息
+    void warm(const std::string &room_id, const std::vector<Message> &messages, bool complete);
+
+    // 新消息写入数据库后追加到房间缓存
+    void append(const Message &message);
+
+    // 丢弃房间缓存（如房间被删除）
+    void evictRoom(const std::string &room_id);
+
+    // 淘汰超过 idle_ttl 未被访问的房间缓存，返回淘汰的房间数量
+    size_t evictIdle();
+
+    size_t capacity() const { return capacity_; }
+    size_t roomCount() const;
+
+private:
+    struct Entry
+    {
+        int64_t id;       // 消息ID，用于去重和保证顺序
+        std::string json; // 预序列化的消息JSON
+    };
+
+    struct Ring
+    {
+        std::deque<Entry> entries;                          // 按消息ID升序
+        bool complete = false;                              // 是否包含房间的全部消息
+        std::chrono::steady_clock::time_point last_access;  // 最近访问时间
+    };
+
+    // 按ID有序插入，超出容量时丢弃最旧的消息，调用方需持有锁
+    void insertLocked(Ring &ring, int64_t id, std::string json);
+
+    size_t capacity_;
+    std::chrono::seconds idle_ttl_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Ring> rings_; // 房间ID到环形缓存的映射
+};
@@ -3,23 +3,35 @@
 #include <string>
 #include <vector>
 #include <optional>
-#include <nlohmann/json.hpp>
-#include "database_connection.hpp"
+#include <cstdint>
 #include "../model/message.hpp"
 
-// 消息数据访问类
+// 消息存储接口
+// 默认实现为 SqliteMessageRepository；LogMessageRepository 为追加写的分段日志存储，启动时选择
 class MessageRepository
 {
 public:
-    explicit MessageRepository(DatabaseConnection *db_conn);
+    virtual ~MessageRepository() = default;
 
     // 消息操作
-    bool saveMessage(const std::string &room_id, const std::string &user_id,
-                     const std::string &content, int64_t timestamp);// 根据ID保存消息
-    std::vector<Message> getMessages(const std::string &room_id, int limit = 50,
-                                     int64_t before_timestamp = 0);// 根据ID获取消息
-    std::optional<Message> getMessageById(int64_t message_id);// 根据ID获取单个消息
+    virtual bool saveMessage(const std::string &room_id, const std::string &user_id,
+                             const std::string &content, int64_t timestamp,
+                             int64_t *message_id = nullptr) = 0;// 根据ID保存消息，可选返回新消息ID
+    virtual std::vector<Message> getMessages(const std::string &room_id, int limit = 50,
+                                             int64_t before_timestamp = 0) = 0;// 按时间正序获取消息
+    virtual std::vector<Message> getRecentMessages(const std::string &room_id, int limit = 50,
+                                                   int64_t before_id = 0) = 0;// 获取最近的消息，before_id 用于向前翻页
+    virtual std::optional<Message> getMessageById(int64_t message_id) = 0;// 根据ID获取单个消息
+    virtual bool deleteRoomMessages(const std::string &room_id) = 0;// 删除房间的全部消息（独立存储没有级联删除）
+    // 从最旧的消息开始清理 时间戳 < before_timestamp 或不在最新 keep_latest 条之内的消息（0 表示不按该条件清理），
+    // 一次调用最多删除一批（约 batch_size 条）后返回删除的条数，调用方重复调用直到返回 0
+    virtual size_t purgeMessages(const std::string &room_id, int64_t before_timestamp,
+                                 size_t keep_latest, size_t batch_size) = 0;
 
-private:
-    DatabaseConnection *db_conn_;
+    // 全文搜索：在房间内查找包含 query 中所有词的消息，按相关度排序，跳过 offset 条后最多返回 limit 条。
+    // 存储没有全文索引时返回空，由调用方退化为逐条扫描
+    virtual std::optional<std::vector<Message>> searchMessages(const std::string &room_id, const std::string &query,
+                                                               int limit, int offset) = 0;
+    // 把尚未进入全文索引的消息加入索引，一次最多 batch_size 条，返回加入的条数；没有全文索引的存储返回 0
+    virtual size_t indexPendingMessages(size_t batch_size) = 0;
 };
@@ -0,0 +1,249 @@
+#include "message_retention.hpp"
+#include "database_manager.hpp"
+#include "database_connection.hpp"
+#include "../utils/logger.hpp"
+#include <ctime>
+#include <thread>
+#include <vector>
+
+nlohmann::json RetentionPolicy::toJson() const
+{
+    return {{"max_age_seconds", max_age.count()}, {"max_messages", max_messages}};
+}
+
+MessageRetention::MessageRetention(DatabaseManager &db, DatabaseConnection *meta_conn)
+    : db_(db), meta_conn_(meta_conn)
+{
+    loadRoomPolicies();
+}
+
+MessageRetention::~MessageRetention()
+{
+    stop();
+}
+
+void MessageRetention::setOptions(const Options &options)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+}
+
+MessageRetention::Options MessageRetention::getOptions() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+void MessageRetention::start()
+{
+    Options options = getOptions();
+    if (started_)
+    {
+        return;
+    }
+    started_ = true;
+    stopping_ = false;
+
+    // 第一次清理在一个周期后执行，避免与启动时的其他初始化争抢数据库
+    timer_.addPeriodicTask(options.purge_interval, options.purge_interval, [this]()
+                           { purgeOnce(); });
+    if (options.maintenance_interval.count() > 0)
+    {
+        timer_.addPeriodicTask(options.maintenance_interval, options.maintenance_interval, [this]()
+                               { runMaintenance(); });
+    }
+    timer_.start();
+    LOG_INFO << "Message retention started, global policy: " << options.global.toJson().dump()
+             << ", purge interval: " << options.purge_interval.count() << " ms";
+}
+
+void MessageRetention::stop()
+{
+    stopping_ = true;
+    timer_.stop();
+}
+
+void MessageRetention::loadRoomPolicies()
+{
+    if (!meta_conn_ || !meta_conn_->isConnected())
+    {
+        return;
+    }
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(meta_conn_->getMutex());
+    const char *sql = "SELECT r.id, rr.max_age_seconds, rr.max_messages "
+                      "FROM room_retention rr JOIN rooms r ON r.pk = rr.room_pk;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(meta_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(meta_conn_->getDb());
+        return;
+    }
+
+    std::lock_guard<std::mutex> policies_lock(mutex_);
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        RetentionPolicy policy;
+        policy.max_age = std::chrono::seconds(sqlite3_column_int64(stmt, 1));
+        policy.max_messages = static_cast<size_t>(sqlite3_column_int64(stmt, 2));
+        room_policies_[reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0))] = policy;
+    }
+    sqlite3_finalize(stmt);
+}
+
+bool MessageRetention::setRoomPolicy(const std::string &room_id, const RetentionPolicy &policy)
+{
+    if (meta_conn_)
+    {
+        std::lock_guard<DatabaseConnection::Mutex> lock(meta_conn_->getMutex());
+        const char *sql = "INSERT OR REPLACE INTO room_retention (room_pk, max_age_seconds, max_messages) "
+                          "SELECT pk, ?, ? FROM rooms WHERE id = ?;";
+        sqlite3_stmt *stmt;
+
+        if (sqlite3_prepare_v2(meta_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(meta_conn_->getDb());
+            return false;
+        }
+
+        sqlite3_bind_int64(stmt, 1, policy.max_age.count());
+        sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(policy.max_messages));
+        sqlite3_bind_text(stmt, 3, room_id.c_str(), -1, SQLITE_STATIC);
+
+        // 房间不存在时查不到主键，不插入任何行
+        bool success = (sqlite3_step(stmt) == SQLITE_DONE) && sqlite3_changes(meta_conn_->getDb()) == 1;
+        sqlite3_finalize(stmt);
+        if (!success)
+        {
+            return false;
+        }
+    }
+    else if (!db_.roomExists(room_id))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    room_policies_[room_id] = policy;
+    return true;
+}
+
+bool MessageRetention::clearRoomPolicy(const std::string &room_id)
+{
+    if (meta_conn_)
+    {
+        std::lock_guard<DatabaseConnection::Mutex> lock(meta_conn_->getMutex());
+        const char *sql = "DELETE FROM room_retention WHERE room_pk = (SELECT pk FROM rooms WHERE id = ?);";
+        sqlite3_stmt *stmt;
+
+        if (sqlite3_prepare_v2(meta_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(meta_conn_->getDb());
+            return false;
+        }
+
+        sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+        bool success = (sqlite3_step(stmt) == SQLITE_DONE);
+        sqlite3_finalize(stmt);
+        if (!success)
+        {
+            return false;
+        }
+    }
+
+    forgetRoom(room_id);
+    return true;
+}
+
+std::optional<RetentionPolicy> MessageRetention::getRoomPolicy(const std::string &room_id) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = room_policies_.find(room_id);
+    if (it == room_policies_.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+RetentionPolicy MessageRetention::getEffectivePolicy(const std::string &room_id) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = room_policies_.find(room_id);
+    return it != room_policies_.end() ? it->second : options_.global;
+}
+
+void MessageRetention::forgetRoom(const std::string &room_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    room_policies_.erase(room_id);
+}
+
+size_t MessageRetention::purgeOnce()
+{
+    Options options = getOptions();
+    std::vector<std::pair<std::string, RetentionPolicy>> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (options.global.unlimited())
+        {
+            // 没有全局策略时只需要处理单独设置了策略的房间，不必遍历房间表
+            for (const auto &entry : room_policies_)
+            {
+                targets.push_back(entry);
+            }
+        }
+    }
+    if (!options.global.unlimited())
+    {
+        for (const auto &room : db_.getAllRooms())
+        {
+            targets.emplace_back(room.getId(), getEffectivePolicy(room.getId()));
+        }
+    }
+
+    size_t total = 0;
+    for (const auto &[room_id, policy] : targets)
+    {
+        if (stopping_)
+        {
+            break;
+        }
+        if (!policy.unlimited())
+        {
+            total += purgeRoom(room_id, policy);
+        }
+    }
+    if (total > 0)
+    {
+        LOG_INFO << "Message retention purged " << total << " messages";
+    }
+    return total;
+}
+
+size_t MessageRetention::purgeRoom(const std::string &room_id, const RetentionPolicy &policy)
+{
+    Options options = getOptions();
+    // 消息时间戳为秒级 Unix 时间
+    int64_t before_timestamp = policy.max_age.count() > 0 ? static_cast<int64_t>(std::time(nullptr)) - policy.max_age.count() : 0;
+
+    size_t total = 0;
+    while (!stopping_)
+    {
+        size_t deleted = db_.purgeRoomMessages(room_id, before_timestamp, policy.max_messages, options.batch_size);
+        if (deleted == 0)
+        {
+            break;
+        }
+        total += deleted;
+        // 让出数据库锁，排队中的前台写入可以先执行
+        std::this_thread::sleep_for(options.batch_pause);
+    }
+    return total;
+}
+
+void MessageRetention::runMaintenance()
+{
+    db_.runStorageMaintenance(getOptions().vacuum_pages);
+}
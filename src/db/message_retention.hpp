@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "../utils/timer.hpp"
+
+class DatabaseManager;
+class DatabaseConnection;
+
+// 消息保留策略
+struct RetentionPolicy
+{
+    std::chrono::seconds max_age{0}; // 早于该时长的消息被清理，0 表示不限
+    size_t max_messages = 0;         // 每个房间最多保留的消息条数，0 表示不限
+
+    bool unlimited() const { return max_age.count() == 0 && max_messages == 0; }
+    nlohmann::json toJson() const;
+};
+
+// 后台消息清理任务
+// 定时按全局策略或房间单独设置的策略删除过期消息。每个房间从最旧的消息开始分批删除，
+// 每批是一个独立的短事务，两批之间释放数据库锁并暂停 batch_pause，前台写入不会被一次大的 DELETE 长时间阻塞。
+// 另有一个定时任务对所有SQLite连接执行增量回收和WAL检查点
+class MessageRetention
+{
+public:
+    struct Options
+    {
+        RetentionPolicy global;                                                        // 没有单独设置策略的房间使用全局策略
+        std::chrono::milliseconds purge_interval = std::chrono::minutes(1);            // 清理任务间隔
+        size_t batch_size = 500;                                                       // 每批最多删除的消息数
+        std::chrono::milliseconds batch_pause = std::chrono::milliseconds(10);         // 两批之间让出数据库的时间
+        std::chrono::milliseconds maintenance_interval = std::chrono::minutes(10);     // 增量回收和检查点间隔，0 表示不执行
+        int vacuum_pages = 1000;                                                       // 每次增量回收的最大页数
+    };
+
+    // meta_conn: 保存房间策略的元数据库连接，为空时（内存引擎）房间策略只保存在内存中
+    MessageRetention(DatabaseManager &db, DatabaseConnection *meta_conn);
+    ~MessageRetention();
+
+    MessageRetention(const MessageRetention &) = delete;
+    MessageRetention &operator=(const MessageRetention &) = delete;
+
+    void setOptions(const Options &options);
+    Options getOptions() const;
+
+    // 启动/停止后台定时任务
+    void start();
+    void stop();
+
+    // 房间单独设置的策略，覆盖全局策略
+    bool setRoomPolicy(const std::string &room_id, const RetentionPolicy &policy);
+    bool clearRoomPolicy(const std::string &room_id);
+    std::optional<RetentionPolicy> getRoomPolicy(const std::string &room_id) const;
+    RetentionPolicy getEffectivePolicy(const std::string &room_id) const;
+    void forgetRoom(const std::string &room_id); // 房间已删除，丢弃内存中的策略
+
+    size_t purgeOnce();    // 对所有房间执行一轮清理，返回删除的消息数
+    void runMaintenance(); // 增量回收和WAL检查点
+
+private:
+    void loadRoomPolicies();
+    size_t purgeRoom(const std::string &room_id, const RetentionPolicy &policy);
+
+    DatabaseManager &db_;
+    DatabaseConnection *meta_conn_;
+
+    mutable std::mutex mutex_; // 保护 options_ 和 room_policies_
+    Options options_;
+    std::unordered_map<std::string, RetentionPolicy> room_policies_;
+
+    std::atomic<bool> stopping_{false}; // 停止时中断正在进行的清理
+    bool started_ = false;
+    utils::Timer timer_;
+};
@@ -0,0 +1,145 @@
+#include "query_stats.hpp"
+#include "../utils/logger.hpp"
+#include <algorithm>
+#include <vector>
+
+const std::array<int64_t, QueryStats::kBucketCount - 1> QueryStats::kBucketBoundsUs = {
+    100, 500, 1000, 5000, 10000, 50000, 100000};
+
+QueryStats::QueryStats()
+    : mutex_acquisitions_(0), mutex_contended_(0), mutex_wait_total_ns_(0), mutex_wait_max_ns_(0),
+      slow_query_threshold_ns_(100 * 1000 * 1000) {}
+
+int QueryStats::traceCallback(unsigned type, void *context, void *p, void *x)
+{
+    auto *stats = static_cast<QueryStats *>(context);
+    auto *stmt = static_cast<sqlite3_stmt *>(p);
+    if (type == SQLITE_TRACE_ROW)
+    {
+        stats->recordRow(stmt);
+    }
+    else if (type == SQLITE_TRACE_PROFILE)
+    {
+        stats->recordProfile(stmt, *static_cast<sqlite3_int64 *>(x));
+    }
+    return 0;
+}
+
+void QueryStats::recordRow(sqlite3_stmt *stmt)
+{
+    // SQLite 内部语句（如加载表结构）没有SQL文本，也不会触发 PROFILE，忽略
+    if (!sqlite3_sql(stmt))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++pending_rows_[stmt];
+}
+
+void QueryStats::recordProfile(sqlite3_stmt *stmt, int64_t elapsed_ns)
+{
+    const char *sql = sqlite3_sql(stmt);
+    if (!sql)
+    {
+        return;
+    }
+
+    // 第一个上界不小于耗时的桶，超过所有上界的落在最后一个桶
+    size_t bucket = std::lower_bound(kBucketBoundsUs.begin(), kBucketBoundsUs.end(), elapsed_ns / 1000) - kBucketBoundsUs.begin();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t rows = 0;
+        auto pending = pending_rows_.find(stmt);
+        if (pending != pending_rows_.end())
+        {
+            rows = pending->second;
+            pending_rows_.erase(pending);
+        }
+
+        StatementStats &entry = statements_[sql];
+        ++entry.calls;
+        entry.rows += rows;
+        entry.total_ns += elapsed_ns;
+        entry.max_ns = std::max(entry.max_ns, elapsed_ns);
+        ++entry.histogram[bucket];
+    }
+
+    int64_t threshold = slow_query_threshold_ns_.load(std::memory_order_relaxed);
+    if (threshold > 0 && elapsed_ns >= threshold)
+    {
+        LOG_WARN << "Slow query (" << elapsed_ns / 1000000.0 << " ms): " << sql;
+    }
+}
+
+void QueryStats::recordMutexWait(int64_t wait_ns)
+{
+    mutex_contended_.fetch_add(1, std::memory_order_relaxed);
+    mutex_wait_total_ns_.fetch_add(wait_ns, std::memory_order_relaxed);
+    int64_t current_max = mutex_wait_max_ns_.load(std::memory_order_relaxed);
+    while (wait_ns > current_max &&
+           !mutex_wait_max_ns_.compare_exchange_weak(current_max, wait_ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+void QueryStats::setSlowQueryThreshold(std::chrono::milliseconds threshold)
+{
+    slow_query_threshold_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(threshold).count());
+}
+
+std::chrono::milliseconds QueryStats::getSlowQueryThreshold() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::nanoseconds(slow_query_threshold_ns_.load()));
+}
+
+nlohmann::json QueryStats::toJson() const
+{
+    std::vector<std::pair<std::string, StatementStats>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        snapshot.assign(statements_.begin(), statements_.end());
+    }
+    // 按总耗时倒序，最值得优化的语句排在前面
+    std::sort(snapshot.begin(), snapshot.end(), [](const auto &a, const auto &b)
+              { return a.second.total_ns > b.second.total_ns; });
+
+    nlohmann::json statements = nlohmann::json::array();
+    for (const auto &[sql, entry] : snapshot)
+    {
+        nlohmann::json histogram = nlohmann::json::object();
+        for (size_t i = 0; i < kBucketCount; ++i)
+        {
+            std::string key = i < kBucketBoundsUs.size() ? "le_" + std::to_string(kBucketBoundsUs[i]) + "us"
+                                                         : "gt_" + std::to_string(kBucketBoundsUs.back()) + "us";
+            histogram[key] = entry.histogram[i];
+        }
+        statements.push_back({{"sql", sql},
+                              {"calls", entry.calls},
+                              {"rows", entry.rows},
+                              {"total_us", entry.total_ns / 1000},
+                              {"avg_us", entry.calls ? entry.total_ns / 1000 / static_cast<int64_t>(entry.calls) : 0},
+                              {"max_us", entry.max_ns / 1000},
+                              {"histogram", histogram}});
+    }
+
+    return {
+        {"mutex", {{"acquisitions", mutex_acquisitions_.load()},
+                   {"contended", mutex_contended_.load()},
+                   {"wait_total_us", mutex_wait_total_ns_.load() / 1000},
+                   {"wait_max_us", mutex_wait_max_ns_.load() / 1000}}},
+        {"slow_query_threshold_ms", getSlowQueryThreshold().count()},
+        {"statements", statements}};
+}
+
+void QueryStats::reset()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statements_.clear();
+    }
+    mutex_acquisitions_ = 0;
+    mutex_contended_ = 0;
+    mutex_wait_total_ns_ = 0;
+    mutex_wait_max_ns_ = 0;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <sqlite3.h>
+#include <nlohmann/json.hpp>
+
+// SQL 执行统计
+// 通过 sqlite3_trace_v2 (SQLITE_TRACE_PROFILE / SQLITE_TRACE_ROW) 收集每条语句的调用次数、返回行数和耗时分布，
+// 同时记录调用方等待数据库互斥锁的时间。语句按 sqlite3_sql() 返回的原始SQL归类，绑定参数不会进入统计和日志
+class QueryStats
+{
+public:
+    static constexpr size_t kBucketCount = 8;
+    static const std::array<int64_t, kBucketCount - 1> kBucketBoundsUs; // 耗时直方图各桶的上界（微秒）
+
+    QueryStats();
+
+    // 注册到 sqlite3_trace_v2 的回调
+    static int traceCallback(unsigned type, void *context, void *p, void *x);
+
+    void recordRow(sqlite3_stmt *stmt);
+    void recordProfile(sqlite3_stmt *stmt, int64_t elapsed_ns);
+    void recordMutexWait(int64_t wait_ns);                          // 发生争用时记录等待时间
+    void recordMutexAcquire() { mutex_acquisitions_.fetch_add(1, std::memory_order_relaxed); }
+
+    // 慢查询阈值，超过阈值的语句输出 WARN 日志；0 表示不记录
+    void setSlowQueryThreshold(std::chrono::milliseconds threshold);
+    std::chrono::milliseconds getSlowQueryThreshold() const;
+
+    nlohmann::json toJson() const;
+    void reset();
+
+private:
+    struct StatementStats
+    {
+        uint64_t calls = 0;
+        uint64_t rows = 0;
+        int64_t total_ns = 0;
+        int64_t max_ns = 0;
+        std::array<uint64_t, kBucketCount> histogram{};
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, StatementStats> statements_; // 按SQL文本归类的统计
+    std::unordered_map<sqlite3_stmt *, uint64_t> pending_rows_;  // 执行中的语句已返回的行数
+
+    std::atomic<uint64_t> mutex_acquisitions_;
+    std::atomic<uint64_t> mutex_contended_;
+    std::atomic<int64_t> mutex_wait_total_ns_;
+    std::atomic<int64_t> mutex_wait_max_ns_;
+    std::atomic<int64_t> slow_query_threshold_ns_;
+};
+
+// 记录等待时间的递归互斥锁，满足 Lockable 要求，可直接用于 std::lock_guard
+// 无争用时只多一次 try_lock，只有真正需要等待时才读取时钟
+class InstrumentedMutex
+{
+public:
+    explicit InstrumentedMutex(QueryStats &stats) : stats_(stats) {}
+
+    void lock()
+    {
+        // 同一线程重入不计为一次获取，统计反映的是真正的加锁次数
+        if (owner_.load(std::memory_order_relaxed) == std::this_thread::get_id())
+        {
+            mutex_.lock();
+            ++depth_;
+            return;
+        }
+        stats_.recordMutexAcquire();
+        if (!mutex_.try_lock())
+        {
+            auto start = std::chrono::steady_clock::now();
+            mutex_.lock();
+            stats_.recordMutexWait(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       std::chrono::steady_clock::now() - start)
+                                       .count());
+        }
+        owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        depth_ = 1;
+    }
+
+    bool try_lock()
+    {
+        if (!mutex_.try_lock())
+        {
+            return false;
+        }
+        if (owner_.load(std::memory_order_relaxed) == std::this_thread::get_id())
+        {
+            ++depth_;
+        }
+        else
+        {
+            owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+            depth_ = 1;
+        }
+        return true;
+    }
+
+    void unlock()
+    {
+        if (--depth_ == 0)
+        {
+            owner_.store(std::thread::id(), std::memory_order_relaxed);
+        }
+        mutex_.unlock();
+    }
+
+private:
+    std::recursive_mutex mutex_;
+    std::atomic<std::thread::id> owner_{}; // 持有锁的线程
+    int depth_ = 0;                        // 重入深度，只由持有锁的线程修改
+    QueryStats &stats_;
+};
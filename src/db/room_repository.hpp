@@ -1,40 +1,97 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <nlohmann/json.hpp>
-#include "database_connection.hpp"
 #include "../model/room.hpp"
 
-// 房间数据访问类
+// 流式查询得到的一行房间数据，字段只在回调执行期间有效
+struct RoomRow
+{
+    std::string_view id;
+    std::string_view name;
+    std::string_view description;
+    std::string_view creator_id;
+    int64_t created_at = 0;
+    int64_t member_count = 0;
+    int64_t message_count = 0;
+    int64_t last_activity = 0;
+};
+
+// 流式查询得到的一个房间成员，字段只在回调执行期间有效
+struct MemberRow
+{
+    std::string_view user_id;
+    std::string_view username;
+    int64_t joined_at = 0;
+};
+
+// 成员校验结果：区分房间不存在和不是成员，服务层据此返回 404 或 403
+enum class MembershipStatus
+{
+    Member,
+    NotMember,
+    RoomNotFound
+};
+
+// 加入房间的结果
+enum class JoinResult
+{
+    Joined,       // 已加入，原本就是成员时同样返回 Joined
+    RoomNotFound,
+    UserNotFound,
+    Failed        // 数据库错误
+};
+
+// 返回 false 时停止遍历
+using RoomRowVisitor = std::function<bool(const RoomRow &)>;
+using MemberRowVisitor = std::function<bool(const MemberRow &)>;
+
+// 房间及成员数据访问接口
+// 默认实现为 SqliteRoomRepository；MemoryRoomRepository 为纯内存实现，用于压测和测试
 class RoomRepository
 {
 public:
-    explicit RoomRepository(DatabaseConnection* db_conn);
+    virtual ~RoomRepository() = default;
 
     // 房间基本操作
-    std::optional<Room> createRoom(const std::string &name, const std::string &description, const std::string &creator_id);
-    bool deleteRoom(const std::string &room_id);// 根据ID删除房间
-    bool roomExists(const std::string &room_id);// 根据ID检查房间是否存在
-    bool updateRoom(const std::string &room_id, const std::string &name, const std::string &description);// 更新房间
+    virtual std::optional<Room> createRoom(const std::string &name, const std::string &description, const std::string &creator_id) = 0;
+    virtual bool deleteRoom(const std::string &room_id) = 0;// 根据ID删除房间
+    virtual bool roomExists(const std::string &room_id) const = 0;// 根据ID检查房间是否存在
+    virtual bool updateRoom(const std::string &room_id, const std::string &name, const std::string &description) = 0;// 更新房间
     
     // 房间查询
-    std::vector<std::string> getRooms();// 获取所有房间（仅名称）
-    std::vector<Room> getAllRooms();// 获取所有房间的详细信息
-    std::optional<Room> getRoomById(const std::string &room_id) const;// 根据ID获取房间信息
-    std::optional<std::string> getRoomIdByName(const std::string &room_name) const;// 根据房间名获取房间ID
-    bool isRoomCreator(const std::string &room_id, const std::string &user_id);// 检查是否为房间创建者
+    virtual std::vector<std::string> getRooms() = 0;// 获取所有房间（仅名称）
+    virtual std::vector<Room> getAllRooms() = 0;// 获取所有房间的详细信息
+    // 从新到旧逐行回调，不构造 Room 对象；回调期间不持有数据库锁，可以直接写网络
+    // after 非空时从该房间之后开始（游标分页，after 不存在时没有结果），limit 为 0 表示不限条数
+    virtual void visitRooms(const std::string &after, size_t limit, const RoomRowVisitor &visitor) const = 0;
+    virtual std::optional<Room> getRoomById(const std::string &room_id) const = 0;// 根据ID获取房间信息
+    virtual std::optional<std::string> getRoomIdByName(const std::string &room_name) const = 0;// 根据房间名获取房间ID
+    virtual bool isRoomCreator(const std::string &room_id, const std::string &user_id) = 0;// 检查是否为房间创建者
     
     // 房间成员管理
-    std::vector<nlohmann::json> getRoomMembers(const std::string &room_id) const;// 获取房间成员
-    std::vector<Room> getUserJoinedRooms(const std::string &user_id) const;// 获取用户已加入的房间列表
-    bool addRoomMember(const std::string &room_id, const std::string &user_id);// 根据ID添加房间成员
-    bool removeRoomMember(const std::string &room_id, const std::string &user_id);// 根据ID移除房间成员
+    virtual std::vector<nlohmann::json> getRoomMembers(const std::string &room_id) const = 0;// 获取房间成员
+    virtual void visitRoomMembers(const std::string &room_id, const MemberRowVisitor &visitor) const = 0;// 按加入顺序逐个回调，回调期间不持有数据库锁
+    virtual std::vector<Room> getUserJoinedRooms(const std::string &user_id) const = 0;// 获取用户已加入的房间列表
+    virtual bool addRoomMember(const std::string &room_id, const std::string &user_id) = 0;// 根据ID添加房间成员
+    virtual bool removeRoomMember(const std::string &room_id, const std::string &user_id) = 0;// 根据ID移除房间成员
+    virtual bool isRoomMember(const std::string &room_id, const std::string &user_id) const = 0;// 检查用户是否为房间成员
+    virtual size_t getRoomMemberCount(const std::string &room_id) const = 0;// 获取房间成员数量
+
+    // 组合操作：检查和读写在一次加锁内完成，不会在两次调用之间读到不一致的状态
+    virtual MembershipStatus checkMembership(const std::string &room_id, const std::string &user_id) const = 0;// 房间是否存在、用户是否为成员
+    virtual JoinResult joinRoom(const std::string &room_id, const std::string &user_id) = 0;// 房间和用户都存在时加入房间
+
+    // 房间计数
+    // 消息不在元数据库中（分片库、日志引擎）时，由 DatabaseManager 在写入和清理消息后调用，
+    // 更新房间的消息数（增加 message_delta 条）和最后活跃时间
+    virtual void recordMessageActivity(const std::string &room_id, int64_t message_delta, int64_t timestamp) = 0;
     
     // 工具方法
     std::string generateRoomId();
-
-private:
-    DatabaseConnection* db_conn_;
 };
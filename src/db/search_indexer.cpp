@@ -0,0 +1,72 @@
+#include "search_indexer.hpp"
+#include "database_manager.hpp"
+#include "../utils/logger.hpp"
+#include <thread>
+
+SearchIndexer::SearchIndexer(DatabaseManager &db) : db_(db) {}
+
+SearchIndexer::~SearchIndexer()
+{
+    stop();
+}
+
+void SearchIndexer::setOptions(const Options &options)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+}
+
+SearchIndexer::Options SearchIndexer::getOptions() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+void SearchIndexer::start()
+{
+    Options options = getOptions();
+    if (started_)
+    {
+        return;
+    }
+    started_ = true;
+    stopping_ = false;
+
+    // 启动后立即执行一次，补上旧库中尚未建立索引的消息
+    timer_.addPeriodicTask(std::chrono::milliseconds(0), options.interval, [this]()
+                           { indexOnce(); });
+    timer_.start();
+    LOG_INFO << "Search indexer started, interval: " << options.interval.count() << " ms";
+}
+
+void SearchIndexer::stop()
+{
+    stopping_ = true;
+    timer_.stop();
+}
+
+size_t SearchIndexer::indexOnce()
+{
+    Options options = getOptions();
+    size_t total = 0;
+    for (size_t i = 0; i < db_.getMessageShardCount() && !stopping_; ++i)
+    {
+        MessageRepository *repo = db_.getMessageShard(i);
+        while (!stopping_)
+        {
+            size_t indexed = repo->indexPendingMessages(options.batch_size);
+            if (indexed == 0)
+            {
+                break;
+            }
+            total += indexed;
+            // 让出数据库锁，排队中的前台写入可以先执行
+            std::this_thread::sleep_for(options.batch_pause);
+        }
+    }
+    if (total > 0)
+    {
+        LOG_DEBUG << "Search indexer indexed " << total << " messages";
+    }
+    return total;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include "../utils/timer.hpp"
+
+class DatabaseManager;
+
+// 后台全文索引任务
+// 消息写入时不维护全文索引，由定时任务把新消息分批加入各个消息库的 FTS5 索引，
+// 每批是一个独立的短事务，两批之间释放数据库锁并暂停 batch_pause，不拖慢前台写入
+class SearchIndexer
+{
+public:
+    struct Options
+    {
+        std::chrono::milliseconds interval = std::chrono::seconds(1);          // 索引任务间隔
+        size_t batch_size = 1000;                                              // 每批最多索引的消息数
+        std::chrono::milliseconds batch_pause = std::chrono::milliseconds(5);  // 两批之间让出数据库的时间
+    };
+
+    explicit SearchIndexer(DatabaseManager &db);
+    ~SearchIndexer();
+
+    SearchIndexer(const SearchIndexer &) = delete;
+    SearchIndexer &operator=(const SearchIndexer &) = delete;
+
+    void setOptions(const Options &options);
+    Options getOptions() const;
+
+    // 启动/停止后台定时任务
+    void start();
+    void stop();
+
+    size_t indexOnce(); // 把所有消息库中待索引的消息加入索引，返回索引的消息数
+
+private:
+    DatabaseManager &db_;
+
+    mutable std::mutex mutex_; // 保护 options_
+    Options options_;
+
+    std::atomic<bool> stopping_{false}; // 停止时中断正在进行的索引
+    bool started_ = false;
+    utils::Timer timer_;
+};
@@ -0,0 +1,499 @@
+#include "sqlite_message_repository.hpp"
+#include "user_repository.hpp"
+#include "../utils/logger.hpp"
+#include "../model/user.hpp"
+#include <chrono>
+#include <algorithm>
+#include <sstream>
+
+SqliteMessageRepository::SqliteMessageRepository(DatabaseConnection* db_conn) : db_conn_(db_conn) {}
+
+SqliteMessageRepository::SqliteMessageRepository(DatabaseConnection *db_conn, const UserRepository *user_repo,
+                                                 int shard_index, int shard_count)
+    : db_conn_(db_conn), user_repo_(user_repo), shard_index_(shard_index), shard_count_(shard_count) {}
+
+std::string SqliteMessageRepository::selectSql(const std::string &extra_columns) const
+{
+    if (user_repo_)
+    {
+        // 分片库中没有用户表，用户名在读取后单独查询
+        return "SELECT m.id, m.room_id, m.content, m.timestamp, m.user_id" + extra_columns + " FROM messages m ";
+    }
+    // 元数据库中消息按整数主键引用房间和用户，对外的字符串ID通过关联取回
+    return "SELECT m.id, r.id, m.content, m.timestamp, u.id, u.username" + extra_columns + " "
+           "FROM messages m "
+           "JOIN rooms r ON m.room_pk = r.pk "
+           "JOIN users u ON m.user_pk = u.pk ";
+}
+
+std::string SqliteMessageRepository::roomFilter() const
+{
+    // 标量子查询只执行一次，外层仍按 (room_pk, id) 索引查找
+    return user_repo_ ? "room_id = ?" : "room_pk = (SELECT pk FROM rooms WHERE id = ?)";
+}
+
+Message SqliteMessageRepository::readMessage(sqlite3_stmt *stmt, std::unordered_map<std::string, std::string> &usernames) const
+{
+    int64_t message_id = toGlobalId(sqlite3_column_int64(stmt, 0));
+    std::string room_id = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+    std::string content = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+    int64_t timestamp = sqlite3_column_int64(stmt, 3);
+    std::string user_id = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 4));
+
+    std::string username;
+    if (!user_repo_)
+    {
+        username = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 5));
+    }
+    else
+    {
+        // 同一批消息的发送者通常只有少数几个，按用户ID缓存查询结果
+        auto it = usernames.find(user_id);
+        if (it == usernames.end())
+        {
+            auto user = user_repo_->getUserById(user_id);
+            it = usernames.emplace(user_id, user ? user->getUsername() : "").first;
+        }
+        username = it->second;
+    }
+
+    return Message(message_id, room_id, user_id, content, timestamp, username);
+}
+
+bool SqliteMessageRepository::saveMessage(const std::string &room_id, const std::string &user_id,
+                                       const std::string &content, int64_t timestamp,
+                                       int64_t *message_id)
+{
+    if (!db_conn_->isConnected()) return false;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    // 写入是最频繁的操作，复用预编译语句
+    // 元数据库中把字符串ID换成整数主键写入，房间或用户不存在时不插入任何行
+    sqlite3_stmt *stmt = db_conn_->getCachedStatement(
+        user_repo_ ? "INSERT INTO messages (content, timestamp, room_id, user_id) VALUES (?, ?, ?, ?);"
+                   : "INSERT INTO messages (content, timestamp, room_pk, user_pk) "
+                     "SELECT ?, ?, r.pk, u.pk FROM rooms r, users u WHERE r.id = ? AND u.id = ?;");
+    if (!stmt)
+    {
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, content.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, timestamp);
+    sqlite3_bind_text(stmt, 3, room_id.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, user_id.c_str(), -1, SQLITE_STATIC);
+
+    bool success = (sqlite3_step(stmt) == SQLITE_DONE) && sqlite3_changes(db_conn_->getDb()) == 1;
+    sqlite3_reset(stmt);
+
+    if (success && message_id)
+    {
+        *message_id = toGlobalId(sqlite3_last_insert_rowid(db_conn_->getDb()));
+    }
+    return success;
+}
+
+std::vector<Message> SqliteMessageRepository::getMessages(const std::string &room_id, int limit,
+                                                    int64_t before_timestamp)
+{
+    std::vector<Message> messages;
+    if (!db_conn_->isConnected()) return messages;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    
+    std::string sql = selectSql() + "WHERE m." + roomFilter();
+    
+    if (before_timestamp > 0)
+    {
+        sql += " AND m.timestamp >= ?";
+    }
+    
+    sql += " ORDER BY m.timestamp ASC";
+    
+    if (limit > 0)
+    {
+        sql += " LIMIT ?";
+    }
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return messages;
+    }
+
+    int param_index = 1;
+    sqlite3_bind_text(stmt, param_index++, room_id.c_str(), -1, SQLITE_STATIC);
+    
+    if (before_timestamp > 0)
+    {
+        sqlite3_bind_int64(stmt, param_index++, before_timestamp);
+    }
+    
+    if (limit > 0)
+    {
+        sqlite3_bind_int(stmt, param_index++, limit);
+    }
+
+    std::unordered_map<std::string, std::string> usernames;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        // 创建 Message 对象，包含发送者信息
+        messages.push_back(readMessage(stmt, usernames));
+    }
+
+    sqlite3_finalize(stmt);
+    return messages;
+}
+
+std::vector<Message> SqliteMessageRepository::getRecentMessages(const std::string &room_id, int limit,
+                                                          int64_t before_id)
+{
+    std::vector<Message> messages;
+    if (!db_conn_->isConnected()) return messages;
+
+    // 把全局ID换算成本分片的本地ID上界：本地ID < local_before 等价于 全局ID < before_id
+    int64_t local_before = 0;
+    if (before_id > 0)
+    {
+        if (before_id <= shard_index_) return messages;
+        local_before = (before_id - shard_index_ + shard_count_ - 1) / shard_count_;
+    }
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+
+    // 按ID倒序取最近的 limit 条，再翻转为时间正序
+    std::string sql = selectSql() + "WHERE m." + roomFilter();
+
+    if (local_before > 0)
+    {
+        sql += " AND m.id < ?";
+    }
+
+    sql += " ORDER BY m.id DESC LIMIT ?";
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return messages;
+    }
+
+    int param_index = 1;
+    sqlite3_bind_text(stmt, param_index++, room_id.c_str(), -1, SQLITE_STATIC);
+
+    if (local_before > 0)
+    {
+        sqlite3_bind_int64(stmt, param_index++, local_before);
+    }
+
+    sqlite3_bind_int(stmt, param_index++, limit > 0 ? limit : -1);
+
+    std::unordered_map<std::string, std::string> usernames;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        messages.push_back(readMessage(stmt, usernames));
+    }
+
+    sqlite3_finalize(stmt);
+    std::reverse(messages.begin(), messages.end());
+    return messages;
+}
+
+std::optional<Message> SqliteMessageRepository::getMessageById(int64_t message_id)
+{
+    if (!db_conn_->isConnected()) return std::nullopt;
+    // 消息不属于本分片
+    if (message_id % shard_count_ != shard_index_) return std::nullopt;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    
+    std::string sql = selectSql() + "WHERE m.id = ?";
+    
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return std::nullopt;
+    }
+
+    sqlite3_bind_int64(stmt, 1, toLocalId(message_id));
+
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        std::unordered_map<std::string, std::string> usernames;
+        Message message = readMessage(stmt, usernames);
+
+        sqlite3_finalize(stmt);
+        return message;
+    }
+
+    sqlite3_finalize(stmt);
+    return std::nullopt;
+}
+
+bool SqliteMessageRepository::deleteRoomMessages(const std::string &room_id)
+{
+    if (!db_conn_->isConnected()) return false;
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    std::string sql = "DELETE FROM messages WHERE " + roomFilter() + ";";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+    bool success = (sqlite3_step(stmt) == SQLITE_DONE);
+    sqlite3_finalize(stmt);
+    return success;
+}
+
+size_t SqliteMessageRepository::purgeMessages(const std::string &room_id, int64_t before_timestamp,
+                                              size_t keep_latest, size_t batch_size)
+{
+    if (!db_conn_->isConnected() || batch_size == 0) return 0;
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+
+    // 按条数保留时，先找到需要删除的最新一条消息的ID（最新 keep_latest 条之后的第一条）
+    int64_t max_purge_id = 0;
+    if (keep_latest > 0)
+    {
+        sqlite3_stmt *stmt = db_conn_->getCachedStatement(
+            user_repo_ ? "SELECT id FROM messages WHERE room_id = ? ORDER BY id DESC LIMIT 1 OFFSET ?;"
+                       : "SELECT id FROM messages WHERE room_pk = (SELECT pk FROM rooms WHERE id = ?) "
+                         "ORDER BY id DESC LIMIT 1 OFFSET ?;");
+        if (!stmt) return 0;
+        sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(keep_latest));
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            max_purge_id = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_reset(stmt);
+    }
+    if (max_purge_id == 0 && before_timestamp <= 0) return 0;
+
+    // 每批一条 DELETE，自动提交模式下即为一个独立的短事务，不会长时间持有写锁
+    sqlite3_stmt *stmt = db_conn_->getCachedStatement(
+        user_repo_ ? "DELETE FROM messages WHERE id IN (SELECT id FROM messages WHERE room_id = ? "
+                     "AND (id <= ? OR timestamp < ?) ORDER BY id LIMIT ?);"
+                   : "DELETE FROM messages WHERE id IN (SELECT id FROM messages "
+                     "WHERE room_pk = (SELECT pk FROM rooms WHERE id = ?) "
+                     "AND (id <= ? OR timestamp < ?) ORDER BY id LIMIT ?);");
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, max_purge_id);
+    sqlite3_bind_int64(stmt, 3, before_timestamp);
+    sqlite3_bind_int64(stmt, 4, static_cast<int64_t>(batch_size));
+
+    size_t deleted = 0;
+    if (sqlite3_step(stmt) == SQLITE_DONE)
+    {
+        deleted = static_cast<size_t>(sqlite3_changes(db_conn_->getDb()));
+    }
+    else
+    {
+        LOG_ERROR << "Failed to purge messages of room " << room_id << ": " << sqlite3_errmsg(db_conn_->getDb());
+    }
+    sqlite3_reset(stmt);
+    return deleted;
+}
+
+namespace
+{
+    // 按空白切分搜索词
+    std::vector<std::string> splitTerms(const std::string &query)
+    {
+        std::vector<std::string> terms;
+        std::istringstream iss(query);
+        std::string term;
+        while (iss >> term)
+        {
+            terms.push_back(term);
+        }
+        return terms;
+    }
+
+    // UTF-8 字符数，不计续字节
+    size_t charCount(const std::string &text)
+    {
+        return std::count_if(text.begin(), text.end(), [](char c)
+                             { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; });
+    }
+
+    // 每个词作为一个短语加引号，词之间为 AND，用户输入中的 FTS5 语法不会生效
+    std::string toMatchExpression(const std::vector<std::string> &terms)
+    {
+        std::string expression;
+        for (const auto &term : terms)
+        {
+            if (!expression.empty()) expression += ' ';
+            expression += '"';
+            for (char c : term)
+            {
+                if (c == '"') expression += '"';
+                expression += c;
+            }
+            expression += '"';
+        }
+        return expression;
+    }
+
+    // LIKE 模式，转义通配符
+    std::string toLikePattern(const std::string &term)
+    {
+        std::string pattern = "%";
+        for (char c : term)
+        {
+            if (c == '%' || c == '_' || c == '\\') pattern += '\\';
+            pattern += c;
+        }
+        return pattern + "%";
+    }
+}
+
+std::optional<std::vector<Message>> SqliteMessageRepository::searchMessages(const std::string &room_id, const std::string &query,
+                                                                            int limit, int offset)
+{
+    std::vector<Message> messages;
+    if (!db_conn_->isConnected()) return messages;
+
+    std::vector<std::string> terms = splitTerms(query);
+    if (terms.empty() || limit <= 0) return messages;
+
+    // trigram 分词无法匹配少于 3 个字符的词，这类查询只在该房间内按内容逐条匹配，按时间倒序返回
+    bool use_index = std::all_of(terms.begin(), terms.end(), [](const std::string &term)
+                                 { return charCount(term) >= 3; });
+
+    std::string sql;
+    if (use_index)
+    {
+        // 后台任务还没索引到的新消息按内容逐条匹配（只扫描索引进度之后的少量消息），排在索引结果之前，
+        // 刚发送的消息也能被搜到，搜索本身不写索引
+        sql = selectSql(", 0 AS fresh, f.rank AS score") +
+              "JOIN messages_fts f ON f.rowid = m.id WHERE f.messages_fts MATCH ? AND m." + roomFilter() +
+              " UNION ALL " + selectSql(", 1 AS fresh, 0 AS score") + "WHERE m." + roomFilter() +
+              " AND m.id > (SELECT last_indexed_id FROM messages_fts_state WHERE id = 0)";
+        for (size_t i = 0; i < terms.size(); ++i)
+        {
+            sql += " AND m.content LIKE ? ESCAPE '\\'";
+        }
+        sql += " ORDER BY fresh DESC, score, 1 DESC";
+    }
+    else
+    {
+        sql = selectSql() + "WHERE m." + roomFilter();
+        for (size_t i = 0; i < terms.size(); ++i)
+        {
+            sql += " AND m.content LIKE ? ESCAPE '\\'";
+        }
+        sql += " ORDER BY m.id DESC";
+    }
+    sql += " LIMIT ? OFFSET ?";
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return messages;
+    }
+
+    int param_index = 1;
+    if (use_index)
+    {
+        sqlite3_bind_text(stmt, param_index++, toMatchExpression(terms).c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, param_index++, room_id.c_str(), -1, SQLITE_STATIC);
+    }
+    sqlite3_bind_text(stmt, param_index++, room_id.c_str(), -1, SQLITE_STATIC);
+    for (const auto &term : terms)
+    {
+        sqlite3_bind_text(stmt, param_index++, toLikePattern(term).c_str(), -1, SQLITE_TRANSIENT);
+    }
+    sqlite3_bind_int(stmt, param_index++, limit);
+    sqlite3_bind_int(stmt, param_index++, std::max(offset, 0));
+
+    std::unordered_map<std::string, std::string> usernames;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        messages.push_back(readMessage(stmt, usernames));
+    }
+    if (rc != SQLITE_DONE)
+    {
+        LOG_ERROR << "Failed to search messages of room " << room_id << ": " << sqlite3_errmsg(db_conn_->getDb());
+    }
+
+    sqlite3_finalize(stmt);
+    return messages;
+}
+
+size_t SqliteMessageRepository::indexPendingMessages(size_t batch_size)
+{
+    if (!db_conn_->isConnected() || batch_size == 0) return 0;
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+
+    int64_t last_indexed_id = 0;
+    sqlite3_stmt *stmt = db_conn_->getCachedStatement("SELECT last_indexed_id FROM messages_fts_state WHERE id = 0;");
+    if (!stmt) return 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        last_indexed_id = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_reset(stmt);
+
+    // 先确定本批的ID上界
+    int64_t batch_end = 0;
+    size_t count = 0;
+    stmt = db_conn_->getCachedStatement(
+        "SELECT MAX(id), COUNT(*) FROM (SELECT id FROM messages WHERE id > ? ORDER BY id LIMIT ?);");
+    if (!stmt) return 0;
+    sqlite3_bind_int64(stmt, 1, last_indexed_id);
+    sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(batch_size));
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        batch_end = sqlite3_column_int64(stmt, 0);
+        count = static_cast<size_t>(sqlite3_column_int64(stmt, 1));
+    }
+    sqlite3_reset(stmt);
+    if (count == 0) return 0;
+
+    // 加入索引和推进进度在同一个事务中完成，中途失败不会把同一条消息索引两次
+    if (!db_conn_->beginTransaction()) return 0;
+
+    bool success = false;
+    stmt = db_conn_->getCachedStatement(
+        "INSERT INTO messages_fts (rowid, content) SELECT id, content FROM messages WHERE id > ? AND id <= ?;");
+    if (stmt)
+    {
+        sqlite3_bind_int64(stmt, 1, last_indexed_id);
+        sqlite3_bind_int64(stmt, 2, batch_end);
+        success = (sqlite3_step(stmt) == SQLITE_DONE);
+        sqlite3_reset(stmt);
+    }
+    if (success)
+    {
+        stmt = db_conn_->getCachedStatement("UPDATE messages_fts_state SET last_indexed_id = ? WHERE id = 0;");
+        success = stmt != nullptr;
+        if (stmt)
+        {
+            sqlite3_bind_int64(stmt, 1, batch_end);
+            success = (sqlite3_step(stmt) == SQLITE_DONE);
+            sqlite3_reset(stmt);
+        }
+    }
+
+    if (!success || !db_conn_->commitTransaction())
+    {
+        LOG_ERROR << "Failed to index messages in " << db_conn_->getPath() << ": " << sqlite3_errmsg(db_conn_->getDb());
+        db_conn_->rollbackTransaction();
+        return 0;
+    }
+    return count;
+}
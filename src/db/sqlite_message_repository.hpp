@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "database_connection.hpp"
+#include "message_repository.hpp"
+#include "../model/message.hpp"
+
+class UserRepository;
+
+// 基于 SQLite 的消息数据访问类
+class SqliteMessageRepository : public MessageRepository
+{
+public:
+    explicit SqliteMessageRepository(DatabaseConnection *db_conn);
+    // 分片模式：消息存放在独立的分片库中，发送者用户名通过元数据库的 user_repo 查询
+    // 对外的消息ID为 本地ID * shard_count + shard_index，可以从ID反推所在分片
+    SqliteMessageRepository(DatabaseConnection *db_conn, const UserRepository *user_repo,
+                            int shard_index, int shard_count);
+
+    // 消息操作
+    bool saveMessage(const std::string &room_id, const std::string &user_id,
+                     const std::string &content, int64_t timestamp,
+                     int64_t *message_id) override;
+    std::vector<Message> getMessages(const std::string &room_id, int limit,
+                                     int64_t before_timestamp) override;
+    std::vector<Message> getRecentMessages(const std::string &room_id, int limit,
+                                           int64_t before_id) override;
+    std::optional<Message> getMessageById(int64_t message_id) override;
+    bool deleteRoomMessages(const std::string &room_id) override;
+    size_t purgeMessages(const std::string &room_id, int64_t before_timestamp,
+                         size_t keep_latest, size_t batch_size) override;
+    std::optional<std::vector<Message>> searchMessages(const std::string &room_id, const std::string &query,
+                                                       int limit, int offset) override;
+    size_t indexPendingMessages(size_t batch_size) override;
+
+private:
+    int64_t toGlobalId(int64_t local_id) const { return local_id * shard_count_ + shard_index_; }
+    int64_t toLocalId(int64_t global_id) const { return global_id / shard_count_; }
+    std::string selectSql(const std::string &extra_columns = "") const;// 查询消息的 SELECT ... FROM ... 部分，extra_columns 追加在固定列之后
+    std::string roomFilter() const;// 按房间ID筛选消息的条件，绑定一个房间ID参数
+    Message readMessage(sqlite3_stmt *stmt, std::unordered_map<std::string, std::string> &usernames) const;// 读取一行消息
+
+    DatabaseConnection *db_conn_;
+    const UserRepository *user_repo_ = nullptr; // 非空时为分片模式
+    int shard_index_ = 0;
+    int shard_count_ = 1;
+};
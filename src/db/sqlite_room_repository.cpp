@@ -0,0 +1,711 @@
+#include "sqlite_room_repository.hpp"
+#include "../utils/logger.hpp"
+#include <chrono>
+#include <limits>
+
+namespace
+{
+    // 流式遍历每次持锁读取的行数，读完一批释放锁后再回调
+    constexpr size_t kVisitBatchRows = 256;
+
+    // 复制出来的一行房间数据，释放数据库锁之后回调时引用
+    struct OwnedRoomRow
+    {
+        std::string id;
+        std::string name;
+        std::string description;
+        std::string creator_id;
+        RoomRow row;
+
+        explicit OwnedRoomRow(const RoomRow &source)
+            : id(source.id), name(source.name), description(source.description), creator_id(source.creator_id), row(source)
+        {
+        }
+
+        RoomRow view() const
+        {
+            RoomRow result = row;
+            result.id = id;
+            result.name = name;
+            result.description = description;
+            result.creator_id = creator_id;
+            return result;
+        }
+    };
+
+    // 列值的只读视图，NULL 时为空，下一次 step 或 finalize 之前有效
+    std::string_view columnView(sqlite3_stmt *stmt, int col)
+    {
+        const unsigned char *value = sqlite3_column_text(stmt, col);
+        return value ? std::string_view(reinterpret_cast<const char *>(value),
+                                        static_cast<size_t>(sqlite3_column_bytes(stmt, col)))
+                     : std::string_view();
+    }
+
+    // 房间查询统一的列顺序：id, name, description, creator_id, created_at, member_count, message_count, last_activity
+    RoomRow readRoomRow(sqlite3_stmt *stmt)
+    {
+        RoomRow row;
+        row.id = columnView(stmt, 0);
+        row.name = columnView(stmt, 1);
+        row.description = columnView(stmt, 2);
+        row.creator_id = columnView(stmt, 3);
+        row.created_at = sqlite3_column_int64(stmt, 4);
+        row.member_count = sqlite3_column_int64(stmt, 5);
+        row.message_count = sqlite3_column_int64(stmt, 6);
+        row.last_activity = sqlite3_column_int64(stmt, 7);
+        return row;
+    }
+
+    Room toRoom(const RoomRow &row)
+    {
+        Room room(std::string(row.id), std::string(row.name), std::string(row.description),
+                  std::string(row.creator_id), row.created_at);
+        room.setMemberCount(row.member_count);
+        room.setMessageCount(row.message_count);
+        room.setLastActivity(row.last_activity);
+        return room;
+    }
+}
+
+SqliteRoomRepository::SqliteRoomRepository(DatabaseConnection* db_conn) : db_conn_(db_conn) {}
+
+std::optional<Room> SqliteRoomRepository::createRoom(const std::string &name, const std::string &description, const std::string &creator_id) {
+    if (!db_conn_ || !db_conn_->isConnected()) {
+        return std::nullopt;
+    }
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    
+    // 1. 生成一个新的、唯一的房间ID
+    std::string room_id = generateRoomId();
+
+    LOG_INFO << "createRoom: room_id=" << room_id << ", name=" << name << ", description=" << description << ", creator_id=" << creator_id;
+
+    // 创建者通过字符串ID换成整数主键，创建者不存在时不插入任何行
+    const char *sql = "INSERT INTO rooms (id, name, description, creator_pk, created_at) "
+                      "SELECT ?, ?, ?, pk, ? FROM users WHERE id = ?;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR << "Failed to prepare statement for createRoom: " << sqlite3_errmsg(db_conn_->getDb());
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, description.c_str(), -1, SQLITE_STATIC); // 使用传入的描述
+    sqlite3_bind_int64(stmt, 4, std::chrono::system_clock::now().time_since_epoch().count());
+    sqlite3_bind_text(stmt, 5, creator_id.c_str(), -1, SQLITE_STATIC);
+
+    bool success = (sqlite3_step(stmt) == SQLITE_DONE) && sqlite3_changes(db_conn_->getDb()) == 1;
+    sqlite3_finalize(stmt);
+
+    if (success) {
+        // 新房间还没有成员，直接登记一个空索引，避免后续再去加载
+        member_index_[room_id];
+
+        // 2. 如果插入成功，立即用ID把这个新房间查出来并返回
+        auto result = getRoomById(room_id);
+        if (result.has_value()) {
+            LOG_INFO << "createRoom success, returning: " << result.value().toJson().dump();
+        } else {
+            LOG_ERROR << "createRoom: getRoomById failed for room_id: " << room_id;
+        }
+        return result;
+    } else {
+        // 3. 如果插入失败（比如房间名重复），则返回空
+        LOG_ERROR << "Failed to execute statement for createRoom, possibly due to duplicate name.";
+        return std::nullopt;
+    }
+}
+
+bool SqliteRoomRepository::deleteRoom(const std::string &room_id)
+{
+    if (!db_conn_->isConnected()) return false;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    const char *sql = "DELETE FROM rooms WHERE id = ?;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+
+    bool success = (sqlite3_step(stmt) == SQLITE_DONE);
+    sqlite3_finalize(stmt);
+
+    if (success)
+    {
+        // 成员关系随房间级联删除，索引也一并丢弃
+        member_index_.erase(room_id);
+    }
+    return success;
+}
+
+bool SqliteRoomRepository::roomExists(const std::string &room_id) const
+{
+    if (!db_conn_->isConnected()) return false;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    // EXISTS 命中唯一索引的第一行即返回
+    return queryExists("SELECT EXISTS(SELECT 1 FROM rooms WHERE id = ?);", room_id, nullptr);
+}
+
+bool SqliteRoomRepository::updateRoom(const std::string &room_id, const std::string &name, const std::string &description)
+{
+    if (!db_conn_->isConnected()) return false;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    const char *sql = "UPDATE rooms SET name = ?, description = ? WHERE id = ?;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, description.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, room_id.c_str(), -1, SQLITE_STATIC);
+
+    bool success = (sqlite3_step(stmt) == SQLITE_DONE);
+    sqlite3_finalize(stmt);
+    return success;
+}
+
+std::vector<std::string> SqliteRoomRepository::getRooms()
+{
+    std::vector<std::string> rooms;
+    if (!db_conn_->isConnected()) return rooms;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    const char *sql = "SELECT name FROM rooms;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return rooms;
+    }
+
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        rooms.push_back(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
+    }
+
+    sqlite3_finalize(stmt);
+    return rooms;
+}
+
+std::optional<Room> SqliteRoomRepository::getRoomById(const std::string &room_id) const
+{
+    // 1. 检查数据库连接
+    if (!db_conn_ || !db_conn_->isConnected())
+    {
+        return std::nullopt;
+    }
+
+    // 2. 获取锁以保证线程安全
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+
+    // 3. 准备SQL查询语句，计数直接取 rooms 表上维护的列
+    const char *sql = "SELECT r.id, r.name, r.description, u.id, r.created_at, "
+                      "r.member_count, r.message_count, r.last_activity "
+                      "FROM rooms r JOIN users u ON u.pk = r.creator_pk WHERE r.id = ?;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement for getRoomById: " << sqlite3_errmsg(db_conn_->getDb());
+        return std::nullopt; // 准备失败，返回空
+    }
+
+    // 4. 绑定参数
+    sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+
+    // 5. 执行查询并处理结果
+    std::optional<Room> room;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        room = toRoom(readRoomRow(stmt));
+        LOG_INFO << "getRoomById constructed Room: " << room->toJson().dump();
+    }
+
+    // 6. 释放语句句柄并返回结果，未找到时为空
+    sqlite3_finalize(stmt);
+    return room;
+}
+
+bool SqliteRoomRepository::isRoomCreator(const std::string &room_id, const std::string &user_id)
+{
+    if (!db_conn_->isConnected()) return false;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    return queryExists("SELECT EXISTS(SELECT 1 FROM rooms r JOIN users u ON u.pk = r.creator_pk "
+                       "WHERE r.id = ? AND u.id = ?);",
+                       room_id, &user_id);
+}
+
+std::vector<nlohmann::json> SqliteRoomRepository::getRoomMembers(const std::string &room_id) const
+{
+    std::vector<nlohmann::json> members;
+    visitRoomMembers(room_id, [&members](const MemberRow &row)
+                     {
+                         members.push_back({{"id", row.user_id},
+                                            {"username", row.username},
+                                            {"joined_at", row.joined_at}});
+                         return true;
+                     });
+    return members;
+}
+
+void SqliteRoomRepository::visitRoomMembers(const std::string &room_id, const MemberRowVisitor &visitor) const
+{
+    if (!db_conn_ || !db_conn_->isConnected())
+    {
+        return;
+    }
+
+    // 成员行复制出来后释放锁再回调
+    struct OwnedMemberRow
+    {
+        std::string user_id;
+        std::string username;
+        int64_t joined_at;
+    };
+    std::vector<OwnedMemberRow> members;
+    {
+        std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+
+        // 使用 JOIN 查询，同时从 room_members 和 users 表中获取信息，表之间按整数主键关联
+        const char *sql = "SELECT u.id, u.username, rm.joined_at FROM rooms r "
+                          "JOIN room_members rm ON rm.room_pk = r.pk "
+                          "JOIN users u ON u.pk = rm.user_pk WHERE r.id = ? ORDER BY rm.joined_at;";
+        sqlite3_stmt *stmt;
+
+        if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            LOG_ERROR << "Failed to prepare statement for visitRoomMembers: " << sqlite3_errmsg(db_conn_->getDb());
+            return;
+        }
+
+        sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            members.push_back({std::string(columnView(stmt, 0)), std::string(columnView(stmt, 1)), sqlite3_column_int64(stmt, 2)});
+        }
+
+        sqlite3_finalize(stmt);
+    }
+
+    for (const auto &member : members)
+    {
+        if (!visitor(MemberRow{member.user_id, member.username, member.joined_at}))
+        {
+            break;
+        }
+    }
+}
+
+bool SqliteRoomRepository::addRoomMember(const std::string &room_id, const std::string &user_id)
+{
+    return joinRoom(room_id, user_id) == JoinResult::Joined;
+}
+
+JoinResult SqliteRoomRepository::joinRoom(const std::string &room_id, const std::string &user_id)
+{
+    if (!db_conn_->isConnected()) return JoinResult::Failed;
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    // 检查和插入在同一个写事务中完成；已经是成员时忽略
+    if (!db_conn_->beginTransaction())
+    {
+        return JoinResult::Failed;
+    }
+    auto room_pk = findPk("SELECT pk FROM rooms WHERE id = ?;", room_id);
+    auto user_pk = room_pk ? findPk("SELECT pk FROM users WHERE id = ?;", user_id) : std::nullopt;
+    JoinResult result = !room_pk ? JoinResult::RoomNotFound : !user_pk ? JoinResult::UserNotFound : JoinResult::Joined;
+
+    if (result == JoinResult::Joined)
+    {
+        sqlite3_stmt *stmt = db_conn_->getCachedStatement(
+            "INSERT OR IGNORE INTO room_members (room_pk, user_pk, joined_at) VALUES (?, ?, ?);");
+        if (!stmt)
+        {
+            result = JoinResult::Failed;
+        }
+        else
+        {
+            sqlite3_bind_int64(stmt, 1, *room_pk);
+            sqlite3_bind_int64(stmt, 2, *user_pk);
+            sqlite3_bind_int64(stmt, 3, std::chrono::system_clock::now().time_since_epoch().count());
+            if (sqlite3_step(stmt) != SQLITE_DONE)
+            {
+                LOG_ERROR << "Failed to add room member: " << sqlite3_errmsg(db_conn_->getDb());
+                result = JoinResult::Failed;
+            }
+            sqlite3_reset(stmt);
+        }
+    }
+    if (result == JoinResult::Joined && !db_conn_->commitTransaction())
+    {
+        result = JoinResult::Failed;
+    }
+    if (result != JoinResult::Joined)
+    {
+        db_conn_->rollbackTransaction();
+        return result;
+    }
+
+    // 只更新已加载的索引，未加载的房间下次访问时会从表中读到这条记录
+    auto it = member_index_.find(room_id);
+    if (it != member_index_.end())
+    {
+        it->second.insert(user_id);
+    }
+    return result;
+}
+
+std::vector<Room> SqliteRoomRepository::getUserJoinedRooms(const std::string &user_id) const
+{
+    std::vector<Room> joined_rooms;
+    if (!db_conn_->isConnected()) return joined_rooms;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    const char *sql = "SELECT r.id, r.name, r.description, c.id, r.created_at, "
+                      "r.member_count, r.message_count, r.last_activity "
+                      "FROM users u "
+                      "JOIN room_members rm ON rm.user_pk = u.pk "
+                      "JOIN rooms r ON r.pk = rm.room_pk "
+                      "JOIN users c ON c.pk = r.creator_pk "
+                      "WHERE u.id = ?;";
+    
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return joined_rooms;
+    }
+
+    sqlite3_bind_text(stmt, 1, user_id.c_str(), -1, SQLITE_STATIC);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        joined_rooms.push_back(toRoom(readRoomRow(stmt)));
+    }
+
+    sqlite3_finalize(stmt);
+    return joined_rooms;
+}
+
+bool SqliteRoomRepository::removeRoomMember(const std::string &room_id, const std::string &user_id)
+{
+    if (!db_conn_->isConnected()) return false;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    const char *sql = "DELETE FROM room_members "
+                      "WHERE room_pk = (SELECT pk FROM rooms WHERE id = ?) "
+                      "AND user_pk = (SELECT pk FROM users WHERE id = ?);";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, user_id.c_str(), -1, SQLITE_STATIC);
+
+    bool success = (sqlite3_step(stmt) == SQLITE_DONE);
+    sqlite3_finalize(stmt);
+
+    if (success)
+    {
+        auto it = member_index_.find(room_id);
+        if (it != member_index_.end())
+        {
+            it->second.erase(user_id);
+        }
+    }
+    return success;
+}
+
+bool SqliteRoomRepository::isRoomMember(const std::string &room_id, const std::string &user_id) const
+{
+    if (!db_conn_ || !db_conn_->isConnected()) return false;
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    const auto *members = loadMemberIndex(room_id);
+    return members && members->count(user_id) > 0;
+}
+
+MembershipStatus SqliteRoomRepository::checkMembership(const std::string &room_id, const std::string &user_id) const
+{
+    if (!db_conn_ || !db_conn_->isConnected()) return MembershipStatus::RoomNotFound;
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    // 成员索引只为存在的房间加载，一次查询同时回答房间是否存在
+    const auto *members = loadMemberIndex(room_id);
+    if (!members)
+    {
+        return MembershipStatus::RoomNotFound;
+    }
+    return members->count(user_id) > 0 ? MembershipStatus::Member : MembershipStatus::NotMember;
+}
+
+size_t SqliteRoomRepository::getRoomMemberCount(const std::string &room_id) const
+{
+    if (!db_conn_ || !db_conn_->isConnected()) return 0;
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    // 已加载成员索引时直接取大小，否则读 rooms 表上的计数，不为此加载整个成员集合
+    auto it = member_index_.find(room_id);
+    if (it != member_index_.end())
+    {
+        return it->second.size();
+    }
+
+    sqlite3_stmt *stmt = db_conn_->getCachedStatement("SELECT member_count FROM rooms WHERE id = ?;");
+    if (!stmt)
+    {
+        return 0;
+    }
+    sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+    size_t count = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        count = static_cast<size_t>(sqlite3_column_int64(stmt, 0));
+    }
+    sqlite3_reset(stmt);
+    return count;
+}
+
+void SqliteRoomRepository::recordMessageActivity(const std::string &room_id, int64_t message_delta, int64_t timestamp)
+{
+    if (!db_conn_ || !db_conn_->isConnected()) return;
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    sqlite3_stmt *stmt = db_conn_->getCachedStatement(
+        "UPDATE rooms SET message_count = MAX(message_count + ?, 0), last_activity = MAX(last_activity, ?) "
+        "WHERE id = ?;");
+    if (!stmt)
+    {
+        return;
+    }
+    sqlite3_bind_int64(stmt, 1, message_delta);
+    sqlite3_bind_int64(stmt, 2, timestamp);
+    sqlite3_bind_text(stmt, 3, room_id.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) != SQLITE_DONE)
+    {
+        LOG_ERROR << "Failed to update message counters for room " << room_id << ": "
+                  << sqlite3_errmsg(db_conn_->getDb());
+    }
+    sqlite3_reset(stmt);
+}
+
+const std::unordered_set<std::string> *SqliteRoomRepository::loadMemberIndex(const std::string &room_id) const
+{
+    auto it = member_index_.find(room_id);
+    if (it != member_index_.end())
+    {
+        return &it->second;
+    }
+
+    const char *sql = "SELECT u.id FROM rooms r "
+                      "JOIN room_members rm ON rm.room_pk = r.pk "
+                      "JOIN users u ON u.pk = rm.user_pk WHERE r.id = ?;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement for loadMemberIndex: " << sqlite3_errmsg(db_conn_->getDb());
+        return nullptr;
+    }
+
+    sqlite3_bind_text(stmt, 1, room_id.c_str(), -1, SQLITE_STATIC);
+
+    std::unordered_set<std::string> members;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        members.emplace(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
+    }
+    sqlite3_finalize(stmt);
+
+    // 没有成员时确认房间确实存在，避免为无效的房间ID缓存空集合
+    if (members.empty() && !roomExists(room_id))
+    {
+        return nullptr;
+    }
+
+    auto inserted = member_index_.emplace(room_id, std::move(members));
+    return &inserted.first->second;
+}
+
+std::optional<std::string> SqliteRoomRepository::getRoomIdByName(const std::string &room_name) const
+{
+    LOG_INFO << "getRoomIdByName called with room_name: '" << room_name << "'";
+    
+    // 1. 检查数据库连接
+    if (!db_conn_ || !db_conn_->isConnected())
+    {
+        LOG_ERROR << "Database connection is null or not connected";
+        return std::nullopt;
+    }
+
+    // 2. 获取锁以保证线程安全
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+
+    // 3. 准备SQL查询语句
+    const char *sql = "SELECT id FROM rooms WHERE name = ?;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement for getRoomIdByName: " << sqlite3_errmsg(db_conn_->getDb());
+        return std::nullopt;
+    }
+
+    // 4. 绑定参数
+    sqlite3_bind_text(stmt, 1, room_name.c_str(), -1, SQLITE_STATIC);
+    LOG_INFO << "Executing SQL query with room_name: '" << room_name << "'";
+
+    // 5. 执行查询并处理结果
+    int step_result = sqlite3_step(stmt);
+    LOG_INFO << "SQLite step result: " << step_result << " (SQLITE_ROW=" << SQLITE_ROW << ", SQLITE_DONE=" << SQLITE_DONE << ")";
+    
+    if (step_result == SQLITE_ROW)
+    {
+        // 找到了匹配的房间，获取房间ID
+        const unsigned char* id_col = sqlite3_column_text(stmt, 0);
+        std::string room_id = reinterpret_cast<const char*>(id_col);
+
+        LOG_INFO << "Found room ID: '" << room_id << "' for room name: '" << room_name << "'";
+        
+        // 6. 释放语句句柄并返回结果
+        sqlite3_finalize(stmt);
+        return room_id;
+    }
+    else
+    {
+        // 未找到匹配的房间名
+        LOG_WARN << "No room found with name: '" << room_name << "'";
+        sqlite3_finalize(stmt);
+        return std::nullopt;
+    }
+}
+
+std::vector<Room> SqliteRoomRepository::getAllRooms()
+{
+    std::vector<Room> rooms;
+    visitRooms("", 0, [&rooms](const RoomRow &row)
+               {
+                   rooms.push_back(toRoom(row));
+                   return true;
+               });
+    return rooms;
+}
+
+void SqliteRoomRepository::visitRooms(const std::string &after, size_t limit, const RoomRowVisitor &visitor) const
+{
+    if (!db_conn_->isConnected()) return;
+
+    // 回调通常直接写网络，慢客户端不能拖住全局数据库锁：每批行复制出来后释放锁再回调，
+    // 下一批沿整数主键从上一批的最后一行继续
+    int64_t cursor_pk = std::numeric_limits<int64_t>::max();
+    size_t remaining = limit > 0 ? limit : std::numeric_limits<size_t>::max();
+    std::vector<OwnedRoomRow> batch;
+    while (remaining > 0)
+    {
+        size_t batch_rows = std::min(remaining, kVisitBatchRows);
+        batch.clear();
+        {
+            std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+            if (cursor_pk == std::numeric_limits<int64_t>::max() && !after.empty())
+            {
+                // 游标换成主键后直接在表的 B 树上定位，不需要额外索引；不存在时没有结果
+                auto after_pk = findPk("SELECT pk FROM rooms WHERE id = ?;", after);
+                if (!after_pk)
+                {
+                    return;
+                }
+                cursor_pk = *after_pk;
+            }
+
+            // 按整数主键倒序即从新到旧；成员数和消息数由触发器增量维护，列表不再需要逐个房间聚合
+            sqlite3_stmt *stmt = db_conn_->getCachedStatement(
+                "SELECT r.id, r.name, r.description, u.id, r.created_at, "
+                "r.member_count, r.message_count, r.last_activity, r.pk "
+                "FROM rooms r JOIN users u ON u.pk = r.creator_pk "
+                "WHERE r.pk < ? ORDER BY r.pk DESC LIMIT ?;");
+            if (!stmt)
+            {
+                return;
+            }
+            sqlite3_bind_int64(stmt, 1, cursor_pk);
+            sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(batch_rows));
+            while (sqlite3_step(stmt) == SQLITE_ROW)
+            {
+                batch.emplace_back(readRoomRow(stmt));
+                cursor_pk = sqlite3_column_int64(stmt, 8);
+            }
+            sqlite3_reset(stmt);
+        }
+
+        for (const auto &room : batch)
+        {
+            if (!visitor(room.view()))
+            {
+                return;
+            }
+        }
+        if (batch.size() < batch_rows)
+        {
+            return;
+        }
+        remaining -= batch.size();
+    }
+}
+
+std::optional<int64_t> SqliteRoomRepository::findPk(const char *sql, const std::string &id) const
+{
+    sqlite3_stmt *stmt = db_conn_->getCachedStatement(sql);
+    if (!stmt)
+    {
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_STATIC);
+    std::optional<int64_t> pk;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        pk = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_reset(stmt);
+    return pk;
+}
+
+bool SqliteRoomRepository::queryExists(const char *sql, const std::string &first, const std::string *second) const
+{
+    sqlite3_stmt *stmt = db_conn_->getCachedStatement(sql);
+    if (!stmt)
+    {
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, first.c_str(), -1, SQLITE_STATIC);
+    if (second)
+    {
+        sqlite3_bind_text(stmt, 2, second->c_str(), -1, SQLITE_STATIC);
+    }
+    bool exists = sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) != 0;
+    sqlite3_reset(stmt);
+    return exists;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <nlohmann/json.hpp>
+#include "database_connection.hpp"
+#include "room_repository.hpp"
+#include "../model/room.hpp"
+
+// 基于 SQLite 的房间数据访问类
+class SqliteRoomRepository : public RoomRepository
+{
+public:
+    explicit SqliteRoomRepository(DatabaseConnection* db_conn);
+
+    // 房间基本操作
+    std::optional<Room> createRoom(const std::string &name, const std::string &description, const std::string &creator_id) override;
+    bool deleteRoom(const std::string &room_id) override;
+    bool roomExists(const std::string &room_id) const override;
+    bool updateRoom(const std::string &room_id, const std::string &name, const std::string &description) override;
+    
+    // 房间查询
+    std::vector<std::string> getRooms() override;
+    std::vector<Room> getAllRooms() override;
+    void visitRooms(const std::string &after, size_t limit, const RoomRowVisitor &visitor) const override;
+    std::optional<Room> getRoomById(const std::string &room_id) const override;
+    std::optional<std::string> getRoomIdByName(const std::string &room_name) const override;
+    bool isRoomCreator(const std::string &room_id, const std::string &user_id) override;
+    
+    // 房间成员管理
+    std::vector<nlohmann::json> getRoomMembers(const std::string &room_id) const override;
+    void visitRoomMembers(const std::string &room_id, const MemberRowVisitor &visitor) const override;
+    std::vector<Room> getUserJoinedRooms(const std::string &user_id) const override;
+    bool addRoomMember(const std::string &room_id, const std::string &user_id) override;
+    bool removeRoomMember(const std::string &room_id, const std::string &user_id) override;
+    bool isRoomMember(const std::string &room_id, const std::string &user_id) const override;// 走内存索引
+    size_t getRoomMemberCount(const std::string &room_id) const override;// 走内存索引或 rooms 表上的计数
+    MembershipStatus checkMembership(const std::string &room_id, const std::string &user_id) const override;
+    JoinResult joinRoom(const std::string &room_id, const std::string &user_id) override;
+    void recordMessageActivity(const std::string &room_id, int64_t message_delta, int64_t timestamp) override;
+
+private:
+    // 按需从 room_members 表加载房间的成员索引，调用方需持有数据库锁
+    // 房间不存在时返回 nullptr
+    const std::unordered_set<std::string> *loadMemberIndex(const std::string &room_id) const;
+
+    // 用 sql 把对外的字符串ID换成表内的整数主键，不存在时返回空，调用方需持有数据库锁
+    std::optional<int64_t> findPk(const char *sql, const std::string &id) const;
+
+    // 执行 SELECT EXISTS(...) 形式的查询，绑定一到两个文本参数，调用方需持有数据库锁
+    bool queryExists(const char *sql, const std::string &first, const std::string *second) const;
+
+    DatabaseConnection* db_conn_;
+
+    // 房间ID到成员ID集合的内存索引，懒加载，由数据库锁保护
+    // 由 addRoomMember/removeRoomMember/deleteRoom 同步维护
+    mutable std::unordered_map<std::string, std::unordered_set<std::string>> member_index_;
+};
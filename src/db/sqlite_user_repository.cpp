@@ -0,0 +1,337 @@
+#include "sqlite_user_repository.hpp"
+#include "../utils/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace
+{
+    // 流式遍历每次持锁读取的行数，读完一批释放锁后再回调
+    constexpr size_t kVisitBatchRows = 256;
+    // 批量查询每条语句绑定的ID数，低于旧版 SQLite 999 个参数的上限
+    constexpr size_t kLookupBatchIds = 500;
+}
+
+SqliteUserRepository::SqliteUserRepository(DatabaseConnection* db_conn) : db_conn_(db_conn) {}
+
+bool SqliteUserRepository::createUser(const std::string &username, const std::string &password_hash)
+{
+    LOG_INFO << "Attempting to create user: " << username;
+    
+    if (!db_conn_->isConnected()) 
+    {
+        LOG_ERROR << "Database not connected when creating user: " << username;
+        return false;//如果数据库未连接，直接返回失败
+    }
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());//获取连接锁
+    std::string user_id = generateUserId();//生成用户ID
+    LOG_INFO << "Generated user ID: " << user_id << " for username: " << username;
+
+    const char *sql = "INSERT INTO users (id, username, password_hash, created_at) VALUES(?, ?, ?, ?);";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, user_id.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, username.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, password_hash.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 4, std::chrono::system_clock::now().time_since_epoch().count());
+
+    LOG_INFO << "Executing INSERT statement for user: " << username;
+    int step_result = sqlite3_step(stmt);
+    bool success = (step_result == SQLITE_DONE);
+    
+    if (!success)
+    {
+        LOG_ERROR << "Failed to execute INSERT for user: " << username 
+                  << ", SQLite error: " << sqlite3_errmsg(db_conn_->getDb())
+                  << ", Step result: " << step_result;
+    }
+    else
+    {
+        LOG_INFO << "Successfully created user: " << username;
+    }
+    
+    sqlite3_finalize(stmt);
+    return success;
+}
+
+bool SqliteUserRepository::validateUser(const std::string &username, const std::string &password_hash)
+{
+    if (!db_conn_->isConnected()) return false;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    const char *sql = "SELECT COUNT(*) FROM users WHERE username = ? AND password_hash = ?;";
+    sqlite3_stmt *stmt;
+    
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, password_hash.c_str(), -1, SQLITE_STATIC);
+
+    bool valid = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        valid = (sqlite3_column_int(stmt, 0) > 0);
+    }
+
+    sqlite3_finalize(stmt);
+    return valid;
+}
+
+bool SqliteUserRepository::userExists(const std::string &user_id)
+{
+    LOG_INFO << "userExists: Checking existence for user_id: " << user_id;
+    
+    if (!db_conn_->isConnected()) {
+        LOG_ERROR << "userExists: Database not connected";
+        return false;
+    }
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    // EXISTS 在唯一索引上找到第一行即停止，语句缓存在连接上
+    sqlite3_stmt *stmt = db_conn_->getCachedStatement("SELECT EXISTS(SELECT 1 FROM users WHERE id = ?);");
+    if (!stmt)
+    {
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, user_id.c_str(), -1, SQLITE_STATIC);
+
+    bool exists = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        exists = sqlite3_column_int(stmt, 0) != 0;
+    }
+    else
+    {
+        LOG_ERROR << "userExists: Failed to execute query for user_id: " << user_id;
+    }
+
+    sqlite3_reset(stmt);
+    LOG_INFO << "userExists: Result for user_id " << user_id << " is " << (exists ? "true" : "false");
+    return exists;
+}
+
+
+void SqliteUserRepository::visitUsers(const std::string &after, size_t limit, const UserRowVisitor &visitor) const
+{
+    if (!db_conn_->isConnected()) return;
+
+    // 回调通常直接写网络，慢客户端不能拖住全局数据库锁：每批行复制出来后释放锁再回调，
+    // 下一批沿整数主键从上一批的最后一行继续
+    int64_t cursor_pk = 0;
+    size_t remaining = limit > 0 ? limit : std::numeric_limits<size_t>::max();
+    std::vector<std::pair<std::string, std::string>> batch;
+    while (remaining > 0)
+    {
+        size_t batch_rows = std::min(remaining, kVisitBatchRows);
+        batch.clear();
+        {
+            std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+            if (cursor_pk == 0 && !after.empty())
+            {
+                // 游标在 id 唯一索引上换成整数主键，不存在时没有结果
+                sqlite3_stmt *stmt = db_conn_->getCachedStatement("SELECT pk FROM users WHERE id = ?;");
+                if (!stmt)
+                {
+                    return;
+                }
+                sqlite3_bind_text(stmt, 1, after.c_str(), -1, SQLITE_STATIC);
+                if (sqlite3_step(stmt) == SQLITE_ROW)
+                {
+                    cursor_pk = sqlite3_column_int64(stmt, 0);
+                }
+                sqlite3_reset(stmt);
+                if (cursor_pk == 0)
+                {
+                    return;
+                }
+            }
+
+            // 沿主键向后扫描一批；只取响应需要的列
+            sqlite3_stmt *stmt = db_conn_->getCachedStatement("SELECT pk, id, username FROM users WHERE pk > ? ORDER BY pk LIMIT ?;");
+            if (!stmt)
+            {
+                return;
+            }
+            sqlite3_bind_int64(stmt, 1, cursor_pk);
+            sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(batch_rows));
+            while (sqlite3_step(stmt) == SQLITE_ROW)
+            {
+                cursor_pk = sqlite3_column_int64(stmt, 0);
+                batch.emplace_back(std::string(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)),
+                                               static_cast<size_t>(sqlite3_column_bytes(stmt, 1))),
+                                   std::string(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2)),
+                                               static_cast<size_t>(sqlite3_column_bytes(stmt, 2))));
+            }
+            sqlite3_reset(stmt);
+        }
+
+        for (const auto &user : batch)
+        {
+            if (!visitor(UserRow{user.first, user.second}))
+            {
+                return;
+            }
+        }
+        if (batch.size() < batch_rows)
+        {
+            return;
+        }
+        remaining -= batch.size();
+    }
+}
+
+std::vector<User> SqliteUserRepository::getAllUsers() const
+{
+    std::vector<User> users;
+    if (!db_conn_->isConnected()) return users;
+    
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    const char *sql = "SELECT id, username, password_hash FROM users;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return users;
+    }
+
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        const char *id = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        const char *username = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+        const char *password = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+        users.emplace_back(std::string(id), std::string(username), std::string(password));
+    }
+
+    sqlite3_finalize(stmt);
+    return users;
+}
+
+std::optional<User> SqliteUserRepository::getUserById(const std::string &user_id) const
+{
+    if (!db_conn_->isConnected()) return std::nullopt;
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    const char *sql = "SELECT id, username, password_hash FROM users WHERE id = ?;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(stmt, 1, user_id.c_str(), -1, SQLITE_STATIC);
+
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        //确定找到了一行数据时，才构造 User 对象
+        const unsigned char *id_col = sqlite3_column_text(stmt, 0);
+        const unsigned char *username_col = sqlite3_column_text(stmt, 1);
+        const unsigned char *password_col = sqlite3_column_text(stmt, 2);
+
+        std::string id_str = id_col ? std::string(reinterpret_cast<const char*>(id_col)) : "";
+        std::string username_str = username_col ? std::string(reinterpret_cast<const char*>(username_col)) : "";
+        std::string password_str = password_col ? std::string(reinterpret_cast<const char*>(password_col)) : "";
+
+        // 构造并返回User对象。C++会自动将其包装在std::optional中
+        sqlite3_finalize(stmt);
+        return User(id_str, username_str, password_str);
+    }
+    else
+    {
+        sqlite3_finalize(stmt); // 确保释放stmt资源
+        LOG_ERROR << "User not found with ID: " << user_id; // 如果没有找到用户，记录错误日志
+        return std::nullopt; // 如果没有找到用户，返回std::nullopt
+    }
+}
+
+std::optional<User> SqliteUserRepository::getUserByUsername(const std::string &username) const
+{
+    if (!db_conn_->isConnected()) return std::nullopt;
+
+    std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+    const char *sql = "SELECT id, username, password_hash FROM users WHERE username = ?;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db_conn_->getDb(), sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
+
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        const unsigned char *id_col = sqlite3_column_text(stmt, 0);
+        const unsigned char *username_col = sqlite3_column_text(stmt, 1);
+        const unsigned char *password_col = sqlite3_column_text(stmt, 2);
+
+        std::string id_str = id_col ? std::string(reinterpret_cast<const char*>(id_col)) : "";
+        std::string username_str = username_col ? std::string(reinterpret_cast<const char*>(username_col)) : "";
+        std::string password_str = password_col ? std::string(reinterpret_cast<const char*>(password_col)) : "";
+
+        sqlite3_finalize(stmt);
+        return User(id_str, username_str, password_str);
+    }
+    else
+    {
+        sqlite3_finalize(stmt); // 确保释放stmt资源
+        LOG_ERROR << "User not found with username: " << username; // 如果没有找到用户，记录错误日志
+        return std::nullopt; // 如果没有找到用户，返回std::nullopt
+    }
+}
+
+std::unordered_map<std::string, std::string> SqliteUserRepository::getUsernames(const std::vector<std::string> &user_ids) const
+{
+    std::unordered_map<std::string, std::string> usernames;
+    if (!db_conn_->isConnected()) return usernames;
+
+    // 每批一条 WHERE id IN (...) 语句，批与批之间释放锁
+    for (size_t begin = 0; begin < user_ids.size(); begin += kLookupBatchIds)
+    {
+        size_t count = std::min(kLookupBatchIds, user_ids.size() - begin);
+        std::string sql = "SELECT id, username FROM users WHERE id IN (?";
+        for (size_t i = 1; i < count; ++i)
+        {
+            sql += ",?";
+        }
+        sql += ");";
+
+        std::lock_guard<DatabaseConnection::Mutex> lock(db_conn_->getMutex());
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(db_conn_->getDb(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            LOG_ERROR << "Failed to prepare statement: " << sqlite3_errmsg(db_conn_->getDb());
+            return usernames;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            sqlite3_bind_text(stmt, static_cast<int>(i + 1), user_ids[begin + i].c_str(), -1, SQLITE_STATIC);
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            const unsigned char *id_col = sqlite3_column_text(stmt, 0);
+            const unsigned char *username_col = sqlite3_column_text(stmt, 1);
+            if (id_col && username_col)
+            {
+                usernames.emplace(reinterpret_cast<const char *>(id_col), reinterpret_cast<const char *>(username_col));
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+    return usernames;
+}
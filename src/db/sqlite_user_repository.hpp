@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include "database_connection.hpp"
+#include "user_repository.hpp"
+#include "../model/user.hpp"
+
+// 基于 SQLite 的用户数据访问类
+class SqliteUserRepository : public UserRepository
+{
+public:
+    explicit SqliteUserRepository(DatabaseConnection* db_conn);// 构造函数，接受数据库连接指针
+
+    // 用户基本操作
+    bool createUser(const std::string &username, const std::string &password_hash) override;
+    bool validateUser(const std::string &username, const std::string &password_hash) override;
+    bool userExists(const std::string &user_id) override;
+    
+    // 用户查询
+    std::vector<User> getAllUsers() const override;
+    void visitUsers(const std::string &after, size_t limit, const UserRowVisitor &visitor) const override;
+    std::optional<User> getUserById(const std::string &user_id) const override;
+    std::optional<User> getUserByUsername(const std::string &username) const override;
+    std::unordered_map<std::string, std::string> getUsernames(const std::vector<std::string> &user_ids) const override;
+
+private:
+    DatabaseConnection* db_conn_;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+// 分段加锁的哈希表
+// 按键的哈希把数据分散到 N 个分段，每个分段有自己的读写锁，不同分段上的读写互不阻塞。
+// 只通过回调访问分段内的 map，回调在持锁期间执行，不要在回调中访问同一个 StripedMap 的其他键
+template <typename Key, typename Value, size_t N = 16>
+class StripedMap
+{
+public:
+    using Map = std::unordered_map<Key, Value>;
+
+    // 持有 key 所在分段的读锁调用 fn(const Map &)
+    template <typename Fn>
+    auto read(const Key &key, Fn &&fn) const
+    {
+        const Stripe &stripe = stripeFor(key);
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+        return fn(static_cast<const Map &>(stripe.map));
+    }
+
+    // 持有 key 所在分段的写锁调用 fn(Map &)
+    template <typename Fn>
+    auto write(const Key &key, Fn &&fn)
+    {
+        Stripe &stripe = stripeFor(key);
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+        return fn(stripe.map);
+    }
+
+    // 依次持有每个分段的读锁调用 fn(const Key &, const Value &)，不是全表一致的快照
+    template <typename Fn>
+    void forEach(Fn &&fn) const
+    {
+        for (const Stripe &stripe : stripes_)
+        {
+            std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+            for (const auto &[key, value] : stripe.map)
+            {
+                fn(key, value);
+            }
+        }
+    }
+
+private:
+    struct Stripe
+    {
+        mutable std::shared_mutex mutex;
+        Map map;
+    };
+
+    Stripe &stripeFor(const Key &key) { return stripes_[std::hash<Key>{}(key) % N]; }
+    const Stripe &stripeFor(const Key &key) const { return stripes_[std::hash<Key>{}(key) % N]; }
+
+    std::array<Stripe, N> stripes_;
+};
@@ -1,30 +1,45 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <optional>
-#include "database_connection.hpp"
 #include "../model/user.hpp"
 
-// 用户数据访问类
+// 流式查询得到的一行用户数据，字段只在回调执行期间有效
+struct UserRow
+{
+    std::string_view id;
+    std::string_view username;
+};
+// 返回 false 时停止遍历
+using UserRowVisitor = std::function<bool(const UserRow &)>;
+
+// 用户数据访问接口
+// 默认实现为 SqliteUserRepository；MemoryUserRepository 为纯内存实现，用于压测和测试
 class UserRepository
 {
 public:
-    explicit UserRepository(DatabaseConnection* db_conn);// 构造函数，接受数据库连接指针
+    virtual ~UserRepository() = default;
 
     // 用户基本操作
-    bool createUser(const std::string &username, const std::string &password_hash);// 创建用户
-    bool validateUser(const std::string &username, const std::string &password_hash);// 验证用户
-    bool userExists(const std::string &user_id);// 根据ID检查用户是否存在
+    virtual bool createUser(const std::string &username, const std::string &password_hash) = 0;// 创建用户
+    virtual bool validateUser(const std::string &username, const std::string &password_hash) = 0;// 验证用户
+    virtual bool userExists(const std::string &user_id) = 0;// 根据ID检查用户是否存在
     
     // 用户查询
-    std::vector<User> getAllUsers() const;// 获取所有用户
-    std::optional<User> getUserById(const std::string &user_id) const; 
-    std::optional<User> getUserByUsername(const std::string &username) const;
+    virtual std::vector<User> getAllUsers() const = 0;// 获取所有用户
+    // 按创建顺序逐行回调，不构造 User 对象；回调期间不持有数据库锁，可以直接写网络
+    // after 非空时从该用户之后开始（游标分页，after 不存在时没有结果），limit 为 0 表示不限条数
+    virtual void visitUsers(const std::string &after, size_t limit, const UserRowVisitor &visitor) const = 0;
+    virtual std::optional<User> getUserById(const std::string &user_id) const = 0;
+    virtual std::optional<User> getUserByUsername(const std::string &username) const = 0;
+    // 批量查询用户名（用户ID -> 用户名），不存在的用户不出现在结果中
+    virtual std::unordered_map<std::string, std::string> getUsernames(const std::vector<std::string> &user_ids) const = 0;
 
     // 工具方法
     std::string generateUserId();// 生成用户ID
-
-private:
-    DatabaseConnection* db_conn_;
 };
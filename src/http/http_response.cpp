@@ -31,6 +31,7 @@ namespace http
     HttpResponse &HttpResponse::withBody(const std::string &body_content, const std::string &content_type)
     {
         body_ = body_content;
+        producer_ = nullptr;
         headers_["Content-Type"] = content_type;
         return *this;
     }
@@ -38,10 +39,19 @@ namespace http
     HttpResponse &HttpResponse::withJsonBody(const nlohmann::json &json_body)
     {
         body_ = json_body.dump(); // 使用库进行序列化
+        producer_ = nullptr;
         headers_["Content-Type"] = "application/json; charset=utf-8";
         return *this;
     }
 
+    HttpResponse &HttpResponse::withStreamBody(BodyProducer producer, const std::string &content_type)
+    {
+        body_.clear();
+        producer_ = std::move(producer);
+        headers_["Content-Type"] = content_type;
+        return *this;
+    }
+
     // --- 静态工厂方法实现 ---
     HttpResponse HttpResponse::Ok(const std::string &body)
     {
@@ -86,19 +96,63 @@ namespace http
 
     // --- 序列化 ---
     std::string HttpResponse::toString() const
+    {
+        std::string result;
+        writeTo([&result](std::string_view data)
+                {
+                    result.append(data);
+                    return true;
+                });
+        return result;
+    }
+
+    bool HttpResponse::writeTo(const BodySink &write) const
+    {
+        if (!producer_)
+        {
+            return write(headerString()) && write(body_);
+        }
+        if (!write(headerString()))
+        {
+            return false;
+        }
+
+        // 每次写入作为一个块发送：十六进制长度、CRLF、数据、CRLF；空数据不能发送，否则会被当作结束块
+        bool ok = true;
+        producer_([&](std::string_view data)
+                  {
+                      if (!ok || data.empty())
+                      {
+                          return ok;
+                      }
+                      std::stringstream size;
+                      size << std::hex << data.size() << "\r\n";
+                      ok = write(size.str()) && write(data) && write("\r\n");
+                      return ok;
+                  });
+        return ok && write("0\r\n\r\n");
+    }
+
+    std::string HttpResponse::headerString() const
     {
         std::stringstream ss;
         ss << "HTTP/1.1 " << status_code_ << " " << getStatusText(status_code_) << "\r\n";
 
-        // 确保Content-Length总是最新的
-        ss << "Content-Length: " << body_.length() << "\r\n";
+        // 确保Content-Length总是最新的；流式响应体长度未知，改用分块传输
+        if (producer_)
+        {
+            ss << "Transfer-Encoding: chunked\r\n";
+        }
+        else
+        {
+            ss << "Content-Length: " << body_.length() << "\r\n";
+        }
 
         for (const auto &header : headers_)
         {
             ss << header.first << ": " << header.second << "\r\n";
         }
         ss << "\r\n";
-        ss << body_;
         return ss.str();
     }
 
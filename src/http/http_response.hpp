@@ -1,10 +1,16 @@
 #pragma once
+#include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <nlohmann/json.hpp>
 
 namespace http
 {
+    // 流式响应体：生产者把数据依次交给 BodySink，BodySink 返回 false 表示连接已断开，应停止生产
+    using BodySink = std::function<bool(std::string_view)>;
+    using BodyProducer = std::function<void(const BodySink &)>;
+
     class HttpResponse
     {
     public:
@@ -15,6 +21,8 @@ namespace http
         HttpResponse &withHeader(const std::string &key, const std::string &value);
         HttpResponse &withBody(const std::string &body_content, const std::string &content_type = "text/plain");
         HttpResponse &withJsonBody(const nlohmann::json &json_body);
+        // 响应体在发送时才由 producer 生成，以 chunked 编码边生成边发送，不计算 Content-Length
+        HttpResponse &withStreamBody(BodyProducer producer, const std::string &content_type = "application/json; charset=utf-8");
 
         // --- 静态工厂方法 ---
         static HttpResponse Ok(const std::string &body = "OK");
@@ -26,16 +34,24 @@ namespace http
         static HttpResponse InternalError(const std::string &error_message = "Internal Server Error");
         static HttpResponse NoContent();
 
-        // 将响应对象序列化为发送给客户端的字符串
+        // 将响应对象序列化为发送给客户端的字符串，流式响应会先完整生成响应体
         std::string toString() const;
 
+        // 把响应依次写给 write：先写响应头，再写响应体，流式响应体按块写出
+        // write 返回 false 时停止，整体返回 false
+        bool writeTo(const BodySink &write) const;
+
+        bool isStreaming() const { return static_cast<bool>(producer_); }
+
     private:
         int status_code_;
         std::string body_;
+        BodyProducer producer_;
         std::unordered_map<std::string, std::string> headers_;
 
         // 私有辅助函数
         static std::string getStatusText(int code);
         static std::string getHttpDate();
+        std::string headerString() const;
     };
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 
@@ -297,9 +298,12 @@ namespace http
                 .withHeader("Access-Control-Allow-Headers",
                             "Content-Type, Authorization, X-Requested-With")
                 .withHeader("X-Server", "SwiftChat/1.0");
-            // 4. 发送响应
-            std::string response_str = response.toString();
-            send(client_fd, response_str.c_str(), response_str.length(), 0);
+            // 4. 发送响应，流式响应体边生成边发送
+            if (!response.writeTo([client_fd](std::string_view data)
+                                  { return sendAll(client_fd, data); }))
+            {
+                LOG_WARN << "Failed to send response to client fd " << client_fd;
+            }
         }
         catch (const std::exception &e)
         {
@@ -474,4 +478,33 @@ namespace http
             LOG_ERROR << "Failed to set file descriptor to non-blocking: " << strerror(errno);
         }
     }
+
+    bool HttpServer::sendAll(int fd, std::string_view data)
+    {
+        // 套接字是非阻塞的，发送缓冲区满时等待可写，客户端长时间不读则放弃
+        const int SEND_TIMEOUT_MS = 5000;
+        while (!data.empty())
+        {
+            ssize_t sent = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (sent > 0)
+            {
+                data.remove_prefix(static_cast<size_t>(sent));
+                continue;
+            }
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                pollfd pfd{fd, POLLOUT, 0};
+                if (poll(&pfd, 1, SEND_TIMEOUT_MS) > 0)
+                {
+                    continue;
+                }
+            }
+            return false;
+        }
+        return true;
+    }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <functional>
 #include <vector>
 #include <unordered_map>
@@ -67,5 +68,6 @@ namespace http
         Epoller epoller_; // 使用Epoller处理IO事件
         void handleClient(int client_fd); // 核心客户端处理逻辑
         static void setNoBlocking(int fd);
+        static bool sendAll(int fd, std::string_view data); // 发送全部数据，失败或超时返回 false
     };
 }
\ No newline at end of file
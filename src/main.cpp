@@ -8,6 +8,7 @@
 #include "service/server_service.hpp"
 #include "middleware/auth_middleware.hpp"
 #include "db/database_manager.hpp"
+#include "utils/timer.hpp"
 #include <iostream>
 #include <signal.h>
 #include <atomic>
@@ -16,10 +17,13 @@
 #include <ctime>
 #include <cstdlib>
 #include <memory>
+#include <algorithm>
 #include <getopt.h>
 #include <fstream>
 #include <filesystem>
 #include <locale>
+#include <sstream>
+#include <unordered_set>
 
 
 std::atomic<bool> running(true);
@@ -29,7 +33,26 @@ std::unique_ptr<WebSocketServer> ws_server;
 struct ServerConfig {
     int http_port = 8080;
     int ws_port = 8081;
+    int ws_threads = std::max(1u, std::thread::hardware_concurrency()); // WebSocket 事件循环线程数
+    std::string ws_deflate = "shared"; // permessage-deflate：off、shared（每条消息独立压缩，广播共享）或 takeover（保留上下文）
+    int ws_deflate_min_size = 256; // 小于该字节数的消息不压缩
+    int ws_deflate_window_bits = 15; // 服务端压缩窗口位数
+    int ws_max_message_size = 1024 * 1024; // 单条消息（压缩消息按解压后计）的字节数上限
+    int ws_queue_messages = 1024; // 每个连接出站队列的消息数上限
+    int ws_queue_bytes = 4 * 1024 * 1024; // 每个连接出站队列的字节数上限
+    std::string ws_queue_policy = "drop"; // 出站队列超限策略：drop（丢弃最旧的上下线通知）或 close
+    int ws_ping_interval = 30; // 连接空闲多少秒后服务端发送 ping，0 表示关闭服务端心跳
+    int ws_ping_misses = 2; // 连续多少次 ping 无响应后断开连接
+    int ws_presence_window = 250; // 上下线通知的合并窗口（毫秒），0 表示逐个通知
+    int ws_presence_threshold = 100; // 在线成员超过该数量的房间才合并上下线通知
     std::string db_path = "./chat.db";
+    int message_shards = 1; // 消息分片库数量，1 表示不分片
+    int slow_query_ms = 100; // 慢查询日志阈值（毫秒），0 表示关闭
+    std::string message_store = "sqlite"; // 消息存储引擎：sqlite 或 log
+    int retention_days = 0; // 全局消息保留天数，0 表示不限
+    int retention_messages = 0; // 每个房间最多保留的消息数，0 表示不限
+    std::unordered_set<std::string> admin_users; // 可以调用内部统计（数据库、WebSocket）和备份接口的用户ID
+    int backup_keep = 3; // 保留的备份份数，0 表示不清理
     std::string static_dir = "./static";
     std::string log_file = ""; // 将在运行时根据日期生成
     std::string log_dir = "./logs"; // 日志目录
@@ -43,7 +66,26 @@ void showHelp(const char* program_name) {
     std::cout << "选项:\n";
     std::cout << "  --http-port PORT     HTTP 服务器端口 (默认: 8080)\n";
     std::cout << "  --ws-port PORT       WebSocket 服务器端口 (默认: 8081)\n";
-    std::cout << "  --db-path PATH       数据库文件路径 (默认: ./chat.db)\n";
+    std::cout << "  --ws-threads N       WebSocket 事件循环线程数 (默认: CPU 核数)\n";
+    std::cout << "  --ws-deflate MODE    permessage-deflate 压缩: off、shared (广播只压缩一次) 或 takeover (保留上下文) (默认: shared)\n";
+    std::cout << "  --ws-deflate-min-size N 小于 N 字节的消息不压缩 (默认: 256)\n";
+    std::cout << "  --ws-deflate-window-bits N 服务端压缩窗口位数 9~15 (默认: 15)\n";
+    std::cout << "  --ws-max-message-size N 单条消息的字节数上限，压缩消息按解压后计，超过时以 1009 关闭连接 (默认: 1048576)\n";
+    std::cout << "  --ws-queue-messages N 每个连接出站队列的消息数上限 (默认: 1024)\n";
+    std::cout << "  --ws-queue-bytes N   每个连接出站队列的字节数上限 (默认: 4194304)\n";
+    std::cout << "  --ws-queue-policy P  出站队列超限策略: drop (丢弃最旧的上下线通知) 或 close (默认: drop)\n";
+    std::cout << "  --ws-ping-interval S 连接空闲 S 秒后服务端发送 ping，0 表示关闭 (默认: 30)\n";
+    std::cout << "  --ws-ping-misses N   连续 N 次 ping 无响应后断开连接 (默认: 2)\n";
+    std::cout << "  --ws-presence-window MS 大房间的上下线通知合并为每 MS 毫秒一条 presence_delta，0 表示逐个通知 (默认: 250)\n";
+    std::cout << "  --ws-presence-threshold N 在线成员超过 N 的房间才合并上下线通知 (默认: 100)\n";
+    std::cout << "  --db-path PATH       数据库文件路径，:memory-engine: 表示纯内存存储 (默认: ./chat.db)\n";
+    std::cout << "  --message-shards N   消息分片库数量，按房间分散写入 (默认: 1，不分片)\n";
+    std::cout << "  --slow-query-ms MS   慢查询日志阈值，0 表示关闭 (默认: 100)\n";
+    std::cout << "  --message-store TYPE 消息存储引擎: sqlite 或 log (追加写分段日志) (默认: sqlite)\n";
+    std::cout << "  --retention-days N   消息保留天数，后台定期清理更早的消息 (默认: 0，不限)\n";
+    std::cout << "  --retention-messages N 每个房间最多保留的消息数 (默认: 0，不限)\n";
+    std::cout << "  --admin-users IDS    可以调用内部统计（数据库、WebSocket）和备份接口的用户ID，逗号分隔 (默认: 空，这些接口关闭)\n";
+    std::cout << "  --backup-keep N      保留最新的 N 份备份，0 表示不清理 (默认: 3)\n";
     std::cout << "  --static-dir DIR     静态文件目录 (默认: ./static)\n";
     std::cout << "  --log-dir DIR        日志文件目录 (默认: ./logs)\n";
     std::cout << "  --help               显示帮助信息\n";
@@ -52,6 +94,7 @@ void showHelp(const char* program_name) {
     std::cout << "示例:\n";
     std::cout << "  " << program_name << " --http-port 9000 --ws-port 9001\n";
     std::cout << "  " << program_name << " --db-path /var/lib/swiftchat/chat.db\n";
+    std::cout << "  " << program_name << " --db-path :memory-engine:   # 压测网络层，数据不落盘\n";
 }
 
 void showVersion() {
@@ -65,7 +108,26 @@ ServerConfig parseCommandLine(int argc, char* argv[]) {
     static struct option long_options[] = {
         {"http-port", required_argument, 0, 'h'},
         {"ws-port", required_argument, 0, 'w'},
+        {"ws-threads", required_argument, 0, 't'},
+        {"ws-deflate", required_argument, 0, 'z'},
+        {"ws-deflate-min-size", required_argument, 0, 'y'},
+        {"ws-deflate-window-bits", required_argument, 0, 'b'},
+        {"ws-max-message-size", required_argument, 0, 'j'},
+        {"ws-queue-messages", required_argument, 0, 'o'},
+        {"ws-queue-bytes", required_argument, 0, 'k'},
+        {"ws-queue-policy", required_argument, 0, 'p'},
+        {"ws-ping-interval", required_argument, 0, 'i'},
+        {"ws-ping-misses", required_argument, 0, 'r'},
+        {"ws-presence-window", required_argument, 0, 'c'},
+        {"ws-presence-threshold", required_argument, 0, 'g'},
         {"db-path", required_argument, 0, 'd'},
+        {"message-shards", required_argument, 0, 'm'},
+        {"slow-query-ms", required_argument, 0, 'q'},
+        {"message-store", required_argument, 0, 'e'},
+        {"retention-days", required_argument, 0, 'a'},
+        {"retention-messages", required_argument, 0, 'n'},
+        {"admin-users", required_argument, 0, 'u'},
+        {"backup-keep", required_argument, 0, 'x'},
         {"static-dir", required_argument, 0, 's'},
         {"log-dir", required_argument, 0, 'l'},
         {"help", no_argument, 0, '?'},
@@ -74,7 +136,7 @@ ServerConfig parseCommandLine(int argc, char* argv[]) {
     };
     
     int c;
-    while ((c = getopt_long(argc, argv, "h:w:d:s:l:?v", long_options, nullptr)) != -1) {
+    while ((c = getopt_long(argc, argv, "h:w:t:z:y:b:j:o:k:p:i:r:c:g:d:m:q:e:a:n:u:x:s:l:?v", long_options, nullptr)) != -1) {
         switch (c) {
             case 'h':
                 config.http_port = std::atoi(optarg);
@@ -82,9 +144,85 @@ ServerConfig parseCommandLine(int argc, char* argv[]) {
             case 'w':
                 config.ws_port = std::atoi(optarg);
                 break;
+            case 't':
+                config.ws_threads = std::max(1, std::atoi(optarg));
+                break;
+            case 'z':
+                config.ws_deflate = optarg;
+                if (config.ws_deflate != "off" && config.ws_deflate != "shared" && config.ws_deflate != "takeover") {
+                    std::cerr << "未知的压缩模式: " << config.ws_deflate << "\n";
+                    config.show_help = true;
+                }
+                break;
+            case 'y':
+                config.ws_deflate_min_size = std::max(0, std::atoi(optarg));
+                break;
+            case 'b':
+                config.ws_deflate_window_bits = std::min(15, std::max(9, std::atoi(optarg)));
+                break;
+            case 'j':
+                config.ws_max_message_size = std::max(1024, std::atoi(optarg));
+                break;
+            case 'o':
+                config.ws_queue_messages = std::max(1, std::atoi(optarg));
+                break;
+            case 'k':
+                config.ws_queue_bytes = std::max(1024, std::atoi(optarg));
+                break;
+            case 'p':
+                config.ws_queue_policy = optarg;
+                if (config.ws_queue_policy != "drop" && config.ws_queue_policy != "close") {
+                    std::cerr << "未知的出站队列策略: " << config.ws_queue_policy << "\n";
+                    config.show_help = true;
+                }
+                break;
+            case 'i':
+                config.ws_ping_interval = std::max(0, std::atoi(optarg));
+                break;
+            case 'r':
+                config.ws_ping_misses = std::max(1, std::atoi(optarg));
+                break;
+            case 'c':
+                config.ws_presence_window = std::max(0, std::atoi(optarg));
+                break;
+            case 'g':
+                config.ws_presence_threshold = std::max(0, std::atoi(optarg));
+                break;
             case 'd':
                 config.db_path = optarg;
                 break;
+            case 'm':
+                config.message_shards = std::max(1, std::atoi(optarg));
+                break;
+            case 'q':
+                config.slow_query_ms = std::max(0, std::atoi(optarg));
+                break;
+            case 'e':
+                config.message_store = optarg;
+                if (config.message_store != "sqlite" && config.message_store != "log") {
+                    std::cerr << "未知的消息存储引擎: " << config.message_store << "\n";
+                    config.show_help = true;
+                }
+                break;
+            case 'a':
+                config.retention_days = std::max(0, std::atoi(optarg));
+                break;
+            case 'n':
+                config.retention_messages = std::max(0, std::atoi(optarg));
+                break;
+            case 'u': {
+                std::stringstream ids(optarg);
+                std::string id;
+                while (std::getline(ids, id, ',')) {
+                    if (!id.empty()) {
+                        config.admin_users.insert(id);
+                    }
+                }
+                break;
+            }
+            case 'x':
+                config.backup_keep = std::max(0, std::atoi(optarg));
+                break;
             case 's':
                 config.static_dir = optarg;
                 break;
@@ -201,8 +339,39 @@ int main(int argc, char *argv[])
         }
 
         // 初始化数据库管理器
-        DatabaseManager db_manager(config.db_path);
-        LOG_INFO << "数据库管理器已初始化: " << config.db_path;
+        DatabaseOptions db_options;
+        db_options.message_shards = config.message_shards;
+        db_options.message_engine = config.message_store == "log" ? MessageEngine::Log : MessageEngine::Sqlite;
+        DatabaseManager db_manager(config.db_path, db_options);
+        if (!db_manager.isConnected()) {
+            LOG_ERROR << "数据库初始化失败: " << config.db_path;
+            std::cerr << "数据库初始化失败，详见日志: " << config.db_path << std::endl;
+            return 1;
+        }
+        LOG_INFO << "数据库管理器已初始化: " << config.db_path << "，消息存储: " << config.message_store
+                 << "，消息分片数: " << config.message_shards;
+        db_manager.setSlowQueryThreshold(std::chrono::milliseconds(config.slow_query_ms));
+
+        // 后台消息清理：全局策略来自命令行，房间可以单独设置
+        MessageRetention::Options retention_options;
+        retention_options.global.max_age = std::chrono::hours(24) * config.retention_days;
+        retention_options.global.max_messages = static_cast<size_t>(config.retention_messages);
+        db_manager.getRetention().setOptions(retention_options);
+        db_manager.getRetention().start();
+
+        // 在线备份只保留最新的几份，避免反复备份占满磁盘
+        DatabaseBackup::Options backup_options = db_manager.getBackup().getOptions();
+        backup_options.keep_backups = static_cast<size_t>(config.backup_keep);
+        db_manager.getBackup().setOptions(backup_options);
+
+        // 后台全文索引：新消息分批加入搜索索引
+        db_manager.getSearchIndexer().start();
+
+        // 后台维护定时器：定期淘汰空闲房间的热消息缓存
+        utils::Timer maintenance_timer;
+        maintenance_timer.addPeriodicTask(std::chrono::seconds(60), std::chrono::seconds(60), [&db_manager]()
+                                          { db_manager.getMessageCache().evictIdle(); });
+        maintenance_timer.start();
 
         // 创建HTTP服务器实例
         http::HttpServer server(config.http_port, 4); // 4个工作线程
@@ -220,6 +389,19 @@ int main(int argc, char *argv[])
         MessageService message_service(db_manager);
         UserService user_service(db_manager);
         ServerService server_service(db_manager);
+        server_service.setAdminUsers(config.admin_users);
+        if (config.admin_users.empty()) {
+            LOG_INFO << "未配置管理员用户，内部统计和备份接口已关闭";
+        }
+        server_service.setWebSocketStatsProvider([]()
+                                                 {
+                                                     if (!ws_server) {
+                                                         return nlohmann::json(nullptr);
+                                                     }
+                                                     return nlohmann::json{{"outbound", ws_server->outbound_stats()},
+                                                                           {"heartbeat", ws_server->heartbeat_stats()},
+                                                                           {"presence", ws_server->presence_stats()}};
+                                                 });
         
         // 注册路由
         auth_service.registerRoutes(server);
@@ -230,8 +412,33 @@ int main(int argc, char *argv[])
         
         LOG_INFO << "所有服务已注册成功";
 
+        // WebSocket 压缩配置，服务器和每个连接的压缩扩展都从这里读取
+        PermessageDeflate::Options deflate_options;
+        deflate_options.enabled = config.ws_deflate != "off";
+        deflate_options.server_no_context_takeover = config.ws_deflate != "takeover";
+        deflate_options.min_compress_size = static_cast<size_t>(config.ws_deflate_min_size);
+        deflate_options.server_max_window_bits = config.ws_deflate_window_bits;
+        deflate_options.max_message_size = static_cast<size_t>(config.ws_max_message_size);
+        PermessageDeflate::setOptions(deflate_options);
+
         // 创建并启动WebSocket服务器
-        ws_server = std::make_unique<WebSocketServer>(db_manager);
+        ws_server = std::make_unique<WebSocketServer>(db_manager, config.ws_threads);
+        OutboundQueue::Limits outbound_limits;
+        outbound_limits.max_messages = static_cast<size_t>(config.ws_queue_messages);
+        outbound_limits.max_bytes = static_cast<size_t>(config.ws_queue_bytes);
+        outbound_limits.transport_bytes = std::min(outbound_limits.transport_bytes, outbound_limits.max_bytes);
+        outbound_limits.policy = config.ws_queue_policy == "close" ? OutboundQueue::OverflowPolicy::Close
+                                                                   : OutboundQueue::OverflowPolicy::DropOldest;
+        ws_server->set_outbound_limits(outbound_limits);
+        HeartbeatWheel::Options heartbeat_options;
+        heartbeat_options.interval_ms = static_cast<int64_t>(config.ws_ping_interval) * 1000;
+        heartbeat_options.max_missed = config.ws_ping_misses;
+        ws_server->set_heartbeat_options(heartbeat_options);
+        PresenceCoalescer::Options presence_options;
+        presence_options.window_ms = config.ws_presence_window;
+        presence_options.member_threshold = static_cast<size_t>(config.ws_presence_threshold);
+        ws_server->set_presence_options(presence_options);
+        ws_server->set_max_message_size(static_cast<size_t>(config.ws_max_message_size));
         LOG_INFO << "WebSocket服务器已创建";
 
         // 启动信息
@@ -295,6 +502,9 @@ int main(int argc, char *argv[])
             websocket_thread.join();
         }
 
+        // 停止后台维护定时器
+        maintenance_timer.stop();
+
         LOG_INFO << "所有服务器已关闭";
         
         // 关闭文件日志
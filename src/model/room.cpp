@@ -7,7 +7,10 @@ json Room::toJson() const
         {"name", name_},
         {"description", description_},
         {"creator_id", creator_id_},
-        {"created_at", created_at_}
+        {"created_at", created_at_},
+        {"member_count", member_count_},
+        {"message_count", message_count_},
+        {"last_activity", last_activity_}
     };
 }
 
@@ -30,5 +33,14 @@ Room Room::fromJson(const json &j)
     if (j.contains("created_at") && j["created_at"].is_number_integer())
         room.created_at_ = j["created_at"];
     
+    if (j.contains("member_count") && j["member_count"].is_number_integer())
+        room.member_count_ = j["member_count"];
+    
+    if (j.contains("message_count") && j["message_count"].is_number_integer())
+        room.message_count_ = j["message_count"];
+    
+    if (j.contains("last_activity") && j["last_activity"].is_number_integer())
+        room.last_activity_ = j["last_activity"];
+    
     return room;
 }
@@ -13,13 +13,17 @@ private:
     std::string description_;  // 房间描述
     std::string creator_id_;   // 创建者ID
     int64_t created_at_;       // 创建时间戳
+    int64_t member_count_;     // 成员数
+    int64_t message_count_;    // 消息数
+    int64_t last_activity_;    // 最后一条消息的时间戳（秒），没有消息时为0
 
 public:
     // 构造函数
-    Room() : created_at_(0) {} // 默认构造函数
+    Room() : created_at_(0), member_count_(0), message_count_(0), last_activity_(0) {} // 默认构造函数
     Room(const std::string &id, const std::string &name, const std::string &description,
          const std::string &creator_id, int64_t created_at)
-        : id_(id), name_(name), description_(description), creator_id_(creator_id), created_at_(created_at) {}
+        : id_(id), name_(name), description_(description), creator_id_(creator_id), created_at_(created_at),
+          member_count_(0), message_count_(0), last_activity_(0) {}
 
     // Getter方法
     const std::string &getId() const { return id_; }
@@ -27,6 +31,9 @@ public:
     const std::string &getDescription() const { return description_; }
     const std::string &getCreatorId() const { return creator_id_; }
     int64_t getCreatedAt() const { return created_at_; }
+    int64_t getMemberCount() const { return member_count_; }
+    int64_t getMessageCount() const { return message_count_; }
+    int64_t getLastActivity() const { return last_activity_; }
 
     // Setter方法
     void setId(const std::string &id) { id_ = id; }
@@ -34,6 +41,9 @@ public:
     void setDescription(const std::string &description) { description_ = description; }
     void setCreatorId(const std::string &creator_id) { creator_id_ = creator_id; }
     void setCreatedAt(int64_t created_at) { created_at_ = created_at; }
+    void setMemberCount(int64_t member_count) { member_count_ = member_count; }
+    void setMessageCount(int64_t message_count) { message_count_ = message_count; }
+    void setLastActivity(int64_t last_activity) { last_activity_ = last_activity; }
 
     // JSON转换
     json toJson() const;
@@ -21,6 +21,15 @@ void MessageService::registerRoutes(http::HttpServer &server)
         .use_auth_middleware = true // 使用认证中间件
     };
     server.addHandler(route);
+
+    server.addHandler({
+        .path = "/api/v1/messages/search",
+        .method = "GET",
+        .handler = [this](const http::HttpRequest &request) {
+            return searchMessages(request);
+        },
+        .use_auth_middleware = true
+    });
 }
 
 std::optional<std::string> MessageService::getUserIdFromRequest(const http::HttpRequest &request)
@@ -59,18 +68,7 @@ http::HttpResponse MessageService::getMessages(const http::HttpRequest &request)
         return http::HttpResponse::BadRequest().withJsonBody(error_response);
     }
     std::string room_id = room_id_it->second;
-    
-    // 检查房间是否存在
-    if (!db_manager_.roomExists(room_id))
-    {
-        LOG_ERROR << "Room with ID '" << room_id << "' does not exist.";
-        json error_response = {
-            {"success", false},
-            {"message", "Room not found"},
-            {"error", "Room with ID '" + room_id + "' does not exist"}
-        };
-        return http::HttpResponse::NotFound().withJsonBody(error_response);
-    }
+
     int limit = 50; // 默认值
     if(auto limit_opt=request.getQueryParam("limit"))
     {
@@ -91,13 +89,110 @@ http::HttpResponse MessageService::getMessages(const http::HttpRequest &request)
         }
     }
 
-    //确认用户是该房间的成员
-    auto menbers = db_manager_.getRoomMembers(room_id);
-    if(std::find_if(menbers.begin(), menbers.end(), [&](const json& member) {
-        return member["id"] == user_id;  // 注意：这里应该是 "id" 而不是 "user_id"
-    }) == menbers.end())
+    // before 为消息ID，用于向前翻页；不带 before 时返回最新的消息
+    int64_t before_id = 0;
+    if(auto before_opt=request.getQueryParam("before"))
+    {
+        auto result = std::from_chars(before_opt->data(), before_opt->data() + before_opt->size(), before_id);
+        if(result.ec != std::errc() || before_id < 0)
+        {
+            LOG_WARN << "Invalid before parameter: " << std::string(before_opt->data(), before_opt->size()) << ". Ignoring it.";
+            before_id = 0;
+        }
+    }
+
+    try
+    {
+        // 房间校验、成员校验和取消息一次完成：最新一页优先走热消息缓存，消息已经预先序列化
+        std::vector<std::string> message_jsons;
+        MembershipStatus status = db_manager_.getMessagePageIfMember(room_id, user_id, limit, before_id, message_jsons);
+        if(status == MembershipStatus::RoomNotFound)
+        {
+            LOG_ERROR << "Room with ID '" << room_id << "' does not exist.";
+            json error_response = {
+                {"success", false},
+                {"message", "Room not found"},
+                {"error", "Room with ID '" + room_id + "' does not exist"}
+            };
+            return http::HttpResponse::NotFound().withJsonBody(error_response);
+        }
+        if(status == MembershipStatus::NotMember)
+        {
+            LOG_ERROR << "User " << user_id << " is not a member of room " << room_id;
+            json error_response = {
+                {"success", false},
+                {"message", "Access denied"},
+                {"error", "You are not a member of this room"}
+            };
+            return http::HttpResponse::Forbidden().withJsonBody(error_response);
+        }
+
+        // 直接拼接预序列化的消息，避免重新构建JSON DOM
+        std::string body = R"({"success":true,"message":"Messages retrieved successfully","data":{"messages":[)";
+        for(size_t i = 0; i < message_jsons.size(); ++i)
+        {
+            if(i > 0) body += ',';
+            body += message_jsons[i];
+        }
+        body += R"(],"room_id":)" + json(room_id).dump();
+        body += R"(,"count":)" + std::to_string(message_jsons.size()) + "}}";
+        return http::HttpResponse::Ok().withBody(body, "application/json; charset=utf-8");
+    }
+    catch(const std::exception& e)
+    {
+        LOG_ERROR << "Failed to retrieve messages for room " << room_id << ": " << e.what();
+        json error_response = {
+            {"success", false},
+            {"message", "Failed to retrieve messages"},
+            {"error", e.what()}
+        };
+        return http::HttpResponse::InternalError().withJsonBody(error_response);
+    }
+
+}
+
+// GET /api/v1/messages/search?room_id=...&q=...&limit=...&offset=...
+http::HttpResponse MessageService::searchMessages(const http::HttpRequest &request)
+{
+    auto user_id_opt = getUserIdFromRequest(request);
+    if(!user_id_opt)
+    {
+        json error_response = {
+            {"success", false},
+            {"message", "Authentication required"},
+            {"error", "User is not authenticated"}
+        };
+        return http::HttpResponse::Unauthorized().withJsonBody(error_response);
+    }
+
+    auto room_id_opt = request.getQueryParam("room_id");
+    auto query_opt = request.getQueryParam("q");
+    if(!room_id_opt || !query_opt || query_opt->find_first_not_of(" \t") == std::string_view::npos)
+    {
+        json error_response = {
+            {"success", false},
+            {"message", "Missing required parameter"},
+            {"error", "Both 'room_id' and a non-empty 'q' query parameter are required"}
+        };
+        return http::HttpResponse::BadRequest().withJsonBody(error_response);
+    }
+    std::string room_id(*room_id_opt);
+    std::string query(*query_opt);
+
+    // 与读取消息历史相同，只有房间成员可以搜索；房间是否存在和成员关系一次查出
+    MembershipStatus status = db_manager_.checkMembership(room_id, *user_id_opt);
+    if (status == MembershipStatus::RoomNotFound)
+    {
+        json error_response = {
+            {"success", false},
+            {"message", "Room not found"},
+            {"error", "Room with ID '" + room_id + "' does not exist"}
+        };
+        return http::HttpResponse::NotFound().withJsonBody(error_response);
+    }
+
+    if(status == MembershipStatus::NotMember)
     {
-        LOG_ERROR << "User " << user_id << " is not a member of room " << room_id;
         json error_response = {
             {"success", false},
             {"message", "Access denied"},
@@ -105,42 +200,63 @@ http::HttpResponse MessageService::getMessages(const http::HttpRequest &request)
         };
         return http::HttpResponse::Forbidden().withJsonBody(error_response);
     }
-    //从数据库获取消息
+
+    int limit = 20;
+    if(auto limit_opt = request.getQueryParam("limit"))
+    {
+        auto result = std::from_chars(limit_opt->data(), limit_opt->data() + limit_opt->size(), limit);
+        if(result.ec != std::errc() || limit <= 0 || limit > 100)
+        {
+            LOG_WARN << "Invalid limit value: " << std::string(limit_opt->data(), limit_opt->size()) << ". Using default value of 20.";
+            limit = 20;
+        }
+    }
+    int offset = 0;
+    if(auto offset_opt = request.getQueryParam("offset"))
+    {
+        auto result = std::from_chars(offset_opt->data(), offset_opt->data() + offset_opt->size(), offset);
+        if(result.ec != std::errc() || offset < 0)
+        {
+            LOG_WARN << "Invalid offset value: " << std::string(offset_opt->data(), offset_opt->size()) << ". Ignoring it.";
+            offset = 0;
+        }
+    }
+
     try
     {
-        auto messages = db_manager_.getMessages(room_id, limit);
-        
-        // 将 Message 对象转换为 JSON
-        json message_json_array = json::array();
-        std::transform(
-            messages.begin(),
-            messages.end(),
-            std::back_inserter(message_json_array),
-            [](const auto &message) {
-                return message.toJson();
-            }
-        );
-        
-        json response_data = {
+        json messages = json::array();
+        bool partial = false;
+        for(const auto &message : db_manager_.searchMessages(room_id, query, limit, offset, &partial))
+        {
+            messages.push_back(message.toJson());
+        }
+
+        json data = {
+            {"messages", messages},
+            {"room_id", room_id},
+            {"query", query},
+            {"count", messages.size()},
+            {"offset", offset},
+            {"partial", partial}
+        };
+        // 返回满一页时可能还有更多结果
+        data["next_offset"] = messages.size() == static_cast<size_t>(limit) ? json(offset + limit) : json(nullptr);
+
+        json response = {
             {"success", true},
-            {"message", "Messages retrieved successfully"},
-            {"data", {
-                {"messages", message_json_array},
-                {"room_id", room_id},
-                {"count", messages.size()}
-            }}
+            {"message", "Messages searched successfully"},
+            {"data", data}
         };
-        return http::HttpResponse::Ok().withJsonBody(response_data);
+        return http::HttpResponse::Ok().withJsonBody(response);
     }
     catch(const std::exception& e)
     {
-        LOG_ERROR << "Failed to retrieve messages for room " << room_id << ": " << e.what();
+        LOG_ERROR << "Failed to search messages for room " << room_id << ": " << e.what();
         json error_response = {
             {"success", false},
-            {"message", "Failed to retrieve messages"},
+            {"message", "Failed to search messages"},
             {"error", e.what()}
         };
         return http::HttpResponse::InternalError().withJsonBody(error_response);
     }
-
-}
\ No newline at end of file
+}
@@ -17,5 +17,6 @@ public:
 private:
     DatabaseManager &db_manager_; // 数据库管理器引用
     http::HttpResponse getMessages(const http::HttpRequest &request); // 获取消息列表
+    http::HttpResponse searchMessages(const http::HttpRequest &request); // 在房间内全文搜索消息
     std::optional<std::string> getUserIdFromRequest(const http::HttpRequest& request);
 };
\ No newline at end of file
@@ -4,8 +4,11 @@
 #include "http/http_request.hpp"
 #include "http/http_response.hpp"
 #include "utils/logger.hpp"
+#include "utils/json_writer.hpp"
 #include "utils/jwt_utils.hpp"
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <charconv>
 #include <cstdlib>
 #include <optional>
 #include <chrono>
@@ -71,6 +74,14 @@ void RoomService::registerRoutes(http::HttpServer &server)
         .handler = [this](const http::HttpRequest &request) { return handleDeleteRoom(request); },
         .use_auth_middleware = true
     });
+
+    // 注册设置房间消息保留策略的路由
+    server.addHandler({
+        .path = "/api/v1/rooms/{room_id}/retention",
+        .method = "PUT",
+        .handler = [this](const http::HttpRequest &request) { return handleUpdateRoomRetention(request); },
+        .use_auth_middleware = true
+    });
 }
 
 std::optional<std::string> RoomService::getUserIdFromRequest(const http::HttpRequest &request)
@@ -207,8 +218,13 @@ http::HttpResponse RoomService::handleJoinRoom(const http::HttpRequest &request)
             return http::HttpResponse::BadRequest().withJsonBody(error_response);
         }
         
-        // 检查房间是否存在
-        if (!db_manager_.roomExists(room_id)) {
+        // 房间和用户的校验与加入在同一个事务中完成
+        switch (db_manager_.joinRoom(room_id, user_id))
+        {
+        case JoinResult::Joined:
+            break;
+        case JoinResult::RoomNotFound:
+        {
             LOG_ERROR << "Room not found: " << room_id;
             json error_response = {
                 {"success", false},
@@ -217,26 +233,7 @@ http::HttpResponse RoomService::handleJoinRoom(const http::HttpRequest &request)
             };
             return http::HttpResponse::NotFound().withJsonBody(error_response);
         }
-
-        //检查房间和用户是否存在
-        bool room_exists = db_manager_.roomExists(room_id);
-        bool user_exists = db_manager_.userExists(user_id);
-        
-        LOG_INFO << "Room exists check - Room ID: " << room_id << ", exists: " << room_exists;
-        LOG_INFO << "User exists check - User ID: " << user_id << ", exists: " << user_exists;
-        
-        if(!room_exists)
-        {
-            LOG_ERROR << "Room does not exist. Room ID: " << room_id;
-            json error_response = {
-                {"success", false},
-                {"message", "Room does not exist"},
-                {"error", "Invalid room ID"}
-            };
-            return http::HttpResponse::NotFound().withJsonBody(error_response);
-        }
-        
-        if(!user_exists)
+        case JoinResult::UserNotFound:
         {
             LOG_ERROR << "User does not exist. User ID: " << user_id;
             json error_response = {
@@ -246,9 +243,7 @@ http::HttpResponse RoomService::handleJoinRoom(const http::HttpRequest &request)
             };
             return http::HttpResponse::NotFound().withJsonBody(error_response);
         }
-
-        //将用户加入房间
-        if (!db_manager_.addRoomMember(room_id, user_id))
+        default:
         {
             LOG_ERROR << "Failed to add user to room. Room ID: " << room_id << ", User ID: " << user_id;
             json error_response = {
@@ -258,6 +253,7 @@ http::HttpResponse RoomService::handleJoinRoom(const http::HttpRequest &request)
             };
             return http::HttpResponse::InternalError().withJsonBody(error_response);
         }
+        }
 
         // 成功加入房间
         LOG_INFO << "User " << user_id << " successfully joined room " << room_id;
@@ -313,87 +309,77 @@ http::HttpResponse RoomService::handleGetRooms(const http::HttpRequest &request)
 {
     try
     {
-        // 获取查询参数
+        // 获取查询参数：after 为上一页最后一个房间的ID，limit 超过上限时按上限返回
+        const int MAX_PAGE_SIZE = 100;
         int limit = 50; // 默认限制
-        int offset = 0; // 默认偏移量
+        std::string after;
 
         if (auto limit_opt = request.getQueryParam("limit"))
         {
-            try
+            auto result = std::from_chars(limit_opt->data(), limit_opt->data() + limit_opt->size(), limit);
+            if (result.ec != std::errc() || limit <= 0)
             {
-                std::string limit_str(limit_opt->data(), limit_opt->size());
-                limit = std::stoi(limit_str);
-                if (limit <= 0 || limit > 100) // 限制在1到100之间
-                {
-                    LOG_WARN << "Invalid limit value: " << limit << ". Using default value of 50.";
-                    limit = 50;
-                }
-            }
-            catch (const std::exception& e)
-            {
-                LOG_ERROR << "Invalid limit parameter. Using default value of 50.";
+                LOG_WARN << "Invalid limit value: " << std::string(limit_opt->data(), limit_opt->size()) << ". Using default value of 50.";
                 limit = 50;
             }
+            limit = std::min(limit, MAX_PAGE_SIZE);
+        }
+
+        if (auto after_opt = request.getQueryParam("after"))
+        {
+            after.assign(after_opt->data(), after_opt->size());
         }
 
-        if (auto offset_opt = request.getQueryParam("offset"))
+        // 按游标定位后只读一页（多读一行判断是否还有下一页），逐行直接写进响应体
+        DatabaseManager &db = db_manager_;
+        return http::HttpResponse::Ok().withStreamBody([&db, limit, after](const http::BodySink &sink)
         {
-            try
+            utils::JsonWriter writer(sink);
+            writer.beginObject()
+                .key("success").value(true)
+                .key("message").value("Rooms retrieved successfully")
+                .key("data").beginObject()
+                .key("rooms").beginArray();
+
+            size_t count = 0;
+            bool has_more = false;
+            std::string last_id;
+            db.visitRooms(after, static_cast<size_t>(limit) + 1, [&](const RoomRow &row)
             {
-                std::string offset_str(offset_opt->data(), offset_opt->size());
-                offset = std::stoi(offset_str);
-                if (offset < 0)
+                if (count == static_cast<size_t>(limit))
                 {
-                    LOG_WARN << "Invalid offset value: " << offset << ". Using default value of 0.";
-                    offset = 0;
+                    has_more = true;
+                    return false;
                 }
+                writer.beginObject()
+                    .key("id").value(row.id)
+                    .key("name").value(row.name)
+                    .key("description").value(row.description)
+                    .key("creator_id").value(row.creator_id)
+                    .key("created_at").value(row.created_at)
+                    .key("member_count").value(row.member_count)
+                    .key("message_count").value(row.message_count)
+                    .key("last_activity").value(row.last_activity)
+                    .endObject();
+                last_id.assign(row.id);
+                ++count;
+                return writer.ok();
+            });
+
+            writer.endArray()
+                .key("count").value(count)
+                .key("limit").value(limit);
+            // 没有下一页时游标为 null
+            if (has_more)
+            {
+                writer.key("next_cursor").value(last_id);
             }
-            catch (const std::exception& e)
+            else
             {
-                LOG_ERROR << "Invalid offset parameter. Using default value of 0.";
-                offset = 0;
+                writer.key("next_cursor").value(nullptr);
             }
-        }
-
-        // 从数据库获取所有房间
-        auto all_rooms = db_manager_.getAllRooms();
-        
-        // 在服务层实现分页逻辑
-        size_t total_count = all_rooms.size();
-        size_t start_index = std::min(static_cast<size_t>(offset), total_count);
-        size_t end_index = std::min(start_index + static_cast<size_t>(limit), total_count);
-        
-        std::vector<Room> rooms;
-        if (start_index < total_count) {
-            rooms.assign(all_rooms.begin() + start_index, all_rooms.begin() + end_index);
-        }
-        
-        // 将Room对象转换为JSON数组，并添加成员数量
-        json rooms_json = json::array();
-        for (const auto& room : rooms) {
-            json room_json = room.toJson();
-            
-            // 获取房间成员数量
-            auto members = db_manager_.getRoomMembers(room.getId());
-            room_json["member_count"] = members.size();
-            
-            rooms_json.push_back(room_json);
-        }
-        
-        // 构造标准的JSON响应格式
-        json json_response = {
-            {"success", true},
-            {"message", "Rooms retrieved successfully"},
-            {"data", {
-                {"rooms", rooms_json},
-                {"count", rooms.size()},
-                {"total", total_count},
-                {"limit", limit},
-                {"offset", offset}
-            }}
-        };
-        
-        return http::HttpResponse::Ok().withJsonBody(json_response);
+            writer.endObject().endObject();
+        });
     }
     catch(const std::exception& e)
     {
@@ -432,13 +418,7 @@ http::HttpResponse RoomService::handleGetUserJoinedRooms(const http::HttpRequest
         // 将Room对象转换为JSON数组
         json rooms_json = json::array();
         for (const auto& room : joined_rooms) {
-            json room_json = room.toJson();
-            
-            // 获取房间成员数量（已经在getUserJoinedRooms中计算了，但为了保持一致性再次获取）
-            auto members = db_manager_.getRoomMembers(room.getId());
-            room_json["member_count"] = members.size();
-            
-            rooms_json.push_back(room_json);
+            rooms_json.push_back(room.toJson());
         }
         
         // 构造标准的JSON响应格式
@@ -786,4 +766,131 @@ http::HttpResponse RoomService::handleUpdateRoomDescription(const http::HttpRequ
         };
         return http::HttpResponse::InternalError().withJsonBody(error_response);
     }
-}
\ No newline at end of file
+}
+http::HttpResponse RoomService::handleUpdateRoomRetention(const http::HttpRequest &request)
+{
+    // 获取当前用户的ID
+    auto user_id_opt = getUserIdFromRequest(request);
+    if (!user_id_opt)
+    {
+        LOG_ERROR << "Failed to get user ID from request.";
+        json error_response = {
+            {"success", false},
+            {"message", "Authentication required"},
+            {"error", "Invalid or missing JWT token"}
+        };
+        return http::HttpResponse::Unauthorized().withJsonBody(error_response);
+    }
+
+    std::string user_id = *user_id_opt;
+
+    try
+    {
+        auto room_id_opt = request.getPathParam("room_id");
+        if (!room_id_opt)
+        {
+            LOG_ERROR << "Missing room_id path parameter";
+            json error_response = {
+                {"success", false},
+                {"message", "Room ID is required"},
+                {"error", "Missing room_id path parameter"}
+            };
+            return http::HttpResponse::BadRequest().withJsonBody(error_response);
+        }
+
+        std::string room_id = std::string(*room_id_opt);
+        auto json_body = json::parse(request.getBody());
+
+        // 只有房间创建者可以修改保留策略
+        auto room_info = db_manager_.getRoomById(room_id);
+        if (!room_info)
+        {
+            LOG_ERROR << "Room not found: " << room_id;
+            json error_response = {
+                {"success", false},
+                {"message", "Room not found"},
+                {"error", "Invalid room ID"}
+            };
+            return http::HttpResponse::NotFound().withJsonBody(error_response);
+        }
+        if (room_info->getCreatorId() != user_id)
+        {
+            LOG_ERROR << "User " << user_id << " is not the creator of room " << room_id;
+            json error_response = {
+                {"success", false},
+                {"message", "Access denied"},
+                {"error", "Only the room creator can update the retention policy"}
+            };
+            return http::HttpResponse::Forbidden().withJsonBody(error_response);
+        }
+
+        // {"inherit": true} 表示删除房间策略，恢复使用全局策略
+        MessageRetention &retention = db_manager_.getRetention();
+        bool updated;
+        if (json_body.value("inherit", false))
+        {
+            updated = retention.clearRoomPolicy(room_id);
+        }
+        else
+        {
+            int64_t max_age_seconds = json_body.value("max_age_seconds", static_cast<int64_t>(0));
+            int64_t max_messages = json_body.value("max_messages", static_cast<int64_t>(0));
+            if (max_age_seconds < 0 || max_messages < 0)
+            {
+                json error_response = {
+                    {"success", false},
+                    {"message", "max_age_seconds and max_messages must not be negative"},
+                    {"error", "Invalid retention policy"}
+                };
+                return http::HttpResponse::BadRequest().withJsonBody(error_response);
+            }
+            RetentionPolicy policy;
+            policy.max_age = std::chrono::seconds(max_age_seconds);
+            policy.max_messages = static_cast<size_t>(max_messages);
+            updated = retention.setRoomPolicy(room_id, policy);
+        }
+
+        if (!updated)
+        {
+            LOG_ERROR << "Failed to update retention policy for room: " << room_id;
+            json error_response = {
+                {"success", false},
+                {"message", "Failed to update retention policy"},
+                {"error", "Database operation failed"}
+            };
+            return http::HttpResponse::InternalError().withJsonBody(error_response);
+        }
+
+        LOG_INFO << "Room " << room_id << " retention policy updated by user " << user_id;
+        json response_data = {
+            {"success", true},
+            {"message", "Retention policy updated successfully"},
+            {"data", {
+                {"room_id", room_id},
+                {"inherited", !retention.getRoomPolicy(room_id).has_value()},
+                {"policy", retention.getEffectivePolicy(room_id).toJson()}
+            }}
+        };
+        return http::HttpResponse::Ok().withJsonBody(response_data);
+    }
+    catch(const json::exception &e)
+    {
+        LOG_ERROR << "Invalid retention policy body: " << e.what();
+        json error_response = {
+            {"success", false},
+            {"message", "Invalid JSON format"},
+            {"error", e.what()}
+        };
+        return http::HttpResponse::BadRequest().withJsonBody(error_response);
+    }
+    catch(const std::exception& e)
+    {
+        LOG_ERROR << "Failed to update retention policy, Error: " << e.what();
+        json error_response = {
+            {"success", false},
+            {"message", "Failed to update retention policy"},
+            {"error", e.what()}
+        };
+        return http::HttpResponse::InternalError().withJsonBody(error_response);
+    }
+}
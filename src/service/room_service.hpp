@@ -26,6 +26,7 @@ private:
     http::HttpResponse handleGetUserJoinedRooms(const http::HttpRequest &request);//获取用户已加入的房间，需要验证
     http::HttpResponse handleDeleteRoom(const http::HttpRequest &request);//删除房间，需要验证创建者身份
     http::HttpResponse handleUpdateRoomDescription(const http::HttpRequest &request);//更改房间描述，需要验证创建者身份
+    http::HttpResponse handleUpdateRoomRetention(const http::HttpRequest &request);//设置房间消息保留策略，需要验证创建者身份
     
     // 房间成员管理
     http::HttpResponse handleJoinRoom(const http::HttpRequest &request);//加入房间，需要验证
@@ -1,10 +1,21 @@
 #include "server_service.hpp"
 #include "../utils/logger.hpp"
+#include "../utils/jwt_utils.hpp"
 #include <nlohmann/json.hpp>
 #include <ctime>
 
 using json = nlohmann::json;
 
+// 统计会暴露 SQL、在线用户和负载情况，备份会占用磁盘并长时间占用数据库，这些内部接口只开放给配置的管理员
+static http::HttpResponse adminRequiredResponse() {
+    json error_response = {
+        {"success", false},
+        {"message", "Access denied"},
+        {"error", "Admin privileges required"}
+    };
+    return http::HttpResponse::Forbidden().withJsonBody(error_response);
+}
+
 ServerService::ServerService(DatabaseManager& db_manager) 
     : db_manager_(db_manager) {
     LOG_INFO << "ServerService initialized";
@@ -66,6 +77,59 @@ void ServerService::registerRoutes(http::HttpServer& server) {
     };
     server.addHandler(protected_route);
 
+    // 内部接口：SQL 执行统计
+    http::HttpServer::Route db_stats_route{
+        "/api/v1/internal/db-stats",
+        "GET",
+        [this](const http::HttpRequest& req) {
+            return this->handleDatabaseStats(req);
+        },
+        true // 需要认证中间件
+    };
+    server.addHandler(db_stats_route);
+
+    http::HttpServer::Route reset_db_stats_route{
+        "/api/v1/internal/db-stats",
+        "DELETE",
+        [this](const http::HttpRequest& req) {
+            return this->handleResetDatabaseStats(req);
+        },
+        true // 需要认证中间件
+    };
+    server.addHandler(reset_db_stats_route);
+
+    // 内部接口：WebSocket 出站队列和心跳统计
+    http::HttpServer::Route ws_stats_route{
+        "/api/v1/internal/ws-stats",
+        "GET",
+        [this](const http::HttpRequest& req) {
+            return this->handleWebSocketStats(req);
+        },
+        true // 需要认证中间件
+    };
+    server.addHandler(ws_stats_route);
+
+    // 内部接口：在线热备份
+    http::HttpServer::Route start_backup_route{
+        "/api/v1/internal/backup",
+        "POST",
+        [this](const http::HttpRequest& req) {
+            return this->handleStartBackup(req);
+        },
+        true // 需要认证中间件
+    };
+    server.addHandler(start_backup_route);
+
+    http::HttpServer::Route backup_progress_route{
+        "/api/v1/internal/backup",
+        "GET",
+        [this](const http::HttpRequest& req) {
+            return this->handleBackupProgress(req);
+        },
+        true // 需要认证中间件
+    };
+    server.addHandler(backup_progress_route);
+
     LOG_INFO << "ServerService routes registered successfully";
 }
 
@@ -148,3 +212,120 @@ http::HttpResponse ServerService::handleProtected(const http::HttpRequest& req)
     return http::HttpResponse::Ok()
         .withBody(response.dump(), "application/json");
 }
+
+http::HttpResponse ServerService::handleDatabaseStats(const http::HttpRequest& req) {
+    if (!isAdmin(req)) {
+        return adminRequiredResponse();
+    }
+    json response = {
+        {"success", true},
+        {"message", "Database statistics retrieved successfully"},
+        {"data", {
+            {"connections", db_manager_.getQueryStats()},
+            {"timestamp", std::time(nullptr)}
+        }}
+    };
+
+    return http::HttpResponse::Ok()
+        .withBody(response.dump(), "application/json");
+}
+
+http::HttpResponse ServerService::handleResetDatabaseStats(const http::HttpRequest& req) {
+    if (!isAdmin(req)) {
+        return adminRequiredResponse();
+    }
+    // 返回清零前的统计，便于按时间段观察
+    json response = {
+        {"success", true},
+        {"message", "Database statistics reset successfully"},
+        {"data", {
+            {"connections", db_manager_.getQueryStats()},
+            {"timestamp", std::time(nullptr)}
+        }}
+    };
+    db_manager_.resetQueryStats();
+
+    return http::HttpResponse::Ok()
+        .withBody(response.dump(), "application/json");
+}
+
+void ServerService::setWebSocketStatsProvider(std::function<nlohmann::json()> provider) {
+    ws_stats_provider_ = std::move(provider);
+}
+
+http::HttpResponse ServerService::handleWebSocketStats(const http::HttpRequest& req) {
+    if (!isAdmin(req)) {
+        return adminRequiredResponse();
+    }
+    json stats = ws_stats_provider_ ? ws_stats_provider_() : json(nullptr);
+    if (stats.is_null()) {
+        json error_response = {
+            {"success", false},
+            {"message", "WebSocket server is not running"}
+        };
+        return http::HttpResponse::BadRequest().withJsonBody(error_response);
+    }
+
+    json response = {
+        {"success", true},
+        {"message", "WebSocket statistics retrieved successfully"},
+        {"data", stats}
+    };
+    response["data"]["timestamp"] = std::time(nullptr);
+    return http::HttpResponse::Ok()
+        .withBody(response.dump(), "application/json");
+}
+
+void ServerService::setAdminUsers(std::unordered_set<std::string> admin_users) {
+    admin_users_ = std::move(admin_users);
+}
+
+bool ServerService::isAdmin(const http::HttpRequest& req) const {
+    auto user_id = JwtUtils::getUserIdFromRequest(req);
+    return user_id && admin_users_.count(*user_id) > 0;
+}
+
+http::HttpResponse ServerService::handleStartBackup(const http::HttpRequest& req) {
+    if (!isAdmin(req)) {
+        return adminRequiredResponse();
+    }
+    // 备份路径由服务端生成，不接受客户端指定，避免通过接口覆盖任意文件
+    DatabaseBackup& backup = db_manager_.getBackup();
+    std::string destination = backup.defaultDestination();
+    if (destination.empty()) {
+        json error_response = {
+            {"success", false},
+            {"message", "Backup is not supported by the current storage engine"}
+        };
+        return http::HttpResponse::BadRequest().withJsonBody(error_response);
+    }
+    if (!backup.start(destination)) {
+        json error_response = {
+            {"success", false},
+            {"message", "A backup is already running"},
+            {"data", backup.getProgress().toJson()}
+        };
+        return http::HttpResponse().withStatus(409).withJsonBody(error_response);
+    }
+
+    json response = {
+        {"success", true},
+        {"message", "Backup started"},
+        {"data", backup.getProgress().toJson()}
+    };
+    return http::HttpResponse::Ok()
+        .withBody(response.dump(), "application/json");
+}
+
+http::HttpResponse ServerService::handleBackupProgress(const http::HttpRequest& req) {
+    if (!isAdmin(req)) {
+        return adminRequiredResponse();
+    }
+    json response = {
+        {"success", true},
+        {"message", "Backup progress retrieved successfully"},
+        {"data", db_manager_.getBackup().getProgress().toJson()}
+    };
+    return http::HttpResponse::Ok()
+        .withBody(response.dump(), "application/json");
+}
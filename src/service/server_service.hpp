@@ -4,6 +4,10 @@
 #include "../http/http_request.hpp"
 #include "../http/http_response.hpp"
 #include "../db/database_manager.hpp"
+#include <nlohmann/json.hpp>
+#include <functional>
+#include <string>
+#include <unordered_set>
 
 class ServerService {
 public:
@@ -11,8 +15,18 @@ public:
     
     void registerRoutes(http::HttpServer& server);
 
+    // WebSocket 连接统计（出站队列、心跳）的来源，WebSocket 服务器在 HTTP 服务之后创建
+    void setWebSocketStatsProvider(std::function<nlohmann::json()> provider);
+
+    // 允许调用内部统计和备份接口的管理员用户ID，为空时这些接口对所有人关闭
+    void setAdminUsers(std::unordered_set<std::string> admin_users);
+
 private:
     DatabaseManager& db_manager_;
+    std::function<nlohmann::json()> ws_stats_provider_;
+    std::unordered_set<std::string> admin_users_;
+
+    bool isAdmin(const http::HttpRequest& req) const;
     
     // 服务器相关的API处理方法
     http::HttpResponse handleHealthCheck(const http::HttpRequest& req);
@@ -20,6 +34,11 @@ private:
     http::HttpResponse handleEchoGet(const http::HttpRequest& req);
     http::HttpResponse handleEchoPost(const http::HttpRequest& req);
     http::HttpResponse handleProtected(const http::HttpRequest& req);
+    http::HttpResponse handleDatabaseStats(const http::HttpRequest& req);
+    http::HttpResponse handleResetDatabaseStats(const http::HttpRequest& req);
+    http::HttpResponse handleWebSocketStats(const http::HttpRequest& req);
+    http::HttpResponse handleStartBackup(const http::HttpRequest& req);
+    http::HttpResponse handleBackupProgress(const http::HttpRequest& req);
     
     // 服务器版本和信息
     static constexpr const char* SERVER_NAME = "SwiftChat HTTP Server";
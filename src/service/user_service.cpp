@@ -4,8 +4,11 @@
 #include "http/http_request.hpp"
 #include "http/http_response.hpp"
 #include "utils/logger.hpp"
+#include "utils/json_writer.hpp"
 #include "utils/jwt_utils.hpp"
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <charconv>
 #include <cstdlib>
 #include <optional>
 #include <regex>
@@ -130,84 +133,68 @@ http::HttpResponse UserService::handleGetAllUsers(const http::HttpRequest &reque
 
     try
     {
-        // 获取查询参数
+        // 获取查询参数：after 为上一页最后一个用户的ID，limit 超过上限时按上限返回
+        const int MAX_PAGE_SIZE = 100;
         int limit = 50; // 默认限制
-        int offset = 0; // 默认偏移量
+        std::string after;
 
         if (auto limit_opt = request.getQueryParam("limit"))
         {
-            try
+            auto result = std::from_chars(limit_opt->data(), limit_opt->data() + limit_opt->size(), limit);
+            if (result.ec != std::errc() || limit <= 0)
             {
-                std::string limit_str(limit_opt->data(), limit_opt->size());
-                limit = std::stoi(limit_str);
-                if (limit <= 0 || limit > 100) // 限制在1到100之间
-                {
-                    LOG_WARN << "Invalid limit value: " << limit << ". Using default value of 50.";
-                    limit = 50;
-                }
-            }
-            catch (const std::exception& e)
-            {
-                LOG_ERROR << "Invalid limit parameter. Using default value of 50.";
+                LOG_WARN << "Invalid limit value: " << std::string(limit_opt->data(), limit_opt->size()) << ". Using default value of 50.";
                 limit = 50;
             }
+            limit = std::min(limit, MAX_PAGE_SIZE);
         }
 
-        if (auto offset_opt = request.getQueryParam("offset"))
+        if (auto after_opt = request.getQueryParam("after"))
         {
-            try
+            after.assign(after_opt->data(), after_opt->size());
+        }
+
+        // 按游标定位后只读一页（多读一行判断是否还有下一页），逐行直接写进响应体
+        DatabaseManager &db = db_manager_;
+        return http::HttpResponse::Ok().withStreamBody([&db, limit, after](const http::BodySink &sink)
+        {
+            utils::JsonWriter writer(sink);
+            writer.beginObject()
+                .key("success").value(true)
+                .key("message").value("Users list retrieved successfully")
+                .key("data").beginObject()
+                .key("users").beginArray();
+
+            size_t count = 0;
+            bool has_more = false;
+            std::string last_id;
+            db.visitUsers(after, static_cast<size_t>(limit) + 1, [&](const UserRow &row)
             {
-                std::string offset_str(offset_opt->data(), offset_opt->size());
-                offset = std::stoi(offset_str);
-                if (offset < 0)
+                if (count == static_cast<size_t>(limit))
                 {
-                    LOG_WARN << "Invalid offset value: " << offset << ". Using default value of 0.";
-                    offset = 0;
+                    has_more = true;
+                    return false;
                 }
+                writer.beginObject().key("id").value(row.id).key("username").value(row.username).endObject();
+                last_id.assign(row.id);
+                ++count;
+                return writer.ok();
+            });
+
+            writer.endArray()
+                .key("count").value(count)
+                .key("limit").value(limit);
+            // 没有下一页时游标为 null
+            if (has_more)
+            {
+                writer.key("next_cursor").value(last_id);
             }
-            catch (const std::exception& e)
+            else
             {
-                LOG_ERROR << "Invalid offset parameter. Using default value of 0.";
-                offset = 0;
+                writer.key("next_cursor").value(nullptr);
             }
-        }
-
-        // 从数据库获取用户列表
-        auto all_users = db_manager_.getAllUsers();
-        
-        // 在服务层实现分页逻辑
-        size_t total_count = all_users.size();
-        size_t start_index = std::min(static_cast<size_t>(offset), total_count);
-        size_t end_index = std::min(start_index + static_cast<size_t>(limit), total_count);
-        
-        std::vector<User> users;
-        if (start_index < total_count) {
-            users.assign(all_users.begin() + start_index, all_users.begin() + end_index);
-        }
-        
-        // 将用户对象转换为JSON数组，不包含敏感信息
-        json users_json_array = json::array();
-        for (const auto& user : users)
-        {
-            json user_json = user.toJson();
-            // 移除密码字段（如果存在）
-            user_json.erase("password");
-            user_json.erase("password_hash");
-            users_json_array.push_back(user_json);
-        }
-
-        json response_data = {
-            {"success", true},
-            {"message", "Users list retrieved successfully"},
-            {"data", {
-                {"users", users_json_array},
-                {"count", users.size()},
-                {"total", total_count},
-                {"limit", limit},
-                {"offset", offset}
-            }}
-        };
-        return http::HttpResponse::Ok().withJsonBody(response_data);
+            writer.endObject().endObject();
+        });
     }
     catch (const std::exception& e)
     {
@@ -0,0 +1,174 @@
+#include "json_writer.hpp"
+
+namespace utils
+{
+    JsonWriter::JsonWriter(Sink sink, size_t flush_threshold)
+        : sink_(std::move(sink)), flush_threshold_(flush_threshold)
+    {
+        buffer_.reserve(flush_threshold_ + 256);
+    }
+
+    JsonWriter::~JsonWriter()
+    {
+        flush();
+    }
+
+    JsonWriter &JsonWriter::beginObject()
+    {
+        separate();
+        buffer_ += '{';
+        has_element_.push_back(false);
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::endObject()
+    {
+        buffer_ += '}';
+        has_element_.pop_back();
+        maybeFlush();
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::beginArray()
+    {
+        separate();
+        buffer_ += '[';
+        has_element_.push_back(false);
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::endArray()
+    {
+        buffer_ += ']';
+        has_element_.pop_back();
+        maybeFlush();
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::key(std::string_view name)
+    {
+        separate();
+        appendEscaped(name);
+        buffer_ += ':';
+        after_key_ = true;
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::value(std::string_view text)
+    {
+        separate();
+        appendEscaped(text);
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::integer(int64_t number)
+    {
+        separate();
+        buffer_ += std::to_string(number);
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::value(bool flag)
+    {
+        separate();
+        buffer_ += flag ? "true" : "false";
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::value(std::nullptr_t)
+    {
+        separate();
+        buffer_ += "null";
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::raw(std::string_view json)
+    {
+        separate();
+        buffer_.append(json);
+        maybeFlush();
+        return *this;
+    }
+
+    bool JsonWriter::flush()
+    {
+        if (ok_ && !buffer_.empty())
+        {
+            ok_ = sink_(buffer_);
+        }
+        buffer_.clear();
+        return ok_;
+    }
+
+    void JsonWriter::separate()
+    {
+        // 键之后的值不需要逗号
+        if (after_key_)
+        {
+            after_key_ = false;
+            return;
+        }
+        if (!has_element_.empty())
+        {
+            if (has_element_.back())
+            {
+                buffer_ += ',';
+            }
+            has_element_.back() = true;
+        }
+    }
+
+    void JsonWriter::appendEscaped(std::string_view text)
+    {
+        static const char HEX[] = "0123456789abcdef";
+        buffer_ += '"';
+        for (char c : text)
+        {
+            switch (c)
+            {
+            case '"':
+                buffer_ += "\\\"";
+                break;
+            case '\\':
+                buffer_ += "\\\\";
+                break;
+            case '\n':
+                buffer_ += "\\n";
+                break;
+            case '\r':
+                buffer_ += "\\r";
+                break;
+            case '\t':
+                buffer_ += "\\t";
+                break;
+            case '\b':
+                buffer_ += "\\b";
+                break;
+            case '\f':
+                buffer_ += "\\f";
+                break;
+            default:
+                // 其余控制字符转成 \u00XX，UTF-8 多字节字符原样写入
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    buffer_ += "\\u00";
+                    buffer_ += HEX[(c >> 4) & 0x0F];
+                    buffer_ += HEX[c & 0x0F];
+                }
+                else
+                {
+                    buffer_ += c;
+                }
+            }
+        }
+        buffer_ += '"';
+    }
+
+    void JsonWriter::maybeFlush()
+    {
+        if (buffer_.size() >= flush_threshold_)
+        {
+            flush();
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace utils
+{
+    // 流式 JSON 写入器：不构建 nlohmann::json 对象，直接把值序列化到缓冲区，
+    // 缓冲区超过阈值时整块交给 sink，适合把数据库查询结果逐行写进响应体
+    class JsonWriter
+    {
+    public:
+        // sink 返回 false 表示下游已关闭，之后的写入都会被丢弃
+        using Sink = std::function<bool(std::string_view)>;
+
+        explicit JsonWriter(Sink sink, size_t flush_threshold = 16 * 1024);
+        ~JsonWriter();
+
+        JsonWriter &beginObject();
+        JsonWriter &endObject();
+        JsonWriter &beginArray();
+        JsonWriter &endArray();
+        JsonWriter &key(std::string_view name);
+
+        JsonWriter &value(std::string_view text);
+        JsonWriter &value(const char *text) { return value(std::string_view(text)); }
+        JsonWriter &value(bool flag);
+        JsonWriter &value(std::nullptr_t);
+        // 各种整数类型统一按 int64_t 写出，避免与 bool 重载产生歧义
+        template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+        JsonWriter &value(T number) { return integer(static_cast<int64_t>(number)); }
+        // 已经序列化好的 JSON 片段，原样写入
+        JsonWriter &raw(std::string_view json);
+
+        // 把缓冲区交给 sink，返回下游是否仍然可写
+        bool flush();
+        bool ok() const { return ok_; }
+
+    private:
+        JsonWriter &integer(int64_t number);
+        void separate(); // 在同一层的第二个及之后的元素前写逗号
+        void appendEscaped(std::string_view text);
+        void maybeFlush();
+
+        Sink sink_;
+        size_t flush_threshold_;
+        std::string buffer_;
+        std::vector<bool> has_element_; // 每一层是否已经写过元素
+        bool after_key_ = false;
+        bool ok_ = true;
+    };
+}
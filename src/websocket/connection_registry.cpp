@@ -0,0 +1,290 @@
+#include "connection_registry.hpp"
+#include <algorithm>
+#include <functional>
+
+ConnectionRegistry::ConnectionRegistry(size_t shard_count)
+    : shard_count_(std::max<size_t>(1, shard_count)),
+      user_shards_(new UserShard[shard_count_]),
+      connection_shards_(new ConnectionShard[shard_count_]),
+      room_shards_(new RoomShard[shard_count_])
+{
+}
+
+ConnectionRegistry::Handle ConnectionRegistry::bind(const std::string &user_id, const Handle &hdl, const Features &features)
+{
+    Handle old_hdl;
+    {
+        UserShard &shard = userShard(user_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        UserEntry &entry = shard.users[user_id];
+        old_hdl = entry.hdl;
+        entry.hdl = hdl;
+        entry.features = features;
+        if (!entry.room_id.empty())
+        {
+            replaceMember(entry.room_id, {user_id, hdl, features});
+        }
+    }
+
+    // 旧连接的反向登记提前移除，它之后的关闭回调不会再影响该用户
+    if (const void *old_key = keyOf(old_hdl))
+    {
+        ConnectionShard &shard = connectionShard(old_key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.users.erase(old_key);
+    }
+    const void *key = keyOf(hdl);
+    ConnectionShard &shard = connectionShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.users[key] = user_id;
+    return old_hdl;
+}
+
+ConnectionRegistry::Handle ConnectionRegistry::bind(const std::string &user_id, const Handle &hdl)
+{
+    return bind(user_id, hdl, Features());
+}
+
+std::optional<ConnectionRegistry::Unbound> ConnectionRegistry::unbind(const Handle &hdl)
+{
+    const void *key = keyOf(hdl);
+    Unbound unbound;
+    {
+        ConnectionShard &shard = connectionShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.users.find(key);
+        if (it == shard.users.end())
+        {
+            return std::nullopt;
+        }
+        unbound.user_id = std::move(it->second);
+        shard.users.erase(it);
+    }
+
+    UserShard &shard = userShard(unbound.user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(unbound.user_id);
+    // 只有该连接仍是用户的当前连接时才注销用户；否则用户已经在别处重新登录
+    if (it == shard.users.end() || keyOf(it->second.hdl) != key)
+    {
+        return unbound;
+    }
+    unbound.left_room = std::move(it->second.room_id);
+    if (!unbound.left_room.empty())
+    {
+        removeMember(unbound.left_room, unbound.user_id);
+    }
+    shard.users.erase(it);
+    return unbound;
+}
+
+std::optional<std::string> ConnectionRegistry::userOf(const Handle &hdl) const
+{
+    const void *key = keyOf(hdl);
+    ConnectionShard &shard = connectionShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(key);
+    if (it == shard.users.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::optional<ConnectionRegistry::Features> ConnectionRegistry::featuresOf(const Handle &hdl) const
+{
+    auto user_id = userOf(hdl);
+    if (!user_id)
+    {
+        return std::nullopt;
+    }
+    const void *key = keyOf(hdl);
+    UserShard &shard = userShard(*user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(*user_id);
+    if (it == shard.users.end() || keyOf(it->second.hdl) != key)
+    {
+        return std::nullopt;
+    }
+    return it->second.features;
+}
+
+ConnectionRegistry::JoinResult ConnectionRegistry::join(const std::string &user_id, const std::string &room_id)
+{
+    JoinResult result;
+    UserShard &shard = userShard(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(user_id);
+    if (it == shard.users.end())
+    {
+        // 异步完成的加入（如 resume）可能晚于连接关闭
+        result.not_bound = true;
+        return result;
+    }
+    UserEntry &entry = it->second;
+    if (entry.room_id == room_id)
+    {
+        result.already_in_room = true;
+        return result;
+    }
+    if (!entry.room_id.empty())
+    {
+        removeMember(entry.room_id, user_id);
+        result.left_room = std::move(entry.room_id);
+    }
+    entry.room_id = room_id;
+    addMember(room_id, {user_id, entry.hdl, entry.features});
+    return result;
+}
+
+std::string ConnectionRegistry::leave(const std::string &user_id)
+{
+    UserShard &shard = userShard(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(user_id);
+    if (it == shard.users.end() || it->second.room_id.empty())
+    {
+        return "";
+    }
+    std::string room_id = std::move(it->second.room_id);
+    it->second.room_id.clear();
+    removeMember(room_id, user_id);
+    return room_id;
+}
+
+std::string ConnectionRegistry::currentRoom(const std::string &user_id) const
+{
+    UserShard &shard = userShard(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(user_id);
+    return it != shard.users.end() ? it->second.room_id : "";
+}
+
+ConnectionRegistry::Snapshot ConnectionRegistry::members(const std::string &room_id) const
+{
+    RoomShard &shard = roomShard(room_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.rooms.find(room_id);
+    if (it == shard.rooms.end())
+    {
+        return nullptr;
+    }
+    Room &room = it->second;
+    if (!room.snapshot)
+    {
+        room.snapshot = std::make_shared<const std::vector<Member>>(room.members);
+    }
+    return room.snapshot;
+}
+
+size_t ConnectionRegistry::memberCount(const std::string &room_id) const
+{
+    RoomShard &shard = roomShard(room_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.rooms.find(room_id);
+    return it != shard.rooms.end() ? it->second.members.size() : 0;
+}
+
+std::vector<ConnectionRegistry::Handle> ConnectionRegistry::connections() const
+{
+    std::vector<Handle> result;
+    for (size_t i = 0; i < shard_count_; ++i)
+    {
+        std::lock_guard<std::mutex> lock(user_shards_[i].mutex);
+        for (const auto &pair : user_shards_[i].users)
+        {
+            result.push_back(pair.second.hdl);
+        }
+    }
+    return result;
+}
+
+size_t ConnectionRegistry::connectionCount() const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < shard_count_; ++i)
+    {
+        std::lock_guard<std::mutex> lock(connection_shards_[i].mutex);
+        count += connection_shards_[i].users.size();
+    }
+    return count;
+}
+
+ConnectionRegistry::UserShard &ConnectionRegistry::userShard(const std::string &user_id) const
+{
+    return user_shards_[std::hash<std::string>()(user_id) % shard_count_];
+}
+
+ConnectionRegistry::ConnectionShard &ConnectionRegistry::connectionShard(const void *key) const
+{
+    return connection_shards_[std::hash<const void *>()(key) % shard_count_];
+}
+
+ConnectionRegistry::RoomShard &ConnectionRegistry::roomShard(const std::string &room_id) const
+{
+    return room_shards_[std::hash<std::string>()(room_id) % shard_count_];
+}
+
+void ConnectionRegistry::addMember(const std::string &room_id, const Member &member)
+{
+    RoomShard &shard = roomShard(room_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Room &room = shard.rooms[room_id];
+    room.index[member.user_id] = room.members.size();
+    room.members.push_back(member);
+    room.snapshot.reset();
+}
+
+void ConnectionRegistry::removeMember(const std::string &room_id, const std::string &user_id)
+{
+    RoomShard &shard = roomShard(room_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.rooms.find(room_id);
+    if (it == shard.rooms.end())
+    {
+        return;
+    }
+    Room &room = it->second;
+    auto pos = room.index.find(user_id);
+    if (pos == room.index.end())
+    {
+        return;
+    }
+    // 用最后一个成员填补空位，成员顺序不保证
+    size_t slot = pos->second;
+    room.index.erase(pos);
+    if (slot + 1 != room.members.size())
+    {
+        room.members[slot] = std::move(room.members.back());
+        room.index[room.members[slot].user_id] = slot;
+    }
+    room.members.pop_back();
+    // 房间空了就删除，正在遍历旧快照的广播不受影响
+    if (room.members.empty())
+    {
+        shard.rooms.erase(it);
+    }
+    else
+    {
+        room.snapshot.reset();
+    }
+}
+
+void ConnectionRegistry::replaceMember(const std::string &room_id, const Member &member)
+{
+    RoomShard &shard = roomShard(room_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.rooms.find(room_id);
+    if (it == shard.rooms.end())
+    {
+        return;
+    }
+    Room &room = it->second;
+    auto pos = room.index.find(member.user_id);
+    if (pos == room.index.end())
+    {
+        return;
+    }
+    room.members[pos->second] = member;
+    room.snapshot.reset();
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "wire_codec.hpp"
+
+// WebSocket 连接和房间在线成员的登记表
+// 用户和连接按哈希分片，每个分片一把锁；房间成员保存在可变列表中，加入/离开只做 O(1) 的修改，
+// 并让已发布的快照失效。广播读取成员时才把列表复制成新的不可变快照发布出去，两次广播之间的
+// 任意多次加入/离开只复制一次。广播只需在房间分片锁内取出快照指针，遍历和发送都不持有任何锁，
+// 也不会被同时发生的加入/离开打断。
+// 锁顺序：用户分片 -> 房间分片；连接分片不与其他锁嵌套
+class ConnectionRegistry
+{
+public:
+    using Handle = std::weak_ptr<void>; // 与 websocketpp::connection_hdl 相同
+
+    // 连接握手时协商的特性，广播时按特性分组成帧
+    struct Features
+    {
+        bool deflate = false;                  // 协商了 permessage-deflate
+        bool deflate_context_takeover = false; // 服务端保留压缩上下文，只能逐个连接压缩
+        int deflate_window_bits = 15;          // 服务端压缩窗口位数
+        WireEncoding encoding = WireEncoding::Json; // 认证时选择的消息编码
+    };
+
+    // 房间内的一个在线成员，快照中直接保存连接句柄，广播时不需要再查用户表
+    struct Member
+    {
+        std::string user_id;
+        Handle hdl;
+        Features features;
+    };
+    using Snapshot = std::shared_ptr<const std::vector<Member>>;
+
+    // 切换房间的结果
+    struct JoinResult
+    {
+        bool already_in_room = false; // 已经在该房间中，什么都没有改变
+        bool not_bound = false;       // 用户没有已认证的连接（连接已经关闭），什么都没有改变
+        std::string left_room;        // 因加入新房间而离开的原房间，没有时为空
+    };
+
+    // 连接关闭后解除的登记
+    struct Unbound
+    {
+        std::string user_id;
+        std::string left_room; // 用户离开的房间，没有时为空
+    };
+
+    explicit ConnectionRegistry(size_t shard_count = 64);
+
+    ConnectionRegistry(const ConnectionRegistry &) = delete;
+    ConnectionRegistry &operator=(const ConnectionRegistry &) = delete;
+
+    // 认证通过后绑定用户和连接，返回该用户被替换的旧连接（没有时为空句柄）。
+    // 用户仍留在原来的房间中，房间快照里的连接和特性同时换成新连接的
+    Handle bind(const std::string &user_id, const Handle &hdl, const Features &features);
+    Handle bind(const std::string &user_id, const Handle &hdl);
+    // 连接关闭时解除绑定；连接已经被新的登录替换时返回空
+    std::optional<Unbound> unbind(const Handle &hdl);
+    // 连接对应的已认证用户
+    std::optional<std::string> userOf(const Handle &hdl) const;
+    // 已认证连接的特性，连接未认证或已被新的登录替换时为空
+    std::optional<Features> featuresOf(const Handle &hdl) const;
+
+    // 加入房间，已在其他房间时先离开原房间
+    JoinResult join(const std::string &user_id, const std::string &room_id);
+    // 离开当前房间，返回离开的房间，不在任何房间时为空
+    std::string leave(const std::string &user_id);
+    // 用户当前所在的房间，不在任何房间时为空
+    std::string currentRoom(const std::string &user_id) const;
+
+    // 房间在线成员快照，房间没有在线成员时为空指针。成员变化后第一次调用时发布新快照
+    Snapshot members(const std::string &room_id) const;
+    // 房间在线成员数，不发布快照
+    size_t memberCount(const std::string &room_id) const;
+    // 所有已认证连接，用于停服时逐个关闭
+    std::vector<Handle> connections() const;
+    size_t connectionCount() const;
+
+private:
+    struct UserEntry
+    {
+        Handle hdl;
+        Features features;
+        std::string room_id;
+    };
+    struct UserShard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, UserEntry> users;
+    };
+    struct ConnectionShard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<const void *, std::string> users; // 连接对象地址 -> 用户ID
+    };
+    struct Room
+    {
+        std::vector<Member> members;
+        std::unordered_map<std::string, size_t> index; // 用户ID -> members 中的下标
+        Snapshot snapshot;                             // 最近发布的快照，成员变化后置空
+    };
+    struct RoomShard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Room> rooms;
+    };
+
+    // 连接句柄按所指对象的地址定位，调用方需保证连接在调用期间仍然存活（websocketpp 的回调中总是如此）
+    static const void *keyOf(const Handle &hdl) { return hdl.lock().get(); }
+
+    UserShard &userShard(const std::string &user_id) const;
+    ConnectionShard &connectionShard(const void *key) const;
+    RoomShard &roomShard(const std::string &room_id) const;
+
+    // 在房间成员列表中加入、移除成员或替换成员的连接，调用方持有用户分片锁
+    void addMember(const std::string &room_id, const Member &member);
+    void removeMember(const std::string &room_id, const std::string &user_id);
+    void replaceMember(const std::string &room_id, const Member &member);
+
+    size_t shard_count_;
+    std::unique_ptr<UserShard[]> user_shards_;
+    std::unique_ptr<ConnectionShard[]> connection_shards_;
+    std::unique_ptr<RoomShard[]> room_shards_;
+};
@@ -0,0 +1,29 @@
+#include "frame_header.hpp"
+
+std::string FrameHeader::encode(uint8_t opcode, uint64_t payload_length, bool rsv1)
+{
+    std::string header;
+    header.reserve(10);
+    header.push_back(static_cast<char>(0x80 | (rsv1 ? 0x40 : 0) | (opcode & 0x0f))); // FIN + RSV1 + opcode
+
+    // 负载长度：<126 直接写入，<65536 用 2 字节扩展长度，否则用 8 字节，均为网络字节序
+    if (payload_length < 126)
+    {
+        header.push_back(static_cast<char>(payload_length));
+    }
+    else if (payload_length <= 0xffff)
+    {
+        header.push_back(static_cast<char>(126));
+        header.push_back(static_cast<char>((payload_length >> 8) & 0xff));
+        header.push_back(static_cast<char>(payload_length & 0xff));
+    }
+    else
+    {
+        header.push_back(static_cast<char>(127));
+        for (int shift = 56; shift >= 0; shift -= 8)
+        {
+            header.push_back(static_cast<char>((payload_length >> shift) & 0xff));
+        }
+    }
+    return header;
+}
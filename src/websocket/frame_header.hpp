@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// RFC 6455 数据帧头部编码
+// 服务端发出的帧不加掩码，同一份帧头 + 负载对所有接收者都相同，
+// 广播时只需编码一次，各连接的发送队列共享同一个已成帧的消息
+class FrameHeader
+{
+public:
+    // 编码 FIN 置位、不加掩码的单帧头部，opcode 取 websocketpp::frame::opcode 的值；
+    // rsv1 标记负载经过 permessage-deflate 压缩
+    static std::string encode(uint8_t opcode, uint64_t payload_length, bool rsv1 = false);
+};
@@ -0,0 +1,111 @@
+#include "heartbeat_wheel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+HeartbeatWheel::HeartbeatWheel(const Options &options, int64_t now_ms)
+    : options_(options), start_ms_(now_ms)
+{
+    options_.tick_ms = std::max<int64_t>(1, options_.tick_ms);
+    options_.interval_ms = std::max(options_.tick_ms, options_.interval_ms);
+    options_.max_missed = std::max(1, options_.max_missed);
+    // 任何检查时间都在一个间隔之内，槽位数覆盖一个间隔即可，不需要多圈计数
+    slots_.resize(static_cast<size_t>(options_.interval_ms / options_.tick_ms) + 2);
+}
+
+int64_t HeartbeatWheel::nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t HeartbeatWheel::dueTick(int64_t deadline_ms) const
+{
+    int64_t offset = std::max<int64_t>(0, deadline_ms - start_ms_);
+    uint64_t tick = static_cast<uint64_t>((offset + options_.tick_ms - 1) / options_.tick_ms);
+    tick = std::max(tick, current_tick_ + 1);
+    return std::min<uint64_t>(tick, current_tick_ + slots_.size() - 1);
+}
+
+HeartbeatWheel::EntryPtr HeartbeatWheel::add(const Handle &hdl, int64_t now_ms)
+{
+    auto entry = std::make_shared<Entry>(hdl, now_ms);
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_[dueTick(now_ms + options_.interval_ms) % slots_.size()].push_back(entry);
+    ++tracked_;
+    return entry;
+}
+
+void HeartbeatWheel::advance(int64_t now_ms, const Callback &ping, const Callback &evict)
+{
+    uint64_t target = now_ms > start_ms_ ? static_cast<uint64_t>((now_ms - start_ms_) / options_.tick_ms) : 0;
+    std::vector<Handle> to_ping;
+    std::vector<Handle> to_evict;
+    std::vector<EntryPtr> due;
+    std::vector<std::pair<uint64_t, EntryPtr>> rescheduled;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (current_tick_ < target)
+    {
+        ++current_tick_;
+        due.clear();
+        due.swap(slots_[current_tick_ % slots_.size()]);
+        lock.unlock();
+
+        // 槽位已经取出，处理期间新加入的连接不受影响
+        rescheduled.clear();
+        for (auto &entry : due)
+        {
+            if (entry->closed_.load(std::memory_order_relaxed))
+            {
+                --tracked_;
+                continue;
+            }
+            int64_t last_activity = entry->last_activity_ms_.load(std::memory_order_relaxed);
+            if (now_ms - last_activity < options_.interval_ms || (entry->missed_ > 0 && last_activity >= entry->pinged_ms_))
+            {
+                // 最近一个间隔内或上次 ping 之后有过活动
+                entry->missed_ = 0;
+                rescheduled.emplace_back(last_activity + options_.interval_ms, std::move(entry));
+                continue;
+            }
+            if (entry->missed_ >= options_.max_missed)
+            {
+                entry->closed_ = true;
+                to_evict.push_back(entry->hdl_);
+                --tracked_;
+                continue;
+            }
+            ++entry->missed_;
+            entry->pinged_ms_ = now_ms;
+            to_ping.push_back(entry->hdl_);
+            rescheduled.emplace_back(now_ms + options_.interval_ms, std::move(entry));
+        }
+
+        lock.lock();
+        for (auto &item : rescheduled)
+        {
+            slots_[dueTick(item.first) % slots_.size()].push_back(std::move(item.second));
+        }
+    }
+    lock.unlock();
+
+    pings_ += to_ping.size();
+    evicted_ += to_evict.size();
+    for (const auto &hdl : to_ping)
+    {
+        ping(hdl);
+    }
+    for (const auto &hdl : to_evict)
+    {
+        evict(hdl);
+    }
+}
+
+HeartbeatWheel::Stats HeartbeatWheel::stats() const
+{
+    Stats stats;
+    stats.tracked = tracked_;
+    stats.pings = pings_;
+    stats.evicted = evicted_;
+    return stats;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 连接心跳的时间轮
+// 整个服务器只有一个定时器，每个 tick 处理一个槽位；每个连接只在它的检查时间所在的槽位里出现一次。
+// 收到消息或 pong 时只更新连接自己的活动时间（一次原子写），不移动时间轮中的位置；
+// 检查时仍然活跃的连接按最后活动时间重新放入槽位，空闲满一个间隔的连接发一次 ping，
+// ping 之后有任何活动（通常是 pong）即重新计数，连续 max_missed 次 ping 之后仍无任何活动的连接被驱逐。
+// 已关闭的连接只做标记，下次轮到它所在的槽位时丢弃
+class HeartbeatWheel
+{
+public:
+    using Handle = std::weak_ptr<void>; // 与 websocketpp::connection_hdl 相同
+
+    struct Options
+    {
+        int64_t interval_ms = 30000; // 空闲多久发一次 ping
+        int max_missed = 2;          // 连续多少次 ping 无响应后驱逐
+        int64_t tick_ms = 1000;      // 时间轮精度
+    };
+
+    // 一个连接的心跳状态，连接对象和时间轮共同持有
+    class Entry
+    {
+    public:
+        Entry(const Handle &hdl, int64_t now_ms) : hdl_(hdl), last_activity_ms_(now_ms) {}
+
+        // 收到任何数据时调用
+        void touch(int64_t now_ms) { last_activity_ms_.store(now_ms, std::memory_order_relaxed); }
+        // 连接关闭时调用，时间轮随后丢弃该项
+        void close() { closed_.store(true, std::memory_order_relaxed); }
+
+    private:
+        friend class HeartbeatWheel;
+
+        Handle hdl_;
+        std::atomic<int64_t> last_activity_ms_;
+        std::atomic<bool> closed_{false};
+        int missed_ = 0;         // 以下只在时间轮处理槽位时访问
+        int64_t pinged_ms_ = 0; // 最近一次 ping 的时间
+    };
+    using EntryPtr = std::shared_ptr<Entry>;
+    using Callback = std::function<void(const Handle &)>;
+
+    struct Stats
+    {
+        size_t tracked = 0;   // 时间轮中的连接数
+        uint64_t pings = 0;   // 发出的 ping
+        uint64_t evicted = 0; // 被驱逐的连接
+    };
+
+    HeartbeatWheel(const Options &options, int64_t now_ms);
+
+    HeartbeatWheel(const HeartbeatWheel &) = delete;
+    HeartbeatWheel &operator=(const HeartbeatWheel &) = delete;
+
+    EntryPtr add(const Handle &hdl, int64_t now_ms);
+    // 推进到 now_ms，处理其间到期的槽位；ping 和 evict 在锁外调用
+    void advance(int64_t now_ms, const Callback &ping, const Callback &evict);
+
+    Stats stats() const;
+    const Options &options() const { return options_; }
+
+    // 单调时钟的毫秒数
+    static int64_t nowMs();
+
+private:
+    // 活动时间 + 间隔所在的 tick，至少是下一个 tick；调用方持有 mutex_
+    uint64_t dueTick(int64_t deadline_ms) const;
+
+    Options options_;
+    int64_t start_ms_;
+    uint64_t current_tick_ = 0;
+    std::vector<std::vector<EntryPtr>> slots_;
+    mutable std::mutex mutex_;
+    std::atomic<size_t> tracked_{0};
+    std::atomic<uint64_t> pings_{0};
+    std::atomic<uint64_t> evicted_{0};
+};
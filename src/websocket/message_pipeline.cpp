@@ -0,0 +1,69 @@
+#include "message_pipeline.hpp"
+#include "db/database_manager.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+
+MessagePipeline::MessagePipeline(DatabaseManager &db_manager, boost::asio::io_service &io_service, size_t room_strands)
+    : db_manager_(db_manager)
+{
+    for (size_t i = 0; i < std::max<size_t>(1, room_strands); ++i)
+    {
+        strands_.emplace_back(new boost::asio::io_service::strand(io_service));
+    }
+}
+
+bool MessagePipeline::submitChat(ChatMessage message, ChatCallback on_done)
+{
+    auto chat = std::make_shared<ChatMessage>(std::move(message));
+    auto result = std::make_shared<Persisted>();
+    result->username = chat->user_id;
+
+    return submit(
+        chat->room_id,
+        [this, chat, result]()
+        {
+            result->saved = db_manager_.saveMessage(chat->room_id, chat->user_id, chat->content, chat->timestamp, &result->message_id);
+            if (!result->saved)
+            {
+                return;
+            }
+
+            // 获取用户信息
+            auto user_info = db_manager_.getUserById(chat->user_id);
+            if (user_info)
+            {
+                result->username = user_info->getUsername();
+            }
+
+            // 写入热消息缓存，后续的历史消息请求可以直接命中
+            db_manager_.getMessageCache().append(
+                Message(result->message_id, chat->room_id, chat->user_id, chat->content, chat->timestamp, result->username));
+        },
+        [chat, result, on_done = std::move(on_done)]()
+        { on_done(*chat, *result); });
+}
+
+bool MessagePipeline::submit(const std::string &room_id, std::function<void()> op, std::function<void()> on_done)
+{
+    boost::asio::io_service::strand &strand = strandFor(room_id);
+    // 同一房间的任务在执行器的同一通道上串行执行，按完成顺序投递到同一个 strand，广播顺序与写入顺序一致
+    return db_manager_.getExecutor().trySubmit(
+        room_id,
+        [&strand, op = std::move(op), on_done = std::move(on_done)]()
+        {
+            try
+            {
+                op();
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR << "Database task failed: " << e.what();
+            }
+            strand.post(on_done);
+        });
+}
+
+boost::asio::io_service::strand &MessagePipeline::strandFor(const std::string &room_id)
+{
+    return *strands_[std::hash<std::string>()(room_id) % strands_.size()];
+}
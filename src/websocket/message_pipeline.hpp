@@ -0,0 +1,57 @@
+#pragma once
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 前向声明
+class DatabaseManager;
+
+// WebSocket 聊天消息的处理流水线
+// 事件循环线程只负责解析和校验；持久化和查询用户名在数据库执行器上按房间串行执行，
+// 完成后回到事件循环上按房间的 strand 执行广播。同一房间的消息从写入到广播始终保持提交顺序，
+// 不同房间之间互不等待，一次慢的数据库调用不会卡住所有连接
+class MessagePipeline
+{
+public:
+    struct ChatMessage
+    {
+        std::string room_id;
+        std::string user_id;
+        std::string content;
+        int64_t timestamp = 0;
+    };
+
+    // 持久化和补全的结果
+    struct Persisted
+    {
+        bool saved = false;
+        int64_t message_id = 0;
+        std::string username; // 查不到用户时为用户ID
+    };
+
+    using ChatCallback = std::function<void(const ChatMessage &, const Persisted &)>;
+
+    // room_strands: 房间按哈希分配到的 strand 数量
+    MessagePipeline(DatabaseManager &db_manager, boost::asio::io_service &io_service, size_t room_strands = 64);
+
+    MessagePipeline(const MessagePipeline &) = delete;
+    MessagePipeline &operator=(const MessagePipeline &) = delete;
+
+    // 保存消息、查询用户名并写入热消息缓存，完成后在房间 strand 上调用 on_done；
+    // 执行器队列已满时返回 false，调用方负责向客户端报告过载
+    bool submitChat(ChatMessage message, ChatCallback on_done);
+
+    // 与房间消息保持顺序的任意数据库操作（如进出房间通知的用户名查询）
+    bool submit(const std::string &room_id, std::function<void()> op, std::function<void()> on_done);
+
+private:
+    boost::asio::io_service::strand &strandFor(const std::string &room_id);
+
+    DatabaseManager &db_manager_;
+    std::vector<std::unique_ptr<boost::asio::io_service::strand>> strands_;
+};
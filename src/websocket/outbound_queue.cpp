@@ -0,0 +1,106 @@
+#include "outbound_queue.hpp"
+#include <algorithm>
+
+void OutboundQueue::setLimits(const Limits &limits)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    limits_ = limits;
+}
+
+bool OutboundQueue::overLimit(size_t extra_bytes, size_t transport_buffered) const
+{
+    return entries_.size() + 1 > limits_.max_messages ||
+           transport_buffered + queued_bytes_ + extra_bytes > limits_.max_bytes;
+}
+
+OutboundQueue::PushResult OutboundQueue::push(Frame frame, size_t bytes, bool droppable, size_t transport_buffered)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_)
+    {
+        return PushResult::Closed;
+    }
+
+    if (overLimit(bytes, transport_buffered))
+    {
+        if (limits_.policy == OverflowPolicy::DropOldest)
+        {
+            // 从最旧的开始丢弃可丢弃的事件，直到新帧放得下
+            for (auto it = entries_.begin(); it != entries_.end() && overLimit(bytes, transport_buffered);)
+            {
+                if (!it->droppable)
+                {
+                    ++it;
+                    continue;
+                }
+                queued_bytes_ -= it->bytes;
+                it = entries_.erase(it);
+                ++stats_.dropped_messages;
+            }
+        }
+        if (overLimit(bytes, transport_buffered))
+        {
+            if (limits_.policy == OverflowPolicy::DropOldest && droppable)
+            {
+                ++stats_.dropped_messages;
+                return PushResult::Dropped;
+            }
+            // 不可丢弃的消息放不下，连接已经跟不上了
+            closed_ = true;
+            stats_.overflowed = true;
+            stats_.dropped_messages += entries_.size() + 1;
+            entries_.clear();
+            queued_bytes_ = 0;
+            return PushResult::Overflow;
+        }
+    }
+
+    entries_.push_back({std::move(frame), bytes, droppable});
+    queued_bytes_ += bytes;
+    stats_.peak_messages = std::max(stats_.peak_messages, entries_.size());
+    stats_.peak_bytes = std::max(stats_.peak_bytes, transport_buffered + queued_bytes_);
+    if (flush_scheduled_)
+    {
+        return PushResult::Queued;
+    }
+    flush_scheduled_ = true;
+    return PushResult::ScheduleFlush;
+}
+
+std::vector<OutboundQueue::Frame> OutboundQueue::takeBatch(size_t transport_buffered, bool &more)
+{
+    std::vector<Frame> batch;
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t taken_bytes = 0;
+    while (!entries_.empty())
+    {
+        const Entry &entry = entries_.front();
+        // 传输层空闲时至少交出一帧，避免超大帧永远发不出去
+        bool idle = transport_buffered == 0 && batch.empty();
+        if (!idle && transport_buffered + taken_bytes + entry.bytes > limits_.transport_bytes)
+        {
+            break;
+        }
+        taken_bytes += entry.bytes;
+        queued_bytes_ -= entry.bytes;
+        batch.push_back(std::move(entries_.front().frame));
+        entries_.pop_front();
+    }
+    if (!batch.empty())
+    {
+        ++stats_.flushes;
+        stats_.flushed_messages += batch.size();
+    }
+    more = !entries_.empty() && !closed_;
+    flush_scheduled_ = more;
+    return batch;
+}
+
+OutboundQueue::Stats OutboundQueue::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.queued_messages = entries_.size();
+    stats.queued_bytes = queued_bytes_;
+    return stats;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 单个连接的出站队列
+// websocketpp 的发送队列没有上限，网络卡住的客户端会不断积压广播帧。发送先进入这里：
+// 同一轮事件循环内入队的帧在一次 flush 中一起交给 websocketpp，websocketpp 在写入进行中把排队的帧合并成一次写；
+// 交给传输层的字节数有上限，超出的帧留在队列中，仍然可以按策略丢弃。
+// 排队的消息数或字节数（含传输层已缓冲的字节）超过高水位时按策略丢弃最旧的可丢弃事件，或者要求关闭连接。
+// 作为 websocketpp 的 connection_base，每个连接对象自带一个队列，不需要额外的查找表
+class OutboundQueue
+{
+public:
+    using Frame = std::shared_ptr<void>; // 已构造好的 websocketpp 消息
+
+    enum class OverflowPolicy
+    {
+        DropOldest, // 丢弃最旧的可丢弃事件（如上下线通知），仍然超限时关闭连接
+        Close       // 直接关闭连接
+    };
+
+    struct Limits
+    {
+        size_t max_messages = 1024;            // 队列中的消息数上限
+        size_t max_bytes = 4 * 1024 * 1024;    // 队列和传输层缓冲的字节数上限
+        size_t transport_bytes = 256 * 1024;   // 传输层缓冲达到该字节数后，新的帧留在队列中
+        OverflowPolicy policy = OverflowPolicy::DropOldest;
+    };
+
+    enum class PushResult
+    {
+        Queued,        // 已入队，flush 已经安排过
+        ScheduleFlush, // 已入队，调用方需要安排一次 flush
+        Dropped,       // 超限，丢弃了这条可丢弃的帧
+        Overflow,      // 超限，调用方应关闭连接；之后的帧都被拒绝
+        Closed         // 已经因超限关闭，帧被拒绝
+    };
+
+    // 队列深度统计
+    struct Stats
+    {
+        size_t queued_messages = 0;
+        size_t queued_bytes = 0;
+        size_t peak_messages = 0;
+        size_t peak_bytes = 0;        // 含传输层已缓冲的字节
+        uint64_t dropped_messages = 0;
+        uint64_t flushes = 0;         // 交给传输层的批次数
+        uint64_t flushed_messages = 0;
+        bool overflowed = false;
+    };
+
+    OutboundQueue() = default;
+    OutboundQueue(const OutboundQueue &) = delete;
+    OutboundQueue &operator=(const OutboundQueue &) = delete;
+
+    void setLimits(const Limits &limits);
+
+    // transport_buffered: websocketpp 已缓冲但还没写出的字节数
+    PushResult push(Frame frame, size_t bytes, bool droppable, size_t transport_buffered);
+    // 取出本轮交给传输层的帧；more 表示仍有帧因传输层缓冲已满而滞留，调用方需稍后再次 flush
+    std::vector<Frame> takeBatch(size_t transport_buffered, bool &more);
+
+    Stats stats() const;
+
+private:
+    struct Entry
+    {
+        Frame frame;
+        size_t bytes;
+        bool droppable;
+    };
+
+    // 调用方持有 mutex_
+    bool overLimit(size_t extra_bytes, size_t transport_buffered) const;
+
+    mutable std::mutex mutex_;
+    Limits limits_;
+    std::deque<Entry> entries_;
+    size_t queued_bytes_ = 0;
+    bool flush_scheduled_ = false;
+    bool closed_ = false;
+    Stats stats_;
+};
@@ -0,0 +1,294 @@
+#include "permessage_deflate.hpp"
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+
+namespace
+{
+    std::mutex g_options_mutex;
+    PermessageDeflate::Options g_options;
+
+    // 压缩数据末尾的空 stored 块，发送时去掉，接收时由 websocketpp 在消息结束后补回
+    const uint8_t kTrailer[4] = {0x00, 0x00, 0xff, 0xff};
+
+    std::string trim(const std::string &value)
+    {
+        size_t begin = value.find_first_not_of(" \t");
+        size_t end = value.find_last_not_of(" \t");
+        return begin == std::string::npos ? "" : value.substr(begin, end - begin + 1);
+    }
+
+    // 解析窗口位数参数，非法时返回 0
+    int parseWindowBits(const std::string &value)
+    {
+        std::string digits = value;
+        if (digits.size() >= 2 && digits.front() == '"' && digits.back() == '"')
+        {
+            digits = digits.substr(1, digits.size() - 2);
+        }
+        if (digits.empty() || digits.size() > 2 || !std::all_of(digits.begin(), digits.end(), ::isdigit) || digits[0] == '0')
+        {
+            return 0;
+        }
+        int bits = std::stoi(digits);
+        return bits >= 8 && bits <= 15 ? bits : 0;
+    }
+
+    // zlib 的原始 deflate 不支持 256 字节窗口，服务端压缩窗口最小为 9
+    int clampServerBits(int bits)
+    {
+        return std::min(15, std::max(9, bits));
+    }
+}
+
+std::string PermessageDeflate::Params::toHeader() const
+{
+    std::string header = "permessage-deflate";
+    if (server_no_context_takeover)
+    {
+        header += "; server_no_context_takeover";
+    }
+    if (client_no_context_takeover)
+    {
+        header += "; client_no_context_takeover";
+    }
+    if (server_max_window_bits < 15)
+    {
+        header += "; server_max_window_bits=" + std::to_string(server_max_window_bits);
+    }
+    if (client_max_window_bits_sent)
+    {
+        header += "; client_max_window_bits=" + std::to_string(client_max_window_bits);
+    }
+    return header;
+}
+
+std::optional<PermessageDeflate::Params> PermessageDeflate::negotiate(const Options &options, const Offer &offer)
+{
+    if (!options.enabled)
+    {
+        return std::nullopt;
+    }
+
+    Params params;
+    params.server_no_context_takeover = options.server_no_context_takeover;
+    params.client_no_context_takeover = options.client_no_context_takeover;
+    params.server_max_window_bits = clampServerBits(options.server_max_window_bits);
+
+    for (const auto &param : offer)
+    {
+        const std::string &name = param.first;
+        const std::string &value = param.second;
+        if (name == "server_no_context_takeover")
+        {
+            if (!value.empty())
+            {
+                return std::nullopt;
+            }
+            // 客户端要求时必须接受
+            params.server_no_context_takeover = true;
+        }
+        else if (name == "client_no_context_takeover")
+        {
+            if (!value.empty())
+            {
+                return std::nullopt;
+            }
+        }
+        else if (name == "server_max_window_bits")
+        {
+            int bits = parseWindowBits(value);
+            // 8 位窗口无法满足时拒绝这个请求，连接退回不压缩
+            if (bits < 9)
+            {
+                return std::nullopt;
+            }
+            params.server_max_window_bits = std::min(params.server_max_window_bits, bits);
+        }
+        else if (name == "client_max_window_bits")
+        {
+            // 无值表示客户端支持该参数，上限为 15
+            int bits = value.empty() ? 15 : parseWindowBits(value);
+            if (bits == 0)
+            {
+                return std::nullopt;
+            }
+            params.client_max_window_bits = std::min(bits, std::min(15, std::max(8, options.client_max_window_bits)));
+            params.client_max_window_bits_sent = true;
+        }
+        else
+        {
+            return std::nullopt; // 未知参数
+        }
+    }
+    return params;
+}
+
+std::optional<PermessageDeflate::Params> PermessageDeflate::parseHeader(const std::string &header)
+{
+    size_t start = 0;
+    while (start <= header.size())
+    {
+        size_t comma = header.find(',', start);
+        std::string extension = header.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        start = comma == std::string::npos ? header.size() + 1 : comma + 1;
+
+        size_t semicolon = extension.find(';');
+        if (trim(extension.substr(0, semicolon)) != "permessage-deflate")
+        {
+            continue;
+        }
+
+        Params params;
+        while (semicolon != std::string::npos)
+        {
+            size_t next = extension.find(';', semicolon + 1);
+            std::string param = trim(extension.substr(semicolon + 1, next == std::string::npos ? std::string::npos : next - semicolon - 1));
+            semicolon = next;
+
+            size_t equals = param.find('=');
+            std::string name = trim(param.substr(0, equals));
+            std::string value = equals == std::string::npos ? "" : trim(param.substr(equals + 1));
+            if (name == "server_no_context_takeover")
+            {
+                params.server_no_context_takeover = true;
+            }
+            else if (name == "client_no_context_takeover")
+            {
+                params.client_no_context_takeover = true;
+            }
+            else if (name == "server_max_window_bits" && parseWindowBits(value))
+            {
+                params.server_max_window_bits = parseWindowBits(value);
+            }
+            else if (name == "client_max_window_bits")
+            {
+                params.client_max_window_bits_sent = true;
+                if (parseWindowBits(value))
+                {
+                    params.client_max_window_bits = parseWindowBits(value);
+                }
+            }
+        }
+        return params;
+    }
+    return std::nullopt;
+}
+
+void PermessageDeflate::setOptions(const Options &options)
+{
+    std::lock_guard<std::mutex> lock(g_options_mutex);
+    g_options = options;
+}
+
+PermessageDeflate::Options PermessageDeflate::options()
+{
+    std::lock_guard<std::mutex> lock(g_options_mutex);
+    return g_options;
+}
+
+bool PermessageDeflate::compressMessage(int window_bits, int level, const std::string &input, std::string &output)
+{
+    // 压缩器初始化要分配窗口和哈希表，按线程缓存避免每条广播都重新分配
+    thread_local std::unique_ptr<Deflater> deflaters[16];
+    thread_local int deflater_levels[16];
+    int bits = clampServerBits(window_bits);
+    if (!deflaters[bits] || deflater_levels[bits] != level)
+    {
+        deflaters[bits] = std::make_unique<Deflater>(bits, level, true);
+        deflater_levels[bits] = level;
+    }
+    return deflaters[bits]->compress(input, output);
+}
+
+PermessageDeflate::Deflater::Deflater(int window_bits, int level, bool no_context_takeover)
+    : no_context_takeover_(no_context_takeover)
+{
+    // 负的窗口位数表示不带 zlib 头尾的原始 deflate 流
+    initialized_ = deflateInit2(&stream_, level, Z_DEFLATED, -clampServerBits(window_bits), 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+PermessageDeflate::Deflater::~Deflater()
+{
+    if (initialized_)
+    {
+        deflateEnd(&stream_);
+    }
+}
+
+bool PermessageDeflate::Deflater::compress(const std::string &input, std::string &output)
+{
+    if (!initialized_)
+    {
+        return false;
+    }
+
+    output.clear();
+    stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    stream_.avail_in = static_cast<uInt>(input.size());
+    char buffer[16384];
+    do
+    {
+        stream_.next_out = reinterpret_cast<Bytef *>(buffer);
+        stream_.avail_out = sizeof(buffer);
+        if (deflate(&stream_, Z_SYNC_FLUSH) == Z_STREAM_ERROR)
+        {
+            return false;
+        }
+        output.append(buffer, sizeof(buffer) - stream_.avail_out);
+    } while (stream_.avail_out == 0);
+
+    // Z_SYNC_FLUSH 以 00 00 ff ff 结尾，按 RFC 7692 去掉
+    if (output.size() >= 4 && std::equal(kTrailer, kTrailer + 4, reinterpret_cast<const uint8_t *>(output.data() + output.size() - 4)))
+    {
+        output.resize(output.size() - 4);
+    }
+    if (no_context_takeover_)
+    {
+        deflateReset(&stream_);
+    }
+    return true;
+}
+
+PermessageDeflate::Inflater::Inflater(int window_bits, size_t max_output) : max_output_(max_output)
+{
+    initialized_ = inflateInit2(&stream_, -std::min(15, std::max(8, window_bits))) == Z_OK;
+}
+
+PermessageDeflate::Inflater::~Inflater()
+{
+    if (initialized_)
+    {
+        inflateEnd(&stream_);
+    }
+}
+
+PermessageDeflate::Inflater::Status PermessageDeflate::Inflater::decompress(const uint8_t *data, size_t length,
+                                                                            std::string &output)
+{
+    if (!initialized_)
+    {
+        return Status::Error;
+    }
+
+    stream_.next_in = const_cast<Bytef *>(data);
+    stream_.avail_in = static_cast<uInt>(length);
+    char buffer[16384];
+    do
+    {
+        stream_.next_out = reinterpret_cast<Bytef *>(buffer);
+        stream_.avail_out = sizeof(buffer);
+        int rc = inflate(&stream_, Z_SYNC_FLUSH);
+        if (rc != Z_OK && rc != Z_BUF_ERROR && rc != Z_STREAM_END)
+        {
+            return Status::Error;
+        }
+        size_t produced = sizeof(buffer) - stream_.avail_out;
+        if (max_output_ > 0 && output.size() + produced > max_output_)
+        {
+            return Status::TooBig;
+        }
+        output.append(buffer, produced);
+    } while (stream_.avail_out == 0);
+    return Status::Ok;
+}
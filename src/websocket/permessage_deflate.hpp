@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <zlib.h>
+
+// RFC 7692 permessage-deflate
+// 负责扩展参数协商和消息级的压缩/解压。默认协商 server_no_context_takeover：服务端每条消息独立压缩，
+// 同一条广播只需压缩一次，所有协商了相同窗口位数的接收者共享同一份压缩帧；
+// 关闭该选项后服务端保留压缩上下文，压缩率更高，但只能逐个连接压缩。
+// 小于 min_compress_size 的消息不压缩，压缩的收益抵不过 CPU 开销
+class PermessageDeflate
+{
+public:
+    struct Options
+    {
+        bool enabled = true;                    // 是否接受客户端的 permessage-deflate 请求
+        bool server_no_context_takeover = true; // 服务端每条消息重置压缩上下文，广播帧可共享
+        bool client_no_context_takeover = false; // 要求客户端每条消息重置压缩上下文，节省服务端解压内存
+        int server_max_window_bits = 15;        // 服务端压缩窗口位数上限（8~15）
+        int client_max_window_bits = 15;        // 客户端压缩窗口位数上限，客户端声明支持时才会下发
+        size_t min_compress_size = 256;         // 小于该字节数的消息不压缩
+        int level = Z_DEFAULT_COMPRESSION;      // zlib 压缩级别
+        size_t max_message_size = 1024 * 1024;  // 解压后单条消息的字节数上限，0 表示不限
+    };
+
+    // 协商结果，对应响应中的 Sec-WebSocket-Extensions
+    struct Params
+    {
+        bool server_no_context_takeover = false;
+        bool client_no_context_takeover = false;
+        int server_max_window_bits = 15;
+        int client_max_window_bits = 15;
+        bool client_max_window_bits_sent = false; // 响应中是否带 client_max_window_bits
+
+        std::string toHeader() const;
+    };
+
+    // 客户端的一个 permessage-deflate 请求的参数（名称 -> 值，无值参数为空字符串）
+    using Offer = std::map<std::string, std::string>;
+
+    // 按服务端配置处理客户端请求，参数非法或服务端关闭压缩时返回空（不启用扩展）
+    static std::optional<Params> negotiate(const Options &options, const Offer &offer);
+    // 从 Sec-WebSocket-Extensions 头中解析已协商的 permessage-deflate 参数，没有时返回空
+    static std::optional<Params> parseHeader(const std::string &header);
+
+    // 进程级配置，websocketpp 在每个连接上默认构造扩展对象，通过这里读取配置
+    static void setOptions(const Options &options);
+    static Options options();
+
+    // 不保留上下文地压缩一条消息，供共享广播帧使用；每个线程按窗口位数复用压缩器
+    static bool compressMessage(int window_bits, int level, const std::string &input, std::string &output);
+
+    // 压缩器：输出去掉末尾 00 00 ff ff 的 deflate 数据，可直接作为 RSV1 帧的负载
+    class Deflater
+    {
+    public:
+        Deflater(int window_bits, int level, bool no_context_takeover);
+        ~Deflater();
+        Deflater(const Deflater &) = delete;
+        Deflater &operator=(const Deflater &) = delete;
+
+        bool compress(const std::string &input, std::string &output);
+
+    private:
+        z_stream stream_{};
+        bool initialized_ = false;
+        bool no_context_takeover_;
+    };
+
+    // 解压器：websocketpp 把一条消息的压缩数据分块喂入，output 是该消息的负载缓冲区。
+    // 消息结束时 websocketpp 自己把发送方去掉的 00 00 ff ff 再喂一次（hybi13::finalize_message），
+    // 解压器不能再补，否则两个同步尾之间的字节会被当成下一个 stored 块的长度。
+    // 解压后的消息超过 max_output 字节时返回 TooBig，防止小帧解压出巨大负载
+    class Inflater
+    {
+    public:
+        enum class Status
+        {
+            Ok,
+            Error,  // 压缩数据非法
+            TooBig, // 解压后的消息超过上限
+        };
+
+        // max_output: 解压后单条消息的字节数上限，0 表示不限
+        Inflater(int window_bits, size_t max_output);
+        ~Inflater();
+        Inflater(const Inflater &) = delete;
+        Inflater &operator=(const Inflater &) = delete;
+
+        Status decompress(const uint8_t *data, size_t length, std::string &output);
+
+    private:
+        z_stream stream_{};
+        bool initialized_ = false;
+        size_t max_output_;
+    };
+};
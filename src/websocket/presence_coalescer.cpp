@@ -0,0 +1,86 @@
+#include "presence_coalescer.hpp"
+#include <utility>
+
+PresenceCoalescer::PresenceCoalescer(const Options &options) : options_(options)
+{
+}
+
+PresenceCoalescer::RecordResult PresenceCoalescer::record(const std::string &room_id, const std::string &user_id, bool joined,
+                                                          size_t member_count)
+{
+    if (options_.window_ms <= 0)
+    {
+        return RecordResult::Individual;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto room = rooms_.find(room_id);
+    bool opened = false;
+    if (room == rooms_.end())
+    {
+        if (member_count <= options_.member_threshold)
+        {
+            return RecordResult::Individual;
+        }
+        room = rooms_.emplace(room_id, Pending()).first;
+        opened = true;
+    }
+    ++events_;
+    Pending &pending = room->second;
+    auto it = pending.index.find(user_id);
+    if (it == pending.index.end())
+    {
+        pending.index.emplace(user_id, pending.changes.size());
+        pending.changes.push_back({user_id, joined, joined});
+    }
+    else
+    {
+        pending.changes[it->second].last_joined = joined;
+    }
+    return opened ? RecordResult::WindowOpened : RecordResult::Queued;
+}
+
+std::optional<PresenceCoalescer::Delta> PresenceCoalescer::take(const std::string &room_id)
+{
+    Pending pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = rooms_.find(room_id);
+        if (it == rooms_.end())
+        {
+            return std::nullopt;
+        }
+        pending = std::move(it->second);
+        rooms_.erase(it);
+    }
+
+    Delta delta;
+    for (auto &change : pending.changes)
+    {
+        // 第一次是加入说明窗口开始时不在线，最后一次与之相同才是真正的变化
+        if (change.first_joined != change.last_joined)
+        {
+            ++cancelled_;
+            continue;
+        }
+        (change.last_joined ? delta.joined : delta.left).push_back(std::move(change.user_id));
+    }
+    if (delta.joined.empty() && delta.left.empty())
+    {
+        return std::nullopt;
+    }
+    ++deltas_;
+    return delta;
+}
+
+PresenceCoalescer::Stats PresenceCoalescer::stats() const
+{
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.pending_rooms = rooms_.size();
+    }
+    stats.events = events_;
+    stats.deltas = deltas_;
+    stats.cancelled = cancelled_;
+    return stats;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 大房间上下线通知的合并
+// 在线成员超过阈值的房间不再逐个广播 user_joined/user_left，而是把一个窗口内的变化记下来，
+// 窗口结束时合并成一条 presence_delta 广播一次。窗口内先加入又离开（或先离开又加入）的用户互相抵消，
+// 部署后整个房间重连时，每个成员每个窗口只收到一帧，而不是每个重连的用户一帧
+class PresenceCoalescer
+{
+public:
+    struct Options
+    {
+        int64_t window_ms = 250;       // 合并窗口，0 表示关闭合并，所有房间都逐个通知
+        size_t member_threshold = 100; // 在线成员超过该数量的房间才合并
+    };
+
+    // 一个窗口内房间的净变化，按用户第一次出现的顺序
+    struct Delta
+    {
+        std::vector<std::string> joined;
+        std::vector<std::string> left;
+    };
+
+    enum class RecordResult
+    {
+        Individual,   // 房间不需要合并，调用方直接逐个通知
+        Queued,       // 已并入房间当前的窗口
+        WindowOpened, // 房间开始了新的窗口，调用方需在 window_ms 后调用 take
+    };
+
+    struct Stats
+    {
+        size_t pending_rooms = 0;   // 窗口未结束的房间数
+        uint64_t events = 0;        // 并入窗口的上下线事件
+        uint64_t deltas = 0;        // 发出的 presence_delta
+        uint64_t cancelled = 0;     // 窗口内互相抵消的用户
+    };
+
+    explicit PresenceCoalescer(const Options &options);
+
+    PresenceCoalescer(const PresenceCoalescer &) = delete;
+    PresenceCoalescer &operator=(const PresenceCoalescer &) = delete;
+
+    // 记录一次加入或离开。在线成员超过阈值，或房间已有未结束的窗口时并入窗口，
+    // 避免成员数在阈值附近波动时同一用户的加入和离开分别走两条路径
+    RecordResult record(const std::string &room_id, const std::string &user_id, bool joined, size_t member_count);
+    // 结束房间的窗口并取出净变化，没有变化时返回空
+    std::optional<Delta> take(const std::string &room_id);
+
+    Stats stats() const;
+    const Options &options() const { return options_; }
+
+private:
+    struct Change
+    {
+        std::string user_id;
+        bool first_joined; // 窗口内第一次事件，决定窗口开始时用户是否在线
+        bool last_joined;  // 窗口内最后一次事件
+    };
+    struct Pending
+    {
+        std::vector<Change> changes;
+        std::unordered_map<std::string, size_t> index; // 用户ID -> changes 中的下标
+    };
+
+    Options options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Pending> rooms_;
+    std::atomic<uint64_t> events_{0};
+    std::atomic<uint64_t> deltas_{0};
+    std::atomic<uint64_t> cancelled_{0};
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/extensions/extension.hpp>
+#include <websocketpp/http/constants.hpp>
+#include <websocketpp/processors/base.hpp>
+#include <memory>
+#include <string>
+#include <utility>
+#include "heartbeat_wheel.hpp"
+#include "outbound_queue.hpp"
+#include "permessage_deflate.hpp"
+
+// websocketpp 的 permessage_deflate 扩展点
+// 处理器在每个连接上默认构造一个该对象，握手时调用 negotiate，之后收发的压缩消息经 compress/decompress 处理。
+// 参数取自 PermessageDeflate::options()，协商和压缩算法都在 PermessageDeflate 中
+class DeflateExtension
+{
+public:
+    typedef std::pair<websocketpp::lib::error_code, std::string> err_str_pair;
+
+    bool is_implemented() const { return true; }
+    bool is_enabled() const { return enabled_; }
+
+    // 服务端处理客户端的一个 permessage-deflate 请求，返回响应头中的扩展描述
+    err_str_pair negotiate(websocketpp::http::attribute_list const &offer)
+    {
+        options_ = PermessageDeflate::options();
+        auto params = PermessageDeflate::negotiate(options_, offer);
+        if (!params)
+        {
+            return err_str_pair(websocketpp::extensions::error::make_error_code(websocketpp::extensions::error::general), "");
+        }
+        params_ = *params;
+        enabled_ = true;
+        return err_str_pair(websocketpp::lib::error_code(), params_.toHeader());
+    }
+
+    websocketpp::lib::error_code init(bool /*is_server*/)
+    {
+        deflater_ = std::make_unique<PermessageDeflate::Deflater>(params_.server_max_window_bits, options_.level,
+                                                                  params_.server_no_context_takeover);
+        inflater_ = std::make_unique<PermessageDeflate::Inflater>(params_.client_max_window_bits, options_.max_message_size);
+        return websocketpp::lib::error_code();
+    }
+
+    // 只作为服务端使用，不主动发起请求
+    std::string generate_offer() const { return ""; }
+    websocketpp::lib::error_code validate_offer(websocketpp::http::attribute_list const &) { return websocketpp::lib::error_code(); }
+
+    websocketpp::lib::error_code compress(std::string const &in, std::string &out)
+    {
+        std::string compressed;
+        if (!deflater_ || !deflater_->compress(in, compressed))
+        {
+            return websocketpp::extensions::error::make_error_code(websocketpp::extensions::error::general);
+        }
+        out.append(compressed);
+        return websocketpp::lib::error_code();
+    }
+
+    // websocketpp 只按压缩后的长度检查 max_message_size，解压后的上限由 Inflater 检查，超限时以 1009 关闭连接
+    websocketpp::lib::error_code decompress(uint8_t const *buf, size_t len, std::string &out)
+    {
+        auto status = inflater_ ? inflater_->decompress(buf, len, out) : PermessageDeflate::Inflater::Status::Error;
+        switch (status)
+        {
+        case PermessageDeflate::Inflater::Status::Ok:
+            return websocketpp::lib::error_code();
+        case PermessageDeflate::Inflater::Status::TooBig:
+            return websocketpp::processor::error::make_error_code(websocketpp::processor::error::message_too_big);
+        default:
+            return websocketpp::extensions::error::make_error_code(websocketpp::extensions::error::general);
+        }
+    }
+
+private:
+    bool enabled_ = false;
+    PermessageDeflate::Options options_;
+    PermessageDeflate::Params params_;
+    std::unique_ptr<PermessageDeflate::Deflater> deflater_;
+    std::unique_ptr<PermessageDeflate::Inflater> inflater_;
+};
+
+// 每个 websocketpp 连接对象自带的状态，不需要再按连接句柄查表
+struct ConnectionState
+{
+    OutboundQueue outbound;             // 出站队列
+    HeartbeatWheel::EntryPtr heartbeat; // 心跳状态，on_open 时登记
+};
+
+// 在 websocketpp 默认的 asio 配置上启用 permessage-deflate，每个连接对象带一份 ConnectionState
+struct WebSocketConfig : public websocketpp::config::asio
+{
+    typedef WebSocketConfig type;
+    typedef websocketpp::config::asio base;
+
+    typedef base::concurrency_type concurrency_type;
+    typedef base::request_type request_type;
+    typedef base::response_type response_type;
+    typedef base::message_type message_type;
+    typedef base::con_msg_manager_type con_msg_manager_type;
+    typedef base::endpoint_msg_manager_type endpoint_msg_manager_type;
+    typedef base::alog_type alog_type;
+    typedef base::elog_type elog_type;
+    typedef base::rng_type rng_type;
+
+    struct transport_config : public base::transport_config
+    {
+        typedef type::concurrency_type concurrency_type;
+        typedef type::alog_type alog_type;
+        typedef type::elog_type elog_type;
+        typedef type::request_type request_type;
+        typedef type::response_type response_type;
+        typedef websocketpp::transport::asio::basic_socket::endpoint socket_type;
+    };
+    typedef websocketpp::transport::asio::endpoint<transport_config> transport_type;
+
+    typedef DeflateExtension permessage_deflate_type;
+    typedef ConnectionState connection_base;
+};
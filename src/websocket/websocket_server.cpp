@@ -1,14 +1,19 @@
 #include "websocket_server.hpp"
+#include "frame_header.hpp"
+#include "wire_codec.hpp"
 #include "utils/logger.hpp"
 #include "utils/jwt_utils.hpp"
 #include "db/database_manager.hpp"
 #include <nlohmann/json.hpp>
+#include <algorithm>
 #include <ctime>
+#include <map>
 
 using json = nlohmann::json;
 
-WebSocketServer::WebSocketServer(DatabaseManager &db_manager)
-    : db_manager_(db_manager)
+WebSocketServer::WebSocketServer(DatabaseManager &db_manager, size_t io_threads)
+    : io_thread_count_(std::max<size_t>(1, io_threads)), deflate_options_(PermessageDeflate::options()),
+      presence_(std::make_unique<PresenceCoalescer>(PresenceCoalescer::Options())), db_manager_(db_manager)
 {
     // 关闭websocketpp的日志
     server_.clear_access_channels(websocketpp::log::alevel::all);
@@ -16,6 +21,7 @@ WebSocketServer::WebSocketServer(DatabaseManager &db_manager)
 
     // 初始化Asio
     server_.init_asio();
+    pipeline_ = std::make_unique<MessagePipeline>(db_manager_, server_.get_io_service());
 
     // 设置重用地址选项
     server_.set_reuse_addr(true);
@@ -26,8 +32,8 @@ WebSocketServer::WebSocketServer(DatabaseManager &db_manager)
 
 WebSocketServer::~WebSocketServer()
 {
-    // 停止服务器线程
-    if (server_thread_.joinable())
+    // 停止事件循环线程
+    if (!io_threads_.empty())
     {
         stop();
     }
@@ -45,46 +51,89 @@ void WebSocketServer::setup_handlers()
     server_.set_close_handler(bind(&WebSocketServer::on_close, this, _1));
     // 接收到消息时调用on_message
     server_.set_message_handler(bind(&WebSocketServer::on_message, this, _1, _2));
+    // 协议层 ping/pong 也算作连接的活动；websocketpp 自动回复客户端的 ping
+    server_.set_ping_handler(bind(&WebSocketServer::on_ping, this, _1, _2));
+    server_.set_pong_handler(bind(&WebSocketServer::on_pong, this, _1, _2));
 }
 
 void WebSocketServer::run(uint16_t port)
 {
-    // 在一个新线程中启动服务器，避免阻塞主线程
-    server_thread_ = std::thread([this, port]()
-                                 {
-        try
-        {
-            LOG_INFO << "Starting WebSocket server on port " << port;
-            
-            // 设置监听端口
-            websocketpp::lib::error_code ec;
-            server_.listen(port, ec);
-            if (ec) {
-                LOG_ERROR << "WebSocket server listen error: " << ec.message();
-                return;
-            }
-            
-            LOG_INFO << "WebSocket server listening on port " << port;
-
-            // 开始接受连接
-            server_.start_accept(ec);
-            if (ec) {
-                LOG_ERROR << "WebSocket server start_accept error: " << ec.message();
-                return;
-            }
+    try
+    {
+        LOG_INFO << "Starting WebSocket server on port " << port;
 
-            // 运行Asio事件循环
-            server_.run();
-            LOG_INFO << "WebSocket server event loop exited";
+        // 设置监听端口
+        websocketpp::lib::error_code ec;
+        server_.listen(port, ec);
+        if (ec)
+        {
+            LOG_ERROR << "WebSocket server listen error: " << ec.message();
+            return;
         }
-        catch (const websocketpp::exception &e)
+
+        LOG_INFO << "WebSocket server listening on port " << port;
+
+        // 开始接受连接
+        server_.start_accept(ec);
+        if (ec)
         {
-            LOG_ERROR << "WebSocket server error: " << e.what();
+            LOG_ERROR << "WebSocket server start_accept error: " << ec.message();
+            return;
         }
-        catch (const std::exception &e)
+
+        // 所有连接共用一个心跳定时器
+        if (heartbeat_options_.interval_ms > 0)
         {
-            LOG_ERROR << "WebSocket server error: " << e.what();
-        } });
+            heartbeat_ = std::make_unique<HeartbeatWheel>(heartbeat_options_, HeartbeatWheel::nowMs());
+            schedule_heartbeat();
+        }
+    }
+    catch (const websocketpp::exception &e)
+    {
+        LOG_ERROR << "WebSocket server error: " << e.what();
+        return;
+    }
+
+    // 多个线程共同运行同一个 io_service；websocketpp 为每个连接创建 strand，
+    // 同一连接的读写和回调不会并发，不同连接在各线程上并行处理
+    for (size_t i = 0; i < io_thread_count_; ++i)
+    {
+        io_threads_.emplace_back([this]()
+                                 {
+            try
+            {
+                server_.run();
+            }
+            catch (const websocketpp::exception &e)
+            {
+                LOG_ERROR << "WebSocket server error: " << e.what();
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR << "WebSocket server error: " << e.what();
+            } });
+    }
+    LOG_INFO << "WebSocket server event loop running on " << io_thread_count_ << " threads";
+}
+
+void WebSocketServer::set_outbound_limits(const OutboundQueue::Limits &limits)
+{
+    outbound_limits_ = limits;
+}
+
+void WebSocketServer::set_heartbeat_options(const HeartbeatWheel::Options &options)
+{
+    heartbeat_options_ = options;
+}
+
+void WebSocketServer::set_presence_options(const PresenceCoalescer::Options &options)
+{
+    presence_ = std::make_unique<PresenceCoalescer>(options);
+}
+
+void WebSocketServer::set_max_message_size(size_t bytes)
+{
+    server_.set_max_message_size(bytes);
 }
 
 void WebSocketServer::stop()
@@ -105,27 +154,28 @@ void WebSocketServer::stop()
         }
 
         // 关闭所有现有连接
+        for (const auto &hdl : registry_.connections())
         {
-            std::lock_guard<std::mutex> lock(connection_mutex_);
-            for (const auto &pair : connection_users_)
+            websocketpp::lib::error_code ec;
+            server_.close(hdl, websocketpp::close::status::going_away, "Server shutdown", ec);
+            if (ec)
             {
-                websocketpp::lib::error_code ec;
-                server_.close(pair.first, websocketpp::close::status::going_away, "Server shutdown", ec);
-                if (ec)
-                {
-                    LOG_ERROR << "Error closing connection: " << ec.message();
-                }
+                LOG_ERROR << "Error closing connection: " << ec.message();
             }
         }
 
         // 停止IO事件循环
         server_.stop();
 
-        // 等待服务器线程结束
-        if (server_thread_.joinable())
+        // 等待所有事件循环线程结束
+        for (auto &thread : io_threads_)
         {
-            server_thread_.join();
+            if (thread.joinable())
+            {
+                thread.join();
+            }
         }
+        io_threads_.clear();
 
         LOG_INFO << "WebSocket server stopped successfully";
     }
@@ -140,69 +190,118 @@ void WebSocketServer::stop()
 void WebSocketServer::on_open(connection_hdl hdl)
 {
     LOG_INFO << "New WebSocket connection opened";
-    // 可以在这里处理新连接的初始化逻辑
+    websocketpp::lib::error_code ec;
+    auto connection = server_.get_con_from_hdl(hdl, ec);
+    if (!ec)
+    {
+        connection->outbound.setLimits(outbound_limits_);
+        if (heartbeat_)
+        {
+            connection->heartbeat = heartbeat_->add(hdl, HeartbeatWheel::nowMs());
+        }
+    }
 }
 
 void WebSocketServer::on_close(connection_hdl hdl)
 {
-    // 使用互斥锁保护共享数据
-    std::lock_guard<std::mutex> lock(connection_mutex_);
-    // 检查这个连接是否已经认证过了
-    auto it = connection_users_.find(hdl);
-    if (it != connection_users_.end())
+    websocketpp::lib::error_code ec;
+    auto connection = server_.get_con_from_hdl(hdl, ec);
+    if (!ec && connection->heartbeat)
     {
-        std::string user_id = it->second;
-        LOG_INFO << "WebSocket connection closed for user: " << user_id;
+        connection->heartbeat->close();
+    }
+    release_connection(hdl);
+}
 
-        // 如果用户在房间中，先通知其他用户再移除
-        auto room_it = user_current_room_.find(user_id);
-        if (room_it != user_current_room_.end())
-        {
-            std::string room_id = room_it->second;
+void WebSocketServer::release_connection(connection_hdl hdl)
+{
+    // 注销连接；连接仍是用户的当前连接时用户一并离开房间
+    auto unbound = registry_.unbind(hdl);
+    if (!unbound)
+    {
+        LOG_INFO << "WebSocket connection closed for unknown user";
+        return;
+    }
+    LOG_INFO << "WebSocket connection closed for user: " << unbound->user_id;
 
-            // 获取用户信息
-            auto user_info = db_manager_.getUserById(user_id);
-            std::string username = user_info ? user_info->getUsername() : user_id;
+    // 通知房间内其他用户该用户已离开
+    if (!unbound->left_room.empty())
+    {
+        broadcast_presence("user_left", unbound->user_id, unbound->left_room);
+    }
+}
 
-            // 通知房间内其他用户该用户已离开
-            json notification = {
-                {"success", true},
-                {"message", "User left room"},
-                {"data", {{"type", "user_left"}, {"user_id", user_id}, {"username", username}, {"room_id", room_id}}}};
-            broadcast_to_room(room_id, notification.dump(), user_id); // 排除自己
+bool WebSocketServer::on_ping(connection_hdl hdl, std::string /*payload*/)
+{
+    touch_connection(hdl);
+    return true; // 由 websocketpp 回复 pong
+}
 
-            // 然后从房间中移除用户
-            leave_room(user_id, room_id);
-        }
+void WebSocketServer::on_pong(connection_hdl hdl, std::string /*payload*/)
+{
+    touch_connection(hdl);
+}
 
-        // 从用户连接映射中移除
-        user_connections_.erase(user_id);
-        connection_users_.erase(it);
+void WebSocketServer::touch_connection(connection_hdl hdl)
+{
+    if (!heartbeat_)
+    {
+        return;
     }
-    else
+    websocketpp::lib::error_code ec;
+    auto connection = server_.get_con_from_hdl(hdl, ec);
+    if (!ec && connection->heartbeat)
     {
-        LOG_INFO << "WebSocket connection closed for unknown user";
+        connection->heartbeat->touch(HeartbeatWheel::nowMs());
+    }
+}
+
+void WebSocketServer::schedule_heartbeat()
+{
+    server_.set_timer(heartbeat_->options().tick_ms, [this](const websocketpp::lib::error_code &ec)
+                      {
+                          if (ec)
+                          {
+                              return; // 停服时定时器被取消
+                          }
+                          heartbeat_->advance(
+                              HeartbeatWheel::nowMs(),
+                              [this](const HeartbeatWheel::Handle &hdl)
+                              {
+                                  websocketpp::lib::error_code ping_ec;
+                                  server_.ping(hdl, "", ping_ec);
+                              },
+                              [this](const HeartbeatWheel::Handle &hdl)
+                              { evict_idle(hdl); });
+                          schedule_heartbeat(); });
+}
+
+void WebSocketServer::evict_idle(connection_hdl hdl)
+{
+    LOG_WARN << "Evicting WebSocket connection after " << heartbeat_->options().max_missed << " unanswered pings";
+    // 对端可能已经失联，关闭握手要等超时；先移出房间，之后的广播不再发给它
+    release_connection(hdl);
+    websocketpp::lib::error_code ec;
+    server_.close(hdl, websocketpp::close::status::going_away, "Heartbeat timeout", ec);
+    if (ec)
+    {
+        LOG_ERROR << "Error closing idle connection: " << ec.message();
     }
 }
 
 void WebSocketServer::on_message(connection_hdl hdl, websocket_server::message_ptr msg)
 {
+    touch_connection(hdl);
+
     // 先检查连接是否验证
     std::string user_id;
-    bool is_authenticated = false;
+    auto bound_user = registry_.userOf(hdl);
+    if (bound_user)
     {
-        // 使用互斥锁保护共享数据
-        std::lock_guard<std::mutex> lock(connection_mutex_);
-        // 检查连接是否已经认证
-        auto it = connection_users_.find(hdl);
-        if (it != connection_users_.end())
-        {
-            is_authenticated = true;
-            user_id = it->second; // 线程安全地获取用户id
-        }
+        user_id = std::move(*bound_user);
     }
 
-    if (!is_authenticated) // 处理未认证的连接，期望收到的认证消息
+    if (!bound_user) // 处理未认证的连接，期望收到的认证消息
     {
         try
         {
@@ -212,6 +311,21 @@ void WebSocketServer::on_message(connection_hdl hdl, websocket_server::message_p
                 // 处理认证消息 - 只需要token
                 std::string token = json_msg.at("token").get<std::string>();
 
+                // 可选的消息编码，认证之后双方都按该编码收发
+                std::string encoding_name = json_msg.value("encoding", "json");
+                auto encoding = WireCodec::parse(encoding_name);
+                if (!encoding)
+                {
+                    LOG_ERROR << "Unsupported wire encoding: " << encoding_name;
+                    json error_response = {
+                        {"success", false},
+                        {"message", "Authentication failed"},
+                        {"error", "Unsupported encoding: " + encoding_name}};
+                    send_json(hdl, error_response);
+                    close_after_flush(hdl, websocketpp::close::status::policy_violation, "Unsupported encoding");
+                    return;
+                }
+
                 // 验证JWT令牌并获取用户ID
                 auto verified_user_id = JwtUtils::verifyToken(token);
                 if (!verified_user_id)
@@ -221,51 +335,39 @@ void WebSocketServer::on_message(connection_hdl hdl, websocket_server::message_p
                         {"success", false},
                         {"message", "Authentication failed"},
                         {"error", "Invalid or expired token"}};
-                    server_.send(hdl, error_response.dump(), websocketpp::frame::opcode::text);
-                    server_.close(hdl, websocketpp::close::status::policy_violation, "Invalid token");
+                    send_json(hdl, error_response);
+                    close_after_flush(hdl, websocketpp::close::status::policy_violation, "Invalid token");
                     return;
                 }
 
                 std::string verified_id = *verified_user_id;
 
-                { // 进入临界区
-                    std::lock_guard<std::mutex> lock(connection_mutex_);
-                    // 检查用户是否已有连接
-                    auto old_connection_it = user_connections_.find(verified_id);
-                    if (old_connection_it != user_connections_.end())
+                // 认证通过，保存连接和用户ID映射；用户已有连接时关闭旧连接
+                auto features = connection_features(hdl);
+                features.encoding = *encoding;
+                connection_hdl old_connection = registry_.bind(verified_id, hdl, features);
+                if (!old_connection.expired())
+                {
+                    LOG_INFO << "User " << verified_id << " already has a connection. Closing old connection.";
+                    json reason = {
+                        {"success", false},
+                        {"message", "Connection closed due to new login"},
+                        {"error", "logged_in_from_another_location"}};
+                    websocketpp::lib::error_code ec;
+                    server_.close(old_connection, websocketpp::close::status::policy_violation, reason.dump(), ec);
+                    if (ec)
                     {
-                        LOG_INFO << "User " << verified_id << " already has a connection. Closing old connection.";
-                        // 获取旧连接句柄
-                        // 向旧连接发送通知
-                        json reason = {
-                            {"success", false},
-                            {"message", "Connection closed due to new login"},
-                            {"error", "logged_in_from_another_location"}};
-                        try
-                        {
-                            server_.close(old_connection_it->second, websocketpp::close::status::policy_violation, reason.dump());
-                        }
-                        catch (const std::exception &e)
-                        {
-                            LOG_ERROR << "Error closing old connection for user " << verified_id << ": " << e.what();
-                        }
-
-                        // 关闭旧连接
-                        // 从反向映射中移除旧的句柄记录
-                        // on_close处理器之后也会做这件事，但在这里提前做可以保证状态立即更新
-                        connection_users_.erase(old_connection_it->second);
+                        LOG_ERROR << "Error closing old connection for user " << verified_id << ": " << ec.message();
                     }
-                    // 认证通过，保存连接和用户ID映射
-                    user_connections_[verified_id] = hdl;
-                    connection_users_[hdl] = verified_id;
                 }
 
-                LOG_INFO << "WebSocket connection authenticated for user: " << verified_id;
+                LOG_INFO << "WebSocket connection authenticated for user: " << verified_id << " (" << WireCodec::name(*encoding) << ")";
+                // 认证响应仍是 JSON 文本，之后的消息才切换到选定的编码
                 json response = {
                     {"success", true},
                     {"message", "WebSocket authentication successful"},
-                    {"data", {{"user_id", verified_id}, {"status", "connected"}}}};
-                server_.send(hdl, response.dump(), websocketpp::frame::opcode::text);
+                    {"data", {{"user_id", verified_id}, {"status", "connected"}, {"encoding", WireCodec::name(*encoding)}}}};
+                send_payload(hdl, websocketpp::frame::opcode::text, response.dump());
             }
             else
             {
@@ -286,8 +388,8 @@ void WebSocketServer::on_message(connection_hdl hdl, websocket_server::message_p
                 {"success", false},
                 {"message", "Internal server error"},
                 {"error", "Failed to process authentication"}};
-            server_.send(hdl, error_response.dump(), websocketpp::frame::opcode::text);
-            server_.close(hdl, websocketpp::close::status::internal_endpoint_error, "Internal server error");
+            send_json(hdl, error_response);
+            close_after_flush(hdl, websocketpp::close::status::internal_endpoint_error, "Internal server error");
         }
     }
     else
@@ -295,13 +397,28 @@ void WebSocketServer::on_message(connection_hdl hdl, websocket_server::message_p
         // 处理已认证用户的消息
         try
         {
-            auto json_msg = json::parse(msg->get_payload());
+            // 文本帧始终按 JSON 解析，二进制帧按认证时选择的编码解码
+            json json_msg;
+            if (msg->get_opcode() == websocketpp::frame::opcode::binary)
+            {
+                auto features = registry_.featuresOf(hdl);
+                if (!features || !WireCodec::isBinary(features->encoding))
+                {
+                    send_error(hdl, "Binary frames require a binary encoding");
+                    return;
+                }
+                json_msg = WireCodec::decode(msg->get_payload(), features->encoding);
+            }
+            else
+            {
+                json_msg = json::parse(msg->get_payload());
+            }
             handle_authenticated_message(hdl, user_id, json_msg);
         }
         catch (const json::exception &e)
         {
             LOG_ERROR << "JSON parsing error from user " << user_id << ": " << e.what();
-            send_error(hdl, "Invalid JSON format");
+            send_error(hdl, "Invalid message format");
         }
         catch (const std::exception &e)
         {
@@ -329,6 +446,10 @@ void WebSocketServer::handle_authenticated_message(connection_hdl hdl, const std
     {
         handle_chat_message(hdl, user_id, message);
     }
+    else if (msg_type == "resume")
+    {
+        handle_resume(hdl, user_id, message);
+    }
     else if (msg_type == "ping")
     {
         // 处理心跳消息
@@ -336,7 +457,7 @@ void WebSocketServer::handle_authenticated_message(connection_hdl hdl, const std
             {"success", true},
             {"message", "Pong response"},
             {"data", {{"type", "pong"}, {"timestamp", std::time(nullptr)}}}};
-        server_.send(hdl, pong_response.dump(), websocketpp::frame::opcode::text);
+        send_json(hdl, pong_response);
     }
     else
     {
@@ -351,38 +472,22 @@ void WebSocketServer::handle_join_room(connection_hdl hdl, const std::string &us
     {
         std::string room_id = message.at("room_id").get<std::string>();
 
-        std::lock_guard<std::mutex> lock(connection_mutex_); // 访问共享数据，进入临界区
-        // 检查用户是否在房间中
-        auto current_room_it = user_current_room_.find(user_id);
-        if (current_room_it != user_current_room_.end() && current_room_it->second == room_id)
+        // 已在其他房间时先离开原房间，整个切换在用户分片锁内完成，之后的发送和广播都不持有锁
+        auto joined = registry_.join(user_id, room_id);
+        if (joined.already_in_room)
         {
             LOG_WARN << "User " << user_id << " tried to join room " << room_id << " but is already in it.";
             send_error(hdl, "You are already in this room");
             return;
         }
-        // 如果用户已经在其他房间，先通知原房间其他用户然后离开
-        if (current_room_it != user_current_room_.end())
-        {
-            std::string old_room_id = current_room_it->second;
-
-            // 获取用户信息
-            auto user_info = db_manager_.getUserById(user_id);
-            std::string username = user_info ? user_info->getUsername() : user_id;
+        const std::string &old_room_id = joined.left_room;
 
-            // 通知原房间内其他用户该用户已离开
-            json leave_notification = {
-                {"success", true},
-                {"message", "User left room"},
-                {"data", {{"type", "user_left"}, {"user_id", user_id}, {"username", username}, {"room_id", old_room_id}}}};
-            broadcast_to_room(old_room_id, leave_notification.dump(), user_id); // 排除自己
-
-            // 然后从原房间移除用户
-            leave_room(user_id, old_room_id);
+        // 通知原房间内其他用户该用户已离开
+        if (!old_room_id.empty())
+        {
+            broadcast_presence("user_left", user_id, old_room_id);
         }
 
-        // 加入新房间
-        join_room(user_id, room_id);
-
         LOG_INFO << "User " << user_id << " joined room: " << room_id;
 
         // 发送成功响应给用户
@@ -390,18 +495,10 @@ void WebSocketServer::handle_join_room(connection_hdl hdl, const std::string &us
             {"success", true},
             {"message", "Room joined successfully"},
             {"data", {{"type", "room_joined"}, {"room_id", room_id}, {"user_id", user_id}}}};
-        server_.send(hdl, response.dump(), websocketpp::frame::opcode::text);
-
-        // 获取用户信息
-        auto user_info = db_manager_.getUserById(user_id);
-        std::string username = user_info ? user_info->getUsername() : user_id;
+        send_json(hdl, response);
 
         // 通知房间内其他用户
-        json notification = {
-            {"success", true},
-            {"message", "User joined room"},
-            {"data", {{"type", "user_joined"}, {"user_id", user_id}, {"username", username}, {"room_id", room_id}}}};
-        broadcast_to_room(room_id, notification.dump(), user_id); // 排除自己
+        broadcast_presence("user_joined", user_id, room_id);
     }
     catch (const json::exception &e)
     {
@@ -417,38 +514,26 @@ void WebSocketServer::handle_join_room(connection_hdl hdl, const std::string &us
 
 void WebSocketServer::handle_leave_room(connection_hdl hdl, const std::string &user_id, const json &message)
 {
-    std::lock_guard<std::mutex> lock(connection_mutex_);
-    auto current_room_it = user_current_room_.find(user_id);
-    if (current_room_it == user_current_room_.end())
+    // 先移除当前用户，之后的广播不会再发给自己
+    std::string room_id = registry_.leave(user_id);
+
+    if (room_id.empty())
     {
         send_error(hdl, "You are not in any room");
         return;
     }
 
-    std::string room_id = current_room_it->second;
-
     LOG_INFO << "User " << user_id << " left room: " << room_id;
 
-    // 获取用户信息
-    auto user_info = db_manager_.getUserById(user_id);
-    std::string username = user_info ? user_info->getUsername() : user_id;
-
-    // 先通知房间内其他用户，再移除当前用户
-    json notification = {
-        {"success", true},
-        {"message", "User left room"},
-        {"data", {{"type", "user_left"}, {"user_id", user_id}, {"username", username}, {"room_id", room_id}}}};
-    broadcast_to_room(room_id, notification.dump(), user_id); // 排除自己
-
-    // 然后移除用户
-    leave_room(user_id, room_id);
+    // 通知房间内其他用户
+    broadcast_presence("user_left", user_id, room_id);
 
     // 发送成功响应给用户
     json response = {
         {"success", true},
         {"message", "Room left successfully"},
         {"data", {{"type", "room_left"}, {"room_id", room_id}, {"user_id", user_id}}}};
-    server_.send(hdl, response.dump(), websocketpp::frame::opcode::text);
+    send_json(hdl, response);
 }
 
 void WebSocketServer::handle_chat_message(connection_hdl hdl, const std::string &user_id, const json &message)
@@ -457,47 +542,51 @@ void WebSocketServer::handle_chat_message(connection_hdl hdl, const std::string
     {
         int64_t timestamp = std::time(nullptr); // 只生成一次时间戳
         std::string content = message.at("content").get<std::string>();
-        std::string room_id;
-
-        { // 临界区开始
-            std::lock_guard<std::mutex> lock(connection_mutex_);
-            // 检查用户是否在房间中
-            auto current_room_it = user_current_room_.find(user_id);
-            if (current_room_it == user_current_room_.end())
-            {
-                send_error(hdl, "You must join a room before sending messages");
-                return;
-            }
-            room_id = current_room_it->second;
-        } // 锁释放
+        std::string room_id = registry_.currentRoom(user_id);
 
-        // 保存消息到数据库
-        try
+        if (room_id.empty())
         {
-            db_manager_.saveMessage(room_id, user_id, content, timestamp);
-            LOG_INFO << "Message saved to database from user " << user_id << " in room " << room_id;
+            send_error(hdl, "You must join a room before sending messages");
+            return;
         }
-        catch (const std::exception &e)
+
+        if (content.empty())
         {
-            LOG_ERROR << "Failed to save message to database: " << e.what();
-            send_error(hdl, "Failed to save message");
+            send_error(hdl, "Message content cannot be empty");
             return;
         }
 
-        // 获取用户信息
-        auto user_info = db_manager_.getUserById(user_id);
-        std::string username = user_info ? user_info->getUsername() : user_id;
+        // 事件循环只做到这里：持久化和查询用户名交给流水线，结果按房间顺序回到事件循环后再广播
+        bool accepted = pipeline_->submitChat(
+            {room_id, user_id, content, timestamp},
+            [this, hdl](const MessagePipeline::ChatMessage &chat, const MessagePipeline::Persisted &result)
+            {
+                if (!result.saved)
+                {
+                    LOG_ERROR << "Failed to save message to database from user " << chat.user_id << " in room " << chat.room_id;
+                    send_error(hdl, "Failed to save message");
+                    return;
+                }
+                LOG_INFO << "Message saved to database from user " << chat.user_id << " in room " << chat.room_id;
 
-        // 构造聊天消息
-        json chat_msg = {
-            {"success", true},
-            {"message", "Message sent successfully"},
-            {"data", {{"type", "message_received"}, {"user_id", user_id}, {"username", username}, {"room_id", room_id}, {"content", content}, {"timestamp", timestamp}}}};
+                // 构造聊天消息，seq 是消息ID，在房间内严格递增，断线重连时用于 resume
+                json chat_msg = {
+                    {"success", true},
+                    {"message", "Message sent successfully"},
+                    {"data", {{"type", "message_received"}, {"seq", result.message_id}, {"user_id", chat.user_id}, {"username", result.username}, {"room_id", chat.room_id}, {"content", chat.content}, {"timestamp", chat.timestamp}}}};
 
-        // 广播到房间内所有用户（包括发送者）
-        broadcast_to_room(room_id, chat_msg.dump());
+                // 广播到房间内所有用户（包括发送者）
+                broadcast_to_room(chat.room_id, chat_msg);
 
-        LOG_INFO << "Chat message from user " << user_id << " in room " << room_id;
+                LOG_INFO << "Chat message from user " << chat.user_id << " in room " << chat.room_id;
+            });
+
+        if (!accepted)
+        {
+            // 数据库执行器过载，明确告知客户端稍后重试
+            LOG_WARN << "Database executor overloaded, rejecting message from user " << user_id;
+            send_error(hdl, "Server busy, please retry later");
+        }
     }
     catch (const json::exception &e)
     {
@@ -506,25 +595,175 @@ void WebSocketServer::handle_chat_message(connection_hdl hdl, const std::string
     }
 }
 
-void WebSocketServer::join_room(const std::string &user_id, const std::string &room_id)
+void WebSocketServer::handle_resume(connection_hdl hdl, const std::string &user_id, const json &message)
 {
-    room_members_[room_id].insert(user_id);
-    user_current_room_[user_id] = room_id;
+    try
+    {
+        std::string room_id = message.at("room_id").get<std::string>();
+        int64_t last_seq = message.value("last_seq", static_cast<int64_t>(0));
+
+        struct Resume
+        {
+            MembershipStatus status = MembershipStatus::RoomNotFound;
+            bool complete = true;
+            std::vector<std::string> messages;
+        };
+        auto resume = std::make_shared<Resume>();
+
+        // 在房间的流水线上执行：读取缺口时之前提交的聊天消息都已保存，之后保存的消息在房间 strand 上
+        // 排在补发之后广播，补发时才加入在线成员，广播和补发之间既不重复也不遗漏
+        bool accepted = pipeline_->submit(
+            room_id,
+            [this, resume, room_id, user_id, last_seq]()
+            {
+                resume->status = db_manager_.checkMembership(room_id, user_id);
+                if (resume->status != MembershipStatus::Member)
+                {
+                    return;
+                }
+                resume->complete = db_manager_.getMessagesAfter(room_id, last_seq, kMaxResumeMessages, resume->messages);
+            },
+            [this, hdl, resume, room_id, user_id]()
+            {
+                if (resume->status != MembershipStatus::Member)
+                {
+                    send_error(hdl, resume->status == MembershipStatus::RoomNotFound ? "Room not found" : "You are not a member of this room");
+                    return;
+                }
+                auto joined = registry_.join(user_id, room_id);
+                if (joined.not_bound)
+                {
+                    return;
+                }
+                if (!joined.left_room.empty())
+                {
+                    broadcast_presence("user_left", user_id, joined.left_room);
+                }
+
+                json messages = json::array();
+                for (const auto &message_json : resume->messages)
+                {
+                    messages.push_back(json::parse(message_json));
+                }
+                LOG_INFO << "User " << user_id << " resumed room " << room_id << ", replaying " << messages.size() << " messages";
+                json response = {
+                    {"success", true},
+                    {"message", "Session resumed"},
+                    {"data", {{"type", "resumed"}, {"room_id", room_id}, {"messages", messages}, {"complete", resume->complete}}}};
+                send_json(hdl, response);
+
+                if (!joined.already_in_room)
+                {
+                    broadcast_presence("user_joined", user_id, room_id);
+                }
+            });
+
+        if (!accepted)
+        {
+            LOG_WARN << "Database executor overloaded, rejecting resume from user " << user_id;
+            send_error(hdl, "Server busy, please retry later");
+        }
+    }
+    catch (const json::exception &e)
+    {
+        LOG_ERROR << "Error resuming session for user " << user_id << ": " << e.what();
+        send_error(hdl, "Missing required field: room_id");
+    }
 }
 
-void WebSocketServer::leave_room(const std::string &user_id, const std::string &room_id)
+void WebSocketServer::broadcast_presence(const std::string &type, const std::string &user_id, const std::string &room_id)
 {
-    auto room_it = room_members_.find(room_id);
-    if (room_it != room_members_.end())
+    // 大房间逐个通知是 O(n²) 的帧数，改为每个窗口广播一次净变化
+    // 只取成员数，加入风暴中不为每次加入发布一次快照
+    auto recorded = presence_->record(room_id, user_id, type == "user_joined", registry_.memberCount(room_id));
+    if (recorded == PresenceCoalescer::RecordResult::WindowOpened)
     {
-        room_it->second.erase(user_id);
-        // 如果房间空了，删除房间
-        if (room_it->second.empty())
-        {
-            room_members_.erase(room_it);
-        }
+        server_.set_timer(presence_->options().window_ms, [this, room_id](const websocketpp::lib::error_code &ec)
+                          {
+                              if (!ec)
+                              {
+                                  flush_presence(room_id);
+                              } });
+    }
+    if (recorded != PresenceCoalescer::RecordResult::Individual)
+    {
+        return;
+    }
+
+    auto username = std::make_shared<std::string>(user_id);
+    auto notify = [this, type, user_id, room_id, username]()
+    {
+        json notification = {
+            {"success", true},
+            {"message", type == "user_joined" ? "User joined room" : "User left room"},
+            {"data", {{"type", type}, {"user_id", user_id}, {"username", *username}, {"room_id", room_id}}}};
+        broadcast_to_room(room_id, notification, user_id, true); // 排除自己，慢连接可以丢弃
+    };
+
+    // 用户名查询交给流水线，执行器过载时退化为直接用用户ID通知
+    if (!pipeline_->submit(room_id, [this, user_id, username]()
+                           {
+                               auto user_info = db_manager_.getUserById(user_id);
+                               if (user_info)
+                               {
+                                   *username = user_info->getUsername();
+                               } },
+                           notify))
+    {
+        notify();
+    }
+}
+
+void WebSocketServer::flush_presence(const std::string &room_id)
+{
+    auto delta = presence_->take(room_id);
+    if (!delta)
+    {
+        return; // 窗口内的变化全部抵消
+    }
+
+    auto changes = std::make_shared<json>(json{{"joined", json::array()}, {"left", json::array()}});
+    for (const auto &user_id : delta->joined)
+    {
+        (*changes)["joined"].push_back({{"user_id", user_id}, {"username", user_id}});
+    }
+    for (const auto &user_id : delta->left)
+    {
+        (*changes)["left"].push_back({{"user_id", user_id}, {"username", user_id}});
+    }
+    LOG_INFO << "Presence delta for room " << room_id << ": " << delta->joined.size() << " joined, " << delta->left.size() << " left";
+
+    auto notify = [this, room_id, changes]()
+    {
+        json notification = {
+            {"success", true},
+            {"message", "Room presence changed"},
+            {"data", {{"type", "presence_delta"}, {"room_id", room_id}, {"joined", (*changes)["joined"]}, {"left", (*changes)["left"]}}}};
+        // 整个房间共享一帧，不像逐个通知那样排除本人：窗口内加入的用户会在 joined 中看到自己（见 API 文档）
+        broadcast_to_room(room_id, notification, "", true); // 慢连接可以丢弃
+    };
+
+    // 与逐个通知相同：用户名在流水线上查询，执行器过载时退化为用户ID；整个窗口的用户一次批量查询
+    std::vector<std::string> user_ids = delta->joined;
+    user_ids.insert(user_ids.end(), delta->left.begin(), delta->left.end());
+    if (!pipeline_->submit(room_id, [this, changes, user_ids = std::move(user_ids)]()
+                           {
+                               auto usernames = db_manager_.getUsernames(user_ids);
+                               for (auto *list : {&(*changes)["joined"], &(*changes)["left"]})
+                               {
+                                   for (auto &entry : *list)
+                                   {
+                                       auto it = usernames.find(entry["user_id"].get<std::string>());
+                                       if (it != usernames.end())
+                                       {
+                                           entry["username"] = it->second;
+                                       }
+                                   }
+                               } },
+                           notify))
+    {
+        notify();
     }
-    user_current_room_.erase(user_id);
 }
 
 void WebSocketServer::send_error(connection_hdl hdl, const std::string &error_message)
@@ -533,63 +772,284 @@ void WebSocketServer::send_error(connection_hdl hdl, const std::string &error_me
         {"success", false},
         {"message", "Request failed"},
         {"error", error_message}};
-    try
-    {
-        server_.send(hdl, error_response.dump(), websocketpp::frame::opcode::text);
-    }
-    catch (const std::exception &e)
-    {
-        LOG_ERROR << "Failed to send error message: " << e.what();
-    }
+    send_json(hdl, error_response);
 }
 
-void WebSocketServer::broadcast_to_room(const std::string &room_id, const std::string &message)
+void WebSocketServer::broadcast_to_room(const std::string &room_id, const json &message)
 {
     broadcast_to_room(room_id, message, ""); // 空字符串表示不排除任何用户
 }
 
-void WebSocketServer::broadcast_to_room(const std::string &room_id, const std::string &message, const std::string &exclude_user_id)
+void WebSocketServer::broadcast_to_room(const std::string &room_id, const json &message, const std::string &exclude_user_id, bool droppable)
 {
-    std::vector<connection_hdl> connections_to_send; // 需要发送的连接
+    // 取出房间成员快照后不再持有任何锁，发送期间的加入/离开只影响之后的广播
+    auto members = registry_.members(room_id);
+    if (!members)
     {
-        // // 加上锁，安全地访问共享数据
-        // std::lock_guard<std::mutex> lock(connection_mutex_);
-        auto room_it = room_members_.find(room_id);
-        if (room_it == room_members_.end())
+        LOG_WARN << "Attempted to broadcast to non-existent or empty room: " << room_id;
+        return;
+    }
+
+    LOG_INFO << "Broadcasting message to " << members->size() << " users in room: " << room_id;
+
+    // 按成员选择的编码分组，每种编码只序列化一次；再按压缩特性分组，每组只成帧（和压缩）一次，
+    // 接收者的发送队列引用同一个消息对象
+    struct Encoded
+    {
+        bool ready = false;
+        std::string payload;
+        websocketpp::frame::opcode::value opcode = websocketpp::frame::opcode::text;
+        bool compress = false;
+        websocket_server::message_ptr plain_frame;
+        std::map<int, websocket_server::message_ptr> deflate_frames; // 窗口位数 -> 共享压缩帧
+    };
+    Encoded encodings[3]; // 下标为 WireEncoding
+    for (const auto &member : *members)
+    {
+        if (member.user_id == exclude_user_id)
         {
-            LOG_WARN << "Attempted to broadcast to non-existent or empty room: " << room_id;
-            return;
+            continue;
+        }
+        Encoded &encoded = encodings[static_cast<size_t>(member.features.encoding)];
+        if (!encoded.ready)
+        {
+            encoded.payload = WireCodec::encode(message, member.features.encoding);
+            encoded.opcode = WireCodec::isBinary(member.features.encoding) ? websocketpp::frame::opcode::binary : websocketpp::frame::opcode::text;
+            encoded.compress = deflate_options_.enabled && encoded.payload.size() >= deflate_options_.min_compress_size;
+            encoded.ready = true;
+        }
+        if (encoded.compress && member.features.deflate_context_takeover)
+        {
+            // 保留压缩上下文的连接只能用各自的压缩器
+            send_payload(member.hdl, encoded.opcode, encoded.payload, droppable);
+            continue;
         }
 
-        // 创建一个需要发送的连接的“快照”
-        for (const std::string &user_id : room_it->second)
+        bool deflate = encoded.compress && member.features.deflate;
+        websocket_server::message_ptr &frame = deflate ? encoded.deflate_frames[member.features.deflate_window_bits] : encoded.plain_frame;
+        if (!frame)
         {
-            if (user_id == exclude_user_id)
+            frame = make_shared_frame(member.hdl, encoded.opcode, encoded.payload, deflate ? member.features.deflate_window_bits : 0);
+            if (!frame)
             {
-                continue;
+                continue; // 该连接刚好关闭，换下一个成员创建
             }
+        }
+        enqueue_frame(member.hdl, frame, droppable);
+    }
+}
 
-            auto conn_it = user_connections_.find(user_id);
-            if (conn_it != user_connections_.end())
-            {
-                connections_to_send.push_back(conn_it->second);
-            }
+websocket_server::message_ptr WebSocketServer::make_shared_frame(connection_hdl hdl, websocketpp::frame::opcode::value opcode,
+                                                                const std::string &payload, int deflate_window_bits)
+{
+    websocketpp::lib::error_code ec;
+    auto connection = server_.get_con_from_hdl(hdl, ec);
+    if (ec)
+    {
+        return nullptr;
+    }
+    // 服务端帧不加掩码，帧头和负载与具体连接无关；标记为已准备好后 websocketpp 直接写出，不再重新成帧。
+    // 压缩帧不保留上下文，任何协商了相同窗口位数的连接都能解压
+    auto frame = connection->get_message(opcode, payload.size());
+    if (deflate_window_bits > 0)
+    {
+        std::string compressed;
+        if (!PermessageDeflate::compressMessage(deflate_window_bits, deflate_options_.level, payload, compressed))
+        {
+            LOG_ERROR << "Failed to compress broadcast frame";
+            return nullptr;
         }
-    } // 锁在这里被释放
+        frame->set_header(FrameHeader::encode(opcode, compressed.size(), true));
+        frame->set_payload(compressed);
+        frame->set_compressed(true);
+    }
+    else
+    {
+        frame->set_header(FrameHeader::encode(opcode, payload.size()));
+        frame->set_payload(payload);
+    }
+    frame->set_prepared(true);
+    return frame;
+}
 
-    LOG_INFO << "Broadcasting message to " << connections_to_send.size() << " users in room: " << room_id;
+void WebSocketServer::send_json(connection_hdl hdl, const json &message)
+{
+    auto features = registry_.featuresOf(hdl);
+    WireEncoding encoding = features ? features->encoding : WireEncoding::Json;
+    send_payload(hdl, WireCodec::isBinary(encoding) ? websocketpp::frame::opcode::binary : websocketpp::frame::opcode::text,
+                 WireCodec::encode(message, encoding));
+}
 
-    // 在不持有锁的情况下执行发送操作
-    for (const auto &hdl : connections_to_send)
+void WebSocketServer::send_payload(connection_hdl hdl, websocketpp::frame::opcode::value opcode, const std::string &payload, bool droppable)
+{
+    websocketpp::lib::error_code ec;
+    auto connection = server_.get_con_from_hdl(hdl, ec);
+    if (ec)
     {
-        try
+        LOG_ERROR << "Failed to send message: " << ec.message();
+        return;
+    }
+    // 未协商压缩的连接上 websocketpp 会忽略压缩标记
+    auto message = connection->get_message(opcode, payload.size());
+    message->set_payload(payload);
+    message->set_compressed(deflate_options_.enabled && payload.size() >= deflate_options_.min_compress_size);
+    enqueue_frame(hdl, message, droppable);
+}
+
+void WebSocketServer::enqueue_frame(connection_hdl hdl, const websocket_server::message_ptr &frame, bool droppable)
+{
+    // 在快照和发送的间隙，用户可能已经断开连接了，这是正常情况
+    websocketpp::lib::error_code ec;
+    auto connection = server_.get_con_from_hdl(hdl, ec);
+    if (ec)
+    {
+        return;
+    }
+
+    size_t bytes = frame->get_header().size() + frame->get_payload().size();
+    switch (connection->outbound.push(frame, bytes, droppable, connection->get_buffered_amount()))
+    {
+    case OutboundQueue::PushResult::ScheduleFlush:
+        // 本轮之后入队的帧都会赶上这次 flush；投递到连接的 strand 上，与 close_after_flush 保持顺序
+        connection->get_strand()->post([this, hdl]()
+                                       { flush_outbound(hdl); });
+        break;
+    case OutboundQueue::PushResult::Overflow:
+        LOG_WARN << "Outbound queue limit exceeded, closing slow connection " << connection->get_remote_endpoint();
+        connection->close(kSlowConsumerCloseCode, "Outbound queue limit exceeded", ec);
+        break;
+    default:
+        break;
+    }
+}
+
+void WebSocketServer::flush_outbound(connection_hdl hdl)
+{
+    websocketpp::lib::error_code ec;
+    auto connection = server_.get_con_from_hdl(hdl, ec);
+    if (ec)
+    {
+        return;
+    }
+
+    bool more = false;
+    for (auto &frame : connection->outbound.takeBatch(connection->get_buffered_amount(), more))
+    {
+        ec = connection->send(std::static_pointer_cast<websocket_server::message_ptr::element_type>(frame));
+        if (ec)
         {
-            server_.send(hdl, message, websocketpp::frame::opcode::text);
+            LOG_ERROR << "Failed to send message: " << ec.message();
         }
-        catch (const websocketpp::exception &e)
+    }
+    if (more)
+    {
+        // 传输层缓冲已满，等它写出一部分后再交下一批；websocketpp 没有写完成回调，只能定时重试。
+        // 定时器回调不在连接的 strand 上，重试同样投递到 strand，与 enqueue_frame 安排的 flush 和
+        // close_after_flush 串行，帧不会乱序
+        auto strand = connection->get_strand();
+        server_.set_timer(kFlushRetryMs, [this, hdl, strand](const websocketpp::lib::error_code &timer_ec)
+                          {
+                              if (!timer_ec)
+                              {
+                                  strand->post([this, hdl]()
+                                               { flush_outbound(hdl); });
+                              } });
+    }
+}
+
+void WebSocketServer::close_after_flush(connection_hdl hdl, websocketpp::close::status::value code, const std::string &reason)
+{
+    websocketpp::lib::error_code ec;
+    auto connection = server_.get_con_from_hdl(hdl, ec);
+    if (ec)
+    {
+        return;
+    }
+    // 排在已安排的 flush 之后，关闭帧不会抢在最后的错误响应前面
+    connection->get_strand()->post([this, hdl, code, reason]()
+                                   {
+                                       websocketpp::lib::error_code close_ec;
+                                       server_.close(hdl, code, reason, close_ec);
+                                       if (close_ec)
+                                       {
+                                           LOG_ERROR << "Error closing connection: " << close_ec.message();
+                                       } });
+}
+
+json WebSocketServer::heartbeat_stats() const
+{
+    if (!heartbeat_)
+    {
+        return {{"enabled", false}};
+    }
+    auto stats = heartbeat_->stats();
+    return {{"enabled", true},
+            {"interval_ms", heartbeat_->options().interval_ms},
+            {"max_missed", heartbeat_->options().max_missed},
+            {"tracked_connections", stats.tracked},
+            {"pings_sent", stats.pings},
+            {"evicted_connections", stats.evicted}};
+}
+
+json WebSocketServer::presence_stats() const
+{
+    auto stats = presence_->stats();
+    return {{"window_ms", presence_->options().window_ms},
+            {"member_threshold", presence_->options().member_threshold},
+            {"pending_rooms", stats.pending_rooms},
+            {"coalesced_events", stats.events},
+            {"deltas_sent", stats.deltas},
+            {"cancelled_users", stats.cancelled}};
+}
+
+json WebSocketServer::outbound_stats()
+{
+    json connections = json::array();
+    size_t queued_messages = 0;
+    size_t queued_bytes = 0;
+    uint64_t dropped_messages = 0;
+    for (const auto &hdl : registry_.connections())
+    {
+        websocketpp::lib::error_code ec;
+        auto connection = server_.get_con_from_hdl(hdl, ec);
+        if (ec)
         {
-            // 在快照和发送的间隙，用户可能已经断开连接了，这是正常情况
-            LOG_ERROR << "Failed to send message during broadcast: " << e.what();
+            continue;
         }
+        auto stats = connection->outbound.stats();
+        queued_messages += stats.queued_messages;
+        queued_bytes += stats.queued_bytes;
+        dropped_messages += stats.dropped_messages;
+        connections.push_back({{"user_id", registry_.userOf(hdl).value_or("")},
+                               {"queued_messages", stats.queued_messages},
+                               {"queued_bytes", stats.queued_bytes},
+                               {"transport_buffered_bytes", connection->get_buffered_amount()},
+                               {"peak_messages", stats.peak_messages},
+                               {"peak_bytes", stats.peak_bytes},
+                               {"dropped_messages", stats.dropped_messages},
+                               {"flushes", stats.flushes},
+                               {"flushed_messages", stats.flushed_messages}});
     }
-}
\ No newline at end of file
+    return {{"connections", connections},
+            {"total", {{"connections", connections.size()}, {"queued_messages", queued_messages}, {"queued_bytes", queued_bytes}, {"dropped_messages", dropped_messages}}}};
+}
+
+ConnectionRegistry::Features WebSocketServer::connection_features(connection_hdl hdl)
+{
+    ConnectionRegistry::Features features;
+    websocketpp::lib::error_code ec;
+    auto connection = server_.get_con_from_hdl(hdl, ec);
+    if (ec)
+    {
+        return features;
+    }
+    // 握手响应中的扩展头就是协商结果
+    auto params = PermessageDeflate::parseHeader(connection->get_response_header("Sec-WebSocket-Extensions"));
+    if (params)
+    {
+        features.deflate = true;
+        features.deflate_context_takeover = !params->server_no_context_takeover;
+        features.deflate_window_bits = params->server_max_window_bits;
+    }
+    return features;
+}
@@ -1,55 +1,61 @@
 #pragma once
 
-#include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
 #include <nlohmann/json.hpp>
 #include <thread>
+#include <vector>
 #include <cstdint>
 #include <functional>
-#include <unordered_map>
-#include <mutex>
-#include <set>
 #include <string>
 #include <memory>
+#include "websocket_config.hpp"
+#include "connection_registry.hpp"
+#include "message_pipeline.hpp"
+#include "presence_coalescer.hpp"
 
 // 前向声明
 class DatabaseManager;
 
-using websocket_server = websocketpp::server<websocketpp::config::asio>;
+using websocket_server = websocketpp::server<WebSocketConfig>;
 using connection_hdl = websocketpp::connection_hdl;
 
-// 为 connection_hdl 定义哈希函数和相等比较函数
-struct ConnectionHdlHash
-{
-    std::size_t operator()(const connection_hdl &hdl) const
-    {
-        return std::hash<void *>()(hdl.lock().get());
-    }
-};
-
-struct ConnectionHdlEqual
-{
-    bool operator()(const connection_hdl &a, const connection_hdl &b) const
-    {
-        return a.lock() == b.lock();
-    }
-};
-
 class WebSocketServer
 {
 public:
-    explicit WebSocketServer(DatabaseManager &db_manager);
+    // io_threads: 运行 asio 事件循环的线程数，同一连接的回调由连接自己的 strand 串行执行
+    explicit WebSocketServer(DatabaseManager &db_manager, size_t io_threads = 1);
     ~WebSocketServer();
 
-    // 在指定端口启动WebSocket服务器
+    // 在指定端口开始监听，并启动事件循环线程后立即返回
     void run(uint16_t port);
 
     // 停止WebSocket服务器
     void stop();
 
-    // 广播消息到房间
-    void broadcast_to_room(const std::string &room_id, const std::string &message);
-    void broadcast_to_room(const std::string &room_id, const std::string &message, const std::string &exclude_user_id);
+    // 每个连接出站队列的高水位和超限策略，需在 run 之前设置
+    void set_outbound_limits(const OutboundQueue::Limits &limits);
+    // 服务端心跳：空闲 interval_ms 的连接收到协议层 ping，连续 max_missed 次无响应后驱逐；
+    // interval_ms 为 0 时关闭。需在 run 之前设置
+    void set_heartbeat_options(const HeartbeatWheel::Options &options);
+    // 上下线通知的合并窗口和房间人数阈值，需在 run 之前设置
+    void set_presence_options(const PresenceCoalescer::Options &options);
+    // 单条消息的字节数上限，超过时以 1009 关闭连接；压缩消息解压后的上限在 PermessageDeflate::Options 中设置
+    void set_max_message_size(size_t bytes);
+    // 各已认证连接的出站队列深度
+    nlohmann::json outbound_stats();
+    // 心跳时间轮的统计
+    nlohmann::json heartbeat_stats() const;
+    // 上下线通知合并的统计
+    nlohmann::json presence_stats() const;
+
+    // 出站队列超限时关闭连接使用的关闭码
+    static constexpr websocketpp::close::status::value kSlowConsumerCloseCode = 4008;
+
+    // 广播消息到房间，按成员选择的编码各序列化一次
+    void broadcast_to_room(const std::string &room_id, const nlohmann::json &message);
+    // droppable: 接收者出站队列超限时可以丢弃的事件（如上下线通知）
+    void broadcast_to_room(const std::string &room_id, const nlohmann::json &message, const std::string &exclude_user_id,
+                           bool droppable = false);
 
 private:
     // 初始化服务器，绑定事件处理程序
@@ -59,30 +65,67 @@ private:
     void on_open(connection_hdl hdl);
     void on_close(connection_hdl hdl);
     void on_message(connection_hdl hdl, websocket_server::message_ptr msg);
+    bool on_ping(connection_hdl hdl, std::string payload);
+    void on_pong(connection_hdl hdl, std::string payload);
+
+    // 解除连接的登记，用户离开房间并通知其他成员
+    void release_connection(connection_hdl hdl);
+    // 记录连接的活动时间，收到任何消息、ping 或 pong 时调用
+    void touch_connection(connection_hdl hdl);
+    // 时间轮的 tick，处理到期的连接后安排下一次
+    void schedule_heartbeat();
+    // 连续多次 ping 无响应：立即从房间中移除，再关闭连接
+    void evict_idle(connection_hdl hdl);
 
     // 消息处理辅助方法
     void handle_authenticated_message(connection_hdl hdl, const std::string &user_id, const nlohmann::json &message);
     void handle_join_room(connection_hdl hdl, const std::string &user_id, const nlohmann::json &message);
     void handle_leave_room(connection_hdl hdl, const std::string &user_id, const nlohmann::json &message);
     void handle_chat_message(connection_hdl hdl, const std::string &user_id, const nlohmann::json &message);
+    // 断线重连：重新加入房间并补发 last_seq 之后的消息
+    void handle_resume(connection_hdl hdl, const std::string &user_id, const nlohmann::json &message);
 
-    // 房间管理辅助方法
-    void join_room(const std::string &user_id, const std::string &room_id);
-    void leave_room(const std::string &user_id, const std::string &room_id);
     void send_error(connection_hdl hdl, const std::string &error_message);
 
+    // 把负载编码成已成帧的消息，广播时所有接收者共享同一份缓冲区；连接已关闭时返回空。
+    // deflate_window_bits > 0 时按该窗口位数压缩一次并置 RSV1
+    websocket_server::message_ptr make_shared_frame(connection_hdl hdl, websocketpp::frame::opcode::value opcode,
+                                                    const std::string &payload, int deflate_window_bits = 0);
+    // 单播消息，按连接认证时选择的编码序列化，未认证的连接使用 JSON
+    void send_json(connection_hdl hdl, const nlohmann::json &message);
+    // 单播已编码的负载，达到压缩阈值时交给连接的 permessage-deflate 压缩
+    void send_payload(connection_hdl hdl, websocketpp::frame::opcode::value opcode, const std::string &payload, bool droppable = false);
+    // 所有发送都经过连接的出站队列；同一轮入队的帧由一次 flush 交给 websocketpp
+    void enqueue_frame(connection_hdl hdl, const websocket_server::message_ptr &frame, bool droppable);
+    void flush_outbound(connection_hdl hdl);
+    // 先把已入队的帧交给 websocketpp 再关闭连接，用于发送错误响应后断开
+    void close_after_flush(connection_hdl hdl, websocketpp::close::status::value code, const std::string &reason);
+    static constexpr long kFlushRetryMs = 20; // 传输层缓冲已满时重试 flush 的间隔
+    static constexpr int kMaxResumeMessages = 200; // 一次 resume 最多补发的消息数
+    // 读取握手时协商的扩展
+    ConnectionRegistry::Features connection_features(connection_hdl hdl);
+
+    // 向房间广播 user_joined/user_left 通知，用户名经消息流水线异步查询，与房间内的聊天消息保持顺序；
+    // 在线成员超过阈值的房间并入合并窗口
+    void broadcast_presence(const std::string &type, const std::string &user_id, const std::string &room_id);
+    // 合并窗口结束：把房间窗口内的净变化作为一条 presence_delta 广播
+    void flush_presence(const std::string &room_id);
+
     websocket_server server_;             // WebSocket服务器实例
-    std::thread server_thread_;           // 服务器运行线程
-    mutable std::mutex connection_mutex_; // 保护连接的互斥锁
+    size_t io_thread_count_;              // 事件循环线程数
+    PermessageDeflate::Options deflate_options_; // 压缩配置，构造时取自 PermessageDeflate::options()
+    OutboundQueue::Limits outbound_limits_; // 新连接的出站队列限制
+    HeartbeatWheel::Options heartbeat_options_; // 心跳配置
+    std::unique_ptr<HeartbeatWheel> heartbeat_; // 心跳时间轮，run 时按配置创建，关闭心跳时为空
+    std::unique_ptr<PresenceCoalescer> presence_; // 大房间上下线通知的合并
+    std::vector<std::thread> io_threads_; // 事件循环线程
 
     // 数据库管理器引用
     DatabaseManager &db_manager_;
 
-    // 用户和连接管理
-    std::unordered_map<std::string, connection_hdl> user_connections_;                                        // 用户ID到连接句柄的映射
-    std::unordered_map<connection_hdl, std::string, ConnectionHdlHash, ConnectionHdlEqual> connection_users_; // 连接句柄到用户ID的映射
+    // 已认证连接和房间在线成员，分片加锁，广播遍历成员快照时不持有锁
+    ConnectionRegistry registry_;
 
-    // 房间管理
-    std::unordered_map<std::string, std::set<std::string>> room_members_; // 房间ID到用户ID集合的映射
-    std::unordered_map<std::string, std::string> user_current_room_;      // 用户ID到当前房间ID的映射
+    // 聊天消息的持久化和广播流水线，依赖 init_asio 之后的 io_service
+    std::unique_ptr<MessagePipeline> pipeline_;
 };
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "wire_codec.hpp"
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+std::optional<WireEncoding> WireCodec::parse(const std::string &name)
+{
+    if (name == "json")
+    {
+        return WireEncoding::Json;
+    }
+    if (name == "msgpack")
+    {
+        return WireEncoding::MessagePack;
+    }
+    if (name == "cbor")
+    {
+        return WireEncoding::Cbor;
+    }
+    return std::nullopt;
+}
+
+const char *WireCodec::name(WireEncoding encoding)
+{
+    switch (encoding)
+    {
+    case WireEncoding::MessagePack:
+        return "msgpack";
+    case WireEncoding::Cbor:
+        return "cbor";
+    default:
+        return "json";
+    }
+}
+
+std::string WireCodec::encode(const json &message, WireEncoding encoding)
+{
+    std::string payload;
+    switch (encoding)
+    {
+    case WireEncoding::MessagePack:
+        json::to_msgpack(message, nlohmann::detail::output_adapter<char>(payload));
+        break;
+    case WireEncoding::Cbor:
+        json::to_cbor(message, nlohmann::detail::output_adapter<char>(payload));
+        break;
+    default:
+        payload = message.dump();
+        break;
+    }
+    return payload;
+}
+
+json WireCodec::decode(const std::string &payload, WireEncoding encoding)
+{
+    switch (encoding)
+    {
+    case WireEncoding::MessagePack:
+        return json::from_msgpack(payload);
+    case WireEncoding::Cbor:
+        return json::from_cbor(payload);
+    default:
+        return json::parse(payload);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <nlohmann/json_fwd.hpp>
+
+// WebSocket 消息的编码方式，客户端在 auth 消息中通过 encoding 字段选择
+enum class WireEncoding : uint8_t
+{
+    Json,        // 文本帧
+    MessagePack, // 二进制帧
+    Cbor         // 二进制帧
+};
+
+// 消息编解码：消息结构在各种编码下完全相同，只是序列化格式不同
+class WireCodec
+{
+public:
+    // "json" / "msgpack" / "cbor"，不支持的名称返回空
+    static std::optional<WireEncoding> parse(const std::string &name);
+    static const char *name(WireEncoding encoding);
+    // JSON 用文本帧，其余用二进制帧
+    static bool isBinary(WireEncoding encoding) { return encoding != WireEncoding::Json; }
+
+    static std::string encode(const nlohmann::json &message, WireEncoding encoding);
+    // 格式错误时抛出 nlohmann::json::exception
+    static nlohmann::json decode(const std::string &payload, WireEncoding encoding);
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "../../src/db/database_manager.hpp"
+
+// 数据库测试共用的辅助函数：临时库文件、清理、造数据和用独立连接访问库文件
+namespace db_test {
+
+// 分片文件最多清理到这个编号
+constexpr size_t kMaxShards = 16;
+
+// 返回一个不与其他测试冲突的库文件路径
+inline std::string tempDbPath(const std::string &prefix) {
+    return prefix + "_" + std::to_string(rand()) + ".sqlite";
+}
+
+// 删除库文件及其 WAL、分片文件和消息日志目录
+inline void removeDatabase(const std::string &path) {
+    for (const auto &file : {path, path + "-wal", path + "-shm"}) {
+        std::remove(file.c_str());
+    }
+    for (size_t i = 0; i < kMaxShards; ++i) {
+        std::string shard = path + ".shard" + std::to_string(i);
+        for (const auto &file : {shard, shard + "-wal", shard + "-shm"}) {
+            std::remove(file.c_str());
+        }
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(path + ".msglog", ec);
+}
+
+// 返回用户ID，用户不存在时先创建
+inline std::string ensureUser(DatabaseManager &db, const std::string &username) {
+    if (!db.getUserByUsername(username)) {
+        db.createUser(username, "pass");
+    }
+    return db.getUserByUsername(username)->getId();
+}
+
+// 由 writer 创建房间，按顺序写入 contents，时间戳从 first_timestamp 开始每条加一
+inline std::string seedRoom(DatabaseManager &db, const std::string &name, const std::vector<std::string> &contents,
+                            int64_t first_timestamp = 0) {
+    auto writer_id = ensureUser(db, "writer");
+    auto room_id = db.createRoom(name, "", writer_id)->getId();
+    for (size_t i = 0; i < contents.size(); ++i) {
+        db.saveMessage(room_id, writer_id, contents[i], first_timestamp + static_cast<int64_t>(i));
+    }
+    return room_id;
+}
+
+// 同上，写入 count 条 "Message <i>"
+inline std::string seedRoom(DatabaseManager &db, const std::string &name, int count, int64_t first_timestamp) {
+    std::vector<std::string> contents;
+    for (int i = 0; i < count; ++i) {
+        contents.push_back("Message " + std::to_string(i));
+    }
+    return seedRoom(db, name, contents, first_timestamp);
+}
+
+// 用独立连接执行 SQL
+inline bool execSql(const std::string &path, const std::string &sql) {
+    sqlite3 *db;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        sqlite3_close(db);
+        return false;
+    }
+    int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+    return rc == SQLITE_OK;
+}
+
+// 用只读连接执行查询，返回第一行第一列
+inline std::optional<std::string> queryValue(const std::string &path, const std::string &sql) {
+    sqlite3 *db;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        sqlite3_close(db);
+        return std::nullopt;
+    }
+    std::optional<std::string> value;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0)) {
+            value = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(db);
+    return value;
+}
+
+} // namespace db_test
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "db_test_support.hpp"
+
+// 在线备份测试固件，每个测试使用独立的数据库文件
+class DatabaseBackupTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        db_path_ = db_test::tempDbPath("test_backup");
+        backup_path_ = db_path_ + ".bak";
+    }
+
+    void TearDown() override {
+        db_test::removeDatabase(db_path_);
+        db_test::removeDatabase(backup_path_);
+        for (const auto &path : extra_files_) {
+            std::remove(path.c_str());
+        }
+    }
+
+    static bool exists(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "r");
+        if (file) {
+            std::fclose(file);
+        }
+        return file != nullptr;
+    }
+
+    // 创建一个空文件，测试结束时删除
+    void touch(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        ASSERT_NE(file, nullptr);
+        std::fclose(file);
+        extra_files_.push_back(path);
+    }
+
+    // 等待备份结束，返回最终进度
+    static DatabaseBackup::Progress waitForBackup(DatabaseBackup &backup) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+        while (backup.isRunning() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return backup.getProgress();
+    }
+
+    // 用独立连接检查备份文件完整并返回消息条数
+    static int64_t checkBackup(const std::string &path) {
+        if (db_test::queryValue(path, "PRAGMA integrity_check;") != "ok") {
+            return -1;
+        }
+        auto count = db_test::queryValue(path, "SELECT COUNT(*) FROM messages;");
+        return count ? std::stoll(*count) : -1;
+    }
+
+    static double percentile(std::vector<double> samples, double p) {
+        if (samples.empty()) {
+            return 0;
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(samples.size() * p))];
+    }
+
+    // 写入一条消息并返回耗时（微秒）
+    static double timedInsert(DatabaseManager &db, const std::string &room_id, const std::string &user_id, int i) {
+        auto begin = std::chrono::steady_clock::now();
+        EXPECT_TRUE(db.saveMessage(room_id, user_id, "live message " + std::to_string(i), 100000 + i));
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    std::string db_path_;
+    std::string backup_path_;
+    std::vector<std::string> extra_files_;
+};
+
+// 备份分多步进行，期间前台写入不被阻塞，备份文件完整且包含备份期间的写入；
+// 同时对比备份前后插入延迟的 p99
+TEST_F(DatabaseBackupTest, CopiesWhileWriting) {
+    DatabaseManager db(db_path_);
+    auto user_id = db_test::ensureUser(db, "writer");
+    auto room_id = db.createRoom("backup", "", user_id)->getId();
+    std::string payload(1500, 'x');
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_TRUE(db.saveMessage(room_id, user_id, payload + std::to_string(i), i));
+    }
+
+    std::vector<double> baseline;
+    for (int i = 0; i < 1000; ++i) {
+        baseline.push_back(timedInsert(db, room_id, user_id, i));
+    }
+
+    DatabaseBackup::Options options;
+    options.pages_per_step = 32;
+    options.step_interval = std::chrono::milliseconds(1);
+    db.getBackup().setOptions(options);
+    ASSERT_TRUE(db.getBackup().start(backup_path_));
+    ASSERT_FALSE(db.getBackup().start(backup_path_ + "2")); // 同一时间只允许一个备份
+
+    std::vector<double> during;
+    while (db.getBackup().isRunning()) {
+        during.push_back(timedInsert(db, room_id, user_id, 1000 + static_cast<int>(during.size())));
+    }
+    auto progress = waitForBackup(db.getBackup());
+    ASSERT_EQ(progress.state, DatabaseBackup::State::Done) << progress.error;
+    ASSERT_EQ(progress.files_done, 1);
+    ASSERT_EQ(progress.percent(), 100.0);
+    ASSERT_GT(progress.steps, 10);
+    ASSERT_GT(during.size(), 0);
+
+    // 经同一连接的写入会同步到备份中，备份结束前写入的消息都在备份里
+    int64_t backed_up = checkBackup(backup_path_);
+    ASSERT_GE(backed_up, 6000);
+    ASSERT_LE(backed_up, 6000 + static_cast<int64_t>(during.size()));
+    ASSERT_EQ(std::fopen((backup_path_ + ".tmp").c_str(), "r"), nullptr);
+
+    double p99_baseline = percentile(baseline, 0.99);
+    double p99_during = percentile(during, 0.99);
+    std::cout << "insert p99 without backup: " << p99_baseline << " us, during backup: " << p99_during
+              << " us (" << during.size() << " inserts, " << progress.steps << " steps)" << std::endl;
+    RecordProperty("insert_p99_baseline_us", static_cast<int>(p99_baseline));
+    RecordProperty("insert_p99_during_backup_us", static_cast<int>(p99_during));
+
+    // 备份文件可以直接作为数据库打开
+    DatabaseManager restored(backup_path_);
+    ASSERT_TRUE(restored.isConnected());
+    ASSERT_TRUE(restored.getUserByUsername("writer").has_value());
+    ASSERT_EQ(restored.getRecentMessages(room_id, 1).front().getContent(), "live message " + std::to_string(backed_up - 5001));
+}
+
+// 分片库逐个备份，文件命名与分片一致；内存引擎不支持备份
+TEST_F(DatabaseBackupTest, ShardsAndMemoryEngine) {
+    std::vector<std::string> rooms;
+    {
+        DatabaseManager db(db_path_, 2);
+        for (int r = 0; r < 4; ++r) {
+            rooms.push_back(db_test::seedRoom(db, "room" + std::to_string(r), 50, 0));
+        }
+        ASSERT_EQ(db.getBackup().defaultDestination().rfind(db_path_ + ".backup-", 0), 0);
+        ASSERT_TRUE(db.getBackup().start(backup_path_));
+        auto progress = waitForBackup(db.getBackup());
+        ASSERT_EQ(progress.state, DatabaseBackup::State::Done) << progress.error;
+        ASSERT_EQ(progress.files_total, 3);
+        ASSERT_EQ(progress.files_done, 3);
+        ASSERT_EQ(progress.toJson()["state"], "done");
+    }
+    ASSERT_EQ(checkBackup(backup_path_ + ".shard0") + checkBackup(backup_path_ + ".shard1"), 200);
+
+    DatabaseManager restored(backup_path_, 2);
+    for (const auto &room_id : rooms) {
+        ASSERT_EQ(restored.getRecentMessages(room_id, 100).size(), 50);
+    }
+
+    DatabaseManager memory(DatabaseManager::kMemoryEnginePath);
+    ASSERT_TRUE(memory.getBackup().defaultDestination().empty());
+    ASSERT_FALSE(memory.getBackup().start(backup_path_));
+    ASSERT_EQ(memory.getBackup().getProgress().state, DatabaseBackup::State::Idle);
+}
+
+// 备份完成后只保留最新的 keep_backups 份默认路径备份，旧备份的分片一起删除，其他文件不动
+TEST_F(DatabaseBackupTest, PrunesOldBackups) {
+    DatabaseManager db(db_path_, 2);
+    std::vector<std::string> old_backups;
+    for (int i = 0; i < 4; ++i) {
+        std::string path = db_path_ + ".backup-20200101-00000" + std::to_string(i);
+        old_backups.push_back(path);
+        touch(path);
+        touch(path + ".shard0");
+        touch(path + ".shard1");
+    }
+    touch(db_path_ + ".backup-manual");
+
+    DatabaseBackup::Options options = db.getBackup().getOptions();
+    options.keep_backups = 2;
+    db.getBackup().setOptions(options);
+    std::string destination = db.getBackup().defaultDestination();
+    extra_files_.insert(extra_files_.end(), {destination, destination + ".shard0", destination + ".shard1"});
+    ASSERT_TRUE(db.getBackup().start(destination));
+    auto progress = waitForBackup(db.getBackup());
+    ASSERT_EQ(progress.state, DatabaseBackup::State::Done) << progress.error;
+
+    ASSERT_TRUE(exists(destination));
+    ASSERT_TRUE(exists(destination + ".shard1"));
+    ASSERT_TRUE(exists(old_backups[3]));
+    ASSERT_TRUE(exists(old_backups[3] + ".shard0"));
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_FALSE(exists(old_backups[i])) << old_backups[i];
+        ASSERT_FALSE(exists(old_backups[i] + ".shard0"));
+        ASSERT_FALSE(exists(old_backups[i] + ".shard1"));
+    }
+    ASSERT_TRUE(exists(db_path_ + ".backup-manual"));
+}
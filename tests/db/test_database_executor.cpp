@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../../src/db/database_executor.hpp"
+
+// 任务按提交顺序在执行器线程上执行
+TEST(DatabaseExecutorTest, ExecutesTasksInOrder) {
+    DatabaseExecutor executor(1, 100);
+    std::vector<int> order;
+    std::mutex order_mutex;
+
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_TRUE(executor.trySubmit([&order, &order_mutex, i]() {
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(i);
+        }));
+    }
+    executor.stop();
+
+    ASSERT_EQ(order.size(), 50);
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_EQ(order[i], i);
+    }
+}
+
+// 通过 future 获取任务结果，且任务不在调用线程上执行
+TEST(DatabaseExecutorTest, SubmitReturnsFuture) {
+    DatabaseExecutor executor;
+    auto caller_id = std::this_thread::get_id();
+
+    auto future_opt = executor.submit([caller_id]() {
+        return std::this_thread::get_id() != caller_id ? 42 : -1;
+    });
+    ASSERT_TRUE(future_opt.has_value());
+    ASSERT_EQ(future_opt->get(), 42);
+}
+
+// 队列满时拒绝新任务，而不是无限排队
+TEST(DatabaseExecutorTest, RejectsWhenQueueFull) {
+    DatabaseExecutor executor(1, 2);
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::promise<void> started;
+
+    // 第一个任务占住工作线程
+    ASSERT_TRUE(executor.trySubmit([gate, &started]() {
+        started.set_value();
+        gate.wait();
+    }));
+    started.get_future().wait();
+
+    // 队列容量为2
+    ASSERT_TRUE(executor.trySubmit([]() {}));
+    ASSERT_TRUE(executor.trySubmit([]() {}));
+    ASSERT_EQ(executor.pendingCount(), 2);
+
+    ASSERT_FALSE(executor.trySubmit([]() {}));
+    ASSERT_FALSE(executor.submit([]() { return 1; }).has_value());
+    ASSERT_EQ(executor.rejectedCount(), 2);
+
+    release.set_value();
+    executor.stop();
+    ASSERT_EQ(executor.pendingCount(), 0);
+}
+
+// 停止时执行完已入队的任务，停止后不再接受新任务
+TEST(DatabaseExecutorTest, StopDrainsQueue) {
+    std::atomic<int> counter{0};
+    DatabaseExecutor executor(2, 100);
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(executor.trySubmit([&counter]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            counter++;
+        }));
+    }
+    executor.stop();
+    ASSERT_EQ(counter.load(), 20);
+    ASSERT_FALSE(executor.trySubmit([&counter]() { counter++; }));
+}
+
+// 任务抛出的异常通过 future 传递给调用方，不会影响执行器线程
+TEST(DatabaseExecutorTest, ExceptionPropagatesThroughFuture) {
+    DatabaseExecutor executor;
+    auto failing = executor.submit([]() -> int { throw std::runtime_error("db error"); });
+    ASSERT_TRUE(failing.has_value());
+    ASSERT_THROW(failing->get(), std::runtime_error);
+
+    auto ok = executor.submit([]() { return 7; });
+    ASSERT_TRUE(ok.has_value());
+    ASSERT_EQ(ok->get(), 7);
+}
+
+// 同一 key 的任务按提交顺序串行执行，不同 key 在多个工作线程上并行；
+// 排队中的通道任务计入队列上限，停止时同样会被执行完
+TEST(DatabaseExecutorTest, KeyedTasksKeepOrder) {
+    DatabaseExecutor executor(4, 10000);
+    const int keys = 8;
+    const int per_key = 200;
+    std::vector<std::vector<int>> order(keys);
+    std::vector<std::atomic<int>> running(keys);
+    std::atomic<int> overlaps{0};
+
+    for (int i = 0; i < per_key; ++i) {
+        for (int k = 0; k < keys; ++k) {
+            ASSERT_TRUE(executor.trySubmit("room" + std::to_string(k), [&, k, i]() {
+                if (++running[k] > 1) {
+                    ++overlaps;
+                }
+                order[k].push_back(i); // 同一通道串行执行，不需要加锁
+                --running[k];
+            }));
+        }
+    }
+    executor.stop();
+
+    ASSERT_EQ(overlaps, 0);
+    for (int k = 0; k < keys; ++k) {
+        ASSERT_EQ(order[k].size(), per_key);
+        for (int i = 0; i < per_key; ++i) {
+            ASSERT_EQ(order[k][i], i);
+        }
+    }
+
+    DatabaseExecutor small(1, 2);
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::promise<void> started;
+    ASSERT_TRUE(small.trySubmit("room", [gate, &started]() {
+        started.set_value();
+        gate.wait();
+    }));
+    started.get_future().wait();
+    ASSERT_TRUE(small.trySubmit("room", []() {}));
+    ASSERT_TRUE(small.trySubmit("other", []() {}));
+    ASSERT_EQ(small.pendingCount(), 2);
+    ASSERT_FALSE(small.trySubmit("room", []() {}));
+    release.set_value();
+}
@@ -4,6 +4,9 @@
 #include <vector>
 #include <optional>
 #include <cstdio>
+#include <chrono>
+#include <future>
+#include <nlohmann/json.hpp>
 #include "../../src/db/database_manager.hpp" // 请确保路径正确
 
 // 测试固件 (无需修改)
@@ -105,6 +108,273 @@ TEST_F(DatabaseManagerTest, RoomAndMemberLifecycle) {
     ASSERT_FALSE(db_manager_->getRoomById(room_id).has_value());
 }
 
+TEST_F(DatabaseManagerTest, RoomMemberIndex) {
+    db_manager_->createUser("idx_owner", "pass_owner");
+    db_manager_->createUser("idx_member", "pass_member");
+    auto owner = *db_manager_->getUserByUsername("idx_owner");
+    auto member = *db_manager_->getUserByUsername("idx_member");
+
+    auto room_opt = db_manager_->createRoom("Index Room", "Membership index", owner.getId());
+    ASSERT_TRUE(room_opt.has_value());
+    std::string room_id = room_opt->getId();
+
+    // 1. 新房间没有成员
+    ASSERT_FALSE(db_manager_->isRoomMember(room_id, owner.getId()));
+    ASSERT_EQ(db_manager_->getRoomMemberCount(room_id), 0);
+
+    // 2. 添加成员后索引同步更新
+    ASSERT_TRUE(db_manager_->addRoomMember(room_id, owner.getId()));
+    ASSERT_TRUE(db_manager_->addRoomMember(room_id, member.getId()));
+    ASSERT_TRUE(db_manager_->isRoomMember(room_id, owner.getId()));
+    ASSERT_TRUE(db_manager_->isRoomMember(room_id, member.getId()));
+    ASSERT_EQ(db_manager_->getRoomMemberCount(room_id), 2);
+
+    // 3. 移除成员后索引同步更新
+    ASSERT_TRUE(db_manager_->removeRoomMember(room_id, member.getId()));
+    ASSERT_FALSE(db_manager_->isRoomMember(room_id, member.getId()));
+    ASSERT_EQ(db_manager_->getRoomMemberCount(room_id), 1);
+
+    // 4. 重新打开数据库，索引从 room_members 表懒加载
+    db_manager_ = std::make_unique<DatabaseManager>(test_db_path_);
+    ASSERT_TRUE(db_manager_->isRoomMember(room_id, owner.getId()));
+    ASSERT_FALSE(db_manager_->isRoomMember(room_id, member.getId()));
+
+    // 5. 删除房间后索引失效，无效房间不会被判定为成员
+    ASSERT_TRUE(db_manager_->deleteRoom(room_id));
+    ASSERT_FALSE(db_manager_->isRoomMember(room_id, owner.getId()));
+    ASSERT_FALSE(db_manager_->isRoomMember("non-existent-room-id", owner.getId()));
+    ASSERT_EQ(db_manager_->getRoomMemberCount(room_id), 0);
+}
+
+// 组合操作：一次调用完成校验和读写，区分房间不存在和不是成员
+TEST_F(DatabaseManagerTest, CompositeOperations) {
+    db_manager_->createUser("composite_owner", "p");
+    db_manager_->createUser("composite_guest", "p");
+    auto owner = *db_manager_->getUserByUsername("composite_owner");
+    auto guest = *db_manager_->getUserByUsername("composite_guest");
+    auto room_id = db_manager_->createRoom("Composite Room", "", owner.getId())->getId();
+
+    ASSERT_EQ(db_manager_->joinRoom("non-existent-room-id", owner.getId()), JoinResult::RoomNotFound);
+    ASSERT_EQ(db_manager_->joinRoom(room_id, "non-existent-user-id"), JoinResult::UserNotFound);
+    ASSERT_EQ(db_manager_->joinRoom(room_id, owner.getId()), JoinResult::Joined);
+    ASSERT_EQ(db_manager_->joinRoom(room_id, owner.getId()), JoinResult::Joined); // 重复加入
+    ASSERT_EQ(db_manager_->getRoomMemberCount(room_id), 1);
+
+    ASSERT_EQ(db_manager_->checkMembership(room_id, owner.getId()), MembershipStatus::Member);
+    ASSERT_EQ(db_manager_->checkMembership(room_id, guest.getId()), MembershipStatus::NotMember);
+    ASSERT_EQ(db_manager_->checkMembership("non-existent-room-id", owner.getId()), MembershipStatus::RoomNotFound);
+
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(db_manager_->saveMessage(room_id, owner.getId(), "Message " + std::to_string(i), 1000 + i));
+    }
+
+    std::vector<std::string> page;
+    ASSERT_EQ(db_manager_->getMessagePageIfMember(room_id, guest.getId(), 10, 0, page), MembershipStatus::NotMember);
+    ASSERT_EQ(db_manager_->getMessagePageIfMember("non-existent-room-id", owner.getId(), 10, 0, page),
+              MembershipStatus::RoomNotFound);
+    ASSERT_TRUE(page.empty());
+
+    // 第一次回源数据库并填充缓存，之后的最新一页走缓存；两次都只加一次数据库锁
+    for (int round = 0; round < 2; ++round) {
+        page.clear();
+        db_manager_->resetQueryStats();
+        ASSERT_EQ(db_manager_->getMessagePageIfMember(room_id, owner.getId(), 3, 0, page), MembershipStatus::Member);
+        ASSERT_EQ(db_manager_->getQueryStats()[0]["mutex"]["acquisitions"], 1);
+        ASSERT_EQ(page.size(), 3);
+        ASSERT_NE(page.front().find("Message 2"), std::string::npos);
+        ASSERT_NE(page.back().find("Message 4"), std::string::npos);
+    }
+
+    // 更早的分页直接读数据库
+    int64_t oldest_id = nlohmann::json::parse(page.front())["id"];
+    page.clear();
+    ASSERT_EQ(db_manager_->getMessagePageIfMember(room_id, owner.getId(), 10, oldest_id, page), MembershipStatus::Member);
+    ASSERT_EQ(page.size(), 2);
+    ASSERT_NE(page.front().find("Message 0"), std::string::npos);
+
+    // 读事务已结束，后续写入不受影响
+    ASSERT_TRUE(db_manager_->saveMessage(room_id, owner.getId(), "after", 2000));
+
+    // 内存引擎提供相同的语义
+    DatabaseManager memory(DatabaseManager::kMemoryEnginePath);
+    memory.createUser("composite_owner", "p");
+    auto memory_owner = *memory.getUserByUsername("composite_owner");
+    auto memory_room = memory.createRoom("Composite Room", "", memory_owner.getId())->getId();
+    ASSERT_EQ(memory.joinRoom(memory_room, "non-existent-user-id"), JoinResult::UserNotFound);
+    ASSERT_EQ(memory.joinRoom("non-existent-room-id", memory_owner.getId()), JoinResult::RoomNotFound);
+    ASSERT_EQ(memory.checkMembership(memory_room, memory_owner.getId()), MembershipStatus::NotMember);
+    ASSERT_EQ(memory.joinRoom(memory_room, memory_owner.getId()), JoinResult::Joined);
+    ASSERT_TRUE(memory.saveMessage(memory_room, memory_owner.getId(), "hello", 1));
+    page.clear();
+    ASSERT_EQ(memory.getMessagePageIfMember(memory_room, memory_owner.getId(), 10, 0, page), MembershipStatus::Member);
+    ASSERT_EQ(page.size(), 1);
+}
+
+TEST_F(DatabaseManagerTest, RowVisitors) {
+    db_manager_->createUser("visit_owner", "pass");
+    db_manager_->createUser("visit_member", "pass");
+    auto owner = *db_manager_->getUserByUsername("visit_owner");
+    auto member = *db_manager_->getUserByUsername("visit_member");
+    auto first = db_manager_->createRoom("Visit A", "desc \"quoted\"", owner.getId())->getId();
+    auto second = db_manager_->createRoom("Visit B", "", owner.getId())->getId();
+    ASSERT_TRUE(db_manager_->addRoomMember(first, member.getId()));
+    ASSERT_TRUE(db_manager_->addRoomMember(first, owner.getId()));
+    ASSERT_TRUE(db_manager_->saveMessage(first, owner.getId(), "hello", 1234));
+
+    // 1. 用户按创建顺序回调
+    std::vector<std::string> usernames;
+    db_manager_->visitUsers("", 0, [&](const UserRow &row) {
+        usernames.emplace_back(row.username);
+        return true;
+    });
+    ASSERT_EQ(usernames, (std::vector<std::string>{"visit_owner", "visit_member"}));
+
+    // 2. 房间从新到旧回调，字段与 getAllRooms 一致，回调返回 false 时停止
+    auto rooms = db_manager_->getAllRooms();
+    size_t visited = 0;
+    db_manager_->visitRooms("", 0, [&](const RoomRow &row) {
+        EXPECT_EQ(row.id, rooms[visited].getId());
+        EXPECT_EQ(row.description, rooms[visited].getDescription());
+        EXPECT_EQ(row.creator_id, owner.getId());
+        if (row.id == first) {
+            EXPECT_EQ(row.member_count, 2);
+            EXPECT_EQ(row.message_count, 1);
+            EXPECT_EQ(row.last_activity, 1234);
+        }
+        ++visited;
+        return false;
+    });
+    ASSERT_EQ(visited, 1);
+    ASSERT_EQ(rooms[0].getId(), second);
+    ASSERT_EQ(rooms[1].getId(), first);
+
+    // 3. 成员按加入顺序回调
+    std::vector<std::string> member_ids;
+    db_manager_->visitRoomMembers(first, [&](const MemberRow &row) {
+        member_ids.emplace_back(row.user_id);
+        EXPECT_GT(row.joined_at, 0);
+        return true;
+    });
+    ASSERT_EQ(member_ids, (std::vector<std::string>{member.getId(), owner.getId()}));
+}
+
+TEST_F(DatabaseManagerTest, CursorPagination) {
+    const int user_count = 250;
+    for (int i = 0; i < user_count; ++i) {
+        ASSERT_TRUE(db_manager_->createUser("page_user_" + std::to_string(i), "pass"));
+    }
+    auto owner = *db_manager_->getUserByUsername("page_user_0");
+    for (int i = 0; i < 30; ++i) {
+        ASSERT_TRUE(db_manager_->createRoom("page_room_" + std::to_string(i), "", owner.getId()).has_value());
+    }
+
+    // 1. 用户按游标逐页读取，每页从上一页最后一个ID之后开始，不重复不遗漏
+    std::vector<std::string> usernames;
+    std::vector<size_t> page_sizes;
+    std::string cursor;
+    while (true) {
+        size_t page = 0;
+        db_manager_->visitUsers(cursor, 100, [&](const UserRow &row) {
+            usernames.emplace_back(row.username);
+            cursor.assign(row.id);
+            ++page;
+            return true;
+        });
+        if (page == 0) {
+            break;
+        }
+        page_sizes.push_back(page);
+    }
+    ASSERT_EQ(page_sizes, (std::vector<size_t>{100, 100, 50}));
+    ASSERT_EQ(usernames.size(), user_count);
+    ASSERT_EQ(usernames[0], "page_user_0");
+    ASSERT_EQ(usernames[249], "page_user_249");
+
+    // 2. 房间从新到旧分页
+    std::vector<std::string> room_ids;
+    db_manager_->visitRooms("", 10, [&](const RoomRow &row) {
+        room_ids.emplace_back(row.id);
+        return true;
+    });
+    ASSERT_EQ(room_ids.size(), 10);
+    ASSERT_EQ(*db_manager_->getRoomIdByName("page_room_29"), room_ids.front());
+    std::vector<std::string> next_page;
+    db_manager_->visitRooms(room_ids.back(), 100, [&](const RoomRow &row) {
+        next_page.emplace_back(row.name);
+        return true;
+    });
+    ASSERT_EQ(next_page.size(), 20);
+    ASSERT_EQ(next_page.front(), "page_room_19");
+    ASSERT_EQ(next_page.back(), "page_room_0");
+
+    // 3. 不存在的游标没有结果
+    size_t unknown = 0;
+    db_manager_->visitUsers("non-existent-id", 10, [&](const UserRow &) { return ++unknown > 0; });
+    db_manager_->visitRooms("non-existent-id", 10, [&](const RoomRow &) { return ++unknown > 0; });
+    ASSERT_EQ(unknown, 0);
+
+    // 4. 游标查询走主键定位，不扫描整张表
+    sqlite3 *db;
+    ASSERT_EQ(sqlite3_open(test_db_path_.c_str(), &db), SQLITE_OK);
+    std::string plan;
+    sqlite3_stmt *stmt;
+    ASSERT_EQ(sqlite3_prepare_v2(db,
+                                 "EXPLAIN QUERY PLAN SELECT pk, id, username FROM users "
+                                 "WHERE pk > ? ORDER BY pk LIMIT ?;",
+                                 -1, &stmt, nullptr),
+              SQLITE_OK);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        plan += reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+        plan += "\n";
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    EXPECT_NE(plan.find("SEARCH users USING INTEGER PRIMARY KEY (rowid>?)"), std::string::npos) << plan;
+    EXPECT_EQ(plan.find("SCAN users"), std::string::npos) << plan;
+}
+
+// 回调期间不持有数据库锁：慢客户端的流式响应不会阻塞其他线程的写入
+TEST_F(DatabaseManagerTest, VisitorsRunWithoutDatabaseLock) {
+    const int user_count = 600; // 跨越多个读取批次
+    for (int i = 0; i < user_count; ++i) {
+        ASSERT_TRUE(db_manager_->createUser("stream_user_" + std::to_string(i), "pass"));
+    }
+    auto owner = *db_manager_->getUserByUsername("stream_user_0");
+    for (int i = 0; i < 300; ++i) {
+        ASSERT_TRUE(db_manager_->createRoom("stream_room_" + std::to_string(i), "", owner.getId()).has_value());
+    }
+
+    // 回调里等待另一个线程完成一次写入，持有数据库锁时会超时
+    auto writeFromOtherThread = [this](const std::string &username) {
+        auto write = std::async(std::launch::async, [this, username]() {
+            return db_manager_->createUser(username, "pass");
+        });
+        return write.wait_for(std::chrono::seconds(2)) == std::future_status::ready && write.get();
+    };
+
+    size_t users = 0;
+    bool user_write_done = false;
+    db_manager_->visitUsers("", 0, [&](const UserRow &) {
+        if (++users == 300) {
+            user_write_done = writeFromOtherThread("written_during_visit");
+        }
+        return true;
+    });
+    ASSERT_TRUE(user_write_done);
+    ASSERT_EQ(users, user_count + 1); // 后面的批次读到了遍历期间新建的用户
+
+    size_t rooms = 0;
+    bool room_write_done = false;
+    db_manager_->visitRooms("", 0, [&](const RoomRow &) {
+        if (++rooms == 1) {
+            room_write_done = writeFromOtherThread("written_during_room_visit");
+        }
+        return true;
+    });
+    ASSERT_TRUE(room_write_done);
+    ASSERT_EQ(rooms, 300);
+}
+
 // --- 消息管理测试 ---
 
 TEST_F(DatabaseManagerTest, SaveAndGetMessages) {
@@ -133,6 +403,102 @@ TEST_F(DatabaseManagerTest, SaveAndGetMessages) {
     ASSERT_EQ(messages[1].getContent(), "Hello from u2!");
 }
 
+TEST_F(DatabaseManagerTest, GetRecentMessagesPagination) {
+    auto sender = *db_manager_->getUserByUsername( (db_manager_->createUser("pager", "p"), "pager") );
+    auto room_opt = db_manager_->createRoom("Paging Room", "For recent messages", sender.getId());
+    std::string room_id = room_opt->getId();
+
+    std::vector<int64_t> ids;
+    for (int i = 0; i < 10; ++i) {
+        int64_t id = 0;
+        ASSERT_TRUE(db_manager_->saveMessage(room_id, sender.getId(), "Message " + std::to_string(i), 1000 + i, &id));
+        ASSERT_GT(id, 0);
+        ids.push_back(id);
+    }
+
+    // 最新一页按时间正序返回最后的消息
+    auto latest = db_manager_->getRecentMessages(room_id, 3);
+    ASSERT_EQ(latest.size(), 3);
+    ASSERT_EQ(latest[0].getContent(), "Message 7");
+    ASSERT_EQ(latest[2].getContent(), "Message 9");
+    ASSERT_EQ(latest[2].getUserName(), "pager");
+
+    // 使用 before 向前翻页
+    auto older = db_manager_->getRecentMessages(room_id, 3, latest[0].getId());
+    ASSERT_EQ(older.size(), 3);
+    ASSERT_EQ(older[0].getContent(), "Message 4");
+    ASSERT_EQ(older[2].getContent(), "Message 6");
+}
+
+// 断线重连补发：返回 after_id 之后的消息，第二次从缓存命中
+TEST_F(DatabaseManagerTest, GetMessagesAfter) {
+    auto sender = *db_manager_->getUserByUsername( (db_manager_->createUser("resumer", "p"), "resumer") );
+    auto room_opt = db_manager_->createRoom("Resume Room", "For replay", sender.getId());
+    std::string room_id = room_opt->getId();
+
+    std::vector<int64_t> ids;
+    for (int i = 0; i < 10; ++i) {
+        int64_t id = 0;
+        ASSERT_TRUE(db_manager_->saveMessage(room_id, sender.getId(), "Message " + std::to_string(i), 1000 + i, &id));
+        ids.push_back(id);
+    }
+
+    for (int round = 0; round < 2; ++round) {
+        std::vector<std::string> jsons;
+        ASSERT_TRUE(db_manager_->getMessagesAfter(room_id, ids[6], 10, jsons));
+        ASSERT_EQ(jsons.size(), 3);
+        ASSERT_EQ(nlohmann::json::parse(jsons[0]).at("id").get<int64_t>(), ids[7]);
+        ASSERT_EQ(nlohmann::json::parse(jsons[2]).at("content").get<std::string>(), "Message 9");
+    }
+
+    // 缺口超过 limit：只返回最新的 limit 条，并提示还有更早的消息
+    std::vector<std::string> jsons;
+    ASSERT_FALSE(db_manager_->getMessagesAfter(room_id, 0, 4, jsons));
+    ASSERT_EQ(jsons.size(), 4);
+    ASSERT_EQ(nlohmann::json::parse(jsons[0]).at("id").get<int64_t>(), ids[6]);
+
+    ASSERT_TRUE(db_manager_->getMessagesAfter(room_id, ids[9], 10, jsons));
+    ASSERT_TRUE(jsons.empty());
+}
+
+TEST_F(DatabaseManagerTest, QueryStatsRecordsStatements) {
+    db_manager_->resetQueryStats();
+    ASSERT_TRUE(db_manager_->createUser("stats_user", "p"));
+    auto user = *db_manager_->getUserByUsername("stats_user");
+    auto room_id = db_manager_->createRoom("Stats Room", "", user.getId())->getId();
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(db_manager_->saveMessage(room_id, user.getId(), "Message " + std::to_string(i), 1000 + i));
+    }
+    ASSERT_EQ(db_manager_->getRecentMessages(room_id, 10).size(), 3);
+
+    auto stats = db_manager_->getQueryStats();
+    ASSERT_EQ(stats.size(), 1);
+    ASSERT_EQ(stats[0]["database"], test_db_path_);
+    ASSERT_GT(stats[0]["mutex"]["acquisitions"].get<uint64_t>(), 0);
+
+    // 同一条语句的多次执行归为一类，绑定参数不会出现在SQL中
+    bool found_insert = false;
+    bool found_select = false;
+    for (const auto &statement : stats[0]["statements"]) {
+        std::string sql = statement["sql"];
+        ASSERT_EQ(sql.find("Message 0"), std::string::npos);
+        if (sql.rfind("INSERT INTO messages", 0) == 0) {
+            found_insert = true;
+            ASSERT_EQ(statement["calls"], 3);
+        }
+        if (sql.find("ORDER BY m.id DESC") != std::string::npos) {
+            found_select = true;
+            ASSERT_EQ(statement["calls"], 1);
+            ASSERT_EQ(statement["rows"], 3);
+        }
+    }
+    ASSERT_TRUE(found_insert);
+    ASSERT_TRUE(found_select);
+
+    db_manager_->resetQueryStats();
+    ASSERT_TRUE(db_manager_->getQueryStats()[0]["statements"].empty());
+}
+
 // --- 完整的端到端流程测试 ---
 
 TEST_F(DatabaseManagerTest, FullWorkflow) {
@@ -221,6 +587,24 @@ TEST_F(DatabaseManagerTest, BatchUserOperations) {
     }
 }
 
+// 批量查询用户名跨越多条 IN 语句，不存在的ID被忽略
+TEST_F(DatabaseManagerTest, GetUsernamesInBatches) {
+    std::vector<std::string> user_ids;
+    for (int i = 0; i < 1200; ++i) {
+        std::string username = "batch" + std::to_string(i);
+        ASSERT_TRUE(db_manager_->createUser(username, "pass"));
+        user_ids.push_back(db_manager_->getUserByUsername(username)->getId());
+    }
+    user_ids.push_back("missing-user");
+
+    auto usernames = db_manager_->getUsernames(user_ids);
+    ASSERT_EQ(usernames.size(), 1200);
+    ASSERT_EQ(usernames[user_ids[0]], "batch0");
+    ASSERT_EQ(usernames[user_ids[1199]], "batch1199");
+    ASSERT_EQ(usernames.count("missing-user"), 0);
+    ASSERT_TRUE(db_manager_->getUsernames({}).empty());
+}
+
 TEST_F(DatabaseManagerTest, BatchRoomOperations) {
     // 创建用户
     db_manager_->createUser("creator", "creatorpass");
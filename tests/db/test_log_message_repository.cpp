@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "../../src/db/log_message_repository.hpp"
+#include "../../src/db/database_manager.hpp"
+
+// 日志存储测试固件，每个测试使用独立的目录
+class LogMessageRepositoryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        base_path_ = "test_msglog_" + std::to_string(rand());
+        log_dir_ = base_path_ + ".msglog";
+        // 使用很小的段和索引间隔，覆盖跨段读取
+        options_.segment_bytes = 4096;
+        options_.index_interval = 8;
+        options_.sync_interval = std::chrono::milliseconds(10);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(log_dir_);
+        std::remove(base_path_.c_str());
+    }
+
+    std::unique_ptr<LogMessageRepository> openRepo() {
+        return std::make_unique<LogMessageRepository>(log_dir_, nullptr, options_);
+    }
+
+    std::string base_path_;
+    std::string log_dir_;
+    LogMessageRepository::Options options_;
+};
+
+// 写入跨越多个段的消息后，最近消息、向前翻页、按ID查询和按时间查询都与写入一致
+TEST_F(LogMessageRepositoryTest, AppendAndReadAcrossSegments) {
+    auto repo = openRepo();
+    ASSERT_TRUE(repo->isOpen());
+
+    std::vector<int64_t> ids;
+    for (int i = 0; i < 300; ++i) {
+        int64_t id = 0;
+        ASSERT_TRUE(repo->saveMessage("room_a", "user_1", "Message " + std::to_string(i), 1000 + i, &id));
+        if (!ids.empty()) {
+            ASSERT_GT(id, ids.back());
+        }
+        ids.push_back(id);
+    }
+    ASSERT_GT(std::distance(std::filesystem::directory_iterator(log_dir_ + "/r1"), std::filesystem::directory_iterator()), 1);
+
+    auto latest = repo->getRecentMessages("room_a", 50, 0);
+    ASSERT_EQ(latest.size(), 50);
+    ASSERT_EQ(latest.front().getContent(), "Message 250");
+    ASSERT_EQ(latest.back().getContent(), "Message 299");
+    ASSERT_EQ(latest.back().getId(), ids.back());
+
+    auto older = repo->getRecentMessages("room_a", 50, latest.front().getId());
+    ASSERT_EQ(older.size(), 50);
+    ASSERT_EQ(older.front().getContent(), "Message 200");
+    ASSERT_EQ(older.back().getContent(), "Message 249");
+
+    for (int i : {0, 7, 8, 150, 299}) {
+        auto message = repo->getMessageById(ids[i]);
+        ASSERT_TRUE(message.has_value());
+        ASSERT_EQ(message->getContent(), "Message " + std::to_string(i));
+        ASSERT_EQ(message->getRoomId(), "room_a");
+        ASSERT_EQ(message->getTimestamp(), 1000 + i);
+    }
+    ASSERT_FALSE(repo->getMessageById(ids.back() + 1).has_value());
+
+    auto from_timestamp = repo->getMessages("room_a", 5, 1100);
+    ASSERT_EQ(from_timestamp.size(), 5);
+    ASSERT_EQ(from_timestamp.front().getContent(), "Message 100");
+
+    ASSERT_TRUE(repo->getRecentMessages("room_b", 50, 0).empty());
+}
+
+// 重启后从段文件恢复，末尾写了一半的记录被截断，序号继续递增
+TEST_F(LogMessageRepositoryTest, RecoversAfterRestart) {
+    int64_t last_id = 0;
+    {
+        auto repo = openRepo();
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_TRUE(repo->saveMessage("room_a", "user_1", "Message " + std::to_string(i), i, &last_id));
+        }
+        ASSERT_TRUE(repo->saveMessage("room_b", "user_2", "Other room", 1, nullptr));
+    }
+
+    // 模拟崩溃：在最后一个段末尾追加不完整的数据
+    std::string last_segment;
+    for (const auto &entry : std::filesystem::directory_iterator(log_dir_ + "/r1")) {
+        last_segment = std::max(last_segment, entry.path().string());
+    }
+    {
+        std::ofstream out(last_segment, std::ios::binary | std::ios::app);
+        out.write("\x20\x00\x00\x00garbage", 11);
+    }
+
+    auto repo = openRepo();
+    auto messages = repo->getRecentMessages("room_a", 0, 0);
+    ASSERT_EQ(messages.size(), 100);
+    ASSERT_EQ(messages.back().getId(), last_id);
+    ASSERT_EQ(repo->getRecentMessages("room_b", 10, 0).size(), 1);
+
+    int64_t next_id = 0;
+    ASSERT_TRUE(repo->saveMessage("room_a", "user_1", "After restart", 100, &next_id));
+    ASSERT_EQ(next_id, last_id + 1);
+    ASSERT_EQ(repo->getMessageById(next_id)->getContent(), "After restart");
+}
+
+// 删除房间后日志被移除，重启后也不会恢复
+TEST_F(LogMessageRepositoryTest, DeleteRoomRemovesLog) {
+    {
+        auto repo = openRepo();
+        ASSERT_TRUE(repo->saveMessage("room_a", "user_1", "Keep", 1, nullptr));
+        ASSERT_TRUE(repo->saveMessage("room_b", "user_1", "Delete", 1, nullptr));
+        ASSERT_TRUE(repo->deleteRoomMessages("room_b"));
+        ASSERT_TRUE(repo->getRecentMessages("room_b", 10, 0).empty());
+    }
+
+    auto repo = openRepo();
+    ASSERT_EQ(repo->getRecentMessages("room_a", 10, 0).size(), 1);
+    ASSERT_TRUE(repo->getRecentMessages("room_b", 10, 0).empty());
+
+    // 同名房间重新写入时使用新的日志
+    int64_t id = 0;
+    ASSERT_TRUE(repo->saveMessage("room_b", "user_1", "New", 2, &id));
+    ASSERT_EQ(repo->getRecentMessages("room_b", 10, 0).size(), 1);
+}
+
+// 通过 DatabaseManager 选择日志引擎：校验引用、解析用户名、删除房间时清理
+TEST_F(LogMessageRepositoryTest, DatabaseManagerWithLogEngine) {
+    DatabaseOptions options;
+    options.message_engine = MessageEngine::Log;
+    DatabaseManager db(base_path_, options);
+    ASSERT_TRUE(db.isConnected());
+
+    ASSERT_TRUE(db.createUser("alice", "pass"));
+    auto alice = *db.getUserByUsername("alice");
+    auto room_id = db.createRoom("log room", "", alice.getId())->getId();
+
+    ASSERT_FALSE(db.saveMessage(room_id, "invalid-user-id", "hello", 1));
+    ASSERT_FALSE(db.saveMessage("invalid-room-id", alice.getId(), "hello", 1));
+
+    int64_t id = 0;
+    ASSERT_TRUE(db.saveMessage(room_id, alice.getId(), "hello", 1, &id));
+    auto message = db.getMessageById(id);
+    ASSERT_TRUE(message.has_value());
+    ASSERT_EQ(message->getUserName(), "alice");
+    ASSERT_EQ(db.getMessages(room_id).size(), 1);
+
+    ASSERT_TRUE(db.deleteRoom(room_id));
+    ASSERT_TRUE(db.getMessageRepository()->getRecentMessages(room_id, 10, 0).empty());
+}
+
+// 对比日志引擎与 SQLite 的写入速率和分页读取延迟
+TEST_F(LogMessageRepositoryTest, CompareWithSqlite) {
+    const int message_count = 2000;
+    const int page_reads = 500;
+
+    for (MessageEngine engine : {MessageEngine::Sqlite, MessageEngine::Log}) {
+        std::string path = base_path_ + (engine == MessageEngine::Log ? "_log" : "_sqlite");
+        {
+            DatabaseOptions options;
+            options.message_engine = engine;
+            DatabaseManager db(path, options);
+            ASSERT_TRUE(db.isConnected());
+            ASSERT_TRUE(db.createUser("writer", "pass"));
+            auto writer = *db.getUserByUsername("writer");
+            auto room_id = db.createRoom("bench", "", writer.getId())->getId();
+
+            std::vector<int64_t> ids(message_count);
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < message_count; ++i) {
+                ASSERT_TRUE(db.saveMessage(room_id, writer.getId(), "payload " + std::to_string(i), i, &ids[i]));
+            }
+            double insert_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::mt19937 gen(42);
+            std::uniform_int_distribution<int> pick(50, message_count - 1);
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < page_reads; ++i) {
+                ASSERT_EQ(db.getRecentMessages(room_id, 50, ids[pick(gen)]).size(), 50);
+            }
+            double read_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / page_reads;
+
+            std::cout << "[ " << (engine == MessageEngine::Log ? "log   " : "sqlite") << " ] insert "
+                      << static_cast<int64_t>(message_count / insert_seconds) << " msg/s, page read "
+                      << read_us << " us" << std::endl;
+        }
+        std::filesystem::remove_all(path + ".msglog");
+        std::remove(path.c_str());
+    }
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../src/db/database_manager.hpp"
+
+// 内存存储引擎测试固件
+class MemoryEngineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        db_ = std::make_unique<DatabaseManager>(DatabaseManager::kMemoryEnginePath);
+        ASSERT_TRUE(db_->isConnected());
+    }
+
+    std::unique_ptr<DatabaseManager> db_;
+};
+
+// 用户名唯一、密码校验、按ID和用户名查询
+TEST_F(MemoryEngineTest, UserOperations) {
+    ASSERT_TRUE(db_->createUser("alice", "pass"));
+    ASSERT_TRUE(db_->createUser("bob", "pass"));
+    ASSERT_FALSE(db_->createUser("alice", "other"));
+
+    auto alice = db_->getUserByUsername("alice");
+    ASSERT_TRUE(alice.has_value());
+    ASSERT_TRUE(db_->userExists(alice->getId()));
+    ASSERT_EQ(db_->getUserById(alice->getId())->getUsername(), "alice");
+    ASSERT_TRUE(db_->validateUser("alice", "pass"));
+    ASSERT_FALSE(db_->validateUser("alice", "wrong"));
+    ASSERT_FALSE(db_->getUserByUsername("carol").has_value());
+
+    auto usernames = db_->getUsernames({alice->getId(), "missing"});
+    ASSERT_EQ(usernames.size(), 1);
+    ASSERT_EQ(usernames[alice->getId()], "alice");
+
+    auto users = db_->getAllUsers();
+    ASSERT_EQ(users.size(), 2);
+    ASSERT_EQ(users[0].getUsername(), "alice");
+    ASSERT_EQ(users[1].getUsername(), "bob");
+}
+
+// 房间名唯一、改名后索引同步、成员增删和反向索引
+TEST_F(MemoryEngineTest, RoomAndMemberOperations) {
+    ASSERT_TRUE(db_->createUser("owner", "pass"));
+    ASSERT_TRUE(db_->createUser("member", "pass"));
+    auto owner = *db_->getUserByUsername("owner");
+    auto member = *db_->getUserByUsername("member");
+
+    ASSERT_FALSE(db_->createRoom("orphan", "", "invalid-user-id").has_value());
+    auto room = db_->createRoom("general", "desc", owner.getId());
+    ASSERT_TRUE(room.has_value());
+    ASSERT_FALSE(db_->createRoom("general", "", owner.getId()).has_value());
+    ASSERT_TRUE(db_->isRoomCreator(room->getId(), owner.getId()));
+    ASSERT_FALSE(db_->isRoomCreator(room->getId(), member.getId()));
+
+    auto other = db_->createRoom("other", "", owner.getId());
+    ASSERT_FALSE(db_->updateRoom(room->getId(), "other", "taken"));
+    ASSERT_TRUE(db_->updateRoom(room->getId(), "renamed", "new desc"));
+    ASSERT_EQ(*db_->getRoomIdByName("renamed"), room->getId());
+    ASSERT_FALSE(db_->getRoomIdByName("general").has_value());
+    ASSERT_EQ(db_->getRoomById(room->getId())->getDescription(), "new desc");
+    ASSERT_EQ(db_->getRooms(), (std::vector<std::string>{"renamed", "other"}));
+
+    ASSERT_FALSE(db_->addRoomMember(room->getId(), "invalid-user-id"));
+    ASSERT_FALSE(db_->addRoomMember("invalid-room-id", member.getId()));
+    ASSERT_TRUE(db_->addRoomMember(room->getId(), owner.getId()));
+    ASSERT_TRUE(db_->addRoomMember(room->getId(), member.getId()));
+    ASSERT_TRUE(db_->addRoomMember(room->getId(), member.getId()));
+    ASSERT_TRUE(db_->addRoomMember(other->getId(), member.getId()));
+    ASSERT_EQ(db_->getRoomMemberCount(room->getId()), 2);
+    ASSERT_TRUE(db_->isRoomMember(room->getId(), member.getId()));
+    ASSERT_EQ(db_->getUserJoinedRooms(member.getId()).size(), 2);
+
+    auto members = db_->getRoomMembers(room->getId());
+    ASSERT_EQ(members.size(), 2);
+    ASSERT_EQ(members[0]["username"], "owner");
+
+    std::vector<std::string> visited;
+    db_->visitRooms("", 0, [&](const RoomRow &row) {
+        visited.emplace_back(row.name);
+        return true;
+    });
+    ASSERT_EQ(visited, (std::vector<std::string>{"other", "renamed"}));
+    visited.clear();
+    db_->visitRooms(other->getId(), 1, [&](const RoomRow &row) {
+        visited.emplace_back(row.name);
+        return true;
+    });
+    ASSERT_EQ(visited, std::vector<std::string>{"renamed"});
+    std::vector<std::string> user_page;
+    db_->visitUsers(owner.getId(), 10, [&](const UserRow &row) {
+        user_page.emplace_back(row.username);
+        return true;
+    });
+    ASSERT_EQ(user_page, std::vector<std::string>{"member"});
+    std::vector<std::string> usernames;
+    db_->visitRoomMembers(room->getId(), [&](const MemberRow &row) {
+        usernames.emplace_back(row.username);
+        return true;
+    });
+    ASSERT_EQ(usernames, (std::vector<std::string>{"owner", "member"}));
+
+    ASSERT_TRUE(db_->removeRoomMember(room->getId(), member.getId()));
+    ASSERT_FALSE(db_->isRoomMember(room->getId(), member.getId()));
+    ASSERT_EQ(db_->getUserJoinedRooms(member.getId()).size(), 1);
+}
+
+// 消息分页、按ID查询，删除房间时成员关系和消息一并清理
+TEST_F(MemoryEngineTest, MessagesAndCascadeDelete) {
+    ASSERT_TRUE(db_->createUser("alice", "pass"));
+    auto alice = *db_->getUserByUsername("alice");
+    auto room_id = db_->createRoom("chat", "", alice.getId())->getId();
+    ASSERT_TRUE(db_->addRoomMember(room_id, alice.getId()));
+
+    ASSERT_FALSE(db_->saveMessage(room_id, "invalid-user-id", "hello", 1));
+    ASSERT_FALSE(db_->saveMessage("invalid-room-id", alice.getId(), "hello", 1));
+
+    std::vector<int64_t> ids(100);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(db_->saveMessage(room_id, alice.getId(), "Message " + std::to_string(i), 1000 + i, &ids[i]));
+        if (i > 0) {
+            ASSERT_GT(ids[i], ids[i - 1]);
+        }
+    }
+
+    auto latest = db_->getRecentMessages(room_id, 20, 0);
+    ASSERT_EQ(latest.size(), 20);
+    ASSERT_EQ(latest.front().getContent(), "Message 80");
+    ASSERT_EQ(latest.back().getId(), ids.back());
+    ASSERT_EQ(latest.back().getUserName(), "alice");
+
+    auto older = db_->getRecentMessages(room_id, 20, latest.front().getId());
+    ASSERT_EQ(older.size(), 20);
+    ASSERT_EQ(older.front().getContent(), "Message 60");
+    ASSERT_EQ(older.back().getContent(), "Message 79");
+
+    auto from_timestamp = db_->getMessages(room_id, 5, 1050);
+    ASSERT_EQ(from_timestamp.size(), 5);
+    ASSERT_EQ(from_timestamp.front().getContent(), "Message 50");
+    ASSERT_EQ(db_->getMessageById(ids[42])->getContent(), "Message 42");
+
+    ASSERT_TRUE(db_->deleteRoom(room_id));
+    ASSERT_FALSE(db_->roomExists(room_id));
+    ASSERT_TRUE(db_->getRoomMembers(room_id).empty());
+    ASSERT_TRUE(db_->getUserJoinedRooms(alice.getId()).empty());
+    ASSERT_TRUE(db_->getMessageRepository()->getRecentMessages(room_id, 10, 0).empty());
+    ASSERT_FALSE(db_->getMessageById(ids[42]).has_value());
+}
+
+// 多线程并发注册、加入房间和发消息，计数与写入一致
+TEST_F(MemoryEngineTest, ConcurrentAccess) {
+    const int thread_count = 8;
+    const int per_thread = 200;
+
+    ASSERT_TRUE(db_->createUser("owner", "pass"));
+    auto owner = *db_->getUserByUsername("owner");
+    auto room_id = db_->createRoom("busy", "", owner.getId())->getId();
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            std::string username = "user_" + std::to_string(t);
+            if (!db_->createUser(username, "pass")) {
+                ++failures;
+                return;
+            }
+            auto user = *db_->getUserByUsername(username);
+            if (!db_->addRoomMember(room_id, user.getId())) {
+                ++failures;
+            }
+            for (int i = 0; i < per_thread; ++i) {
+                if (!db_->saveMessage(room_id, user.getId(), "payload", i)) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_EQ(db_->getRoomMemberCount(room_id), thread_count);
+    auto messages = db_->getRecentMessages(room_id, 0, 0);
+    ASSERT_EQ(messages.size(), thread_count * per_thread);
+    for (size_t i = 1; i < messages.size(); ++i) {
+        ASSERT_GT(messages[i].getId(), messages[i - 1].getId());
+    }
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <nlohmann/json.hpp>
+
+#include "../../src/db/message_cache.hpp"
+
+namespace {
+
+Message makeMessage(int64_t id, const std::string &room_id = "room_1")
+{
+    return Message(id, room_id, "user_1", "content " + std::to_string(id), 1000 + id, "alice");
+}
+
+int64_t idOf(const std::string &message_json)
+{
+    return nlohmann::json::parse(message_json).at("id").get<int64_t>();
+}
+
+} // namespace
+
+// 未缓存的房间不会命中
+TEST(MessageCacheTest, MissForUnknownRoom) {
+    MessageCache cache(10);
+    std::vector<std::string> out;
+    ASSERT_FALSE(cache.getRecent("room_1", 5, out));
+}
+
+// 从数据库预热后返回最近的 limit 条消息，顺序为时间正序
+TEST(MessageCacheTest, WarmAndServeRecent) {
+    MessageCache cache(10);
+    std::vector<Message> messages;
+    for (int64_t id = 1; id <= 8; ++id) {
+        messages.push_back(makeMessage(id));
+    }
+    cache.warm("room_1", messages, true);
+
+    std::vector<std::string> out;
+    ASSERT_TRUE(cache.getRecent("room_1", 3, out));
+    ASSERT_EQ(out.size(), 3);
+    ASSERT_EQ(idOf(out[0]), 6);
+    ASSERT_EQ(idOf(out[2]), 8);
+
+    // 缓存包含房间全部消息时，超过缓存数量的请求也能命中
+    ASSERT_TRUE(cache.getRecent("room_1", 50, out));
+    ASSERT_EQ(out.size(), 8);
+}
+
+// 超出容量后丢弃最旧的消息，且不再能服务超过缓存数量的请求
+TEST(MessageCacheTest, RingDropsOldestWhenFull) {
+    MessageCache cache(5);
+    cache.warm("room_1", {}, true);
+    for (int64_t id = 1; id <= 7; ++id) {
+        cache.append(makeMessage(id));
+    }
+
+    std::vector<std::string> out;
+    ASSERT_TRUE(cache.getRecent("room_1", 5, out));
+    ASSERT_EQ(idOf(out.front()), 3);
+    ASSERT_EQ(idOf(out.back()), 7);
+    ASSERT_FALSE(cache.getRecent("room_1", 6, out));
+}
+
+// 乱序和重复追加的消息按ID有序且去重
+TEST(MessageCacheTest, AppendKeepsOrderAndDeduplicates) {
+    MessageCache cache(10);
+    cache.warm("room_1", {makeMessage(1), makeMessage(2)}, true);
+    cache.append(makeMessage(4));
+    cache.append(makeMessage(3));
+    cache.append(makeMessage(4));
+
+    std::vector<std::string> out;
+    ASSERT_TRUE(cache.getRecent("room_1", 10, out));
+    ASSERT_EQ(out.size(), 4);
+    for (size_t i = 0; i < out.size(); ++i) {
+        ASSERT_EQ(idOf(out[i]), static_cast<int64_t>(i + 1));
+    }
+}
+
+// 预热时合并查询期间追加进来的新消息
+TEST(MessageCacheTest, WarmMergesConcurrentAppends) {
+    MessageCache cache(10);
+    cache.append(makeMessage(3));
+    cache.warm("room_1", {makeMessage(1), makeMessage(2)}, true);
+
+    std::vector<std::string> out;
+    ASSERT_TRUE(cache.getRecent("room_1", 10, out));
+    ASSERT_EQ(out.size(), 3);
+    ASSERT_EQ(idOf(out.back()), 3);
+}
+
+// 断线重连补发：缓存覆盖缺口时命中，缺口超过 limit 时只返回最新的部分
+TEST(MessageCacheTest, GetAfterServesGap) {
+    MessageCache cache(5);
+    cache.warm("room_1", {}, true);
+    for (int64_t id = 1; id <= 7; ++id) {
+        cache.append(makeMessage(id));
+    }
+
+    std::vector<std::string> out;
+    bool truncated = true;
+    ASSERT_TRUE(cache.getAfter("room_1", 4, 10, out, truncated));
+    ASSERT_FALSE(truncated);
+    ASSERT_EQ(out.size(), 3);
+    ASSERT_EQ(idOf(out.front()), 5);
+    ASSERT_EQ(idOf(out.back()), 7);
+
+    ASSERT_TRUE(cache.getAfter("room_1", 7, 10, out, truncated));
+    ASSERT_TRUE(out.empty());
+
+    ASSERT_TRUE(cache.getAfter("room_1", 3, 2, out, truncated));
+    ASSERT_TRUE(truncated);
+    ASSERT_EQ(idOf(out.front()), 6);
+
+    // 缓存中最旧的是 3，无法确定 1 之后是否还有被挤出的消息
+    ASSERT_FALSE(cache.getAfter("room_1", 1, 10, out, truncated));
+    // 缺口中缓存的部分已经超过 limit 条时仍然命中
+    ASSERT_TRUE(cache.getAfter("room_1", 1, 3, out, truncated));
+    ASSERT_TRUE(truncated);
+    ASSERT_EQ(idOf(out.front()), 5);
+
+    ASSERT_FALSE(cache.getAfter("room_2", 0, 10, out, truncated));
+}
+
+// 空闲房间会被淘汰，删除房间时缓存也被丢弃
+TEST(MessageCacheTest, EvictIdleAndRoom) {
+    MessageCache cache(10, std::chrono::seconds(0));
+    cache.warm("room_1", {makeMessage(1)}, true);
+    cache.warm("room_2", {makeMessage(2, "room_2")}, true);
+    ASSERT_EQ(cache.roomCount(), 2);
+
+    cache.evictRoom("room_2");
+    ASSERT_EQ(cache.roomCount(), 1);
+
+    ASSERT_EQ(cache.evictIdle(), 1);
+    ASSERT_EQ(cache.roomCount(), 0);
+}
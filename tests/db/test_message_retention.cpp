@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+#include "db_test_support.hpp"
+
+// 消息保留测试固件，每个测试使用独立的数据库文件
+class MessageRetentionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        db_path_ = db_test::tempDbPath("test_retention");
+    }
+
+    void TearDown() override {
+        db_test::removeDatabase(db_path_);
+    }
+
+    std::string db_path_;
+};
+
+// 按条数清理：分批删除最旧的消息，只保留最新的 N 条
+TEST_F(MessageRetentionTest, PurgeByCountInBatches) {
+    DatabaseManager db(db_path_);
+    auto room_id = db_test::seedRoom(db, "count", 100, 1000);
+
+    int batches = 0;
+    size_t total = 0;
+    size_t deleted;
+    while ((deleted = db.purgeRoomMessages(room_id, 0, 30, 16)) > 0) {
+        ASSERT_LE(deleted, 16);
+        total += deleted;
+        ++batches;
+    }
+    ASSERT_EQ(total, 70);
+    ASSERT_EQ(batches, 5);
+
+    auto messages = db.getRecentMessages(room_id, 0, 0);
+    ASSERT_EQ(messages.size(), 30);
+    ASSERT_EQ(messages.front().getContent(), "Message 70");
+    ASSERT_EQ(messages.back().getContent(), "Message 99");
+}
+
+// 按时间清理：全局策略生效，房间策略覆盖全局策略，未设置策略时不清理
+TEST_F(MessageRetentionTest, PurgeByAgeWithRoomOverride) {
+    DatabaseManager db(db_path_);
+    int64_t now = std::time(nullptr);
+    // 前 50 条是两天前的消息，后 50 条是刚写入的
+    auto global_room = db_test::seedRoom(db, "global", 50, now - 2 * 86400);
+    auto override_room = db_test::seedRoom(db, "override", 50, now - 2 * 86400);
+    auto writer = *db.getUserByUsername("writer");
+    for (int i = 0; i < 50; ++i) {
+        db.saveMessage(global_room, writer.getId(), "Fresh", now);
+        db.saveMessage(override_room, writer.getId(), "Fresh", now);
+    }
+
+    MessageRetention &retention = db.getRetention();
+    ASSERT_EQ(retention.purgeOnce(), 0);
+
+    MessageRetention::Options options;
+    options.global.max_age = std::chrono::hours(24);
+    options.batch_size = 10;
+    options.batch_pause = std::chrono::milliseconds(0);
+    retention.setOptions(options);
+
+    RetentionPolicy keep_ten;
+    keep_ten.max_messages = 10;
+    ASSERT_TRUE(retention.setRoomPolicy(override_room, keep_ten));
+    ASSERT_FALSE(retention.setRoomPolicy("invalid-room-id", keep_ten));
+
+    ASSERT_EQ(retention.purgeOnce(), 50 + 90);
+    ASSERT_EQ(db.getRecentMessages(global_room, 0, 0).size(), 50);
+    ASSERT_EQ(db.getRecentMessages(override_room, 0, 0).size(), 10);
+    ASSERT_EQ(retention.purgeOnce(), 0);
+}
+
+// 房间策略保存在元数据库中，重启后仍然有效，删除房间时一并删除
+TEST_F(MessageRetentionTest, RoomPolicyPersists) {
+    std::string room_id;
+    {
+        DatabaseManager db(db_path_);
+        room_id = db_test::seedRoom(db, "persist", 1, 1);
+        RetentionPolicy policy;
+        policy.max_age = std::chrono::seconds(3600);
+        policy.max_messages = 5;
+        ASSERT_TRUE(db.getRetention().setRoomPolicy(room_id, policy));
+    }
+
+    DatabaseManager db(db_path_);
+    auto policy = db.getRetention().getRoomPolicy(room_id);
+    ASSERT_TRUE(policy.has_value());
+    ASSERT_EQ(policy->max_age.count(), 3600);
+    ASSERT_EQ(policy->max_messages, 5);
+
+    ASSERT_TRUE(db.getRetention().clearRoomPolicy(room_id));
+    ASSERT_FALSE(db.getRetention().getRoomPolicy(room_id).has_value());
+    ASSERT_TRUE(db.getRetention().getEffectivePolicy(room_id).unlimited());
+}
+
+// 内存引擎和日志引擎同样支持清理，日志引擎以段为单位删除
+TEST_F(MessageRetentionTest, PurgeOtherEngines) {
+    {
+        DatabaseManager db(DatabaseManager::kMemoryEnginePath);
+        auto room_id = db_test::seedRoom(db, "memory", 100, 1000);
+        auto last_id = db.getRecentMessages(room_id, 1, 0).back().getId();
+        while (db.purgeRoomMessages(room_id, 1050, 0, 7) > 0) {
+        }
+        auto messages = db.getRecentMessages(room_id, 0, 0);
+        ASSERT_EQ(messages.size(), 50);
+        ASSERT_EQ(messages.front().getContent(), "Message 50");
+        ASSERT_EQ(db.getMessageById(last_id)->getContent(), "Message 99");
+        ASSERT_FALSE(db.getMessageById(messages.front().getId() - 1).has_value());
+    }
+
+    DatabaseOptions options;
+    options.message_engine = MessageEngine::Log;
+    DatabaseManager db(db_path_, options);
+    // 默认段大小为 16MB，写入足够多的大消息以产生多个段
+    ASSERT_TRUE(db.createUser("writer", "pass"));
+    auto writer = *db.getUserByUsername("writer");
+    auto room_id = db.createRoom("log", "", writer.getId())->getId();
+    std::string payload(64 * 1024, 'x');
+    for (int i = 0; i < 600; ++i) {
+        ASSERT_TRUE(db.saveMessage(room_id, writer.getId(), payload, i));
+    }
+    size_t total = 0;
+    size_t deleted;
+    while ((deleted = db.purgeRoomMessages(room_id, 0, 100, 500)) > 0) {
+        total += deleted;
+    }
+    ASSERT_GT(total, 0);
+    size_t remaining = db.getRecentMessages(room_id, 0, 0).size();
+    ASSERT_EQ(remaining + total, 600);
+    ASSERT_GE(remaining, 100);
+}
+
+// 增量回收释放删除消息后留下的空闲页
+TEST_F(MessageRetentionTest, MaintenanceReclaimsFreePages) {
+    DatabaseConnection conn(db_path_);
+    ASSERT_TRUE(conn.isConnected());
+
+    auto freelistCount = [&conn]() {
+        sqlite3_stmt *stmt;
+        sqlite3_prepare_v2(conn.getDb(), "PRAGMA freelist_count;", -1, &stmt, nullptr);
+        sqlite3_step(stmt);
+        int count = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+        return count;
+    };
+
+    ASSERT_EQ(sqlite3_exec(conn.getDb(),
+                           "CREATE TABLE filler (data BLOB);"
+                           "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 200) "
+                           "INSERT INTO filler SELECT zeroblob(4096) FROM n;"
+                           "DELETE FROM filler;",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+    int before = freelistCount();
+    ASSERT_GT(before, 100);
+
+    ASSERT_TRUE(conn.runMaintenance(50));
+    ASSERT_EQ(freelistCount(), before - 50);
+    ASSERT_TRUE(conn.runMaintenance(100000));
+    ASSERT_EQ(freelistCount(), 0);
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "db_test_support.hpp"
+
+// 全文搜索测试固件，每个测试使用独立的数据库文件
+class MessageSearchTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        db_path_ = db_test::tempDbPath("test_search");
+    }
+
+    void TearDown() override {
+        db_test::removeDatabase(db_path_);
+    }
+
+    // 用独立连接检查全文索引与消息表一致
+    static bool indexIntact(const std::string &path) {
+        return db_test::execSql(path, "INSERT INTO messages_fts (messages_fts, rank) VALUES ('integrity-check', 1);");
+    }
+
+    static std::vector<std::string> contentsOf(const std::vector<Message> &messages) {
+        std::vector<std::string> contents;
+        for (const auto &message : messages) {
+            contents.push_back(message.getContent());
+        }
+        return contents;
+    }
+
+    std::string db_path_;
+};
+
+// 新消息由后台任务分批索引；搜索按相关度排序、支持分页，且只返回本房间的消息
+TEST_F(MessageSearchTest, IndexesInBatchesAndRanks) {
+    DatabaseManager db(db_path_);
+    std::vector<std::string> filler(2500, "nothing interesting here");
+    auto room_id = db_test::seedRoom(db, "search", filler);
+    auto writer = *db.getUserByUsername("writer");
+    ASSERT_TRUE(db.saveMessage(room_id, writer.getId(), "deploy finished", 3000));
+    ASSERT_TRUE(db.saveMessage(room_id, writer.getId(), "deploy deploy deploy rollback", 3001));
+    ASSERT_TRUE(db.saveMessage(room_id, writer.getId(), "Deploying the new build", 3002));
+    auto other_room = db_test::seedRoom(db, "other", {"deploy in another room"});
+
+    SearchIndexer::Options options;
+    options.batch_size = 1000;
+    options.batch_pause = std::chrono::milliseconds(0);
+    db.getSearchIndexer().setOptions(options);
+    ASSERT_EQ(db.getSearchIndexer().indexOnce(), 2504);
+    ASSERT_EQ(db.getSearchIndexer().indexOnce(), 0);
+
+    // 词出现次数多的消息排在前面，不区分大小写
+    auto results = db.searchMessages(room_id, "deploy", 10);
+    ASSERT_EQ(results.size(), 3);
+    ASSERT_EQ(results.front().getContent(), "deploy deploy deploy rollback");
+    ASSERT_EQ(results.front().getUserName(), "writer");
+    ASSERT_EQ(results.front().getRoomId(), room_id);
+
+    // 多个词之间为 AND
+    ASSERT_EQ(contentsOf(db.searchMessages(room_id, "deploy rollback", 10)),
+              std::vector<std::string>{"deploy deploy deploy rollback"});
+
+    // 分页
+    auto first = db.searchMessages(room_id, "deploy", 2, 0);
+    auto second = db.searchMessages(room_id, "deploy", 2, 2);
+    ASSERT_EQ(first.size(), 2);
+    ASSERT_EQ(second.size(), 1);
+    ASSERT_NE(second.front().getId(), first[0].getId());
+    ASSERT_NE(second.front().getId(), first[1].getId());
+
+    ASSERT_EQ(db.searchMessages(other_room, "deploy", 10).size(), 1);
+    ASSERT_TRUE(db.searchMessages(room_id, "missing", 10).empty());
+
+    // 尚未索引的新消息按内容匹配，排在索引结果之前，搜索不会推进索引
+    ASSERT_TRUE(db.saveMessage(room_id, writer.getId(), "deploy hotfix", 3003));
+    results = db.searchMessages(room_id, "deploy", 10);
+    ASSERT_EQ(results.size(), 4);
+    ASSERT_EQ(results.front().getContent(), "deploy hotfix");
+    ASSERT_EQ(results[1].getContent(), "deploy deploy deploy rollback");
+    auto last_page = db.searchMessages(room_id, "deploy", 2, 3);
+    ASSERT_EQ(last_page.size(), 1);
+    ASSERT_EQ(last_page.front().getId(), results.back().getId());
+    ASSERT_EQ(db.getSearchIndexer().indexOnce(), 1);
+    ASSERT_EQ(db.searchMessages(room_id, "deploy", 10).size(), 4);
+}
+
+// 未经后台索引的消息也能搜到；短词、中文和 FTS5 语法字符都按普通文本匹配
+TEST_F(MessageSearchTest, QueryHandling) {
+    DatabaseManager db(db_path_);
+    auto room_id = db_test::seedRoom(db, "query", {"今天天气很好", "明天下雨", "say \"hi\" OR bye", "100% done", "go go"});
+
+    ASSERT_EQ(contentsOf(db.searchMessages(room_id, "天气很", 10)), std::vector<std::string>{"今天天气很好"});
+    // 少于 3 个字符的词不走索引，按内容逐条匹配
+    ASSERT_EQ(contentsOf(db.searchMessages(room_id, "下雨", 10)), std::vector<std::string>{"明天下雨"});
+    ASSERT_EQ(contentsOf(db.searchMessages(room_id, "go", 10)), std::vector<std::string>{"go go"});
+    ASSERT_EQ(contentsOf(db.searchMessages(room_id, "0%", 10)), std::vector<std::string>{"100% done"});
+    ASSERT_TRUE(db.searchMessages(room_id, "_", 10).empty());
+
+    ASSERT_EQ(db.searchMessages(room_id, "\"hi\"", 10).size(), 1);
+    ASSERT_EQ(db.searchMessages(room_id, "OR bye", 10).size(), 1);
+    ASSERT_TRUE(db.searchMessages(room_id, "NEAR(", 10).empty());
+    ASSERT_TRUE(db.searchMessages(room_id, "   ", 10).empty());
+}
+
+// 清理和删除房间时同步移除索引中的消息
+TEST_F(MessageSearchTest, DeletesRemoveIndexedMessages) {
+    {
+        DatabaseManager db(db_path_);
+        std::vector<std::string> contents;
+        for (int i = 0; i < 100; ++i) {
+            contents.push_back("message number " + std::to_string(i));
+        }
+        auto room_id = db_test::seedRoom(db, "purge", contents);
+        auto doomed = db_test::seedRoom(db, "doomed", {"message to be deleted"});
+        ASSERT_EQ(db.getSearchIndexer().indexOnce(), 101);
+
+        while (db.purgeRoomMessages(room_id, 0, 10, 30) > 0) {
+        }
+        ASSERT_EQ(db.searchMessages(room_id, "message", 100).size(), 10);
+        ASSERT_TRUE(db.searchMessages(room_id, "number 12", 100).empty());
+
+        ASSERT_TRUE(db.deleteRoom(doomed));
+    }
+    ASSERT_TRUE(indexIntact(db_path_));
+}
+
+// 分片库各自维护索引；没有全文索引的内存引擎退化为按时间倒序扫描
+TEST_F(MessageSearchTest, ShardsAndFallbackEngines) {
+    {
+        DatabaseManager db(db_path_, 2);
+        auto first = db_test::seedRoom(db, "first", {"shard alpha", "shard beta"});
+        auto second = db_test::seedRoom(db, "second", {"shard gamma"});
+        ASSERT_EQ(db.getSearchIndexer().indexOnce(), 3);
+        ASSERT_EQ(db.searchMessages(first, "shard", 10).size(), 2);
+        ASSERT_EQ(contentsOf(db.searchMessages(second, "shard", 10)), std::vector<std::string>{"shard gamma"});
+        ASSERT_EQ(db.searchMessages(second, "shard", 10).front().getUserName(), "writer");
+    }
+    ASSERT_TRUE(indexIntact(db_path_ + ".shard0"));
+    ASSERT_TRUE(indexIntact(db_path_ + ".shard1"));
+
+    DatabaseManager memory(DatabaseManager::kMemoryEnginePath);
+    std::vector<std::string> contents(1200, "filler");
+    contents[10] = "Needle one";
+    contents[1100] = "needle two";
+    auto room_id = db_test::seedRoom(memory, "memory", contents);
+    ASSERT_EQ(memory.getSearchIndexer().indexOnce(), 0);
+    ASSERT_EQ(contentsOf(memory.searchMessages(room_id, "NEEDLE", 10)),
+              (std::vector<std::string>{"needle two", "Needle one"}));
+    ASSERT_EQ(contentsOf(memory.searchMessages(room_id, "needle", 10, 1)), std::vector<std::string>{"Needle one"});
+
+    // 扫描页数有上限，没有扫描到最早的消息时报告部分结果
+    std::vector<std::string> long_history(12000, "filler");
+    long_history[0] = "needle oldest";
+    long_history[11999] = "needle newest";
+    auto long_room = db_test::seedRoom(memory, "long", long_history);
+    bool partial = false;
+    ASSERT_EQ(contentsOf(memory.searchMessages(long_room, "needle", 10, 0, &partial)),
+              std::vector<std::string>{"needle newest"});
+    ASSERT_TRUE(partial);
+    memory.searchMessages(room_id, "needle", 10, 0, &partial);
+    ASSERT_FALSE(partial);
+}
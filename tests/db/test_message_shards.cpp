@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "db_test_support.hpp"
+
+// 分片模式的测试固件，每个测试使用独立的数据库文件
+class MessageShardTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        for (const auto &path : created_paths_) {
+            db_test::removeDatabase(path);
+        }
+    }
+
+    std::unique_ptr<DatabaseManager> openManager(size_t shards) {
+        std::string path = db_test::tempDbPath("test_shards");
+        created_paths_.push_back(path);
+        return std::make_unique<DatabaseManager>(path, shards);
+    }
+
+    std::vector<std::string> created_paths_;
+};
+
+// 消息按房间分布到各个分片，读写、按ID查询都路由到正确的分片
+TEST_F(MessageShardTest, RoutesMessagesByRoom) {
+    auto db = openManager(4);
+    ASSERT_TRUE(db->isConnected());
+    ASSERT_EQ(db->getMessageShardCount(), 4);
+
+    ASSERT_TRUE(db->createUser("alice", "pass"));
+    auto alice = *db->getUserByUsername("alice");
+
+    std::vector<std::string> room_ids;
+    for (int i = 0; i < 8; ++i) {
+        auto room = db->createRoom("room" + std::to_string(i), "", alice.getId());
+        ASSERT_TRUE(room.has_value());
+        room_ids.push_back(room->getId());
+    }
+
+    for (size_t r = 0; r < room_ids.size(); ++r) {
+        for (int i = 0; i < 3; ++i) {
+            int64_t message_id = 0;
+            std::string content = "room" + std::to_string(r) + " message" + std::to_string(i);
+            ASSERT_TRUE(db->saveMessage(room_ids[r], alice.getId(), content, 1000 + i, &message_id));
+
+            // 全局消息ID可以反查到同一条消息
+            auto message = db->getMessageById(message_id);
+            ASSERT_TRUE(message.has_value());
+            ASSERT_EQ(message->getContent(), content);
+            ASSERT_EQ(message->getRoomId(), room_ids[r]);
+            ASSERT_EQ(message->getUserName(), "alice");
+        }
+    }
+
+    for (size_t r = 0; r < room_ids.size(); ++r) {
+        auto messages = db->getRecentMessages(room_ids[r], 10);
+        ASSERT_EQ(messages.size(), 3);
+        ASSERT_EQ(messages.front().getContent(), "room" + std::to_string(r) + " message0");
+        ASSERT_LT(messages[0].getId(), messages[1].getId());
+
+        // before_id 翻页在分片内同样有效
+        auto older = db->getRecentMessages(room_ids[r], 10, messages.back().getId());
+        ASSERT_EQ(older.size(), 2);
+        ASSERT_EQ(older.back().getId(), messages[1].getId());
+    }
+}
+
+// 分片库没有外键，由元数据库校验房间和用户；删除房间时清理分片中的消息
+TEST_F(MessageShardTest, ValidatesReferencesAndCleansUpRooms) {
+    auto db = openManager(3);
+    ASSERT_TRUE(db->isConnected());
+    ASSERT_TRUE(db->createUser("bob", "pass"));
+    auto bob = *db->getUserByUsername("bob");
+    auto room = db->createRoom("lobby", "", bob.getId());
+    ASSERT_TRUE(room.has_value());
+
+    ASSERT_FALSE(db->saveMessage(room->getId(), "invalid-user-id", "hello", 1000));
+    ASSERT_FALSE(db->saveMessage("invalid-room-id", bob.getId(), "hello", 1000));
+    ASSERT_TRUE(db->saveMessage(room->getId(), bob.getId(), "hello", 1000));
+    ASSERT_EQ(db->getMessages(room->getId()).size(), 1);
+
+    ASSERT_TRUE(db->deleteRoom(room->getId()));
+    ASSERT_TRUE(db->getMessageRepository(room->getId())->getMessages(room->getId()).empty());
+}
+
+// 重新打开后房间仍映射到同一个分片
+TEST_F(MessageShardTest, ShardMappingIsStableAcrossRestarts) {
+    std::string path = "test_shards_restart_" + std::to_string(rand()) + ".sqlite";
+    created_paths_.push_back(path);
+    std::string room_id;
+    {
+        DatabaseManager db(path, 4);
+        ASSERT_TRUE(db.createUser("carol", "pass"));
+        auto carol = *db.getUserByUsername("carol");
+        room_id = db.createRoom("persistent", "", carol.getId())->getId();
+        ASSERT_TRUE(db.saveMessage(room_id, carol.getId(), "still here", 1000));
+    }
+
+    DatabaseManager reopened(path, 4);
+    auto messages = reopened.getRecentMessages(room_id, 10);
+    ASSERT_EQ(messages.size(), 1);
+    ASSERT_EQ(messages[0].getContent(), "still here");
+}
+
+// 以不同的分片数重新打开时拒绝启动，已有消息不会被悄悄隐藏
+TEST_F(MessageShardTest, RejectsChangedShardCount) {
+    std::string path = "test_shards_count_" + std::to_string(rand()) + ".sqlite";
+    created_paths_.push_back(path);
+    {
+        DatabaseManager db(path, 4);
+        ASSERT_TRUE(db.isConnected());
+    }
+    {
+        DatabaseManager changed(path, 2);
+        ASSERT_FALSE(changed.isConnected());
+    }
+    {
+        DatabaseManager unsharded(path, 1);
+        ASSERT_FALSE(unsharded.isConnected());
+    }
+    DatabaseManager reopened(path, 4);
+    ASSERT_TRUE(reopened.isConnected());
+    ASSERT_EQ(reopened.getMessageShardCount(), 4);
+}
+
+// 多线程并发写入不同房间，分别测量不分片和分片时的写入吞吐量
+TEST_F(MessageShardTest, WriteThroughputByShardCount) {
+    const int writer_threads = 4;
+    const int messages_per_thread = 200;
+
+    for (size_t shards : {1, 2, 4}) {
+        auto db = openManager(shards);
+        ASSERT_TRUE(db->isConnected());
+        ASSERT_TRUE(db->createUser("writer", "pass"));
+        auto writer = *db->getUserByUsername("writer");
+
+        std::vector<std::string> room_ids;
+        for (int t = 0; t < writer_threads; ++t) {
+            room_ids.push_back(db->createRoom("bench" + std::to_string(t), "", writer.getId())->getId());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < writer_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                for (int i = 0; i < messages_per_thread; ++i) {
+                    db->saveMessage(room_ids[t], writer.getId(), "payload " + std::to_string(i), i);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t total = 0;
+        for (const auto &room_id : room_ids) {
+            total += db->getMessages(room_id, 0).size();
+        }
+        ASSERT_EQ(total, static_cast<size_t>(writer_threads * messages_per_thread));
+
+        std::cout << "[ shards=" << shards << " ] " << total << " messages in " << seconds
+                  << "s, " << static_cast<int64_t>(total / seconds) << " msg/s" << std::endl;
+    }
+}
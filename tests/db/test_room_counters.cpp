@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "db_test_support.hpp"
+
+// 房间计数测试固件，每个测试使用独立的数据库文件
+class RoomCountersTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        db_path_ = db_test::tempDbPath("test_room_counters");
+    }
+
+    void TearDown() override {
+        db_test::removeDatabase(db_path_);
+    }
+
+    // 在 getAllRooms 的结果中找到指定房间
+    static Room findRoom(DatabaseManager &db, const std::string &room_id) {
+        for (const auto &room : db.getAllRooms()) {
+            if (room.getId() == room_id) {
+                return room;
+            }
+        }
+        return Room();
+    }
+
+    // 创建两个用户和一个房间，两人都加入，写入 count 条消息
+    std::string seedRoom(DatabaseManager &db, int count) {
+        owner_id_ = db_test::ensureUser(db, "owner");
+        member_id_ = db_test::ensureUser(db, "member");
+        auto room_id = db.createRoom("counted", "", owner_id_)->getId();
+        EXPECT_TRUE(db.addRoomMember(room_id, owner_id_));
+        EXPECT_TRUE(db.addRoomMember(room_id, member_id_));
+        for (int i = 0; i < count; ++i) {
+            EXPECT_TRUE(db.saveMessage(room_id, owner_id_, "Message " + std::to_string(i), 1000 + i));
+        }
+        return room_id;
+    }
+
+    // 检查房间在列表、按ID查询和已加入房间中的计数一致
+    void expectCounters(DatabaseManager &db, const std::string &room_id,
+                        int64_t members, int64_t messages, int64_t last_activity) {
+        auto listed = findRoom(db, room_id);
+        EXPECT_EQ(listed.getMemberCount(), members);
+        EXPECT_EQ(listed.getMessageCount(), messages);
+        EXPECT_EQ(listed.getLastActivity(), last_activity);
+        auto room = db.getRoomById(room_id);
+        ASSERT_TRUE(room.has_value());
+        EXPECT_EQ(room->getMemberCount(), members);
+        EXPECT_EQ(room->getMessageCount(), messages);
+        EXPECT_EQ(db.getRoomMemberCount(room_id), static_cast<size_t>(members));
+        auto joined = db.getUserJoinedRooms(owner_id_);
+        ASSERT_EQ(joined.size(), 1);
+        EXPECT_EQ(joined.front().getMessageCount(), messages);
+    }
+
+    std::string db_path_;
+    std::string owner_id_;
+    std::string member_id_;
+};
+
+// 成员进出、重复加入、写入和清理消息时计数随之更新
+TEST_F(RoomCountersTest, MaintainedOnWrites) {
+    DatabaseManager db(db_path_);
+    auto room_id = seedRoom(db, 20);
+    expectCounters(db, room_id, 2, 20, 1019);
+
+    // 重复加入被忽略，不计数
+    ASSERT_TRUE(db.addRoomMember(room_id, member_id_));
+    ASSERT_TRUE(db.removeRoomMember(room_id, member_id_));
+    ASSERT_TRUE(db.removeRoomMember(room_id, member_id_));
+    ASSERT_FALSE(db.saveMessage(room_id, "invalid-user-id", "hello", 5000));
+    expectCounters(db, room_id, 1, 20, 1019);
+
+    while (db.purgeRoomMessages(room_id, 0, 5, 4) > 0) {
+    }
+    expectCounters(db, room_id, 1, 5, 1019);
+
+    // 写入较早时间戳的消息不会让最后活跃时间倒退
+    ASSERT_TRUE(db.saveMessage(room_id, owner_id_, "late", 10));
+    expectCounters(db, room_id, 1, 6, 1019);
+
+    ASSERT_TRUE(db.roomExists(room_id));
+    ASSERT_FALSE(db.roomExists("invalid-room-id"));
+    ASSERT_TRUE(db.isRoomCreator(room_id, owner_id_));
+    ASSERT_FALSE(db.isRoomCreator(room_id, member_id_));
+    ASSERT_TRUE(db.userExists(member_id_));
+    ASSERT_FALSE(db.userExists("invalid-user-id"));
+}
+
+// 版本 2 的库打开时加上计数列并从现有数据回填
+TEST_F(RoomCountersTest, MigratesVersionTwoDatabase) {
+    std::string room_id;
+    {
+        DatabaseManager db(db_path_);
+        room_id = seedRoom(db, 30);
+    }
+    // 退回版本 2 的结构：去掉触发器和计数列
+    ASSERT_TRUE(db_test::execSql(db_path_,
+        "DROP TRIGGER room_members_count_insert; DROP TRIGGER room_members_count_delete;"
+        "DROP TRIGGER messages_count_insert; DROP TRIGGER messages_count_delete;"
+        "ALTER TABLE rooms DROP COLUMN member_count; ALTER TABLE rooms DROP COLUMN message_count;"
+        "ALTER TABLE rooms DROP COLUMN last_activity; PRAGMA user_version = 2;"));
+
+    DatabaseManager db(db_path_);
+    ASSERT_TRUE(db.isConnected());
+    expectCounters(db, room_id, 2, 30, 1029);
+    ASSERT_TRUE(db.saveMessage(room_id, owner_id_, "after", 2000));
+    expectCounters(db, room_id, 2, 31, 2000);
+}
+
+// 分片库和内存引擎中的消息同样计入房间计数
+TEST_F(RoomCountersTest, ExternalMessageStores) {
+    {
+        DatabaseManager db(db_path_, 2);
+        auto room_id = seedRoom(db, 10);
+        expectCounters(db, room_id, 2, 10, 1009);
+        while (db.purgeRoomMessages(room_id, 0, 3, 100) > 0) {
+        }
+        expectCounters(db, room_id, 2, 3, 1009);
+    }
+
+    DatabaseManager memory(DatabaseManager::kMemoryEnginePath);
+    auto room_id = seedRoom(memory, 10);
+    expectCounters(memory, room_id, 2, 10, 1009);
+    ASSERT_TRUE(memory.addRoomMember(room_id, member_id_));
+    ASSERT_TRUE(memory.removeRoomMember(room_id, member_id_));
+    while (memory.purgeRoomMessages(room_id, 0, 4, 3) > 0) {
+    }
+    expectCounters(memory, room_id, 1, 4, 1009);
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../../src/db/database_manager.hpp"
+
+// 版本 1 的表结构：字符串ID作为主键和外键
+static const char *kTextKeySchema =
+    "CREATE TABLE users (id TEXT PRIMARY KEY, username TEXT UNIQUE NOT NULL, "
+    "password_hash TEXT NOT NULL, created_at INTEGER NOT NULL);"
+    "CREATE TABLE rooms (id TEXT PRIMARY KEY, name TEXT UNIQUE NOT NULL, description TEXT DEFAULT '', "
+    "creator_id TEXT NOT NULL, created_at INTEGER NOT NULL, "
+    "FOREIGN KEY(creator_id) REFERENCES users(id) ON DELETE CASCADE);"
+    "CREATE TABLE room_members (room_id TEXT NOT NULL, user_id TEXT NOT NULL, joined_at INTEGER NOT NULL, "
+    "PRIMARY KEY(room_id, user_id), "
+    "FOREIGN KEY(room_id) REFERENCES rooms(id) ON DELETE CASCADE, "
+    "FOREIGN KEY(user_id) REFERENCES users(id) ON DELETE CASCADE);"
+    "CREATE TABLE messages (id INTEGER PRIMARY KEY AUTOINCREMENT, room_id TEXT NOT NULL, user_id TEXT NOT NULL, "
+    "content TEXT NOT NULL, timestamp INTEGER NOT NULL, "
+    "FOREIGN KEY(room_id) REFERENCES rooms(id) ON DELETE CASCADE, "
+    "FOREIGN KEY(user_id) REFERENCES users(id) ON DELETE CASCADE);"
+    "CREATE TABLE room_retention (room_id TEXT PRIMARY KEY, max_age_seconds INTEGER NOT NULL DEFAULT 0, "
+    "max_messages INTEGER NOT NULL DEFAULT 0, "
+    "FOREIGN KEY(room_id) REFERENCES rooms(id) ON DELETE CASCADE);"
+    "CREATE INDEX idx_users_username ON users(username);"
+    "CREATE INDEX idx_rooms_name ON rooms(name);"
+    "CREATE INDEX idx_messages_room ON messages(room_id, id);";
+
+// 表结构迁移测试固件，直接用 sqlite3 构造旧版本的数据库文件
+class SchemaMigrationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        db_path_ = "test_migration_" + std::to_string(rand()) + ".sqlite";
+    }
+
+    void TearDown() override {
+        std::remove(db_path_.c_str());
+    }
+
+    // 创建版本 1 的库：users 个用户、rooms 个房间，每个用户加入所有房间，每个房间 messages 条消息
+    void createTextKeyDatabase(int users, int rooms, int messages) {
+        sqlite3 *db;
+        ASSERT_EQ(sqlite3_open(db_path_.c_str(), &db), SQLITE_OK);
+        ASSERT_EQ(sqlite3_exec(db, kTextKeySchema, nullptr, nullptr, nullptr), SQLITE_OK);
+        ASSERT_EQ(sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr), SQLITE_OK);
+        std::string sql;
+        for (int u = 0; u < users; ++u) {
+            sql += "INSERT INTO users VALUES ('user_" + std::to_string(u) + "', 'name" + std::to_string(u) +
+                   "', 'hash', " + std::to_string(u) + ");";
+        }
+        for (int r = 0; r < rooms; ++r) {
+            std::string room = "'room_" + std::to_string(r) + "'";
+            sql += "INSERT INTO rooms VALUES (" + room + ", 'room" + std::to_string(r) + "', 'desc', 'user_0', " +
+                   std::to_string(r) + ");";
+            for (int u = 0; u < users; ++u) {
+                sql += "INSERT INTO room_members VALUES (" + room + ", 'user_" + std::to_string(u) + "', 0);";
+            }
+            for (int m = 0; m < messages; ++m) {
+                sql += "INSERT INTO messages (room_id, user_id, content, timestamp) VALUES (" + room + ", 'user_" +
+                       std::to_string(m % users) + "', 'Message " + std::to_string(m) + "', " + std::to_string(m) + ");";
+            }
+        }
+        ASSERT_EQ(sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr), SQLITE_OK);
+        ASSERT_EQ(sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr), SQLITE_OK);
+        sqlite3_close(db);
+    }
+
+    // 把 sql 执行 iterations 次，每次绑定 bind(i) 给出的文本参数，返回平均耗时（微秒）
+    static double timeQuery(sqlite3 *db, const char *sql, int iterations,
+                            const std::function<std::string(int)> &bind) {
+        sqlite3_stmt *stmt;
+        EXPECT_EQ(sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr), SQLITE_OK) << sqlite3_errmsg(db);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            std::string param = bind(i);
+            sqlite3_bind_text(stmt, 1, param.c_str(), -1, SQLITE_TRANSIENT);
+            int rows = 0;
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                ++rows;
+            }
+            EXPECT_GT(rows, 0);
+            sqlite3_reset(stmt);
+        }
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        sqlite3_finalize(stmt);
+        return elapsed / iterations;
+    }
+
+    std::string db_path_;
+};
+
+// 旧库打开时自动迁移：数据和消息ID保持不变，外键和级联删除按整数主键生效
+TEST_F(SchemaMigrationTest, MigratesTextKeyDatabase) {
+    createTextKeyDatabase(3, 2, 10);
+    {
+        // 删除最新的一条消息，迁移后它的ID也不能被重新分配
+        sqlite3 *db;
+        ASSERT_EQ(sqlite3_open(db_path_.c_str(), &db), SQLITE_OK);
+        ASSERT_EQ(sqlite3_exec(db,
+                               "DELETE FROM messages WHERE id = (SELECT MAX(id) FROM messages);"
+                               "INSERT INTO room_retention VALUES ('room_1', 3600, 5);",
+                               nullptr, nullptr, nullptr),
+                  SQLITE_OK);
+        sqlite3_close(db);
+    }
+
+    DatabaseManager db(db_path_);
+    ASSERT_TRUE(db.isConnected());
+
+    ASSERT_EQ(db.getAllUsers().size(), 3);
+    ASSERT_EQ(db.getUserById("user_1")->getUsername(), "name1");
+    ASSERT_EQ(db.getRoomById("room_0")->getCreatorId(), "user_0");
+    ASSERT_TRUE(db.isRoomCreator("room_1", "user_0"));
+    ASSERT_EQ(db.getRoomMemberCount("room_0"), 3);
+    ASSERT_EQ(db.getUserJoinedRooms("user_2").size(), 2);
+    ASSERT_EQ(db.getRetention().getRoomPolicy("room_1")->max_messages, 5);
+
+    auto messages = db.getRecentMessages("room_0", 0, 0);
+    ASSERT_EQ(messages.size(), 10);
+    ASSERT_EQ(messages.front().getId(), 1);
+    ASSERT_EQ(messages.back().getUserName(), "name0");
+    ASSERT_EQ(messages.back().getRoomId(), "room_0");
+    ASSERT_EQ(db.getRecentMessages("room_1", 0, 0).back().getId(), 19);
+
+    int64_t id = 0;
+    ASSERT_TRUE(db.saveMessage("room_1", "user_2", "After migration", 100, &id));
+    ASSERT_EQ(id, 21);
+    ASSERT_FALSE(db.saveMessage("room_1", "invalid-user-id", "hello", 100));
+
+    ASSERT_TRUE(db.deleteRoom("room_1"));
+    ASSERT_EQ(db.getUserJoinedRooms("user_2").size(), 1);
+    ASSERT_FALSE(db.getMessageById(id).has_value());
+}
+
+// 对比字符串外键和整数外键下 JOIN 查询的延迟
+TEST_F(SchemaMigrationTest, CompareJoinQueries) {
+    const int users = 200;
+    const int rooms = 50;
+    const int iterations = 200;
+    createTextKeyDatabase(users, rooms, 200);
+
+    auto room = [](int i) { return "room_" + std::to_string(i % rooms); };
+    auto user = [](int i) { return "user_" + std::to_string(i % users); };
+
+    sqlite3 *db;
+    ASSERT_EQ(sqlite3_open(db_path_.c_str(), &db), SQLITE_OK);
+    double text_members = timeQuery(db,
+        "SELECT u.id, u.username, rm.joined_at FROM room_members rm "
+        "JOIN users u ON rm.user_id = u.id WHERE rm.room_id = ?;", iterations, room);
+    double text_joined = timeQuery(db,
+        "SELECT r.id, r.name, r.description, r.creator_id, r.created_at FROM rooms r "
+        "JOIN room_members rm ON r.id = rm.room_id WHERE rm.user_id = ?;", iterations, user);
+    double text_messages = timeQuery(db,
+        "SELECT m.id, m.room_id, m.content, m.timestamp, u.id, u.username FROM messages m "
+        "JOIN users u ON m.user_id = u.id WHERE m.room_id = ? ORDER BY m.id DESC LIMIT 50;", iterations, room);
+    sqlite3_close(db);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        DatabaseConnection conn(db_path_);
+        ASSERT_TRUE(conn.isConnected());
+    }
+    double migrate_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    ASSERT_EQ(sqlite3_open(db_path_.c_str(), &db), SQLITE_OK);
+    double int_members = timeQuery(db,
+        "SELECT u.id, u.username, rm.joined_at FROM rooms r "
+        "JOIN room_members rm ON rm.room_pk = r.pk "
+        "JOIN users u ON u.pk = rm.user_pk WHERE r.id = ?;", iterations, room);
+    double int_joined = timeQuery(db,
+        "SELECT r.id, r.name, r.description, c.id, r.created_at FROM users u "
+        "JOIN room_members rm ON rm.user_pk = u.pk "
+        "JOIN rooms r ON r.pk = rm.room_pk "
+        "JOIN users c ON c.pk = r.creator_pk WHERE u.id = ?;", iterations, user);
+    double int_messages = timeQuery(db,
+        "SELECT m.id, r.id, m.content, m.timestamp, u.id, u.username FROM messages m "
+        "JOIN rooms r ON m.room_pk = r.pk JOIN users u ON m.user_pk = u.pk "
+        "WHERE m.room_pk = (SELECT pk FROM rooms WHERE id = ?) ORDER BY m.id DESC LIMIT 50;", iterations, room);
+    sqlite3_close(db);
+
+    std::cout << "[ migrate ] " << migrate_ms << " ms" << std::endl;
+    std::cout << "[ members ] text " << text_members << " us, integer " << int_members << " us" << std::endl;
+    std::cout << "[ joined  ] text " << text_joined << " us, integer " << int_joined << " us" << std::endl;
+    std::cout << "[ messages] text " << text_messages << " us, integer " << int_messages << " us" << std::endl;
+}
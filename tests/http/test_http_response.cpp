@@ -99,4 +99,30 @@ TEST(HttpResponseTest, CorrectContentLength) {
     std::string body = "Hello, World!";
     auto resp_with_body = http::HttpResponse::Ok(body);
     EXPECT_THAT(resp_with_body.toString(), HasSubstr("Content-Length: " + std::to_string(body.length()) + "\r\n"));
-}
\ No newline at end of file
+}
+TEST(HttpResponseTest, StreamBodyUsesChunkedEncoding) {
+    // 流式响应体：每次写入成为一个块，空写入被跳过，最后是长度为 0 的结束块
+    auto resp = http::HttpResponse::Ok().withStreamBody([](const http::BodySink &sink) {
+        sink("{\"a\":");
+        sink("");
+        sink(std::string(20, 'x'));
+    });
+    ASSERT_TRUE(resp.isStreaming());
+
+    const auto resp_str = resp.toString();
+    EXPECT_THAT(resp_str, HasSubstr("Transfer-Encoding: chunked\r\n"));
+    EXPECT_THAT(resp_str, Not(HasSubstr("Content-Length")));
+    EXPECT_THAT(resp_str, HasSubstr("Content-Type: application/json; charset=utf-8\r\n"));
+    EXPECT_THAT(resp_str, EndsWith("\r\n\r\n5\r\n{\"a\":\r\n14\r\n" + std::string(20, 'x') + "\r\n0\r\n\r\n"));
+
+    // 写出失败后生产者收到 false，不再写入结束块（响应头和第一个块共 4 次写入成功）
+    int produced = 0;
+    auto failing = http::HttpResponse::Ok().withStreamBody([&produced](const http::BodySink &sink) {
+        while (sink("data")) {
+            ++produced;
+        }
+    });
+    int writes = 0;
+    EXPECT_FALSE(failing.writeTo([&writes](std::string_view) { return ++writes < 5; }));
+    EXPECT_EQ(produced, 1);
+}
@@ -155,3 +155,21 @@ TEST(RoomTest, LargeTimestamp) {
     
     EXPECT_EQ(restored_room.getCreatedAt(), large_timestamp);
 }
+
+// 测试房间计数字段的JSON转换
+TEST(RoomTest, CountersRoundTrip) {
+    Room room("room_counters", "Counters", "", "user_counter", 1640995800);
+    room.setMemberCount(3);
+    room.setMessageCount(120);
+    room.setLastActivity(1640999999);
+
+    json j = room.toJson();
+    EXPECT_EQ(j["member_count"], 3);
+    EXPECT_EQ(j["message_count"], 120);
+    EXPECT_EQ(j["last_activity"], 1640999999);
+
+    Room restored_room = Room::fromJson(j);
+    EXPECT_EQ(restored_room.getMemberCount(), 3);
+    EXPECT_EQ(restored_room.getMessageCount(), 120);
+    EXPECT_EQ(restored_room.getLastActivity(), 1640999999);
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "../../src/utils/json_writer.hpp"
+
+// 嵌套对象和数组的逗号、转义与 nlohmann::json 解析结果一致
+TEST(JsonWriterTest, WritesNestedValues) {
+    std::string out;
+    {
+        utils::JsonWriter writer([&out](std::string_view data) {
+            out.append(data);
+            return true;
+        });
+        writer.beginObject()
+            .key("name").value("quote \" slash \\ newline \n tab \t bell \x07 中文")
+            .key("count").value(42)
+            .key("negative").value(int64_t(-7))
+            .key("flag").value(false)
+            .key("empty").beginArray().endArray()
+            .key("items").beginArray()
+            .value(1).value("two").beginObject().key("three").value(true).endObject()
+            .endArray()
+            .key("raw").raw("{\"x\":[1,2]}")
+            .endObject();
+    }
+
+    auto parsed = nlohmann::json::parse(out);
+    EXPECT_EQ(parsed["name"], "quote \" slash \\ newline \n tab \t bell \x07 中文");
+    EXPECT_EQ(parsed["count"], 42);
+    EXPECT_EQ(parsed["negative"], -7);
+    EXPECT_EQ(parsed["flag"], false);
+    EXPECT_TRUE(parsed["empty"].empty());
+    EXPECT_EQ(parsed["items"].dump(), "[1,\"two\",{\"three\":true}]");
+    EXPECT_EQ(parsed["raw"]["x"][1], 2);
+}
+
+// 缓冲区超过阈值时按块交给 sink；sink 返回 false 后停止输出
+TEST(JsonWriterTest, FlushesInChunks) {
+    std::vector<std::string> chunks;
+    utils::JsonWriter writer([&chunks](std::string_view data) {
+        chunks.emplace_back(data);
+        return chunks.size() < 3;
+    }, 64);
+
+    writer.beginArray();
+    for (int i = 0; i < 100 && writer.ok(); ++i) {
+        writer.beginObject().key("index").value(i).endObject();
+    }
+    EXPECT_FALSE(writer.ok());
+    EXPECT_EQ(chunks.size(), 3);
+    for (const auto &chunk : chunks) {
+        EXPECT_GE(chunk.size(), 64);
+    }
+    EXPECT_FALSE(writer.flush());
+}
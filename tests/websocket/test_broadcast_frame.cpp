@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "../../src/websocket/frame_header.hpp"
+
+// 统计堆分配次数，用于对比两种广播方式
+namespace {
+    std::atomic<int64_t> g_allocations{0};
+}
+
+void *operator new(size_t size) {
+    ++g_allocations;
+    if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+class BroadcastFrameTest : public ::testing::Test {
+protected:
+    using Frame = std::shared_ptr<const std::string>;
+    using SendQueue = std::vector<Frame>;
+
+    struct FanOutStats {
+        int64_t allocations = 0;
+        double micros = 0;
+    };
+
+    // 每个接收者单独成帧：复制负载并编码帧头，相当于逐个调用 send(hdl, string, opcode)
+    static FanOutStats fanOutPerRecipient(std::vector<SendQueue> &queues, const std::string &payload) {
+        int64_t before = g_allocations;
+        auto begin = std::chrono::steady_clock::now();
+        for (auto &queue : queues) {
+            auto frame = std::make_shared<std::string>(FrameHeader::encode(1, payload.size()));
+            frame->append(payload);
+            queue.push_back(std::move(frame));
+        }
+        return {g_allocations - before,
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count()};
+    }
+
+    // 成帧一次，所有接收者的发送队列共享同一个缓冲区
+    static FanOutStats fanOutShared(std::vector<SendQueue> &queues, const std::string &payload) {
+        int64_t before = g_allocations;
+        auto begin = std::chrono::steady_clock::now();
+        auto frame = std::make_shared<std::string>(FrameHeader::encode(1, payload.size()));
+        frame->append(payload);
+        Frame shared = std::move(frame);
+        for (auto &queue : queues) {
+            queue.push_back(shared);
+        }
+        return {g_allocations - before,
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count()};
+    }
+
+    static std::vector<SendQueue> makeQueues(size_t recipients) {
+        std::vector<SendQueue> queues(recipients);
+        for (auto &queue : queues) {
+            queue.reserve(1); // 队列自身的扩容不计入广播开销
+        }
+        return queues;
+    }
+};
+
+// 帧头按负载长度选择 7 位、16 位或 64 位长度字段，不加掩码
+TEST_F(BroadcastFrameTest, EncodeHeader) {
+    ASSERT_EQ(FrameHeader::encode(1, 0), std::string("\x81\x00", 2));
+    ASSERT_EQ(FrameHeader::encode(1, 125), std::string("\x81\x7d", 2));
+    ASSERT_EQ(FrameHeader::encode(2, 126), std::string("\x82\x7e\x00\x7e", 4));
+    ASSERT_EQ(FrameHeader::encode(1, 65535), std::string("\x81\x7e\xff\xff", 4));
+    ASSERT_EQ(FrameHeader::encode(1, 65536), std::string("\x81\x7f\x00\x00\x00\x00\x00\x01\x00\x00", 10));
+}
+
+// 100、1k、10k 成员房间的广播：对比分配次数和扇出耗时
+TEST_F(BroadcastFrameTest, FanOutAllocations) {
+    const std::string payload(1024, 'x');
+    for (size_t recipients : {100, 1000, 10000}) {
+        auto per_recipient_queues = makeQueues(recipients);
+        auto shared_queues = makeQueues(recipients);
+        auto per_recipient = fanOutPerRecipient(per_recipient_queues, payload);
+        auto shared = fanOutShared(shared_queues, payload);
+
+        // 共享缓冲区的分配次数与房间大小无关
+        ASSERT_GE(per_recipient.allocations, static_cast<int64_t>(recipients));
+        ASSERT_LE(shared.allocations, 3);
+        ASSERT_EQ(*shared_queues.front().front(), *per_recipient_queues.back().front());
+        ASSERT_EQ(shared_queues.front().front(), shared_queues.back().front());
+        ASSERT_EQ(shared_queues.front().front().use_count(), static_cast<long>(recipients));
+
+        std::cout << recipients << " members: per-recipient " << per_recipient.allocations << " allocs, "
+                  << per_recipient.micros << " us; shared " << shared.allocations << " allocs, "
+                  << shared.micros << " us" << std::endl;
+        RecordProperty("shared_fanout_us_" + std::to_string(recipients), static_cast<int>(shared.micros));
+    }
+}
@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../src/websocket/connection_registry.hpp"
+
+// 连接登记表测试固件，用普通的 shared_ptr 模拟 websocketpp 的连接对象
+class ConnectionRegistryTest : public ::testing::Test {
+protected:
+    std::shared_ptr<void> newConnection() {
+        auto connection = std::make_shared<int>(0);
+        connections_.push_back(connection);
+        return connection;
+    }
+
+    static bool hasMember(const ConnectionRegistry::Snapshot &snapshot, const std::string &user_id) {
+        if (!snapshot) {
+            return false;
+        }
+        for (const auto &member : *snapshot) {
+            if (member.user_id == user_id) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::shared_ptr<void>> connections_;
+};
+
+// 绑定、加入、切换房间、离开
+TEST_F(ConnectionRegistryTest, BindJoinLeave) {
+    ConnectionRegistry registry(4);
+    auto alice = newConnection();
+    auto bob = newConnection();
+    ASSERT_TRUE(registry.bind("alice", alice).expired());
+    ASSERT_TRUE(registry.bind("bob", bob).expired());
+    ASSERT_EQ(registry.userOf(alice), "alice");
+    ASSERT_FALSE(registry.userOf(newConnection()).has_value());
+    ASSERT_EQ(registry.connectionCount(), 2);
+
+    ASSERT_TRUE(registry.join("alice", "r1").left_room.empty());
+    ASSERT_TRUE(registry.join("bob", "r1").left_room.empty());
+    ASSERT_TRUE(registry.join("alice", "r1").already_in_room);
+    ASSERT_EQ(registry.members("r1")->size(), 2);
+    ASSERT_EQ(registry.currentRoom("alice"), "r1");
+
+    auto switched = registry.join("alice", "r2");
+    ASSERT_FALSE(switched.already_in_room);
+    ASSERT_EQ(switched.left_room, "r1");
+    ASSERT_FALSE(hasMember(registry.members("r1"), "alice"));
+    ASSERT_TRUE(hasMember(registry.members("r2"), "alice"));
+
+    ASSERT_EQ(registry.leave("alice"), "r2");
+    ASSERT_EQ(registry.leave("alice"), "");
+    ASSERT_EQ(registry.members("r2"), nullptr); // 空房间被删除
+    ASSERT_EQ(registry.currentRoom("alice"), "");
+
+    auto unbound = registry.unbind(bob);
+    ASSERT_TRUE(unbound.has_value());
+    ASSERT_EQ(unbound->user_id, "bob");
+    ASSERT_EQ(unbound->left_room, "r1");
+    ASSERT_EQ(registry.members("r1"), nullptr);
+    ASSERT_FALSE(registry.unbind(bob).has_value());
+    ASSERT_EQ(registry.connectionCount(), 1);
+}
+
+// 重新登录替换连接：房间快照换成新连接，旧连接关闭时不影响用户
+TEST_F(ConnectionRegistryTest, RebindReplacesConnection) {
+    ConnectionRegistry registry(4);
+    auto first = newConnection();
+    auto second = newConnection();
+    registry.bind("alice", first);
+    registry.join("alice", "r1");
+
+    auto old_connection = registry.bind("alice", second);
+    ASSERT_EQ(old_connection.lock(), first);
+    ASSERT_EQ(registry.members("r1")->front().hdl.lock(), second);
+    ASSERT_FALSE(registry.userOf(first).has_value());
+    ASSERT_EQ(registry.connections().size(), 1);
+
+    ASSERT_FALSE(registry.unbind(first).has_value());
+    ASSERT_EQ(registry.currentRoom("alice"), "r1");
+    ASSERT_TRUE(hasMember(registry.members("r1"), "alice"));
+}
+
+// 异步完成的加入晚于连接关闭时不会留下没有连接的成员
+TEST_F(ConnectionRegistryTest, JoinAfterUnbindIsIgnored) {
+    ConnectionRegistry registry(4);
+    auto alice = newConnection();
+    registry.bind("alice", alice);
+    registry.unbind(alice);
+
+    ASSERT_TRUE(registry.join("alice", "r1").not_bound);
+    ASSERT_TRUE(registry.join("nobody", "r1").not_bound);
+    ASSERT_EQ(registry.members("r1"), nullptr);
+    ASSERT_EQ(registry.currentRoom("alice"), "");
+}
+
+// 已取出的快照不随之后的加入/离开变化
+TEST_F(ConnectionRegistryTest, SnapshotIsStable) {
+    ConnectionRegistry registry(4);
+    for (int i = 0; i < 3; ++i) {
+        std::string user_id = "u" + std::to_string(i);
+        registry.bind(user_id, newConnection());
+        registry.join(user_id, "r1");
+    }
+    auto snapshot = registry.members("r1");
+    registry.leave("u0");
+    registry.bind("u3", newConnection());
+    registry.join("u3", "r1");
+
+    ASSERT_EQ(snapshot->size(), 3);
+    ASSERT_TRUE(hasMember(snapshot, "u0"));
+    ASSERT_FALSE(hasMember(snapshot, "u3"));
+    ASSERT_EQ(registry.members("r1")->size(), 3);
+    ASSERT_TRUE(hasMember(registry.members("r1"), "u3"));
+}
+
+// 并发吞吐：多个线程同时加入/切换房间，同时有线程持续取房间快照模拟广播，
+// 连接数逐步增加，输出每秒加入次数和每秒广播投递的消息数
+TEST_F(ConnectionRegistryTest, ConcurrentThroughput) {
+    const int threads = std::max(2u, std::thread::hardware_concurrency());
+    const int rooms = 100;
+    for (int connections : {1000, 10000}) {
+        ConnectionRegistry registry;
+        for (int i = 0; i < connections; ++i) {
+            registry.bind("u" + std::to_string(i), newConnection());
+        }
+
+        std::atomic<bool> joining{true};
+        std::atomic<int64_t> deliveries{0};
+        std::thread broadcaster([&]() {
+            int64_t delivered = 0;
+            for (int r = 0; joining; r = (r + 1) % rooms) {
+                auto snapshot = registry.members("room" + std::to_string(r));
+                if (snapshot) {
+                    for (const auto &member : *snapshot) {
+                        delivered += member.hdl.expired() ? 0 : 1;
+                    }
+                }
+            }
+            deliveries = delivered;
+        });
+
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                // 每个连接先加入一个房间再切换到另一个房间
+                for (int i = t; i < connections; i += threads) {
+                    std::string user_id = "u" + std::to_string(i);
+                    registry.join(user_id, "room" + std::to_string(i % rooms));
+                    registry.join(user_id, "room" + std::to_string((i + 1) % rooms));
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        joining = false;
+        broadcaster.join();
+
+        size_t members = 0;
+        for (int r = 0; r < rooms; ++r) {
+            auto snapshot = registry.members("room" + std::to_string(r));
+            members += snapshot ? snapshot->size() : 0;
+        }
+        ASSERT_EQ(members, static_cast<size_t>(connections));
+
+        std::cout << connections << " connections, " << threads << " threads: "
+                  << static_cast<int64_t>(connections * 2 / seconds) << " joins/s, "
+                  << static_cast<int64_t>(deliveries / seconds) << " broadcast msgs/s" << std::endl;
+        RecordProperty("joins_per_sec_" + std::to_string(connections), static_cast<int>(connections * 2 / seconds));
+    }
+}
+
+// 加入风暴：大量连接同时加入同一个房间，期间持续有广播读取快照。
+// 加入只修改成员列表，快照只在广播读取时发布，总开销不随成员数平方增长
+TEST_F(ConnectionRegistryTest, JoinStormIntoOneRoom) {
+    const int threads = std::max(2u, std::thread::hardware_concurrency());
+    const int connections = 10000;
+    ConnectionRegistry registry;
+    for (int i = 0; i < connections; ++i) {
+        registry.bind("u" + std::to_string(i), newConnection());
+    }
+
+    std::atomic<bool> joining{true};
+    std::atomic<int64_t> snapshots{0};
+    std::thread broadcaster([&]() {
+        int64_t taken = 0;
+        while (joining) {
+            auto snapshot = registry.members("storm");
+            taken += snapshot ? 1 : 0;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        snapshots = taken;
+    });
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (int i = t; i < connections; i += threads) {
+                registry.join("u" + std::to_string(i), "storm");
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    joining = false;
+    broadcaster.join();
+
+    ASSERT_EQ(registry.memberCount("storm"), static_cast<size_t>(connections));
+    ASSERT_EQ(registry.members("storm")->size(), static_cast<size_t>(connections));
+
+    // 一半成员离开后快照与成员列表一致
+    for (int i = 0; i < connections; i += 2) {
+        registry.leave("u" + std::to_string(i));
+    }
+    auto snapshot = registry.members("storm");
+    ASSERT_EQ(snapshot->size(), static_cast<size_t>(connections / 2));
+    ASSERT_TRUE(hasMember(snapshot, "u1"));
+    ASSERT_FALSE(hasMember(snapshot, "u0"));
+
+    std::cout << connections << " joins into one room, " << threads << " threads: "
+              << static_cast<int64_t>(connections / seconds) << " joins/s, "
+              << snapshots << " snapshots taken during the storm" << std::endl;
+    RecordProperty("storm_joins_per_sec", static_cast<int>(connections / seconds));
+}
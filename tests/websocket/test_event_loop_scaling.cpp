@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../src/websocket/connection_registry.hpp"
+
+using json = nlohmann::json;
+
+// 多线程事件循环的扩展性测试
+// 按 WebSocketServer 的线程模型模拟：多个线程运行同一个 io_service，每个客户端一个 strand；
+// 每条消息解析 JSON、查登记表找到用户和房间、序列化广播消息并投递给房间成员快照
+class EventLoopScalingTest : public ::testing::Test {
+protected:
+    struct Client {
+        std::shared_ptr<void> connection;
+        std::unique_ptr<boost::asio::io_service::strand> strand;
+        int64_t last_seq = -1; // 只在客户端自己的 strand 上访问
+    };
+
+    static constexpr int kClients = 10000;
+    static constexpr int kRooms = 100;
+    static constexpr int kMessagesPerClient = 5;
+
+    // 处理一条客户端消息，返回投递的消息数
+    static int64_t handleMessage(ConnectionRegistry &registry, Client &client, const std::string &payload,
+                                 std::atomic<int64_t> &out_of_order) {
+        auto message = json::parse(payload);
+        int64_t seq = message.at("seq").get<int64_t>();
+        if (seq != client.last_seq + 1) {
+            ++out_of_order;
+        }
+        client.last_seq = seq;
+
+        auto user_id = registry.userOf(client.connection);
+        auto members = registry.members(registry.currentRoom(*user_id));
+        json chat = {
+            {"success", true},
+            {"data", {{"type", "message_received"}, {"user_id", *user_id}, {"content", message.at("content")}}}};
+        std::string frame = chat.dump();
+
+        int64_t delivered = 0;
+        for (const auto &member : *members) {
+            // 以连接句柄有效性检查代替真实的发送
+            delivered += member.hdl.expired() ? 0 : static_cast<int64_t>(frame.size() > 0);
+        }
+        return delivered;
+    }
+};
+
+// 1..N 个事件循环线程处理 10k 客户端的消息，输出每秒处理的消息数和投递数；
+// 同一客户端的消息必须按发送顺序处理
+TEST_F(EventLoopScalingTest, MessagesPerSecond) {
+    const int max_threads = std::max(2u, std::thread::hardware_concurrency());
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    for (int threads : thread_counts) {
+        boost::asio::io_service io_service;
+        ConnectionRegistry registry;
+        std::vector<Client> clients(kClients);
+        for (int i = 0; i < kClients; ++i) {
+            std::string user_id = "u" + std::to_string(i);
+            clients[i].connection = std::make_shared<int>(i);
+            clients[i].strand.reset(new boost::asio::io_service::strand(io_service));
+            registry.bind(user_id, clients[i].connection);
+            registry.join(user_id, "room" + std::to_string(i % kRooms));
+        }
+
+        // 消息交错投递，相当于所有客户端同时在发
+        std::atomic<int64_t> handled{0};
+        std::atomic<int64_t> delivered{0};
+        std::atomic<int64_t> out_of_order{0};
+        for (int seq = 0; seq < kMessagesPerClient; ++seq) {
+            for (auto &client : clients) {
+                std::string payload = json{{"type", "send_message"}, {"seq", seq}, {"content", "hello"}}.dump();
+                client.strand->post([&, payload]() {
+                    delivered += handleMessage(registry, client, payload, out_of_order);
+                    ++handled;
+                });
+            }
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> loop_threads;
+        for (int t = 0; t < threads; ++t) {
+            loop_threads.emplace_back([&io_service]() { io_service.run(); });
+        }
+        for (auto &thread : loop_threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        ASSERT_EQ(handled, static_cast<int64_t>(kClients) * kMessagesPerClient);
+        ASSERT_EQ(delivered, handled * (kClients / kRooms));
+        ASSERT_EQ(out_of_order, 0);
+
+        std::cout << threads << " loop threads, " << kClients << " clients: "
+                  << static_cast<int64_t>(handled / seconds) << " msgs/s, "
+                  << static_cast<int64_t>(delivered / seconds) << " deliveries/s" << std::endl;
+        RecordProperty("msgs_per_sec_" + std::to_string(threads) + "_threads", static_cast<int>(handled / seconds));
+    }
+}
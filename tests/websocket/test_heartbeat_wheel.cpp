@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <vector>
+#include "../../src/websocket/heartbeat_wheel.hpp"
+
+// 用手动推进的时钟驱动时间轮，连接句柄用普通的 shared_ptr 代替
+class HeartbeatWheelTest : public ::testing::Test {
+protected:
+    static HeartbeatWheel::Options options(int64_t interval_ms, int max_missed, int64_t tick_ms) {
+        HeartbeatWheel::Options options;
+        options.interval_ms = interval_ms;
+        options.max_missed = max_missed;
+        options.tick_ms = tick_ms;
+        return options;
+    }
+
+    // 从 from_ms 开始按 step_ms 推进到 to_ms，记录 ping 和驱逐
+    void run(HeartbeatWheel &wheel, int64_t from_ms, int64_t to_ms, int64_t step_ms) {
+        for (int64_t now = from_ms + step_ms; now <= to_ms; now += step_ms) {
+            wheel.advance(
+                now,
+                [&](const HeartbeatWheel::Handle &hdl) { pings_.push_back(hdl.lock().get()); },
+                [&](const HeartbeatWheel::Handle &hdl) { evicted_.insert(hdl.lock().get()); });
+        }
+    }
+
+    std::vector<const void *> pings_;
+    std::set<const void *> evicted_;
+};
+
+// 空闲连接满一个间隔后收到 ping，连续 max_missed 次无响应后被驱逐
+TEST_F(HeartbeatWheelTest, EvictsAfterMissedPings) {
+    HeartbeatWheel wheel(options(1000, 2, 100), 0);
+    auto idle = std::make_shared<int>(1);
+    wheel.add(idle, 0);
+
+    run(wheel, 0, 900, 100);
+    ASSERT_TRUE(pings_.empty());
+    run(wheel, 900, 1000, 100);
+    ASSERT_EQ(pings_.size(), 1);
+    run(wheel, 1000, 2000, 100);
+    ASSERT_EQ(pings_.size(), 2);
+    ASSERT_TRUE(evicted_.empty());
+    run(wheel, 2000, 3000, 100);
+    ASSERT_EQ(evicted_.count(idle.get()), 1);
+    ASSERT_EQ(wheel.stats().tracked, 0);
+    ASSERT_EQ(wheel.stats().pings, 2);
+    ASSERT_EQ(wheel.stats().evicted, 1);
+}
+
+// 有活动的连接不会收到 ping；pong 之后重新计数
+TEST_F(HeartbeatWheelTest, ActivityPostponesPing) {
+    HeartbeatWheel wheel(options(1000, 2, 100), 0);
+    auto busy = std::make_shared<int>(1);
+    auto answering = std::make_shared<int>(2);
+    auto busy_entry = wheel.add(busy, 0);
+    auto answering_entry = wheel.add(answering, 0);
+
+    for (int64_t now = 100; now <= 10000; now += 100) {
+        busy_entry->touch(now);
+        // 收到 ping 后立即回复 pong
+        wheel.advance(
+            now,
+            [&](const HeartbeatWheel::Handle &hdl) {
+                pings_.push_back(hdl.lock().get());
+                answering_entry->touch(now);
+            },
+            [&](const HeartbeatWheel::Handle &hdl) { evicted_.insert(hdl.lock().get()); });
+    }
+    for (const void *pinged : pings_) {
+        ASSERT_NE(pinged, busy.get());
+    }
+    ASSERT_EQ(wheel.stats().pings, 9); // 只有 answering 空闲，pong 之后再空闲一个间隔才会收到下一次 ping
+    ASSERT_TRUE(evicted_.empty());
+    ASSERT_EQ(wheel.stats().tracked, 2);
+}
+
+// 已关闭的连接在下次轮到时丢弃，不再 ping
+TEST_F(HeartbeatWheelTest, ClosedEntriesAreDropped) {
+    HeartbeatWheel wheel(options(1000, 1, 100), 0);
+    auto conn = std::make_shared<int>(1);
+    wheel.add(conn, 0)->close();
+    run(wheel, 0, 5000, 100);
+    ASSERT_TRUE(pings_.empty());
+    ASSERT_TRUE(evicted_.empty());
+    ASSERT_EQ(wheel.stats().tracked, 0);
+}
+
+// 10 万个连接：每个 tick 只处理到期的一个槽位，一个间隔内每个连接只被检查一次
+TEST_F(HeartbeatWheelTest, ScalesToManyConnections) {
+    const int connections = 100000;
+    HeartbeatWheel wheel(options(30000, 2, 1000), 0);
+    std::vector<std::shared_ptr<int>> handles;
+    std::vector<HeartbeatWheel::EntryPtr> entries;
+    for (int i = 0; i < connections; ++i) {
+        handles.push_back(std::make_shared<int>(i));
+        entries.push_back(wheel.add(handles.back(), i % 30000)); // 连接时间分散在一个间隔内
+    }
+
+    run(wheel, 0, 29000, 1000);
+    ASSERT_TRUE(pings_.empty());
+
+    // 一半的连接持续活跃
+    double max_tick_us = 0;
+    for (int64_t now = 30000; now <= 60000; now += 1000) {
+        for (int i = 0; i < connections; i += 2) {
+            entries[i]->touch(now);
+        }
+        auto begin = std::chrono::steady_clock::now();
+        wheel.advance(now, [&](const HeartbeatWheel::Handle &) { pings_.push_back(nullptr); },
+                      [&](const HeartbeatWheel::Handle &hdl) { evicted_.insert(hdl.lock().get()); });
+        max_tick_us = std::max(max_tick_us, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+    }
+    // 空闲的一半在这个间隔内各收到一次 ping
+    ASSERT_EQ(static_cast<int>(pings_.size()), connections / 2);
+    ASSERT_TRUE(evicted_.empty());
+    ASSERT_EQ(wheel.stats().tracked, static_cast<size_t>(connections));
+    std::cout << connections << " connections: " << pings_.size() << " pings per interval, slowest tick "
+              << max_tick_us << " us" << std::endl;
+    RecordProperty("max_tick_us", static_cast<int>(max_tick_us));
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../src/db/database_manager.hpp"
+#include "../../src/websocket/message_pipeline.hpp"
+
+// 消息流水线测试：真实的 DatabaseManager + 多线程 io_service，模拟 WebSocket 服务器的聊天消息处理
+class MessagePipelineTest : public ::testing::Test {
+protected:
+    static constexpr int kRooms = 8;
+
+    void SetUp() override {
+        db_path_ = "test_pipeline_" + std::to_string(rand()) + ".sqlite";
+        db_ = std::make_unique<DatabaseManager>(db_path_);
+        db_->createUser("sender", "pass");
+        user_id_ = db_->getUserByUsername("sender")->getId();
+        for (int r = 0; r < kRooms; ++r) {
+            rooms_.push_back(db_->createRoom("room" + std::to_string(r), "", user_id_)->getId());
+            ASSERT_EQ(db_->joinRoom(rooms_.back(), user_id_), JoinResult::Joined);
+            for (int i = 0; i < 500; ++i) {
+                ASSERT_TRUE(db_->saveMessage(rooms_.back(), user_id_, "history " + std::to_string(i), i));
+            }
+        }
+
+        work_ = std::make_unique<boost::asio::io_service::work>(io_service_);
+        for (int i = 0; i < 2; ++i) {
+            loop_threads_.emplace_back([this]() { io_service_.run(); });
+        }
+        pipeline_ = std::make_unique<MessagePipeline>(*db_, io_service_);
+    }
+
+    void TearDown() override {
+        work_.reset();
+        io_service_.stop();
+        for (auto &thread : loop_threads_) {
+            thread.join();
+        }
+        pipeline_.reset();
+        db_.reset();
+        std::remove(db_path_.c_str());
+        std::remove((db_path_ + "-wal").c_str());
+        std::remove((db_path_ + "-shm").c_str());
+    }
+
+    struct RunResult {
+        std::vector<double> latencies; // 提交到广播回调的耗时（微秒）
+        int out_of_order = 0;
+        int failed = 0;
+    };
+
+    // 按固定间隔向各房间轮流提交消息，等待全部完成
+    RunResult sendMessages(int count) {
+        RunResult run;
+        std::mutex result_mutex;
+        std::vector<int64_t> last_id(kRooms, 0); // 同一房间的回调在同一个 strand 上串行执行
+        std::atomic<int> done{0};
+
+        for (int i = 0; i < count; ++i) {
+            int room = i % kRooms;
+            auto sent_at = std::chrono::steady_clock::now();
+            bool accepted = pipeline_->submitChat(
+                {rooms_[room], user_id_, "live " + std::to_string(i), 1000 + i},
+                [&, room, sent_at](const MessagePipeline::ChatMessage &chat, const MessagePipeline::Persisted &result) {
+                    double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent_at).count();
+                    bool in_order = result.message_id > last_id[room];
+                    last_id[room] = result.message_id;
+                    {
+                        std::lock_guard<std::mutex> lock(result_mutex);
+                        run.latencies.push_back(micros);
+                        run.out_of_order += in_order ? 0 : 1;
+                        run.failed += result.saved && result.username == "sender" && chat.room_id == rooms_[room] ? 0 : 1;
+                    }
+                    ++done;
+                });
+            EXPECT_TRUE(accepted);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (done < count && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return run;
+    }
+
+    static double percentile(std::vector<double> samples, double p) {
+        if (samples.empty()) {
+            return 0;
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(samples.size() * p))];
+    }
+
+    std::string db_path_;
+    std::unique_ptr<DatabaseManager> db_;
+    std::string user_id_;
+    std::vector<std::string> rooms_;
+    boost::asio::io_service io_service_;
+    std::unique_ptr<boost::asio::io_service::work> work_;
+    std::vector<std::thread> loop_threads_;
+    std::unique_ptr<MessagePipeline> pipeline_;
+};
+
+// 同一房间的消息按写入顺序回到事件循环；对比有无并发历史查询时端到端延迟的 p99
+TEST_F(MessagePipelineTest, OrderingAndLatencyUnderHistoryLoad) {
+    auto baseline = sendMessages(400);
+    ASSERT_EQ(baseline.latencies.size(), 400);
+    ASSERT_EQ(baseline.out_of_order, 0);
+    ASSERT_EQ(baseline.failed, 0);
+
+    // 历史分页查询绕过缓存直接读数据库
+    std::atomic<bool> reading{true};
+    std::atomic<int64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t) {
+        readers.emplace_back([&, t]() {
+            for (int i = t; reading; ++i) {
+                std::vector<std::string> page;
+                db_->getMessagePageIfMember(rooms_[i % kRooms], user_id_, 50, 100 + i % 3000, page);
+                ++reads;
+            }
+        });
+    }
+    auto loaded = sendMessages(400);
+    reading = false;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQ(loaded.latencies.size(), 400);
+    ASSERT_EQ(loaded.out_of_order, 0);
+    ASSERT_EQ(loaded.failed, 0);
+    ASSERT_GT(reads, 0);
+
+    double p99_baseline = percentile(baseline.latencies, 0.99);
+    double p99_loaded = percentile(loaded.latencies, 0.99);
+    std::cout << "end-to-end p99 without history reads: " << p99_baseline << " us, with "
+              << reads << " concurrent history reads: " << p99_loaded << " us" << std::endl;
+    RecordProperty("e2e_p99_baseline_us", static_cast<int>(p99_baseline));
+    RecordProperty("e2e_p99_history_load_us", static_cast<int>(p99_loaded));
+
+    // 写入的消息都进入了热缓存
+    std::vector<std::string> recent;
+    ASSERT_EQ(db_->getMessagePageIfMember(rooms_[0], user_id_, 1, 0, recent), MembershipStatus::Member);
+    ASSERT_NE(recent.front().find("live 392"), std::string::npos);
+}
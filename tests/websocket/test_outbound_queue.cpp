@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../../src/websocket/outbound_queue.hpp"
+
+class OutboundQueueTest : public ::testing::Test {
+protected:
+    static OutboundQueue::Frame frame(const std::string &payload) {
+        return std::make_shared<std::string>(payload);
+    }
+
+    static std::string payloadOf(const OutboundQueue::Frame &frame) {
+        return *std::static_pointer_cast<std::string>(frame);
+    }
+
+    static OutboundQueue::Limits limits(size_t max_messages, size_t max_bytes, OutboundQueue::OverflowPolicy policy) {
+        OutboundQueue::Limits limits;
+        limits.max_messages = max_messages;
+        limits.max_bytes = max_bytes;
+        limits.transport_bytes = max_bytes / 4;
+        limits.policy = policy;
+        return limits;
+    }
+};
+
+// 同一轮入队的帧只安排一次 flush，一次取出
+TEST_F(OutboundQueueTest, CoalesceWithinIteration) {
+    OutboundQueue queue;
+    ASSERT_EQ(queue.push(frame("a"), 1, false, 0), OutboundQueue::PushResult::ScheduleFlush);
+    ASSERT_EQ(queue.push(frame("b"), 1, false, 0), OutboundQueue::PushResult::Queued);
+    ASSERT_EQ(queue.push(frame("c"), 1, true, 0), OutboundQueue::PushResult::Queued);
+
+    bool more = true;
+    auto batch = queue.takeBatch(0, more);
+    ASSERT_FALSE(more);
+    ASSERT_EQ(batch.size(), 3);
+    ASSERT_EQ(payloadOf(batch[0]) + payloadOf(batch[1]) + payloadOf(batch[2]), "abc");
+
+    // flush 之后新的帧需要再安排一次
+    ASSERT_EQ(queue.push(frame("d"), 1, false, 0), OutboundQueue::PushResult::ScheduleFlush);
+    auto stats = queue.stats();
+    ASSERT_EQ(stats.flushes, 1);
+    ASSERT_EQ(stats.flushed_messages, 3);
+    ASSERT_EQ(stats.queued_messages, 1);
+}
+
+// 传输层缓冲已满时帧留在队列中，空闲时至少交出一帧
+TEST_F(OutboundQueueTest, TransportBudget) {
+    OutboundQueue queue;
+    queue.setLimits(limits(100, 4000, OutboundQueue::OverflowPolicy::DropOldest)); // 传输层上限 1000 字节
+    for (int i = 0; i < 5; ++i) {
+        queue.push(frame(std::to_string(i)), 400, false, 0);
+    }
+
+    bool more = false;
+    ASSERT_EQ(queue.takeBatch(0, more).size(), 2);
+    ASSERT_TRUE(more);
+    ASSERT_EQ(queue.takeBatch(900, more).size(), 0);
+    ASSERT_TRUE(more);
+    ASSERT_EQ(queue.takeBatch(100, more).size(), 2);
+    ASSERT_EQ(queue.takeBatch(0, more).size(), 1);
+    ASSERT_FALSE(more);
+
+    queue.push(frame("huge"), 3000, false, 0);
+    ASSERT_EQ(queue.takeBatch(0, more).size(), 1);
+}
+
+// 超限时先丢弃最旧的可丢弃事件，不可丢弃的消息放不下时要求关闭连接
+TEST_F(OutboundQueueTest, DropOldestPolicy) {
+    OutboundQueue queue;
+    queue.setLimits(limits(4, 1 << 20, OutboundQueue::OverflowPolicy::DropOldest));
+    queue.push(frame("presence1"), 10, true, 0);
+    queue.push(frame("chat1"), 10, false, 0);
+    queue.push(frame("presence2"), 10, true, 0);
+    queue.push(frame("chat2"), 10, false, 0);
+
+    ASSERT_EQ(queue.push(frame("chat3"), 10, false, 0), OutboundQueue::PushResult::Queued);
+    ASSERT_EQ(queue.push(frame("chat4"), 10, false, 0), OutboundQueue::PushResult::Queued);
+    ASSERT_EQ(queue.push(frame("presence3"), 10, true, 0), OutboundQueue::PushResult::Dropped);
+    ASSERT_EQ(queue.stats().dropped_messages, 3);
+
+    bool more = false;
+    auto batch = queue.takeBatch(0, more);
+    std::vector<std::string> payloads;
+    for (const auto &f : batch) {
+        payloads.push_back(payloadOf(f));
+    }
+    ASSERT_EQ(payloads, (std::vector<std::string>{"chat1", "chat2", "chat3", "chat4"}));
+
+    // 队列中只剩不可丢弃的消息时，超限要求关闭连接
+    for (int i = 0; i < 4; ++i) {
+        queue.push(frame("chat"), 10, false, 0);
+    }
+    ASSERT_EQ(queue.push(frame("chat"), 10, false, 0), OutboundQueue::PushResult::Overflow);
+    ASSERT_EQ(queue.push(frame("chat"), 10, false, 0), OutboundQueue::PushResult::Closed);
+    ASSERT_TRUE(queue.stats().overflowed);
+    ASSERT_EQ(queue.stats().queued_messages, 0);
+}
+
+TEST_F(OutboundQueueTest, ClosePolicy) {
+    OutboundQueue queue;
+    queue.setLimits(limits(100, 1000, OutboundQueue::OverflowPolicy::Close));
+    ASSERT_EQ(queue.push(frame("a"), 500, true, 0), OutboundQueue::PushResult::ScheduleFlush);
+    ASSERT_EQ(queue.push(frame("b"), 100, true, 600), OutboundQueue::PushResult::Overflow);
+    bool more = true;
+    ASSERT_TRUE(queue.takeBatch(0, more).empty());
+    ASSERT_FALSE(more);
+}
+
+// 停滞的客户端持续收到繁忙房间的广播：队列占用的内存不超过高水位，正常连接不受影响
+TEST_F(OutboundQueueTest, StalledConsumerStaysBounded) {
+    const size_t frame_bytes = 300;
+    const int broadcasts = 100000;
+    auto limits = OutboundQueueTest::limits(1024, 1 << 20, OutboundQueue::OverflowPolicy::DropOldest);
+    OutboundQueue stalled;
+    OutboundQueue healthy;
+    stalled.setLimits(limits);
+    healthy.setLimits(limits);
+
+    size_t stalled_transport = 0; // 停滞的连接写不出任何数据
+    bool closed = false;
+    for (int i = 0; i < broadcasts && !closed; ++i) {
+        auto shared = frame(std::string(frame_bytes, 'x'));
+        bool droppable = i % 4 != 0; // 上下线通知多于聊天消息
+        closed = stalled.push(shared, frame_bytes, droppable, stalled_transport) == OutboundQueue::PushResult::Overflow;
+        healthy.push(shared, frame_bytes, droppable, 0);
+
+        // 每轮事件循环 flush 一次；正常连接的传输层随即写完
+        if (i % 16 == 15) {
+            bool more = false;
+            stalled_transport += stalled.takeBatch(stalled_transport, more).size() * frame_bytes;
+            ASSERT_EQ(healthy.takeBatch(0, more).size(), 16);
+        }
+        ASSERT_LE(stalled_transport + stalled.stats().queued_bytes, limits.max_bytes);
+    }
+
+    auto stats = stalled.stats();
+    ASSERT_TRUE(closed);
+    ASSERT_GT(stats.dropped_messages, 0);
+    ASSERT_LE(stats.peak_bytes, limits.max_bytes);
+    ASSERT_EQ(healthy.stats().dropped_messages, 0);
+    ASSERT_EQ(healthy.stats().peak_messages, 16);
+    std::cout << "stalled consumer: peak " << stats.peak_messages << " messages / " << stats.peak_bytes
+              << " bytes, dropped " << stats.dropped_messages << ", unbounded buffering would hold "
+              << static_cast<size_t>(broadcasts) * frame_bytes << " bytes" << std::endl;
+}
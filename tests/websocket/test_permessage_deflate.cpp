@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "../../src/websocket/frame_header.hpp"
+#include "../../src/websocket/permessage_deflate.hpp"
+
+using json = nlohmann::json;
+
+class PermessageDeflateTest : public ::testing::Test {
+protected:
+    // 与 WebSocketServer 广播的聊天消息格式相同
+    static std::string chatEnvelope(int i) {
+        json message = {
+            {"success", true},
+            {"message", "Message sent successfully"},
+            {"data", {{"type", "message_received"},
+                      {"user_id", "user-" + std::to_string(i % 50)},
+                      {"username", "member" + std::to_string(i % 50)},
+                      {"room_id", "room-" + std::to_string(i % 5)},
+                      {"content", "hello everyone, this is message number " + std::to_string(i) + " in our chat"},
+                      {"timestamp", 1750000000 + i}}}};
+        return message.dump();
+    }
+
+    // 与 websocketpp 的调用方式相同：压缩数据按 chunk 字节分块喂入，消息结束后在同一个负载缓冲区上
+    // 再喂一次同步尾（hybi13::finalize_message）
+    static std::string inflate(PermessageDeflate::Inflater &inflater, const std::string &compressed, size_t chunk = 7) {
+        std::string output;
+        for (size_t offset = 0; offset < compressed.size(); offset += chunk) {
+            size_t length = std::min(chunk, compressed.size() - offset);
+            EXPECT_EQ(inflater.decompress(reinterpret_cast<const uint8_t *>(compressed.data()) + offset, length, output),
+                      PermessageDeflate::Inflater::Status::Ok);
+        }
+        EXPECT_EQ(inflater.decompress(kTrailer, sizeof(kTrailer), output), PermessageDeflate::Inflater::Status::Ok);
+        return output;
+    }
+
+    static constexpr uint8_t kTrailer[4] = {0x00, 0x00, 0xff, 0xff};
+};
+
+// 按 RFC 7692 处理客户端请求的各个参数
+TEST_F(PermessageDeflateTest, Negotiate) {
+    PermessageDeflate::Options options;
+    auto params = PermessageDeflate::negotiate(options, {});
+    ASSERT_TRUE(params.has_value());
+    ASSERT_EQ(params->toHeader(), "permessage-deflate; server_no_context_takeover");
+
+    // 浏览器的典型请求
+    params = PermessageDeflate::negotiate(options, {{"client_max_window_bits", ""}});
+    ASSERT_EQ(params->toHeader(), "permessage-deflate; server_no_context_takeover; client_max_window_bits=15");
+
+    params = PermessageDeflate::negotiate(options, {{"server_max_window_bits", "10"}, {"client_no_context_takeover", ""}});
+    ASSERT_EQ(params->server_max_window_bits, 10);
+    ASSERT_FALSE(params->client_no_context_takeover);
+
+    ASSERT_FALSE(PermessageDeflate::negotiate(options, {{"server_max_window_bits", "8"}}).has_value());
+    ASSERT_FALSE(PermessageDeflate::negotiate(options, {{"server_max_window_bits", "16"}}).has_value());
+    ASSERT_FALSE(PermessageDeflate::negotiate(options, {{"server_max_window_bits", ""}}).has_value());
+    ASSERT_FALSE(PermessageDeflate::negotiate(options, {{"unknown", ""}}).has_value());
+
+    // 保留上下文模式下，客户端要求时仍然必须重置
+    options.server_no_context_takeover = false;
+    options.server_max_window_bits = 12;
+    options.client_no_context_takeover = true;
+    params = PermessageDeflate::negotiate(options, {});
+    ASSERT_EQ(params->toHeader(), "permessage-deflate; client_no_context_takeover; server_max_window_bits=12");
+    params = PermessageDeflate::negotiate(options, {{"server_no_context_takeover", ""}});
+    ASSERT_TRUE(params->server_no_context_takeover);
+
+    options.enabled = false;
+    ASSERT_FALSE(PermessageDeflate::negotiate(options, {}).has_value());
+}
+
+// 从握手响应头中解析协商结果
+TEST_F(PermessageDeflateTest, ParseHeader) {
+    PermessageDeflate::Params params;
+    params.server_no_context_takeover = true;
+    params.server_max_window_bits = 11;
+    params.client_max_window_bits = 13;
+    params.client_max_window_bits_sent = true;
+    auto parsed = PermessageDeflate::parseHeader("x-custom; a=1, " + params.toHeader());
+    ASSERT_TRUE(parsed.has_value());
+    ASSERT_TRUE(parsed->server_no_context_takeover);
+    ASSERT_FALSE(parsed->client_no_context_takeover);
+    ASSERT_EQ(parsed->server_max_window_bits, 11);
+    ASSERT_EQ(parsed->client_max_window_bits, 13);
+
+    ASSERT_FALSE(PermessageDeflate::parseHeader("").has_value());
+    ASSERT_FALSE(PermessageDeflate::parseHeader("x-custom").has_value());
+    ASSERT_EQ(PermessageDeflate::parseHeader("permessage-deflate")->server_max_window_bits, 15);
+}
+
+// 压缩数据去掉同步尾，接收方在下一条消息开始时补回；保留上下文时后续消息引用之前的内容
+TEST_F(PermessageDeflateTest, RoundTrip) {
+    for (bool no_context_takeover : {true, false}) {
+        PermessageDeflate::Deflater deflater(15, Z_DEFAULT_COMPRESSION, no_context_takeover);
+        PermessageDeflate::Inflater inflater(15, 0);
+        for (int i = 0; i < 20; ++i) {
+            std::string input = chatEnvelope(i);
+            std::string compressed;
+            ASSERT_TRUE(deflater.compress(input, compressed));
+            ASSERT_LT(compressed.size(), input.size());
+            ASSERT_NE(compressed.substr(compressed.size() - 4), std::string("\x00\x00\xff\xff", 4));
+            ASSERT_EQ(inflate(inflater, compressed, i % 2 == 0 ? compressed.size() : 7), input);
+        }
+    }
+
+    // 共享广播帧：已经解压过其他消息的接收方（保留解压上下文）也能正确解压
+    PermessageDeflate::Inflater fresh(10, 0);
+    PermessageDeflate::Inflater used(15, 0);
+    PermessageDeflate::Deflater own(15, Z_DEFAULT_COMPRESSION, false);
+    std::string earlier;
+    ASSERT_TRUE(own.compress(chatEnvelope(100), earlier));
+    inflate(used, earlier);
+    std::string shared;
+    ASSERT_TRUE(PermessageDeflate::compressMessage(10, Z_DEFAULT_COMPRESSION, chatEnvelope(7), shared));
+    ASSERT_EQ(inflate(fresh, shared), chatEnvelope(7));
+    ASSERT_EQ(inflate(used, shared), chatEnvelope(7));
+
+    // 同步尾只能喂一次：解压器自己再补一个时，下一条消息的前几个字节会被当成 stored 块的长度
+    PermessageDeflate::Deflater sender(15, Z_DEFAULT_COMPRESSION, false);
+    PermessageDeflate::Inflater doubled(15, 0);
+    std::string first;
+    std::string second;
+    ASSERT_TRUE(sender.compress(chatEnvelope(1), first));
+    ASSERT_TRUE(sender.compress(chatEnvelope(2), second));
+    ASSERT_EQ(inflate(doubled, first), chatEnvelope(1));
+    std::string output;
+    ASSERT_EQ(doubled.decompress(kTrailer, sizeof(kTrailer), output), PermessageDeflate::Inflater::Status::Ok);
+    ASSERT_EQ(doubled.decompress(reinterpret_cast<const uint8_t *>(second.data()), second.size(), output),
+              PermessageDeflate::Inflater::Status::Error);
+
+    ASSERT_EQ(FrameHeader::encode(1, 5, true), std::string("\xc1\x05", 2));
+}
+
+// 解压炸弹：几 KB 的压缩帧解压出 10 MB，超过上限时返回 TooBig，而不是把整条消息解压到内存
+TEST_F(PermessageDeflateTest, RejectsOversizedInflation) {
+    PermessageDeflate::Deflater deflater(15, Z_DEFAULT_COMPRESSION, true);
+    std::string bomb;
+    ASSERT_TRUE(deflater.compress(std::string(10 * 1024 * 1024, 'a'), bomb));
+    ASSERT_LT(bomb.size(), 64 * 1024);
+
+    PermessageDeflate::Inflater inflater(15, 1024 * 1024);
+    std::string output;
+    auto status = PermessageDeflate::Inflater::Status::Ok;
+    for (size_t offset = 0; offset < bomb.size() && status == PermessageDeflate::Inflater::Status::Ok; offset += 1024) {
+        size_t length = std::min<size_t>(1024, bomb.size() - offset);
+        status = inflater.decompress(reinterpret_cast<const uint8_t *>(bomb.data()) + offset, length, output);
+    }
+    ASSERT_EQ(status, PermessageDeflate::Inflater::Status::TooBig);
+    ASSERT_LE(output.size(), 1024 * 1024);
+
+    // 上限按单条消息计算，不足上限的消息正常解压
+    PermessageDeflate::Inflater limited(15, 1024 * 1024);
+    std::string small;
+    ASSERT_TRUE(deflater.compress(std::string(1024 * 1024, 'b'), small));
+    ASSERT_EQ(inflate(limited, small, 512), std::string(1024 * 1024, 'b'));
+    ASSERT_EQ(inflate(limited, small, 512), std::string(1024 * 1024, 'b'));
+
+    // 非法数据
+    PermessageDeflate::Inflater broken(15, 0);
+    std::string garbage("\xff\xff\xff\xff", 4);
+    ASSERT_EQ(broken.decompress(reinterpret_cast<const uint8_t *>(garbage.data()), garbage.size(), output),
+              PermessageDeflate::Inflater::Status::Error);
+}
+
+// 线上字节数与 CPU 开销：不压缩、每条消息独立压缩（可共享）、保留上下文；
+// 以及 1000 人房间广播时压缩一次与逐连接压缩的 CPU 对比
+TEST_F(PermessageDeflateTest, BytesVersusCpu) {
+    const int messages = 2000;
+    std::vector<std::string> inputs;
+    size_t raw_bytes = 0;
+    for (int i = 0; i < messages; ++i) {
+        inputs.push_back(chatEnvelope(i));
+        raw_bytes += inputs.back().size();
+    }
+
+    for (bool no_context_takeover : {true, false}) {
+        PermessageDeflate::Deflater deflater(15, Z_DEFAULT_COMPRESSION, no_context_takeover);
+        size_t wire_bytes = 0;
+        std::string compressed;
+        auto begin = std::chrono::steady_clock::now();
+        for (const auto &input : inputs) {
+            ASSERT_TRUE(deflater.compress(input, compressed));
+            wire_bytes += compressed.size();
+        }
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        ASSERT_LT(wire_bytes, raw_bytes);
+        std::cout << (no_context_takeover ? "no context takeover" : "context takeover") << ": "
+                  << raw_bytes / messages << " -> " << wire_bytes / messages << " bytes/message ("
+                  << 100.0 * wire_bytes / raw_bytes << "%), " << micros / messages << " us/message" << std::endl;
+    }
+
+    const int recipients = 1000;
+    std::string compressed;
+    auto begin = std::chrono::steady_clock::now();
+    ASSERT_TRUE(PermessageDeflate::compressMessage(15, Z_DEFAULT_COMPRESSION, inputs[0], compressed));
+    double shared_micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<std::unique_ptr<PermessageDeflate::Deflater>> per_connection;
+    for (int i = 0; i < 100; ++i) {
+        per_connection.push_back(std::make_unique<PermessageDeflate::Deflater>(15, Z_DEFAULT_COMPRESSION, false));
+    }
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < recipients; ++i) {
+        ASSERT_TRUE(per_connection[i % per_connection.size()]->compress(inputs[0], compressed));
+    }
+    double per_connection_micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "broadcast to " << recipients << " members: compress once " << shared_micros
+              << " us, per connection " << per_connection_micros << " us" << std::endl;
+    RecordProperty("broadcast_compress_once_us", static_cast<int>(shared_micros));
+    RecordProperty("broadcast_per_connection_us", static_cast<int>(per_connection_micros));
+}
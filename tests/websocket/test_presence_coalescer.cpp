@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../../src/websocket/presence_coalescer.hpp"
+
+namespace {
+
+PresenceCoalescer::Options options(int64_t window_ms, size_t member_threshold)
+{
+    PresenceCoalescer::Options options;
+    options.window_ms = window_ms;
+    options.member_threshold = member_threshold;
+    return options;
+}
+
+} // namespace
+
+// 小房间和关闭合并时逐个通知
+TEST(PresenceCoalescerTest, SmallRoomsStayIndividual) {
+    PresenceCoalescer coalescer(options(250, 10));
+    ASSERT_EQ(coalescer.record("r1", "alice", true, 10), PresenceCoalescer::RecordResult::Individual);
+    ASSERT_FALSE(coalescer.take("r1").has_value());
+
+    PresenceCoalescer disabled(options(0, 0));
+    ASSERT_EQ(disabled.record("r1", "alice", true, 1000), PresenceCoalescer::RecordResult::Individual);
+    ASSERT_EQ(disabled.stats().events, 0);
+}
+
+// 一个窗口只安排一次 flush，窗口内的加入和离开合并成一条净变化
+TEST(PresenceCoalescerTest, WindowCollectsNetChanges) {
+    PresenceCoalescer coalescer(options(250, 10));
+    ASSERT_EQ(coalescer.record("r1", "alice", true, 11), PresenceCoalescer::RecordResult::WindowOpened);
+    ASSERT_EQ(coalescer.record("r1", "bob", false, 10), PresenceCoalescer::RecordResult::Queued); // 窗口未结束时不看阈值
+    ASSERT_EQ(coalescer.record("r1", "carol", true, 11), PresenceCoalescer::RecordResult::Queued);
+    ASSERT_EQ(coalescer.record("r2", "dave", true, 11), PresenceCoalescer::RecordResult::WindowOpened);
+
+    // 窗口内加入又离开、离开又加入的用户互相抵消
+    coalescer.record("r1", "carol", false, 11);
+    coalescer.record("r1", "erin", false, 11);
+    coalescer.record("r1", "erin", true, 11);
+    coalescer.record("r1", "frank", true, 11);
+
+    auto delta = coalescer.take("r1");
+    ASSERT_TRUE(delta.has_value());
+    ASSERT_EQ(delta->joined, (std::vector<std::string>{"alice", "frank"}));
+    ASSERT_EQ(delta->left, (std::vector<std::string>{"bob"}));
+    ASSERT_FALSE(coalescer.take("r1").has_value());
+
+    // 下一个窗口重新开始
+    ASSERT_EQ(coalescer.record("r1", "alice", false, 11), PresenceCoalescer::RecordResult::WindowOpened);
+
+    auto stats = coalescer.stats();
+    ASSERT_EQ(stats.events, 9);
+    ASSERT_EQ(stats.deltas, 1);
+    ASSERT_EQ(stats.cancelled, 2);
+    ASSERT_EQ(stats.pending_rooms, 2);
+}
+
+// 全部抵消的窗口不发出任何帧
+TEST(PresenceCoalescerTest, FullyCancelledWindowIsSilent) {
+    PresenceCoalescer coalescer(options(250, 0));
+    coalescer.record("r1", "alice", false, 5);
+    coalescer.record("r1", "alice", true, 5);
+    ASSERT_FALSE(coalescer.take("r1").has_value());
+    ASSERT_EQ(coalescer.stats().pending_rooms, 0);
+    ASSERT_EQ(coalescer.stats().deltas, 0);
+}
+
+// 部署后大房间整体重连：逐个通知的帧数与成员数的平方成正比，合并后每个窗口每个成员一帧
+TEST(PresenceCoalescerTest, ReconnectStormFanOut) {
+    const size_t members = 2000;
+    const size_t joins_per_window = 200; // 重连分散在 10 个窗口内
+    PresenceCoalescer coalescer(options(250, 100));
+
+    uint64_t individual_frames = 0;
+    uint64_t coalesced_frames = 0;
+    size_t online = 0;
+    while (online < members) {
+        bool window_open = false;
+        for (size_t i = 0; i < joins_per_window && online < members; ++i) {
+            ++online;
+            auto recorded = coalescer.record("big", "u" + std::to_string(online), true, online);
+            if (recorded == PresenceCoalescer::RecordResult::Individual) {
+                individual_frames += online - 1;
+            } else {
+                window_open = true;
+            }
+        }
+        if (window_open) {
+            auto delta = coalescer.take("big");
+            ASSERT_TRUE(delta.has_value());
+            coalesced_frames += online;
+        }
+    }
+    uint64_t coalesced_total = individual_frames + coalesced_frames;
+    uint64_t uncoalesced_total = static_cast<uint64_t>(members) * (members - 1) / 2;
+    ASSERT_LT(coalesced_total * 50, uncoalesced_total);
+    std::cout << members << " members reconnecting: " << uncoalesced_total << " individual presence frames, "
+              << coalesced_total << " with coalescing (" << coalescer.stats().deltas << " deltas)" << std::endl;
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "../../src/websocket/wire_codec.hpp"
+
+using json = nlohmann::json;
+
+class WireCodecTest : public ::testing::Test {
+protected:
+    static constexpr WireEncoding kEncodings[] = {WireEncoding::Json, WireEncoding::MessagePack, WireEncoding::Cbor};
+
+    // 与 WebSocketServer 广播的聊天消息格式相同
+    static json chatEnvelope(int i) {
+        return {
+            {"success", true},
+            {"message", "Message sent successfully"},
+            {"data", {{"type", "message_received"},
+                      {"user_id", "user-" + std::to_string(i % 50)},
+                      {"username", "member" + std::to_string(i % 50)},
+                      {"room_id", "room-" + std::to_string(i % 5)},
+                      {"content", "hello everyone, this is message number " + std::to_string(i) + " in our chat"},
+                      {"timestamp", 1750000000 + i}}}};
+    }
+};
+
+// 编码名称与 auth 消息中的 encoding 字段对应
+TEST_F(WireCodecTest, ParseName) {
+    for (WireEncoding encoding : kEncodings) {
+        ASSERT_EQ(WireCodec::parse(WireCodec::name(encoding)), encoding);
+    }
+    ASSERT_FALSE(WireCodec::parse("bson").has_value());
+    ASSERT_FALSE(WireCodec::parse("").has_value());
+    ASSERT_FALSE(WireCodec::isBinary(WireEncoding::Json));
+    ASSERT_TRUE(WireCodec::isBinary(WireEncoding::MessagePack));
+    ASSERT_TRUE(WireCodec::isBinary(WireEncoding::Cbor));
+}
+
+// 各种编码下消息结构完全相同
+TEST_F(WireCodecTest, RoundTrip) {
+    json client_message = {{"type", "send_message"}, {"content", "你好 \xF0\x9F\x91\x8B"}};
+    for (WireEncoding encoding : kEncodings) {
+        ASSERT_EQ(WireCodec::decode(WireCodec::encode(chatEnvelope(3), encoding), encoding), chatEnvelope(3));
+        ASSERT_EQ(WireCodec::decode(WireCodec::encode(client_message, encoding), encoding), client_message);
+    }
+    ASSERT_EQ(WireCodec::encode(client_message, WireEncoding::Json), client_message.dump());
+
+    // 截断的二进制负载抛出解析异常，服务端据此返回错误
+    std::string truncated = WireCodec::encode(chatEnvelope(3), WireEncoding::MessagePack);
+    truncated.resize(truncated.size() / 2);
+    ASSERT_THROW(WireCodec::decode(truncated, WireEncoding::MessagePack), json::exception);
+    ASSERT_THROW(WireCodec::decode("{", WireEncoding::Json), json::exception);
+}
+
+// 每条消息的字节数和编码/解码耗时
+TEST_F(WireCodecTest, SizeAndCpu) {
+    const int messages = 2000;
+    std::vector<json> inputs;
+    for (int i = 0; i < messages; ++i) {
+        inputs.push_back(chatEnvelope(i));
+    }
+
+    size_t json_bytes = 0;
+    for (WireEncoding encoding : kEncodings) {
+        size_t bytes = 0;
+        std::vector<std::string> payloads;
+        auto begin = std::chrono::steady_clock::now();
+        for (const auto &input : inputs) {
+            payloads.push_back(WireCodec::encode(input, encoding));
+            bytes += payloads.back().size();
+        }
+        double encode_micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        begin = std::chrono::steady_clock::now();
+        for (const auto &payload : payloads) {
+            ASSERT_TRUE(WireCodec::decode(payload, encoding).is_object());
+        }
+        double decode_micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+
+        if (encoding == WireEncoding::Json) {
+            json_bytes = bytes;
+        } else {
+            // 二进制编码省去了引号、冒号、逗号和数字的文本表示
+            ASSERT_LT(bytes, json_bytes);
+        }
+        std::cout << WireCodec::name(encoding) << ": " << bytes / messages << " bytes/message, encode "
+                  << encode_micros / messages << " us, decode " << decode_micros / messages << " us" << std::endl;
+        RecordProperty(std::string(WireCodec::name(encoding)) + "_bytes_per_message", static_cast<int>(bytes / messages));
+    }
+}